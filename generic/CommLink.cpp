@@ -17,12 +17,14 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 04/12/2011: created
+// 10/17/2026: Added data sinks
 //-----------------------------------------------------------------------------
 
 #include <CommLink.h>
 #include <Register.h>
 #include <Command.h>
 #include <Data.h>
+#include <DataSink.h>
 #include <CommQueue.h>
 #include <sstream>
 #include <iostream>
@@ -113,12 +115,15 @@ void CommLink::dataHandler() {
    uint32_t   xmlCount;
    uint32_t   xmlSize;
    uint32_t   wrSize;
+   uint32_t   indexGen;
    bool       idle;
 
 #ifdef USE_BZLIB
    int32_t     bzerror;
 #endif
    if (wmqInComm) cout<<"\t[CommLink:dev] dataHandler() start! with runEnable_ =="<<runEnable_<<endl;
+   indexGen = 0;
+
    // Store time
    time(&ltime);
    ctime        = ltime;
@@ -128,6 +133,16 @@ void CommLink::dataHandler() {
    // Running
    while ( runEnable_ ) {
       idle = true;
+
+      // Sidecar index follows the open data file
+      if ( dataFileFd_ >= 0 && indexGen != dataFileGen_ ) {
+         dataIndex_.create(dataFile_,lseek(dataFileFd_,0,SEEK_END));
+         indexGen = dataFileGen_;
+      }
+      else if ( dataFileFd_ < 0 && indexGen != 0 ) {
+         dataIndex_.close();
+         indexGen = 0;
+      }
       //cout<< "[CommLink:dev] COUNTER = " << dataRxCount_ <<endl;
       // Config/status/start/stop update
       if ( xmlCount != xmlReqCnt_ ) {
@@ -141,6 +156,7 @@ void CommLink::dataHandler() {
 
             // Callback function is set
             if ( dataCb_ != NULL ) dataCb_((void *)xmlReqEntry_.c_str(), xmlSize);
+            sinkRecord(xmlSize,xmlReqEntry_.c_str());
 	    
 	    /*// Network is open
             if ( dataNetFd_ >= 0 ) {
@@ -200,6 +216,7 @@ void CommLink::dataHandler() {
 	      
                write(dataFileFd_,&xmlSize,4);
                write(dataFileFd_,xmlReqEntry_.c_str(),wrSize);
+               dataIndex_.add(xmlSize,xmlReqEntry_.c_str());
             }
          }
          xmlCount = xmlReqCnt_;
@@ -223,6 +240,7 @@ void CommLink::dataHandler() {
 
          // Callback function is set
          if ( dataCb_ != NULL ) dataCb_(buff, size);
+         sinkRecord(size,buff);
 	 
          /*// Network is open
          if ( dataNetFd_ >= 0 ) {
@@ -285,9 +303,10 @@ void CommLink::dataHandler() {
 	   
             write(dataFileFd_,&size,4);
             write(dataFileFd_,buff,size*4);
+            dataIndex_.add(size,buff);
             dataFileCount_++;
          }
-         dataRxCount_++;
+         dataRxDone();
          delete dat;
 
          // Debug once a second
@@ -305,8 +324,12 @@ void CommLink::dataHandler() {
 	 }
       //-- wmq
       
-      if ( idle ) dataThreadWait(1000);
+      if ( idle ) {
+         dataIndex_.flush();
+         dataThreadWait(1000);
+      }
    }
+   dataIndex_.close();
 }
 
 Data* CommLink::pollEudaqQueue(){
@@ -347,6 +370,7 @@ CommLink::CommLink ( ) {
    debug_           = false;
    dataSource_      = 0;
    dataFileFd_      = -1;
+   dataFileGen_     = 0;
    dataFile_        = "";
    dataNetFd_       = -1;
    dataNetAddress_  = "";
@@ -365,6 +389,9 @@ CommLink::CommLink ( ) {
    runReqConf_      = 0;
    runReqCnt_       = 0;
    runEnable_       = false;
+   rxStarted_       = false;
+   ioStarted_       = false;
+   dataStarted_     = false;
    dataFileCount_   = 0;
    dataRxCount_     = 0;
    regRxCount_      = 0;
@@ -373,6 +400,9 @@ CommLink::CommLink ( ) {
    maxRxTx_         = 4;
    dataCb_          = NULL;
    unexpCount_      = 0;
+   dataDropCount_   = 0;
+   dataPushed_      = 0;
+   dataHandled_     = 0;
    xmlReqEntry_     = "";
    xmlType_         = 0;
    xmlReqCnt_       = 0;
@@ -386,10 +416,19 @@ CommLink::CommLink ( ) {
    pthread_mutex_init(&ioMutex_,NULL);
    pthread_mutex_init(&dataMutex_,NULL);
    pthread_mutex_init(&mainMutex_,NULL);
+   pthread_mutex_init(&sinkMutex_,NULL);
 
    pthread_cond_init(&ioCondition_,NULL);
    pthread_cond_init(&dataCondition_,NULL);
    pthread_cond_init(&mainCondition_,NULL);
+
+   // Data receive waits use the monotonic clock
+   pthread_condattr_t attr;
+   pthread_condattr_init(&attr);
+   pthread_condattr_setclock(&attr,CLOCK_MONOTONIC);
+   pthread_mutex_init(&dataRxMutex_,NULL);
+   pthread_cond_init(&dataRxCondition_,&attr);
+   pthread_condattr_destroy(&attr);
 }
 
 // Deconstructor
@@ -413,8 +452,9 @@ void CommLink::open (bool enDataThread) {
       close();
       throw(err.str());
    }
+   ioStarted_ = true;
 #ifdef ARM
-   else pthread_setname_np(ioThread_,"cLinkIoThread");
+   pthread_setname_np(ioThread_,"cLinkIoThread");
 #endif
 
    // Start rx thread
@@ -424,8 +464,9 @@ void CommLink::open (bool enDataThread) {
       close();
       throw(err.str());
    }
+   rxStarted_ = true;
 #ifdef ARM
-   else pthread_setname_np(rxThread_,"cLinkRxThread");
+   pthread_setname_np(rxThread_,"cLinkRxThread");
 #endif
 
    if(enDataThread_) {
@@ -436,8 +477,9 @@ void CommLink::open (bool enDataThread) {
          close();
          throw(err.str());
       }
+      dataStarted_ = true;
    #ifdef ARM
-      else pthread_setname_np(dataThread_,"cLinkDataThread");
+      pthread_setname_np(dataThread_,"cLinkDataThread");
    #endif
       usleep(1000); // Let threads catch up
    }
@@ -449,17 +491,21 @@ void CommLink::close () {
    // Stop the thread
    runEnable_ = false;
 
+   // Never opened or already closed
+   if ( ! ioStarted_ && ! rxStarted_ && ! dataStarted_ ) return;
+
    // Wake up threads
    ioThreadWakeup();
    dataThreadWakeup();
    usleep(1100); // Give enough time to threads to stop
 
    // Wait for thread to stop
-   pthread_join(ioThread_, NULL);
-   pthread_join(rxThread_, NULL);
-   if(enDataThread_) {
-      pthread_join(dataThread_, NULL);
-   }
+   if ( ioStarted_ ) pthread_join(ioThread_, NULL);
+   if ( rxStarted_ ) pthread_join(rxThread_, NULL);
+   if ( dataStarted_ ) pthread_join(dataThread_, NULL);
+   ioStarted_   = false;
+   rxStarted_   = false;
+   dataStarted_ = false;
 }
 
 // Open data file
@@ -515,6 +561,7 @@ void CommLink::openDataFile (string file, bool compress) {
      cout<<"[CommLink:dev] non Compress mode!"<<endl;
       // Open the file
       dataFileFd_ = ::open(file.c_str(),O_RDWR|O_CREAT|O_APPEND,S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
+      if ( dataFileFd_ >= 0 ) dataFileGen_++;
 
       // Status
       tmp.str("");
@@ -662,6 +709,36 @@ void CommLink::setDataCb ( void (*dataCb)(void *, uint32_t)) {
    dataCb_ = dataCb;
 }
 
+// Add data sink
+void CommLink::addDataSink ( DataSink *sink ) {
+   pthread_mutex_lock(&sinkMutex_);
+   sinks_.push_back(sink);
+   pthread_mutex_unlock(&sinkMutex_);
+}
+
+// Remove data sink
+void CommLink::removeDataSink ( DataSink *sink ) {
+   uint32_t x;
+
+   pthread_mutex_lock(&sinkMutex_);
+   for (x=0; x < sinks_.size(); x++) {
+      if ( sinks_[x] == sink ) {
+         sinks_.erase(sinks_.begin() + x);
+         break;
+      }
+   }
+   pthread_mutex_unlock(&sinkMutex_);
+}
+
+// Pass a record to the data sinks
+void CommLink::sinkRecord ( uint32_t header, const void *data ) {
+   uint32_t x;
+
+   pthread_mutex_lock(&sinkMutex_);
+   for (x=0; x < sinks_.size(); x++) sinks_[x]->rxRecord(header,data);
+   pthread_mutex_unlock(&sinkMutex_);
+}
+
 // Set debug flag
 void CommLink::setDebug( bool enable ) {
    debug_ = enable;
@@ -885,6 +962,93 @@ uint32_t CommLink::dataRxCount() {
    return(dataRxCount_);
 }
 
+// Wait for data receive count to change
+bool CommLink::waitData ( uint32_t count, uint32_t usec ) {
+   struct timespec timeout;
+   bool            ret;
+
+   clock_gettime(CLOCK_MONOTONIC,&timeout);
+   timeout.tv_sec  += usec / 1000000;
+   timeout.tv_nsec += (usec % 1000000) * 1000;
+   if ( timeout.tv_nsec >= (1000 * 1000 * 1000) ) {
+     timeout.tv_nsec -= (1000 * 1000 * 1000);
+     timeout.tv_sec  += 1;
+   } 
+
+   pthread_mutex_lock(&dataRxMutex_);
+   while ( dataRxCount_ == count ) {
+      if ( pthread_cond_timedwait(&dataRxCondition_,&dataRxMutex_,&timeout) != 0 ) break;
+   }
+   ret = (dataRxCount_ != count);
+   pthread_mutex_unlock(&dataRxMutex_);
+   return(ret);
+}
+
+// Wait for the data thread to handle the frames received so far
+bool CommLink::waitDataDrain ( uint32_t usec ) {
+   struct timespec timeout;
+   uint32_t        target;
+   bool            ret;
+
+   if ( ! enDataThread_ ) return(false);
+   target = __atomic_load_n(&dataPushed_,__ATOMIC_ACQUIRE);
+
+   clock_gettime(CLOCK_MONOTONIC,&timeout);
+   timeout.tv_sec  += usec / 1000000;
+   timeout.tv_nsec += (usec % 1000000) * 1000;
+   if ( timeout.tv_nsec >= (1000 * 1000 * 1000) ) {
+     timeout.tv_nsec -= (1000 * 1000 * 1000);
+     timeout.tv_sec  += 1;
+   } 
+
+   pthread_mutex_lock(&dataRxMutex_);
+   while ( (int32_t)(dataHandled_ - target) < 0 ) {
+      if ( pthread_cond_timedwait(&dataRxCondition_,&dataRxMutex_,&timeout) != 0 ) break;
+   }
+   ret = ((int32_t)(dataHandled_ - target) >= 0);
+   pthread_mutex_unlock(&dataRxMutex_);
+   return(ret);
+}
+
+// Count received data frame and wake threads in waitData
+void CommLink::dataRxDone() {
+   pthread_mutex_lock(&dataRxMutex_);
+   dataRxCount_++;
+   dataHandled_++;
+   pthread_cond_broadcast(&dataRxCondition_);
+   pthread_mutex_unlock(&dataRxMutex_);
+}
+
+// Push received frame to the data queue
+bool CommLink::dataPush(Data *data) {
+   if ( dataQueue_.push(data) ) {
+      __atomic_add_fetch(&dataPushed_,1,__ATOMIC_RELEASE);
+      return(true);
+   }
+   dataDropCount_++;
+   delete data;
+   return(false);
+}
+
+// Get data queue depth
+uint32_t CommLink::dataQueueDepth() {
+   return(dataQueue_.entryCnt());
+}
+
+// Get eudaq queue depth
+uint32_t CommLink::dataWriteLag() {
+   uint32_t ret;
+   std::unique_lock<std::mutex> eulock(eudaqQueue_guard);
+   ret = eudaqQueue_.size();
+   eulock.unlock();
+   return(ret);
+}
+
+// Get data drop count
+uint32_t CommLink::dataDropCount() {
+   return(dataDropCount_);
+}
+
 // Get register rx count
 uint32_t CommLink::regRxCount() {
    return(regRxCount_);
@@ -913,6 +1077,7 @@ void CommLink::clearCounters() {
    timeoutCount_  = 0;
    errorCount_    = 0;
    unexpCount_    = 0;
+   dataDropCount_ = 0;
 }
 
 
@@ -1076,6 +1241,38 @@ void CommLink::addRunTime ( string xml ) {
    pthread_mutex_unlock(&reqMutex_);
 }
 
+// Add calibration marker to data file
+void CommLink::addCalMarker ( uint32_t state, uint32_t channel, uint32_t dac, uint32_t stride ) {
+   uint32_t currResp;
+   uint32_t marker[4];
+   struct timeval tm;
+
+   marker[0] = state;
+   marker[1] = channel;
+   marker[2] = dac;
+   marker[3] = stride;
+
+   pthread_mutex_lock(&reqMutex_);
+
+   // Setup request
+   xmlReqEntry_.assign((const char *)marker,sizeof(marker));
+   xmlType_     = Data::CalMarker;
+   currResp     = xmlRespCnt_;
+   xmlReqCnt_++;
+   initTime(&tm);
+   dataThreadWakeup();
+
+   // Wait for response, 1 second
+   while ( currResp == xmlRespCnt_ ) {
+      if ( timePassed(&tm,1000000) ) {
+         initTime(&tm);
+         cout << "CommLink::addCalMarker -> Waiting for main thread!" << endl;
+      }
+      mainThreadWait(100);
+   }
+   pthread_mutex_unlock(&reqMutex_);
+}
+
 
 // Enable store of config/status/start/stop to data file & callback
 void CommLink::setXmlStore ( bool enable ) {
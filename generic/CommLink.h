@@ -18,6 +18,7 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 04/12/2011: created
+// 10/17/2026: Added data sinks
 //-----------------------------------------------------------------------------
 #ifndef __COMM_LINK_H__
 #define __COMM_LINK_H__
@@ -30,11 +31,13 @@
 #include <sys/time.h>
 #include <time.h>
 #include <CommQueue.h>
+#include <DataIndex.h>
 #include <stdio.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <resolv.h>
 #include <stdint.h>
+#include <vector>
 
 #ifdef USE_BZLIB
 #include <bzlib.h>
@@ -48,6 +51,7 @@ using namespace std;
 class Data;
 class Register;
 class Command;
+class DataSink;
 
 //! Class to contain generic communications link
 class CommLink {
@@ -78,6 +82,11 @@ class CommLink {
       int32_t dataFileFd_;
       string dataFile_;
 
+      // Sidecar record index of the data file, written by the data thread.
+      // The generation changes with each opened data file.
+      DataIndex dataIndex_;
+      uint32_t  dataFileGen_;
+
       // Compression options
       bool     bzEnable_;
 
@@ -98,6 +107,13 @@ class CommLink {
       // Data rx callback function
       void (*dataCb_)(void *, uint32_t);
 
+      // Data sinks
+      vector<DataSink *> sinks_;
+      pthread_mutex_t    sinkMutex_;
+
+      // Pass a record to the data sinks
+      void sinkRecord ( uint32_t header, const void *data );
+
       // Register request/response queue
       Register *regReqEntry_;
       uint32_t  regReqConf_;
@@ -135,6 +151,11 @@ class CommLink {
       pthread_t ioThread_;
       pthread_t dataThread_;
 
+      // Threads started by open(), close() only joins these
+      bool rxStarted_;
+      bool ioStarted_;
+      bool dataStarted_;
+
       // Thread Routines
       static void *rxRun ( void *t );
       static void *ioRun ( void *t );
@@ -147,6 +168,8 @@ class CommLink {
       pthread_mutex_t dataMutex_;
       pthread_cond_t  mainCondition_;
       pthread_mutex_t mainMutex_;
+      pthread_cond_t  dataRxCondition_;
+      pthread_mutex_t dataRxMutex_;
 
       // Condition set and wait routines
       void dataThreadWait(uint32_t usec);
@@ -156,6 +179,12 @@ class CommLink {
       void mainThreadWait(uint32_t usec);
       void mainThreadWakeup();
 
+      // Count received data frame and wake threads in waitData
+      void dataRxDone();
+
+      // Push received frame to the data queue, a frame which does not fit is freed and counted
+      bool dataPush(Data *data);
+
       // Timer functions
       void initTime(struct timeval *tm);
       uint32_t timePassed(struct timeval *tm, uint32_t usec);
@@ -177,6 +206,11 @@ class CommLink {
       uint32_t   timeoutCount_;
       uint32_t   errorCount_;
       uint32_t   unexpCount_;
+      uint32_t   dataDropCount_;
+
+      // Frames pushed and handled by the data thread, never cleared
+      uint32_t   dataPushed_;
+      uint32_t   dataHandled_;
 
       // IO handling routines
       virtual void rxHandler();
@@ -245,6 +279,21 @@ class CommLink {
       */
       void setDataCb ( void (*dataCb_)(void *, uint32_t));
 
+      //! Add data sink
+      /*!
+       * The sink receives every record passed through the data
+       * thread until it is removed.
+       * \param sink Data sink
+      */
+      void addDataSink ( DataSink *sink );
+
+      //! Remove data sink
+      /*!
+       * No record is passed to the sink after this returns.
+       * \param sink Data sink
+      */
+      void removeDataSink ( DataSink *sink );
+
       //! Set debug flag
       /*! 
        * \param enable Debug state
@@ -288,6 +337,30 @@ class CommLink {
       //! Get data receive count
       uint32_t   dataRxCount();
 
+      //! Wait for data receive count to change
+      /*! 
+       * Returns true if the count differs from count.
+       * \param count Last data receive count seen by the caller
+       * \param usec  Timeout in uS
+      */
+      bool waitData ( uint32_t count, uint32_t usec );
+
+      //! Wait for the data thread to handle the frames received so far
+      /*! 
+       * Returns false on timeout or if the data thread is disabled.
+       * \param usec Timeout in uS
+      */
+      bool waitDataDrain ( uint32_t usec );
+
+      //! Get number of received frames waiting for the data thread
+      uint32_t   dataQueueDepth();
+
+      //! Get number of written frames waiting for the eudaq producer
+      uint32_t   dataWriteLag();
+
+      //! Get number of received frames dropped because the data queue was full
+      uint32_t   dataDropCount();
+
       //! Get register rx count
       uint32_t   regRxCount();
 
@@ -354,6 +427,15 @@ class CommLink {
       */
       void addRunTime ( string xml );
 
+      //! Add binary calibration marker to data file
+      /*! 
+       * \param state   Calibration state
+       * \param channel First calibration channel
+       * \param dac     Calibration dac
+       * \param stride  Spacing of injected channels after the first
+      */
+      void addCalMarker ( uint32_t state, uint32_t channel, uint32_t dac, uint32_t stride );
+
       //! Enable store of config/status/start/stop to data file & callback
       /*! 
        * \param enable Enable of config/status/start/stop
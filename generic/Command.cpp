@@ -21,6 +21,7 @@
 //-----------------------------------------------------------------------------
 
 #include <Command.h>
+#include <XmlWriter.h>
 #include <sstream>
 #include <stdint.h>
 using namespace std;
@@ -61,35 +62,43 @@ uint32_t Command::opCode () { return(opCode_); }
 
 // Method to get variable information in xml form.
 string Command::getXmlStructure (bool hidden, uint32_t level) {
-   stringstream           tmp;
+   XmlWriter xml;
+   getXmlStructure(xml,hidden,level);
+   return(xml.str());
+}
+
+// Method to append command information in xml form.
+void Command::getXmlStructure (XmlWriter &xml, bool hidden, uint32_t level) {
 
-   if ( isHidden_ && !hidden ) return(string(""));
+   if ( isHidden_ && !hidden ) return;
 
-   tmp.str("");
-   if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) tmp << " ";
-   tmp << "<command>" << endl;
+   xml.indent(level);
+   xml.append("<command>\n");
 
-   if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-   tmp << "<name>" << name_ << "</name>" << endl;
+   xml.indent(level,3);
+   xml.append("<name>");
+   xml.append(name_);
+   xml.append("</name>\n");
 
    if ( desc_ != "" ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<description>" << desc_ << "</description>" << endl;
+      xml.indent(level,3);
+      xml.append("<description>");
+      xml.append(desc_);
+      xml.append("</description>\n");
    }
 
    if ( isHidden_ ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<hidden/>" << endl;
+      xml.indent(level,3);
+      xml.append("<hidden/>\n");
    }
 
    if ( hasArg_ ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<hasArg/>" << endl;
+      xml.indent(level,3);
+      xml.append("<hasArg/>\n");
    }
 
-   if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) tmp << " ";
-   tmp << "</command>" << endl;
-   return(tmp.str());
+   xml.indent(level);
+   xml.append("</command>\n");
 }
 
 // Set hidden status
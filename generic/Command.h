@@ -26,6 +26,8 @@
 #include <stdint.h>
 using namespace std;
 
+class XmlWriter;
+
 //! Class to contain generic register data.
 class Command {
 
@@ -88,6 +90,14 @@ class Command {
       */
       string getXmlStructure ( bool hidden, uint32_t level );
 
+      //! Method to append variable information in xml form.
+      /*! 
+       * \param xml    Writer to append to.
+       * \param hidden Include hidden commands.
+       * \param level  level for indents
+      */
+      void getXmlStructure ( XmlWriter &xml, bool hidden, uint32_t level );
+
       //! Set hidden status
       /*! 
        * This field determines if the command is hidden.
@@ -0,0 +1,81 @@
+//-----------------------------------------------------------------------------
+// File          : ControlBinary.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Constants for the binary control protocol served by ControlServer on its
+// binary listen port. Shared by the server and ControlClient.
+//
+// All fields are little endian. Strings are a uint32_t length followed by
+// the characters, without termination.
+//
+// Request frame:
+//    uint32_t size      Bytes following this field
+//    uint32_t sequence  Returned in the response
+//    uint32_t count     Number of operations
+//    operations         Opcode byte followed by the arguments listed below
+//
+// A request with a count larger than the bytes of its operations closes
+// the connection.
+//
+// Response frame:
+//    uint32_t size      Bytes following this field
+//    uint32_t sequence  From the request
+//    uint32_t count     Number of operations in the request
+//    results            Status byte for each operation, followed by the
+//                       result listed below when status is OK, or an error
+//                       string when status is ERROR. Operations after an
+//                       error are not executed and return SKIPPED.
+//
+// Names are resolved once to an id which is valid for the life of the
+// server and shared by all clients. Paths use the same form as the
+// XmlVariables keys: cntrlFpga(0):kpixAsic(1):DacCalibration. A missing
+// index selects instance 0, a bare name refers to the top level device.
+//
+// Config variables written with SET_INT or SET_STR take effect in the
+// hardware when an APPLY operation is executed.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __CONTROL_BINARY_H__
+#define __CONTROL_BINARY_H__
+
+// Sizes
+#define CONTROL_BIN_HEADER_SIZE  12
+#define CONTROL_BIN_MAX_FRAME    16777216
+
+// Name kinds for resolve
+#define CONTROL_BIN_KIND_VARIABLE 0
+#define CONTROL_BIN_KIND_REGISTER 1
+#define CONTROL_BIN_KIND_COMMAND  2
+
+// Operations                          Arguments              Result
+#define CONTROL_BIN_OP_RESOLVE    1 // kind byte, path string   id
+#define CONTROL_BIN_OP_SET_INT    2 // id, value                -
+#define CONTROL_BIN_OP_SET_STR    3 // id, value string         -
+#define CONTROL_BIN_OP_GET_INT    4 // id                       value
+#define CONTROL_BIN_OP_GET_STR    5 // id                       value string
+#define CONTROL_BIN_OP_WRITE_REG  6 // id, value                -
+#define CONTROL_BIN_OP_READ_REG   7 // id                       value
+#define CONTROL_BIN_OP_COMMAND    8 // id, arg string           -
+#define CONTROL_BIN_OP_APPLY      9 // -                        -
+
+// Result status
+#define CONTROL_BIN_STATUS_OK      0
+#define CONTROL_BIN_STATUS_ERROR   1
+#define CONTROL_BIN_STATUS_SKIPPED 2
+
+#endif
+
@@ -0,0 +1,285 @@
+//-----------------------------------------------------------------------------
+// File          : ControlClient.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Client for the binary control protocol served by ControlServer. Operations
+// are queued and sent as one frame by execute(), results are then available
+// by operation index. See ControlBinary.h for the protocol.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include <ControlClient.h>
+#include <sstream>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+using namespace std;
+
+// Constructor
+ControlClient::ControlClient ( ) {
+   fd_       = -1;
+   sequence_ = 0;
+   txCount_  = 0;
+}
+
+// DeConstructor
+ControlClient::~ControlClient ( ) {
+   close();
+}
+
+// Connect to server
+void ControlClient::open ( string host, int32_t port ) {
+   struct sockaddr_in addr;
+   struct hostent    *ent;
+   stringstream       err;
+   int32_t            flag;
+
+   close();
+
+   memset(&addr,0,sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_port   = htons(port);
+
+   if ( (ent = gethostbyname(host.c_str())) == NULL ) {
+      err.str("");
+      err << "ControlClient::open -> Failed to resolve host " << host << endl;
+      throw(err.str());
+   }
+   memcpy(&addr.sin_addr,ent->h_addr_list[0],ent->h_length);
+
+   fd_ = socket(AF_INET,SOCK_STREAM,0);
+   if ( fd_ < 0 || connect(fd_,(struct sockaddr *)&addr,sizeof(addr)) < 0 ) {
+      close();
+      err.str("");
+      err << "ControlClient::open -> Failed to connect to " << host << ":" << dec << port << endl;
+      throw(err.str());
+   }
+
+   // Requests are small and latency bound
+   flag = 1;
+   setsockopt(fd_,IPPROTO_TCP,TCP_NODELAY,&flag,sizeof(flag));
+
+   txFrame_.clear();
+   txOps_.clear();
+   txCount_ = 0;
+}
+
+// Close connection
+void ControlClient::close ( ) {
+   if ( fd_ >= 0 ) ::close(fd_);
+   fd_ = -1;
+}
+
+// Start queued operation
+void ControlClient::addOp ( uint8_t op ) {
+
+   // Reserve header space
+   if ( txCount_ == 0 ) {
+      txFrame_.clear();
+      txFrame_.append(CONTROL_BIN_HEADER_SIZE,'\0');
+      txOps_.clear();
+   }
+   txFrame_.push_back(op);
+   txOps_.push_back(op);
+   txCount_++;
+}
+
+// Resolve name to id
+uint32_t ControlClient::resolve ( uint8_t kind, string path ) {
+   uint32_t len = path.size();
+   uint32_t op;
+
+   addOp(CONTROL_BIN_OP_RESOLVE);
+   txFrame_.push_back(kind);
+   txFrame_.append((const char *)&len,4);
+   txFrame_.append(path);
+   op = txCount_ - 1;
+   execute();
+   return(resultInt_[op]);
+}
+
+// Queue variable write, integer value
+void ControlClient::setInt ( uint32_t id, uint32_t value ) {
+   addOp(CONTROL_BIN_OP_SET_INT);
+   txFrame_.append((const char *)&id,4);
+   txFrame_.append((const char *)&value,4);
+}
+
+// Queue variable write, string value
+void ControlClient::setString ( uint32_t id, string value ) {
+   uint32_t len = value.size();
+
+   addOp(CONTROL_BIN_OP_SET_STR);
+   txFrame_.append((const char *)&id,4);
+   txFrame_.append((const char *)&len,4);
+   txFrame_.append(value);
+}
+
+// Queue variable read, integer result
+void ControlClient::getInt ( uint32_t id ) {
+   addOp(CONTROL_BIN_OP_GET_INT);
+   txFrame_.append((const char *)&id,4);
+}
+
+// Queue variable read, string result
+void ControlClient::getString ( uint32_t id ) {
+   addOp(CONTROL_BIN_OP_GET_STR);
+   txFrame_.append((const char *)&id,4);
+}
+
+// Queue register write
+void ControlClient::writeRegister ( uint32_t id, uint32_t value ) {
+   addOp(CONTROL_BIN_OP_WRITE_REG);
+   txFrame_.append((const char *)&id,4);
+   txFrame_.append((const char *)&value,4);
+}
+
+// Queue register read
+void ControlClient::readRegister ( uint32_t id ) {
+   addOp(CONTROL_BIN_OP_READ_REG);
+   txFrame_.append((const char *)&id,4);
+}
+
+// Queue command
+void ControlClient::command ( uint32_t id, string arg ) {
+   uint32_t len = arg.size();
+
+   addOp(CONTROL_BIN_OP_COMMAND);
+   txFrame_.append((const char *)&id,4);
+   txFrame_.append((const char *)&len,4);
+   txFrame_.append(arg);
+}
+
+// Queue write of config variables to hardware
+void ControlClient::apply ( ) {
+   addOp(CONTROL_BIN_OP_APPLY);
+}
+
+// Number of queued operations
+uint32_t ControlClient::pending ( ) {
+   return(txCount_);
+}
+
+// Read exactly size bytes
+void ControlClient::readAll ( char *buffer, uint32_t size ) {
+   uint32_t got;
+   int32_t  ret;
+
+   got = 0;
+   while ( got < size ) {
+      ret = ::read(fd_,buffer + got,size - got);
+      if ( ret <= 0 ) {
+         close();
+         throw(string("ControlClient::execute -> Connection lost\n"));
+      }
+      got += ret;
+   }
+}
+
+// Send queued operations and wait for results
+void ControlClient::execute ( ) {
+   const char *ptr;
+   const char *end;
+   uint32_t    size;
+   uint32_t    count;
+   uint32_t    len;
+   uint32_t    sent;
+   uint32_t    x;
+   int32_t     ret;
+   uint8_t     status;
+   string      error;
+
+   if ( txCount_ == 0 ) return;
+   if ( fd_ < 0 ) throw(string("ControlClient::execute -> Not connected\n"));
+
+   // Fill header
+   size = txFrame_.size() - 4;
+   sequence_++;
+   memcpy(&(txFrame_[0]),&size,4);
+   memcpy(&(txFrame_[4]),&sequence_,4);
+   memcpy(&(txFrame_[8]),&txCount_,4);
+   txCount_ = 0;
+
+   // Send frame
+   sent = 0;
+   while ( sent < txFrame_.size() ) {
+      ret = ::write(fd_,txFrame_.data() + sent,txFrame_.size() - sent);
+      if ( ret <= 0 ) {
+         close();
+         throw(string("ControlClient::execute -> Write failed\n"));
+      }
+      sent += ret;
+   }
+
+   // Response
+   readAll((char *)&size,4);
+   rxFrame_.resize(size);
+   readAll(&(rxFrame_[0]),size);
+
+   ptr = rxFrame_.data();
+   end = ptr + size;
+   memcpy(&count,ptr+4,4);
+   ptr += 8;
+
+   resultInt_.assign(count,0);
+   resultStr_.assign(count,"");
+
+   // Results by operation
+   for (x=0; x < count && ptr < end; x++) {
+      status = (uint8_t)*(ptr++);
+
+      if ( status == CONTROL_BIN_STATUS_ERROR ) {
+         memcpy(&len,ptr,4);
+         error.assign(ptr+4,len);
+         ptr += (4 + len);
+      }
+      else if ( status == CONTROL_BIN_STATUS_OK ) {
+         switch ( txOps_[x] ) {
+            case CONTROL_BIN_OP_RESOLVE  :
+            case CONTROL_BIN_OP_GET_INT  :
+            case CONTROL_BIN_OP_READ_REG :
+               memcpy(&(resultInt_[x]),ptr,4);
+               ptr += 4;
+               break;
+            case CONTROL_BIN_OP_GET_STR :
+               memcpy(&len,ptr,4);
+               resultStr_[x].assign(ptr+4,len);
+               ptr += (4 + len);
+               break;
+            default : break;
+         }
+      }
+   }
+
+   if ( error != "" ) throw(error);
+}
+
+// Integer result of operation
+uint32_t ControlClient::resultInt ( uint32_t op ) {
+   if ( op >= resultInt_.size() ) return(0);
+   return(resultInt_[op]);
+}
+
+// String result of operation
+string ControlClient::resultString ( uint32_t op ) {
+   if ( op >= resultStr_.size() ) return("");
+   return(resultStr_[op]);
+}
+
@@ -0,0 +1,132 @@
+//-----------------------------------------------------------------------------
+// File          : ControlClient.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Client for the binary control protocol served by ControlServer. Operations
+// are queued and sent as one frame by execute(), results are then available
+// by operation index. See ControlBinary.h for the protocol.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __CONTROL_CLIENT_H__
+#define __CONTROL_CLIENT_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <ControlBinary.h>
+using namespace std;
+
+//! Class to issue batched operations over the binary control protocol
+class ControlClient {
+
+      // Socket
+      int32_t fd_;
+
+      // Frame sequence number
+      uint32_t sequence_;
+
+      // Pending request
+      string   txFrame_;
+      uint32_t txCount_;
+      vector<uint8_t> txOps_;
+
+      // Response
+      string           rxFrame_;
+      vector<uint32_t> resultInt_;
+      vector<string>   resultStr_;
+
+      // Read exactly size bytes
+      void readAll ( char *buffer, uint32_t size );
+
+      // Start queued operation
+      void addOp ( uint8_t op );
+
+   public:
+
+      //! Constructor
+      ControlClient ( );
+
+      //! DeConstructor
+      ~ControlClient ( );
+
+      //! Connect to server binary port
+      /*!
+       * Throws string on error
+       * \param host Server address
+       * \param port Server binary port
+      */
+      void open ( string host, int32_t port );
+
+      //! Close connection
+      void close ( );
+
+      //! Resolve name to id, executed immediately
+      /*!
+       * Throws string on error. Pending operations are sent in the same frame.
+       * \param kind CONTROL_BIN_KIND_VARIABLE, _REGISTER or _COMMAND
+       * \param path Name path, cntrlFpga(0):kpixAsic(1):DacCalibration
+      */
+      uint32_t resolve ( uint8_t kind, string path );
+
+      //! Queue variable write, integer value
+      void setInt ( uint32_t id, uint32_t value );
+
+      //! Queue variable write, string value
+      void setString ( uint32_t id, string value );
+
+      //! Queue variable read, integer result
+      void getInt ( uint32_t id );
+
+      //! Queue variable read, string result
+      void getString ( uint32_t id );
+
+      //! Queue register write
+      void writeRegister ( uint32_t id, uint32_t value );
+
+      //! Queue register read, integer result
+      void readRegister ( uint32_t id );
+
+      //! Queue command
+      void command ( uint32_t id, string arg = "" );
+
+      //! Queue write of config variables to hardware
+      void apply ( );
+
+      //! Number of queued operations
+      uint32_t pending ( );
+
+      //! Send queued operations and wait for results
+      /*!
+       * Throws string with the server message if an operation failed.
+      */
+      void execute ( );
+
+      //! Integer result of operation from last execute
+      /*!
+       * \param op Operation index in the frame
+      */
+      uint32_t resultInt ( uint32_t op );
+
+      //! String result of operation from last execute
+      /*!
+       * \param op Operation index in the frame
+      */
+      string resultString ( uint32_t op );
+
+};
+#endif
+
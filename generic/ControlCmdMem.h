@@ -18,12 +18,19 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 01/11/2012: created
+// 10/17/2026: Added multi-slot command ring with futex wakeups
+// 10/17/2026: Added flat config and status snapshot
+// 10/17/2026: Uncollected ring results are reclaimed by the server
+// 10/17/2026: Tickets never published are skipped by the server
 //-----------------------------------------------------------------------------
 #ifndef __CONTROL_CMD_MEM_H__
 #define __CONTROL_CMD_MEM_H__
 
 #ifndef RTEMS
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <sched.h>
 #endif
 
 #include <sys/stat.h>
@@ -57,6 +64,58 @@
 #define CONTROL_CMD_TYPE_SET_REGISTER  6 // Three Args, Device Path, register name and value, No Result
 #define CONTROL_CMD_TYPE_GET_REGISTER  7 // Two Args, Device Path, register name, Result is value
 
+// Command ring, slot count must be a power of two
+#define CONTROL_CMD_RING_SLOTS     16
+#define CONTROL_CMD_RING_ARGA_SIZE 65536
+
+// Milliseconds a completed ring result is kept for the client
+#define CONTROL_CMD_RING_RECLAIM 30000
+
+// Milliseconds the server waits for a claimed ticket to be published
+#define CONTROL_CMD_RING_PUBLISH 1000
+
+// Command ring slot. The sequence word tracks the slot state for ticket t:
+// t free, t+1 ready, t+2 done, t+3 abandoned by the client, t+4 result
+// being copied by the client, t+5 skipped by the server, t+CONTROL_CMD_RING_SLOTS
+// free for the next ticket using the slot. A ticket claimed but not published
+// within CONTROL_CMD_RING_PUBLISH is skipped, the client may have died. A done
+// or skipped slot is freed by the server after CONTROL_CMD_RING_RECLAIM.
+typedef struct {
+   uint32_t     sequence;
+   uint32_t     doneTime;    // Completion time in milliseconds
+   uint8_t      cmdType;
+   char         cmdArgA[CONTROL_CMD_RING_ARGA_SIZE];
+   char         cmdArgB[CONTROL_CMD_ARGB_SIZE];
+   char         cmdResult[CONTROL_CMD_RESULT_SIZE];
+   char         cmdError[CONTROL_CMD_ERROR_SIZE];
+} ControlCmdSlot;
+
+// Snapshot of config and status variables, slot count must be a power of two
+#define CONTROL_CMD_SNAP_SLOTS      8192
+#define CONTROL_CMD_SNAP_KEY_SIZE   96
+#define CONTROL_CMD_SNAP_VALUE_SIZE 256
+
+// Snapshot entry kinds
+#define CONTROL_CMD_SNAP_CONFIG 1
+#define CONTROL_CMD_SNAP_STATUS 2
+
+// Snapshot entry, keys use the path form of XmlVariables
+typedef struct {
+   uint32_t     hash;        // Zero for an unused entry
+   uint8_t      kind;
+   uint8_t      truncated;   // Value did not fit, use the xml buffers
+   char         key[CONTROL_CMD_SNAP_KEY_SIZE];
+   char         value[CONTROL_CMD_SNAP_VALUE_SIZE];
+} ControlCmdSnapEntry;
+
+// Open addressed hash table of entries, guarded by a sequence lock. The
+// version is odd while System::poll is updating the table.
+typedef struct {
+   uint32_t            version;
+   uint32_t            count;
+   ControlCmdSnapEntry entry[CONTROL_CMD_SNAP_SLOTS];
+} ControlCmdSnapshot;
+
 typedef struct {
 
    // Commands
@@ -73,6 +132,15 @@ typedef struct {
    char         xmlConfigBuffer[CONTROL_CMD_CONFIG_SIZE];
    char         xmlPerStatusBuffer[CONTROL_CMD_STATUS_SIZE];
 
+   // Command ring, many clients with many commands in flight
+   uint32_t       ringHead;     // Next ticket to claim
+   uint32_t       ringTail;     // Next ticket to be completed by the server
+   uint32_t       ringSubmit;   // Bumped on each submit, server waits on it
+   ControlCmdSlot ring[CONTROL_CMD_RING_SLOTS];
+
+   // Config and status snapshot
+   ControlCmdSnapshot snapshot;
+
    // Shared name
    char         sharedName[CONTROL_CMD_NAME_SIZE];
 
@@ -142,6 +210,15 @@ inline void controlCmdInit ( ControlCmdMemory *ptr ) {
    ptr->cmdType     = 0;
    ptr->cmdRdyCount = 0;
    ptr->cmdAckCount = 0;
+
+   ptr->ringHead   = 0;
+   ptr->ringTail   = 0;
+   ptr->ringSubmit = 0;
+   for (uint32_t x=0; x < CONTROL_CMD_RING_SLOTS; x++) {
+      memset(&(ptr->ring[x]), 0, sizeof(ControlCmdSlot));
+      ptr->ring[x].sequence = x;
+   }
+   memset(&(ptr->snapshot), 0, sizeof(ControlCmdSnapshot));
 }
 
 // Send command
@@ -219,6 +296,331 @@ inline int32_t controlCmdGetResultTimeout ( ControlCmdMemory *ptr, char *result,
    return(1);
 }
 
+// Monotonic time in milliseconds
+inline uint32_t controlCmdMsec ( ) {
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC,&now);
+   return((uint32_t)((now.tv_sec * 1000) + (now.tv_nsec / 1000000)));
+}
+
+// Deadline for a timeout in milliseconds, negative for none
+inline void controlCmdDeadline ( struct timespec *end, int32_t timeout ) {
+   clock_gettime(CLOCK_MONOTONIC,end);
+   if ( timeout < 0 ) end->tv_sec = 0;
+   else {
+      end->tv_sec  += timeout / 1000;
+      end->tv_nsec += (timeout % 1000) * 1000000;
+      if ( end->tv_nsec >= 1000000000 ) {
+         end->tv_nsec -= 1000000000;
+         end->tv_sec  += 1;
+      }
+   }
+}
+
+// Milliseconds left to a deadline, -1 for none, 0 when passed
+inline int32_t controlCmdRemain ( struct timespec *end ) {
+   struct timespec now;
+   int64_t         rem;
+
+   if ( end->tv_sec == 0 ) return(-1);
+   clock_gettime(CLOCK_MONOTONIC,&now);
+   rem = ((int64_t)(end->tv_sec - now.tv_sec) * 1000) + ((end->tv_nsec - now.tv_nsec) / 1000000);
+   if ( rem <= 0 ) return(0);
+   return((int32_t)rem);
+}
+
+// Wait while a shared futex word holds val, timeout in milliseconds, -1 for none
+inline void controlCmdFutexWait ( uint32_t *addr, uint32_t val, int32_t timeout ) {
+   struct timespec ts;
+
+   ts.tv_sec  = timeout / 1000;
+   ts.tv_nsec = (timeout % 1000) * 1000000;
+   syscall(SYS_futex,addr,FUTEX_WAIT,val,(timeout < 0)?NULL:&ts,NULL,0);
+}
+
+// Wake all waiters on a shared futex word
+inline void controlCmdFutexWake ( uint32_t *addr ) {
+   syscall(SYS_futex,addr,FUTEX_WAKE,0x7FFFFFFF,NULL,NULL,0);
+}
+
+// Submit command to the ring, timeout in milliseconds waiting for a free slot.
+// Returns 1 with the ticket set, 0 on timeout or if the server skipped the
+// ticket before it was published, -1 if argA does not fit a slot.
+inline int32_t controlCmdRingSubmit ( ControlCmdMemory *ptr, uint8_t cmdType, const char *argA, const char *argB,
+                                      uint32_t *ticket, int32_t timeout ) {
+   ControlCmdSlot  *slot;
+   struct timespec  end;
+   uint32_t         t;
+   uint32_t         seq;
+   int32_t          remain;
+
+   if ( argA != NULL && strlen(argA) >= CONTROL_CMD_RING_ARGA_SIZE ) return(-1);
+   controlCmdDeadline(&end,timeout);
+
+   // Claim the slot of the next ticket once its previous command is released
+   while (1) {
+      t    = __atomic_load_n(&(ptr->ringHead),__ATOMIC_ACQUIRE);
+      slot = &(ptr->ring[t % CONTROL_CMD_RING_SLOTS]);
+      seq  = __atomic_load_n(&(slot->sequence),__ATOMIC_ACQUIRE);
+
+      if ( seq == t ) {
+         if ( __atomic_compare_exchange_n(&(ptr->ringHead),&t,t+1,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) ) break;
+      }
+
+      // Ring is full
+      else if ( (int32_t)(seq - t) < 0 ) {
+         if ( (remain = controlCmdRemain(&end)) == 0 ) return(0);
+         controlCmdFutexWait(&(slot->sequence),seq,remain);
+      }
+   }
+
+   slot->cmdType = cmdType;
+   if ( argA != NULL ) strcpy(slot->cmdArgA,argA);
+   else slot->cmdArgA[0] = '\0';
+   if ( argB != NULL ) {
+      strncpy(slot->cmdArgB,argB,CONTROL_CMD_ARGB_SIZE);
+      slot->cmdArgB[CONTROL_CMD_ARGB_SIZE-1] = '\0';
+   }
+   else slot->cmdArgB[0] = '\0';
+   slot->cmdResult[0] = '\0';
+   slot->cmdError[0]  = '\0';
+
+   // Publish and wake server, a ticket skipped by the server counts as a timeout
+   seq = t;
+   if ( ! __atomic_compare_exchange_n(&(slot->sequence),&seq,t+1,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) ) return(0);
+   __atomic_add_fetch(&(ptr->ringSubmit),1,__ATOMIC_RELEASE);
+   controlCmdFutexWake(&(ptr->ringSubmit));
+
+   *ticket = t;
+   return(1);
+}
+
+// Wait for ring command completion, timeout in milliseconds. Result and error
+// may be NULL. Returns 1 on completion, 0 on timeout, -1 for an unknown ticket
+// or a result reclaimed by the server. A command which times out is abandoned,
+// the server releases its slot.
+inline int32_t controlCmdRingResult ( ControlCmdMemory *ptr, uint32_t ticket, char *result, char *error, int32_t timeout ) {
+   ControlCmdSlot  *slot;
+   struct timespec  end;
+   uint32_t         seq;
+   uint32_t         exp;
+   int32_t          remain;
+
+   slot = &(ptr->ring[ticket % CONTROL_CMD_RING_SLOTS]);
+   controlCmdDeadline(&end,timeout);
+
+   while ( (seq = __atomic_load_n(&(slot->sequence),__ATOMIC_ACQUIRE)) != ticket+2 ) {
+      if ( seq != ticket+1 ) return(-1);
+
+      if ( (remain = controlCmdRemain(&end)) == 0 ) {
+         exp = ticket+1;
+         if ( __atomic_compare_exchange_n(&(slot->sequence),&exp,ticket+3,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) ) return(0);
+      }
+      else controlCmdFutexWait(&(slot->sequence),seq,remain);
+   }
+
+   // Hold the result against reclaim while copying
+   exp = ticket+2;
+   if ( ! __atomic_compare_exchange_n(&(slot->sequence),&exp,ticket+4,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) ) return(-1);
+
+   if ( result != NULL ) {
+      slot->cmdResult[CONTROL_CMD_RESULT_SIZE-1] = '\0';
+      strcpy(result,slot->cmdResult);
+   }
+   if ( error != NULL ) {
+      slot->cmdError[CONTROL_CMD_ERROR_SIZE-1] = '\0';
+      strcpy(error,slot->cmdError);
+   }
+
+   // Release slot for the next ticket
+   __atomic_store_n(&(slot->sequence),ticket+CONTROL_CMD_RING_SLOTS,__ATOMIC_RELEASE);
+   controlCmdFutexWake(&(slot->sequence));
+   return(1);
+}
+
+// Return ring slot if the command for ticket is ready, called by ControlServer
+inline ControlCmdSlot * controlCmdRingGetCommand ( ControlCmdMemory *ptr, uint32_t ticket ) {
+   ControlCmdSlot *slot;
+   uint32_t        seq;
+
+   slot = &(ptr->ring[ticket % CONTROL_CMD_RING_SLOTS]);
+   seq  = __atomic_load_n(&(slot->sequence),__ATOMIC_ACQUIRE);
+   if ( seq != ticket+1 && seq != ticket+3 ) return(NULL);
+
+   slot->cmdArgA[CONTROL_CMD_RING_ARGA_SIZE-1] = '\0';
+   slot->cmdArgB[CONTROL_CMD_ARGB_SIZE-1] = '\0';
+   return(slot);
+}
+
+// Complete ring command for ticket, called by ControlServer in ticket order
+inline void controlCmdRingAckCommand ( ControlCmdMemory *ptr, uint32_t ticket ) {
+   ControlCmdSlot *slot;
+   uint32_t        exp;
+
+   slot = &(ptr->ring[ticket % CONTROL_CMD_RING_SLOTS]);
+   exp  = ticket+1;
+   slot->doneTime = controlCmdMsec();
+
+   // Abandoned commands are released here, skipped ones by the reclaim
+   if ( ! __atomic_compare_exchange_n(&(slot->sequence),&exp,ticket+2,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) ) {
+      exp = ticket+3;
+      __atomic_compare_exchange_n(&(slot->sequence),&exp,ticket+CONTROL_CMD_RING_SLOTS,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE);
+   }
+
+   __atomic_store_n(&(ptr->ringTail),ticket+1,__ATOMIC_RELEASE);
+   controlCmdFutexWake(&(slot->sequence));
+}
+
+// Skip a ticket claimed by a client but not published, called by ControlServer
+// once the ticket was not published within CONTROL_CMD_RING_PUBLISH. Returns 1
+// if skipped, 0 if the ticket is not claimed or was published meanwhile.
+inline int32_t controlCmdRingSkip ( ControlCmdMemory *ptr, uint32_t ticket ) {
+   ControlCmdSlot *slot;
+   uint32_t        exp;
+
+   if ( (int32_t)(__atomic_load_n(&(ptr->ringHead),__ATOMIC_ACQUIRE) - ticket) <= 0 ) return(0);
+
+   slot = &(ptr->ring[ticket % CONTROL_CMD_RING_SLOTS]);
+   slot->doneTime = controlCmdMsec();
+   exp = ticket;
+   return(__atomic_compare_exchange_n(&(slot->sequence),&exp,ticket+5,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE)?1:0);
+}
+
+// Free done slots whose result was not collected and skipped slots within
+// timeout milliseconds, called by ControlServer. Returns the number of slots freed.
+inline uint32_t controlCmdRingReclaim ( ControlCmdMemory *ptr, uint32_t timeout ) {
+   ControlCmdSlot *slot;
+   uint32_t        now;
+   uint32_t        seq;
+   uint32_t        state;
+   uint32_t        x;
+   uint32_t        ret;
+
+   now = controlCmdMsec();
+   ret = 0;
+   for (x=0; x < CONTROL_CMD_RING_SLOTS; x++) {
+      slot = &(ptr->ring[x]);
+      seq  = __atomic_load_n(&(slot->sequence),__ATOMIC_ACQUIRE);
+
+      // Done or skipped state of the slot's ticket, seq-2 or seq-5
+      state = (seq - x) % CONTROL_CMD_RING_SLOTS;
+      if ( (state != 2 && state != 5) || (now - slot->doneTime) < timeout ) continue;
+
+      if ( __atomic_compare_exchange_n(&(slot->sequence),&seq,seq-state+CONTROL_CMD_RING_SLOTS,false,__ATOMIC_ACQ_REL,__ATOMIC_ACQUIRE) ) {
+         controlCmdFutexWake(&(slot->sequence));
+         ret++;
+      }
+   }
+   return(ret);
+}
+
+// Wait for ring submissions after seen, timeout in milliseconds. Returns the submit count.
+inline uint32_t controlCmdRingWait ( ControlCmdMemory *ptr, uint32_t seen, int32_t timeout ) {
+   if ( __atomic_load_n(&(ptr->ringSubmit),__ATOMIC_ACQUIRE) == seen ) 
+      controlCmdFutexWait(&(ptr->ringSubmit),seen,timeout);
+   return(__atomic_load_n(&(ptr->ringSubmit),__ATOMIC_ACQUIRE));
+}
+
+// Snapshot key hash, FNV-1a, never zero
+inline uint32_t controlCmdSnapHash ( const char *key ) {
+   uint32_t hash = 2166136261u;
+
+   while ( *key != '\0' ) {
+      hash ^= (uint8_t)(*key++);
+      hash *= 16777619u;
+   }
+   return((hash == 0)?1:hash);
+}
+
+// Find snapshot entry for key, or the free entry where it belongs. NULL if the table is full.
+inline ControlCmdSnapEntry * controlCmdSnapFind ( ControlCmdMemory *ptr, uint8_t kind, const char *key, uint32_t hash ) {
+   ControlCmdSnapEntry *entry;
+   uint32_t             x;
+
+   for (x=0; x < CONTROL_CMD_SNAP_SLOTS; x++) {
+      entry = &(ptr->snapshot.entry[(hash + x) & (CONTROL_CMD_SNAP_SLOTS-1)]);
+      if ( entry->hash == 0 ) return(entry);
+      if ( entry->hash == hash && entry->kind == kind && strncmp(entry->key,key,CONTROL_CMD_SNAP_KEY_SIZE) == 0 ) return(entry);
+   }
+   return(NULL);
+}
+
+// Start snapshot update, called by System
+inline void controlCmdSnapBegin ( ControlCmdMemory *ptr ) {
+   __atomic_add_fetch(&(ptr->snapshot.version),1,__ATOMIC_ACQ_REL);
+   __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// End snapshot update, called by System
+inline void controlCmdSnapEnd ( ControlCmdMemory *ptr ) {
+   __atomic_add_fetch(&(ptr->snapshot.version),1,__ATOMIC_RELEASE);
+}
+
+// Remove all snapshot entries, called by System between begin and end
+// before the variable list is written again.
+inline void controlCmdSnapClear ( ControlCmdMemory *ptr ) {
+   uint32_t x;
+
+   for (x=0; x < CONTROL_CMD_SNAP_SLOTS; x++) ptr->snapshot.entry[x].hash = 0;
+   ptr->snapshot.count = 0;
+}
+
+// Set snapshot value, called by System between begin and end.
+// Returns 0 if the key is too long or the table is full.
+inline int32_t controlCmdSnapSet ( ControlCmdMemory *ptr, uint8_t kind, const char *key, const char *value ) {
+   ControlCmdSnapEntry *entry;
+   uint32_t             hash;
+
+   if ( strlen(key) >= CONTROL_CMD_SNAP_KEY_SIZE ) return(0);
+   hash = controlCmdSnapHash(key);
+   if ( (entry = controlCmdSnapFind(ptr,kind,key,hash)) == NULL ) return(0);
+
+   if ( entry->hash == 0 ) {
+      strcpy(entry->key,key);
+      entry->kind = kind;
+      entry->hash = hash;
+      ptr->snapshot.count++;
+   }
+   entry->truncated = ( strlen(value) >= CONTROL_CMD_SNAP_VALUE_SIZE );
+   strncpy(entry->value,value,CONTROL_CMD_SNAP_VALUE_SIZE);
+   entry->value[CONTROL_CMD_SNAP_VALUE_SIZE-1] = '\0';
+   return(1);
+}
+
+// Get snapshot value into a buffer of CONTROL_CMD_SNAP_VALUE_SIZE bytes.
+// Returns 1 if found, 0 if the key is not in the snapshot and -1 if the
+// value is too long for the snapshot, the xml buffers hold it.
+inline int32_t controlCmdSnapGet ( ControlCmdMemory *ptr, uint8_t kind, const char *key, char *value ) {
+   ControlCmdSnapEntry *entry;
+   uint32_t             hash;
+   uint32_t             before;
+   uint32_t             after;
+   int32_t              ret;
+
+   if ( strlen(key) >= CONTROL_CMD_SNAP_KEY_SIZE ) return(0);
+   hash = controlCmdSnapHash(key);
+
+   do {
+      while ( (before = __atomic_load_n(&(ptr->snapshot.version),__ATOMIC_ACQUIRE)) & 1 ) sched_yield();
+
+      ret = 0;
+      if ( (entry = controlCmdSnapFind(ptr,kind,key,hash)) != NULL && entry->hash != 0 ) {
+         if ( entry->truncated ) ret = -1;
+         else {
+            memcpy(value,entry->value,CONTROL_CMD_SNAP_VALUE_SIZE);
+            value[CONTROL_CMD_SNAP_VALUE_SIZE-1] = '\0';
+            ret = 1;
+         }
+      }
+
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      after = __atomic_load_n(&(ptr->snapshot.version),__ATOMIC_ACQUIRE);
+   } while ( before != after );
+
+   return(ret);
+}
+
 // Set Config
 inline void controlCmdSetConfig ( ControlCmdMemory *ptr, const char *config ) {
    strncpy(ptr->xmlConfigBuffer,config,CONTROL_CMD_CONFIG_SIZE);
@@ -277,6 +679,19 @@ inline void controlCmdSetResult ( ControlCmdMemory *ptr, const char *result ) {
 inline void controlCmdAckCommand ( ControlCmdMemory *ptr ) { }
 inline int32_t controlCmdGetResult ( ControlCmdMemory *ptr, char *result ) { return 0; }
 inline int32_t controlCmdGetResultTimeout ( ControlCmdMemory *ptr, char *result, int32_t timeout ) { return 0; }
+inline int32_t controlCmdRingSubmit ( ControlCmdMemory *ptr, uint8_t cmdType, const char *argA, const char *argB,
+                                      uint32_t *ticket, int32_t timeout ) { return 0; }
+inline int32_t controlCmdRingResult ( ControlCmdMemory *ptr, uint32_t ticket, char *result, char *error, int32_t timeout ) { return 0; }
+inline ControlCmdSlot * controlCmdRingGetCommand ( ControlCmdMemory *ptr, uint32_t ticket ) { return NULL; }
+inline void controlCmdRingAckCommand ( ControlCmdMemory *ptr, uint32_t ticket ) { }
+inline int32_t controlCmdRingSkip ( ControlCmdMemory *ptr, uint32_t ticket ) { return 0; }
+inline uint32_t controlCmdRingReclaim ( ControlCmdMemory *ptr, uint32_t timeout ) { return 0; }
+inline uint32_t controlCmdRingWait ( ControlCmdMemory *ptr, uint32_t seen, int32_t timeout ) { return 0; }
+inline void controlCmdSnapBegin ( ControlCmdMemory *ptr ) { }
+inline void controlCmdSnapEnd ( ControlCmdMemory *ptr ) { }
+inline void controlCmdSnapClear ( ControlCmdMemory *ptr ) { }
+inline int32_t controlCmdSnapSet ( ControlCmdMemory *ptr, uint8_t kind, const char *key, const char *value ) { return 0; }
+inline int32_t controlCmdSnapGet ( ControlCmdMemory *ptr, uint8_t kind, const char *key, char *value ) { return 0; }
 inline void controlCmdSetConfig ( ControlCmdMemory *ptr, const char *config ) { }
 inline const char * controlCmdGetConfig ( ControlCmdMemory *ptr ) { return NULL; }
 inline void controlCmdSetStatus ( ControlCmdMemory *ptr, const char *status ) { }
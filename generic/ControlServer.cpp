@@ -18,45 +18,81 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 08/29/2011: created
+// 10/17/2026: Moved to epoll with per client output buffers
+// 10/17/2026: Added binary control protocol
+// 10/17/2026: Added shared memory command ring
+// 10/17/2026: Variable gets use the shared memory snapshot
+// 10/17/2026: Shared memory register access without xml
+// 10/17/2026: Unpublished ring tickets are skipped
 //-----------------------------------------------------------------------------
 #include <System.h>
 #include <ControlServer.h>
+#include <ControlBinary.h>
+#include <Variable.h>
+#include <Register.h>
+#include <Command.h>
 #include <XmlVariables.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <stdint.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <netinet/tcp.h>
 using namespace std;
 
-bool doalotprint=false;
 // Constructor
 ControlServer::ControlServer ( ) {
    uint32_t x;
 
    debug_      = false;
    servFd_     = -1;
+   binFd_      = -1;
    port_       = 0;
    system_     = NULL;
 
    for ( x=0; x < MaxClients_; x++ ) {
       connFd_[x] = -1;
-      rxData_[x].str("");
+      binary_[x] = false;
+      statusVersion_[x] = 0;
+      rxData_[x] = "";
+      txBuffer_[x] = NULL;
+      txHead_[x] = 0;
+      txCount_[x] = 0;
    }
+   epollFd_ = epoll_create1(0);
    memset((char *) (&servAddr_),0,sizeof(servAddr_));
    memset((char *) (&connAddr_),0,sizeof(connAddr_));
 
    smem_ = NULL;
 
+   ringNext_    = 0;
+   ringPipe_[0] = -1;
+   ringPipe_[1] = -1;
+   ringRun_     = false;
+   ringWaiting_ = false;
+
    signal(SIGPIPE, SIG_IGN);
 }
 
 // DeConstructor
 ControlServer::~ControlServer ( ) {
+   uint32_t x;
+
+   if ( __atomic_load_n(&ringRun_,__ATOMIC_ACQUIRE) ) {
+      __atomic_store_n(&ringRun_,false,__ATOMIC_RELEASE);
+      pthread_join(ringThread_,NULL);
+   }
+   if ( ringPipe_[0] >= 0 ) close(ringPipe_[0]);
+   if ( ringPipe_[1] >= 0 ) close(ringPipe_[1]);
    if ( smem_ != NULL ) controlCmdClose(smem_);
    stopListen();
+   if ( epollFd_ >= 0 ) close(epollFd_);
+   for ( x=0; x < MaxClients_; x++ ) if ( txBuffer_[x] != NULL ) free(txBuffer_[x]);
 }
 
 // Enable shared 
 void ControlServer::enableSharedMemory ( string system, uint32_t id ) {
+   struct epoll_event ev;
 
    // Attempt to open and init shared memory
    if ( (smemFd_ = controlCmdOpenAndMap ( &smem_ , system.c_str(), id )) < 0 ) {
@@ -66,6 +102,78 @@ void ControlServer::enableSharedMemory ( string system, uint32_t id ) {
 
    // Init shared memory
    controlCmdInit(smem_);
+   ringNext_    = 0;
+   ringWaiting_ = false;
+
+   // Ring submissions wake epoll through a pipe
+   if ( __atomic_load_n(&ringRun_,__ATOMIC_ACQUIRE) ) return;
+   if ( pipe(ringPipe_) < 0 ) throw string("ControlServer::enableSharedMemory -> Failed to create pipe");
+   fcntl(ringPipe_[0],F_SETFL,fcntl(ringPipe_[0],F_GETFL) | O_NONBLOCK);
+   fcntl(ringPipe_[1],F_SETFL,fcntl(ringPipe_[1],F_GETFL) | O_NONBLOCK);
+
+   ev.events   = EPOLLIN;
+   ev.data.u32 = MaxClients_ + 2;
+   epoll_ctl(epollFd_,EPOLL_CTL_ADD,ringPipe_[0],&ev);
+
+   __atomic_store_n(&ringRun_,true,__ATOMIC_RELEASE);
+   if ( pthread_create(&ringThread_,NULL,ringRun,this) ) {
+      __atomic_store_n(&ringRun_,false,__ATOMIC_RELEASE);
+      throw string("ControlServer::enableSharedMemory -> Failed to create ring thread");
+   }
+}
+
+// Ring wakeup thread
+void * ControlServer::ringRun ( void *t ) {
+   ControlServer *ti;
+   ti = (ControlServer *)t;
+   ti->ringHandler();
+   pthread_exit(NULL);
+   return(NULL);
+}
+
+// Wait for ring submissions and wake epoll, free results no client collected
+void ControlServer::ringHandler ( ) {
+   uint32_t seen;
+   uint32_t curr;
+   uint32_t freed;
+   char     byte;
+
+   byte = 0;
+   seen = __atomic_load_n(&(smem_->ringSubmit),__ATOMIC_ACQUIRE);
+   while ( __atomic_load_n(&ringRun_,__ATOMIC_ACQUIRE) ) {
+      curr = controlCmdRingWait(smem_,seen,100);
+      if ( curr != seen ) {
+         seen = curr;
+         write(ringPipe_[1],&byte,1);
+      }
+      if ( (freed = controlCmdRingReclaim(smem_,CONTROL_CMD_RING_RECLAIM)) > 0 && debug_ )
+         cout << "ControlServer::ringHandler -> Freed " << dec << freed << " uncollected ring results" << endl;
+   }
+}
+
+// Skip the next ticket if its client did not publish it in time. Tickets
+// complete in order, a client which died between claiming and publishing
+// would block all later commands.
+bool ControlServer::ringSkip ( ) {
+   uint32_t now;
+
+   if ( (int32_t)(__atomic_load_n(&(smem_->ringHead),__ATOMIC_ACQUIRE) - ringNext_) <= 0 ) {
+      ringWaiting_ = false;
+      return(false);
+   }
+
+   now = controlCmdMsec();
+   if ( ! ringWaiting_ || ringWaitTicket_ != ringNext_ ) {
+      ringWaiting_    = true;
+      ringWaitTicket_ = ringNext_;
+      ringWaitTime_   = now;
+      return(false);
+   }
+   if ( (now - ringWaitTime_) < CONTROL_CMD_RING_PUBLISH || ! controlCmdRingSkip(smem_,ringNext_) ) return(false);
+
+   if ( debug_ ) cout << "ControlServer::ringSkip -> Skipped unpublished ring ticket " << dec << ringNext_ << endl;
+   ringWaiting_ = false;
+   return(true);
 }
 
 // Set debug flag
@@ -76,6 +184,9 @@ void ControlServer::setDebug ( bool debug ) {
 // Set top level device
 void ControlServer::setSystem ( System *system ) {
    system_ = system;
+
+   // Clients receive status changes through the journal
+   if ( system_ != NULL ) system_->setStatusJournal(true);
 }
 
 System* ControlServer::getSystem () {
@@ -85,7 +196,8 @@ System* ControlServer::getSystem () {
 
 // Start tcpip listen socket
 int32_t ControlServer::startListen ( int32_t port ) {
-   stringstream err;
+   stringstream       err;
+   struct epoll_event ev;
 
    // Init structures
    servFd_ = socket(AF_INET, SOCK_STREAM, 0);
@@ -128,6 +240,11 @@ int32_t ControlServer::startListen ( int32_t port ) {
    // Start listen
    listen(servFd_,5);
 
+   // Add to epoll set, index past the clients identifies the server
+   ev.events   = EPOLLIN;
+   ev.data.u32 = MaxClients_;
+   epoll_ctl(epollFd_,EPOLL_CTL_ADD,servFd_,&ev);
+
    // Debug
    if ( debug_ ) 
       cout << "ControlServer::startListen -> Listening on port " << dec << port << endl;
@@ -135,15 +252,62 @@ int32_t ControlServer::startListen ( int32_t port ) {
    return(port);
 }
 
+// Start binary protocol listen socket
+int32_t ControlServer::startBinaryListen ( int32_t port ) {
+   stringstream       err;
+   struct epoll_event ev;
+   struct sockaddr_in addr;
+   socklen_t          len;
+
+   binFd_ = socket(AF_INET, SOCK_STREAM, 0);
+   memset((char *)&addr,0,sizeof(addr));
+   addr.sin_family      = AF_INET;
+   addr.sin_addr.s_addr = INADDR_ANY;
+   addr.sin_port        = htons(port);
+
+   // Attempt to bind socket, port zero is assigned by the system
+   if ( bind(binFd_, (struct sockaddr *) &addr, sizeof(addr)) < 0 ) {
+      err.str("");
+      err << "ControlServer::startBinaryListen -> Failed to bind socket " << dec << port << endl;
+      close(binFd_);
+      binFd_ = -1;
+      if ( debug_ ) cout << err.str();
+      throw(err.str());
+   }
+   len = sizeof(addr);
+   getsockname(binFd_,(struct sockaddr *)&addr,&len);
+   port = ntohs(addr.sin_port);
+
+   // Start listen
+   listen(binFd_,5);
+
+   // Add to epoll set
+   ev.events   = EPOLLIN;
+   ev.data.u32 = MaxClients_ + 1;
+   epoll_ctl(epollFd_,EPOLL_CTL_ADD,binFd_,&ev);
+
+   if ( debug_ ) 
+      cout << "ControlServer::startBinaryListen -> Listening on port " << dec << port << endl;
+
+   return(port);
+}
+
 // Close tcpip listen socket
 void ControlServer::stopListen ( ) {
    uint32_t x;
 
    for ( x=0; x < MaxClients_; x++ ) {
-      if ( connFd_[x] >= 0 ) close(connFd_[x]);
-      connFd_[x] = -1;
+      if ( connFd_[x] >= 0 ) closeClient(x);
    }
-   if ( servFd_ >= 0 ) close(servFd_);
+   if ( servFd_ >= 0 ) {
+      epoll_ctl(epollFd_,EPOLL_CTL_DEL,servFd_,NULL);
+      close(servFd_);
+   }
+   if ( binFd_ >= 0 ) {
+      epoll_ctl(epollFd_,EPOLL_CTL_DEL,binFd_,NULL);
+      close(binFd_);
+   }
+   binFd_ = -1;
    servFd_ = -1;
 
    // Debug
@@ -153,13 +317,10 @@ void ControlServer::stopListen ( ) {
 
 // Receive and process data if ready
 void ControlServer::receive ( uint32_t selectPeriod, uint32_t pollPeriod, bool *stop ) {
-   fd_set         fdset;
-   int32_t        maxFd;
-   socklen_t      cliLen;
-   struct timeval tval;
-   int32_t        newFd;
+   struct epoll_event events[MaxClients_+3];
+   int32_t        timeout;
    int32_t        ret;
-   stringstream   msg;
+   int32_t        evCount;
    uint32_t       x;
    int32_t        y;
    string         pmsg;
@@ -169,274 +330,713 @@ void ControlServer::receive ( uint32_t selectPeriod, uint32_t pollPeriod, bool *
    bool           tcpPend;
    bool           indPend[MaxClients_];
    bool           shmPend;
+   ControlCmdSlot *slot;
+   uint32_t       ringFirst;
+   uint32_t       errSize;
+   string         errors;
+   bool           ringMore;
+   bool           ringPend;
    int32_t        pollCycles;
    int32_t        pollCount;
+   uint64_t       version;
+   map<uint64_t,pair<uint64_t,string> >           status;
+   map<uint64_t,pair<uint64_t,string> >::iterator statIter;
 
    if ( pollPeriod < selectPeriod ) pollCycles = 1;
    else  pollCycles = (pollPeriod/selectPeriod);
    pollCount = 0;
 
-   //cout<<"[dev] *stop(value) == "<<stop<<"; &stop ==" << &stop << endl;
-   //int iamcounter=0;
+   // Epoll timeout is in milliseconds
+   timeout  = (selectPeriod + 999) / 1000;
+   ringMore = false;
+
    do {
-     //cout<<"[dev] cntrlServer: I got the stop pointer! => "<< iamcounter << "?pollCount ==>"<<pollCount<<endl;
-     //iamcounter++;
       pollCount++;
       tcpPend = false;
       shmPend = false;
+      for ( x=0; x < MaxClients_; x++ ) indPend[x] = false;
+
+      // Wait for activity, ring commands left from the last batch do not wait
+      evCount = epoll_wait(epollFd_,events,MaxClients_+3,ringMore?0:timeout);
+
+      // Something is ready
+      for ( y=0; y < evCount; y++ ) {
+         x = events[y].data.u32;
 
-      // Setup for listen call
-      FD_ZERO(&fdset);
-      maxFd = 0;
-      if ( servFd_ >= 0 ) {
-         FD_SET(servFd_,&fdset);
-         if ( servFd_ > maxFd ) maxFd = servFd_;
+         // Ring wakeup, commands are picked up below
+         if ( x == (MaxClients_ + 2) ) {
+            while ( read(ringPipe_[0],buffer_,sizeof(buffer_)) > 0 );
+            continue;
+         }
+
+         // server sockets are ready
+         if ( x == MaxClients_ || x == (MaxClients_ + 1) ) {
+            acceptClient((x == MaxClients_)?servFd_:binFd_,(x != MaxClients_));
+            continue;
+         }
+
+         // Client may have been dropped by an earlier event
+         if ( connFd_[x] < 0 ) continue;
+
+         // Client is writable, flush pending output
+         if ( events[y].events & EPOLLOUT ) {
+            flushData(x);
+            if ( connFd_[x] < 0 ) continue;
+         }
+
+         // Client has data or has closed
+         if ( events[y].events & (EPOLLIN | EPOLLHUP | EPOLLERR) ) {
+            ret = read(connFd_[x],buffer_,9000);
+
+            // Connection is lost
+            if ( ret == 0 || (ret < 0 && errno != EAGAIN && errno != EINTR) ) closeClient(x);
+
+            // Process data
+            else if ( ret > 0 ) {
+               if ( binary_[x] ) rxBinary(x,buffer_,ret,&(indPend[x]));
+               else rxData(x,buffer_,ret,&(indPend[x]));
+               if ( indPend[x] ) tcpPend = true;
+            }
+         }
       }
-      for ( x=0; x < MaxClients_; x++ ) {
-         if ( connFd_[x] >= 0 ) {
-            FD_SET(connFd_[x],&fdset);
-            if ( connFd_[x] > maxFd ) maxFd = connFd_[x];
-            indPend[x] = false;
+
+      // Shared memory commands
+      if ( smem_ != NULL && controlCmdGetCommand(smem_,&cmdType,&cmdArgA,&cmdArgB) ) {
+         if ( debug_ ) cout << "ControlServer::receive -> Processing shared memory command type " << dec << cmdType << endl;
+         controlCmdSetResult(smem_,shmCommand(cmdType,cmdArgA,cmdArgB).c_str());
+         shmPend = true;
+      }
+
+      // Shared memory command ring. Commands reading the shared config and status
+      // buffers need a poll after any earlier command, the batch ends there.
+      ringFirst = ringNext_;
+      ringMore  = false;
+      while ( smem_ != NULL ) {
+         if ( (slot = controlCmdRingGetCommand(smem_,ringNext_)) == NULL ) {
+            if ( ! ringSkip() ) break;
+            ringNext_++;
+            continue;
          }
-         else rxData_[x].str("");
+         if ( ringNext_ != ringFirst && (slot->cmdType == CONTROL_CMD_TYPE_GET_CONFIG || 
+                                         slot->cmdType == CONTROL_CMD_TYPE_GET_STATUS) ) {
+            ringMore = true;
+            break;
+         }
+         if ( debug_ ) cout << "ControlServer::receive -> Processing ring command type " << dec << (uint32_t)slot->cmdType << endl;
+
+         errSize = system_->pendingErrors().size();
+         strncpy(slot->cmdResult,shmCommand(slot->cmdType,slot->cmdArgA,slot->cmdArgB).c_str(),CONTROL_CMD_RESULT_SIZE);
+         slot->cmdResult[CONTROL_CMD_RESULT_SIZE-1] = '\0';
+
+         // Errors raised by this command
+         errors = system_->pendingErrors();
+         if ( errors.size() > errSize ) {
+            strncpy(slot->cmdError,errors.substr(errSize).c_str(),CONTROL_CMD_ERROR_SIZE);
+            slot->cmdError[CONTROL_CMD_ERROR_SIZE-1] = '\0';
+         }
+         ringNext_++;
       }
+      ringPend = ( ringNext_ != ringFirst );
 
-      // Call select
-      tval.tv_sec  = 0;
-      tval.tv_usec = selectPeriod;
-      ret = select(maxFd+1,&fdset,NULL,NULL,&tval);
+      // Poll if timeout or xml or tcp command
+      if ( shmPend || ringPend || tcpPend || (pollCount >= pollCycles) ) {
+         if ( smem_ != NULL && smem_->cmdResult[0] != '\0' && debug_ )
+            cout << "ControlServer::receive -> Command result: " << smem_->cmdResult << endl;
+	
+         pmsg = system_->poll(smem_);
+         pollCount = 0;
 
-      // Something is ready
-      if ( ret > 0 ) {
+         // Ack pending command
+         if ( shmPend ) {
+            if ( debug_ ) cout << "ControlServer::receive -> Done Processing shared memory message" << endl;
+            controlCmdAckCommand(smem_);
+         }
 
-         // server socket is ready
-         if ( servFd_ >= 0 && FD_ISSET(servFd_,&fdset)  ) {
+         // Complete ring commands
+         for ( ; ringFirst != ringNext_; ringFirst++ ) controlCmdRingAckCommand(smem_,ringFirst);
 
-            // Accept new client
-            cliLen = sizeof(connAddr_);
+         // Send message
+         if ( pmsg != "" ) {
+            pmsg.append("\f");
 
-#ifdef SOCK_NONBLOCK
-            newFd = accept4(servFd_,(struct sockaddr *)&connAddr_,&cliLen,SOCK_NONBLOCK);
-#else
-            newFd = accept(servFd_,(struct sockaddr *)&connAddr_,&cliLen);
-#endif
+            for ( x=0; x < MaxClients_; x++ ) {
+               if ( connFd_[x] >= 0 && (!binary_[x]) && ((!quietMode_[x]) || indPend[x]) ) 
+                  sendData(x,pmsg.c_str(),pmsg.length());
+            }
+         }
 
-            // Error on accept
-            if ( newFd < 0 ) {
-               //if ( debug_ ) 
-                  //cout << "ControlServer::receive -> Failed to accept on socket" << endl;
-            } else {
+         // Send status changes, rendered once for each distinct client version
+         status.clear();
+         for ( x=0; x < MaxClients_; x++ ) {
+            if ( connFd_[x] >= 0 && (!binary_[x]) && ((!quietMode_[x]) || indPend[x]) ) {
+               statIter = status.find(statusVersion_[x]);
 
-               // Find empty client
-               for ( x=0; x < MaxClients_; x++ ) {
-                  if ( connFd_[x] == -1 ) break;
+               if ( statIter == status.end() ) {
+                  pmsg = system_->statusChanges(statusVersion_[x],&version);
+                  if ( pmsg != "" ) pmsg.append("\f");
+                  statIter = status.insert(make_pair(statusVersion_[x],make_pair(version,pmsg))).first;
                }
 
-               // Out of clients
-               if ( x == MaxClients_ ) {
-                  //if ( debug_ ) cout << "ControlServer::receive -> Rejected connection" << endl;
-                  close(newFd);
-               }
-               else {
-                  //if ( debug_ ) cout << "ControlServer::receive -> Accepted new connection" << endl;
-                  connFd_[x] = newFd;
-                  quietMode_[x] = false;
-
-                  msg.str("");
-                  msg << "<system>" << endl;
-                  msg << system_->structureString(false,false);
-                  msg << system_->configString(false,false);
-                  msg << system_->statusString(false,false,false,true);
-                  msg << "</system>" << endl;
-                  msg << "\f";
-		  cout<<"[CntrlServer:dev] sendData from HERE 1 !"<<endl;
-		  
-                  sendData(x,msg.str().c_str(),msg.str().length());
-               }
+               if ( statIter->second.second != "" ) 
+                  sendData(x,statIter->second.second.c_str(),statIter->second.second.length());
+
+               // Version only advances when the changes were written or queued
+               if ( connFd_[x] >= 0 ) statusVersion_[x] = statIter->second.first;
             }
          }
+      }
+   } while ( stop != NULL && *stop == false );
+}
 
-         // client socket is ready
-         for ( x=0; x < MaxClients_; x++ ) {
-            if ( connFd_[x] >= 0 && FD_ISSET(connFd_[x],&fdset) ) {
+// Execute shared memory command
+string ControlServer::shmCommand ( uint8_t cmdType, const char *argA, const char *argB ) {
+   string ret;
+
+   vars_.clear();
+
+   // Process Command
+   switch(cmdType) {
+
+      // One arg,  XML string, No Result
+      case CONTROL_CMD_TYPE_SEND_XML :
+         system_->parseXmlString(argA);
+         ret = "";
+         break;
+
+      // Two args, Config Variable and String Value, No Result
+      case CONTROL_CMD_TYPE_SET_CONFIG :
+         sprintf(xmlCmd_,"<system><config>%s</config></system>\n",vars_.setXml(argA,argB).c_str());
+         system_->parseXmlString(xmlCmd_);
+         ret = "";
+         break;
+
+      // One Arg, Config Variable, Result is Value
+      // Snapshot lookup, the xml buffers are parsed for keys it does not hold
+      case CONTROL_CMD_TYPE_GET_CONFIG :
+         if ( controlCmdSnapGet(smem_,CONTROL_CMD_SNAP_CONFIG,argA,snapValue_) == 1 ) ret = snapValue_;
+         else {
+            vars_.parse("config",controlCmdGetConfig(smem_));
+            ret = vars_.get(argA);
+         }
+         break;
+
+      // One Arg, Status Variable, Result is Value
+      case CONTROL_CMD_TYPE_GET_STATUS :
+         if ( controlCmdSnapGet(smem_,CONTROL_CMD_SNAP_STATUS,argA,snapValue_) == 1 ) ret = snapValue_;
+         else {
+            vars_.parse("status",controlCmdGetStatus(smem_));
+            vars_.parse("status",controlCmdGetPerStatus(smem_));
+            ret = vars_.get(argA);
+         }
+         break;
+
+      // Two Args, Device Path and command, No Result
+      case CONTROL_CMD_TYPE_EXEC_COMMAND  :
+         sprintf(xmlCmd_,"<system><command>%s</command></system>\n",vars_.setXml(argA,argB).c_str());
+         system_->parseXmlString(xmlCmd_);
+         ret = "";
+         break;
+
+      // Three Args, Device Path, register name and value, No Result
+      case CONTROL_CMD_TYPE_SET_REGISTER :
+         ret = shmRegister(argA,argB,true);
+         break;
+
+      // Two Args, Device Path, register name, Result is value
+      case CONTROL_CMD_TYPE_GET_REGISTER :
+         ret = shmRegister(argA,argB,false);
+         break;
+
+      default:
+         ret = "";
+         break;
+   }
+   return(ret);
+}
 
-               // Read data
-               ret = read(connFd_[x],buffer_,9000);
+// Shared memory register access, the device and register are resolved
+// once through the binary protocol name table
+string ControlServer::shmRegister ( const char *argA, const char *argB, bool write ) {
+   BinaryEntry *entry;
+   const char  *sptr;
+   char        *eptr;
+   uint32_t     value;
+
+   try {
+
+      // Write argument is the register name followed by the value
+      if ( write ) {
+         if ( (sptr = strchr(argB,' ')) == NULL ) 
+            throw(string("ControlServer::shmRegister -> Missing register value\n"));
+         sprintf(regStr_,"%s:",argA);
+         strncat(regStr_,argB,sptr-argB);
+      }
+      else sprintf(regStr_,"%s:%s",argA,argB);
 
-               // Connection is lost
-               if ( ret <= 0 ) {
-                  //if ( debug_ ) cout << "ControlServer::receive -> Closing connection" << endl;
+      entry = binaryEntry(binaryResolve(CONTROL_BIN_KIND_REGISTER,regStr_),CONTROL_BIN_KIND_REGISTER);
 
-                  // Reset
-                  rxData_[x].str("");
+      if ( entry->device->getInt("Enabled") == 0 ) 
+         throw(string("ControlServer::shmRegister -> Device is not enabled: ") + argA + "\n");
 
-                  // Close socket
-                  close(connFd_[x]);
-                  connFd_[x] = -1;
-               }
+      if ( write ) {
+         value = (uint32_t)strtoul(sptr,&eptr,0);
+         entry->device->writeSingle(entry->name,value);
+         return("");
+      }
+      value = entry->device->readSingle(entry->name);
 
-               // Process each byte
-               for (y=0; y<ret; y++) {
+   } catch ( string error ) {
+      system_->addError(error);
+      return("");
+   }
 
-                  if ( buffer_[y] == '\a' || buffer_[y] == 27 ) quietMode_[x] = true;
+   sprintf(regStr_,"0x%x",value);
+   return(regStr_);
+}
 
-                  else if ( buffer_[y] == '\f' || buffer_[y] == 0x4 ) {
+// Accept connection on listen socket
+void ControlServer::acceptClient ( int32_t fd, bool binary ) {
+   struct epoll_event ev;
+   stringstream       msg;
+   socklen_t          cliLen;
+   int32_t            newFd;
+   int32_t            flag;
+   uint32_t           x;
 
-                     // Send to top level
-                     if ( system_ != NULL ) {
-                        if ( debug_ ) {
-                           cout << "ControlServer::receive -> Processing message: " << endl;
-                           cout << rxData_[x].str() << endl;
-                        }
-                        system_->parseXmlString (rxData_[x].str()); 
-                        indPend[x] = true;
+   cliLen = sizeof(connAddr_);
 
-                        tcpPend = true;
-                        if ( debug_ ) cout << "ControlServer::receive -> Done Processing message" << endl;
-                     }
-                     rxData_[x].str("");
-                  }
-                  else rxData_[x] << buffer_[y];
-               }
+#ifdef SOCK_NONBLOCK
+   newFd = accept4(fd,(struct sockaddr *)&connAddr_,&cliLen,SOCK_NONBLOCK);
+#else
+   newFd = accept(fd,(struct sockaddr *)&connAddr_,&cliLen);
+   if ( newFd >= 0 ) fcntl(newFd,F_SETFL,fcntl(newFd,F_GETFL) | O_NONBLOCK);
+#endif
+
+   // Error on accept
+   if ( newFd < 0 ) return;
+
+   // Find empty client
+   for ( x=0; x < MaxClients_; x++ ) {
+      if ( connFd_[x] == -1 ) break;
+   }
+
+   // Out of clients
+   if ( x == MaxClients_ ) {
+      close(newFd);
+      return;
+   }
+
+   connFd_[x]        = newFd;
+   binary_[x]        = binary;
+   quietMode_[x]     = false;
+   statusVersion_[x] = Variable::currentVersion();
+   rxData_[x]        = "";
+   txHead_[x]        = 0;
+   txCount_[x]       = 0;
+
+   ev.events   = EPOLLIN;
+   ev.data.u32 = x;
+   epoll_ctl(epollFd_,EPOLL_CTL_ADD,newFd,&ev);
+
+   // Binary responses are small and latency bound
+   flag = 1;
+   if ( binary ) setsockopt(newFd,IPPROTO_TCP,TCP_NODELAY,&flag,sizeof(flag));
+
+   if ( debug_ ) cout << "ControlServer::acceptClient -> Accepted new " << ((binary)?"binary":"xml") << " connection" << endl;
+
+   // Binary clients do not get the system description
+   if ( binary ) return;
+
+   msg.str("");
+   msg << "<system>" << endl;
+   msg << system_->structureString(false,false);
+   msg << system_->configString(false,false);
+   msg << system_->statusString(false,false,false,true);
+   msg << "</system>" << endl;
+   msg << "\f";
+
+   sendData(x,msg.str().c_str(),msg.str().length());
+}
+
+// Process received bytes from client
+void ControlServer::rxData ( uint32_t idx, const char *buffer, uint32_t size, bool *pend ) {
+   const char  delim[4] = { '\f', 0x4, '\a', 27 };
+   const char *ptr;
+   const char *end;
+   const char *next;
+   const char *found;
+   uint32_t    x;
+
+   ptr = buffer;
+   end = buffer + size;
+
+   while ( ptr < end ) {
+
+      // Locate next control character, each search is bounded by the nearest one so far
+      next = end;
+      for ( x=0; x < 4; x++ ) {
+         found = (const char *)memchr(ptr,delim[x],next-ptr);
+         if ( found != NULL ) next = found;
+      }
+
+      // Append message bytes
+      rxData_[idx].append(ptr,next-ptr);
+      if ( next == end ) break;
+      ptr = next + 1;
+
+      // Quiet mode request
+      if ( *next == '\a' || *next == 27 ) quietMode_[idx] = true;
+
+      // End of message, send to top level
+      else {
+         if ( system_ != NULL ) {
+            if ( debug_ ) {
+               cout << "ControlServer::receive -> Processing message: " << endl;
+               cout << rxData_[idx] << endl;
             }
+            system_->parseXmlString(rxData_[idx]);
+            *pend = true;
+            if ( debug_ ) cout << "ControlServer::receive -> Done Processing message" << endl;
          }
+         rxData_[idx] = "";
       }
+   }
+}
 
-      // Shared memory commands
-      if ( smem_ != NULL && controlCmdGetCommand(smem_,&cmdType,&cmdArgA,&cmdArgB) ) {
-         if ( debug_ ) cout << "ControlServer::receive -> Processing shared memory command type " << dec << cmdType << endl;
-         vars_.clear();
+// Binary protocol field helpers
+static void binPut32 ( string &buff, uint32_t value ) {
+   buff.append((const char *)&value,4);
+}
+
+static void binPutStr ( string &buff, const string &value ) {
+   binPut32(buff,value.size());
+   buff.append(value);
+}
+
+static uint32_t binGet32 ( const char **ptr, const char *end ) {
+   uint32_t value;
+   if ( (end - *ptr) < 4 ) throw(string("ControlServer::binaryFrame -> Truncated operation\n"));
+   memcpy(&value,*ptr,4);
+   *ptr += 4;
+   return(value);
+}
+
+static uint8_t binGet8 ( const char **ptr, const char *end ) {
+   if ( (end - *ptr) < 1 ) throw(string("ControlServer::binaryFrame -> Truncated operation\n"));
+   return((uint8_t)*((*ptr)++));
+}
+
+static string binGetStr ( const char **ptr, const char *end ) {
+   uint32_t len;
+   string   value;
+
+   len = binGet32(ptr,end);
+   if ( (uint32_t)(end - *ptr) < len ) throw(string("ControlServer::binaryFrame -> Truncated operation\n"));
+   value.assign(*ptr,len);
+   *ptr += len;
+   return(value);
+}
+
+// Process received bytes from binary client
+void ControlServer::rxBinary ( uint32_t idx, const char *buffer, uint32_t size, bool *pend ) {
+   uint32_t frame;
+   uint32_t pos;
+
+   rxData_[idx].append(buffer,size);
+   pos = 0;
+
+   // Each complete frame
+   while ( (rxData_[idx].size() - pos) >= 4 ) {
+      memcpy(&frame,rxData_[idx].data() + pos,4);
+
+      // Bad frame size, stream can not be recovered
+      if ( frame < (CONTROL_BIN_HEADER_SIZE - 4) || frame > CONTROL_BIN_MAX_FRAME ) {
+         if ( debug_ ) cout << "ControlServer::rxBinary -> Bad frame size. Closing connection." << endl;
+         closeClient(idx);
+         return;
+      }
+      if ( (rxData_[idx].size() - pos - 4) < frame ) break;
+
+      if ( binaryFrame(idx,rxData_[idx].data() + pos + 4,frame) ) *pend = true;
+      if ( connFd_[idx] < 0 ) return;
+      pos += (4 + frame);
+   }
+   rxData_[idx].erase(0,pos);
+}
+
+// Execute one binary request frame
+bool ControlServer::binaryFrame ( uint32_t idx, const char *data, uint32_t size ) {
+   const char  *ptr;
+   const char  *end;
+   BinaryEntry *entry;
+   uint32_t     sequence;
+   uint32_t     count;
+   uint32_t     x;
+   uint32_t     id;
+   uint32_t     value;
+   uint8_t      op;
+   uint8_t      kind;
+   string       str;
+   bool         failed;
+   bool         change;
+
+   ptr = data;
+   end = data + size;
+   failed = false;
+   change = false;
+
+   sequence = binGet32(&ptr,end);
+   count    = binGet32(&ptr,end);
+
+   // Each operation has at least its opcode, a larger count can not be answered
+   if ( count > (uint32_t)(end - ptr) ) {
+      if ( debug_ ) cout << "ControlServer::binaryFrame -> Bad operation count. Closing connection." << endl;
+      closeClient(idx);
+      return(false);
+   }
+
+   // Response header, size is filled in at the end
+   binTx_.clear();
+   binPut32(binTx_,0);
+   binPut32(binTx_,sequence);
+   binPut32(binTx_,count);
+
+   for (x=0; x < count; x++) {
 
-         // Process Command
-         switch(cmdType) {
+      // Remaining operations are skipped after an error
+      if ( failed ) {
+         binTx_.push_back(CONTROL_BIN_STATUS_SKIPPED);
+         continue;
+      }
+
+      try {
+         op = binGet8(&ptr,end);
+
+         switch (op) {
 
-            // One arg,  XML string, No Result
-            case CONTROL_CMD_TYPE_SEND_XML :
-               system_->parseXmlString(cmdArgA);
-               controlCmdSetResult(smem_,"");
+            case CONTROL_BIN_OP_RESOLVE :
+               kind = binGet8(&ptr,end);
+               str  = binGetStr(&ptr,end);
+               id   = binaryResolve(kind,str);
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               binPut32(binTx_,id);
                break;
 
-            // Two args, Config Variable and String Value, No Result
-            case CONTROL_CMD_TYPE_SET_CONFIG :
-               sprintf(xmlCmd_,"<system><config>%s</config></system>\n",vars_.setXml(cmdArgA,cmdArgB).c_str());
-               system_->parseXmlString(xmlCmd_);
-               controlCmdSetResult(smem_,"");
+            case CONTROL_BIN_OP_SET_INT :
+               entry = binaryEntry(binGet32(&ptr,end),CONTROL_BIN_KIND_VARIABLE);
+               entry->variable->setInt(binGet32(&ptr,end));
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               change = true;
                break;
 
-            // One Arg, Config Variable, Result is Value
-            case CONTROL_CMD_TYPE_GET_CONFIG :
-               vars_.parse("config",controlCmdGetConfig(smem_));
-               controlCmdSetResult(smem_,vars_.get(cmdArgA).c_str());
+            case CONTROL_BIN_OP_SET_STR :
+               entry = binaryEntry(binGet32(&ptr,end),CONTROL_BIN_KIND_VARIABLE);
+               entry->variable->set(binGetStr(&ptr,end));
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               change = true;
                break;
 
-            // One Arg, Status Variable, Result is Value
-            case CONTROL_CMD_TYPE_GET_STATUS :
-               vars_.parse("status",controlCmdGetStatus(smem_));
-               vars_.parse("status",controlCmdGetPerStatus(smem_));
-               controlCmdSetResult(smem_,vars_.get(cmdArgA).c_str());
+            case CONTROL_BIN_OP_GET_INT :
+               entry = binaryEntry(binGet32(&ptr,end),CONTROL_BIN_KIND_VARIABLE);
+               value = entry->variable->getInt();
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               binPut32(binTx_,value);
                break;
 
-            // Two Args, Device Path and command, No Result
-            case CONTROL_CMD_TYPE_EXEC_COMMAND  :
-               sprintf(xmlCmd_,"<system><command>%s</command></system>\n",vars_.setXml(cmdArgA,cmdArgB).c_str());
-               system_->parseXmlString(xmlCmd_);
-               controlCmdSetResult(smem_,"");
+            case CONTROL_BIN_OP_GET_STR :
+               entry = binaryEntry(binGet32(&ptr,end),CONTROL_BIN_KIND_VARIABLE);
+               str   = entry->variable->get();
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               binPutStr(binTx_,str);
                break;
 
-            // Three Args, Device Path, register name and value, No Result
-            case CONTROL_CMD_TYPE_SET_REGISTER :
-               sprintf(regStr_,"%s:WriteRegister",cmdArgA);
-               sprintf(xmlCmd_,"<system><command>%s</command></system>\n",vars_.setXml(regStr_,cmdArgB).c_str());
-               system_->parseXmlString(xmlCmd_);
-               controlCmdSetResult(smem_,"");
+            case CONTROL_BIN_OP_WRITE_REG :
+               entry = binaryEntry(binGet32(&ptr,end),CONTROL_BIN_KIND_REGISTER);
+               entry->device->writeSingle(entry->name,binGet32(&ptr,end));
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               change = true;
                break;
 
-            // Two Args, Device Path, register name, Result is value
-            case CONTROL_CMD_TYPE_GET_REGISTER :
-               sprintf(regStr_,"%s:ReadRegister",cmdArgA);
-               sprintf(xmlCmd_,"<system><command>%s</command></system>\n",vars_.setXml(regStr_,cmdArgB).c_str());
-               system_->parseXmlString(xmlCmd_);
-               vars_.parse("status",system_->statusString(true,false,true,true).c_str());
-               sprintf(regStr_,"%s:ReadRegisterResult",cmdArgA);
-               controlCmdSetResult(smem_,vars_.get(regStr_).c_str());
+            case CONTROL_BIN_OP_READ_REG :
+               entry = binaryEntry(binGet32(&ptr,end),CONTROL_BIN_KIND_REGISTER);
+               value = entry->device->readSingle(entry->name);
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               binPut32(binTx_,value);
                break;
 
-            default:
-               controlCmdSetResult(smem_,"");
+            case CONTROL_BIN_OP_COMMAND :
+               entry = binaryEntry(binGet32(&ptr,end),CONTROL_BIN_KIND_COMMAND);
+               entry->device->command(entry->name,binGetStr(&ptr,end));
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               change = true;
                break;
-         }
-         shmPend = true;
-      }
 
-      // Poll if timeout or xml or tcp command
-      if ( shmPend || tcpPend || (pollCount >= pollCycles) ) {
-	if (smem_->cmdResult[0]!='\0')
-	  std::cout<< "\n[dev]: "<< smem_->cmdResult << "\n" <<std::endl;
-	
-         pmsg = system_->poll(smem_);
-         pollCount = 0;
+            case CONTROL_BIN_OP_APPLY :
+               system_->applyConfig();
+               binTx_.push_back(CONTROL_BIN_STATUS_OK);
+               change = true;
+               break;
 
-         // Ack pending command
-         if ( shmPend ) {
-            if ( debug_ ) cout << "ControlServer::receive -> Done Processing shared memory message" << endl;
-            controlCmdAckCommand(smem_);
+            default :
+               throw(string("ControlServer::binaryFrame -> Invalid operation\n"));
+               break;
          }
+      } catch ( string error ) {
+         binTx_.push_back(CONTROL_BIN_STATUS_ERROR);
+         binPutStr(binTx_,error);
+         failed = true;
+      }
+   }
 
-         // Send message
-         if ( pmsg != "" ) {
-            msg.str("");
-            msg << pmsg << "\f";
+   // Set size and send
+   value = binTx_.size() - 4;
+   memcpy(&(binTx_[0]),&value,4);
+   sendData(idx,binTx_.data(),binTx_.size());
 
-            for ( x=0; x < MaxClients_; x++ ) {
-               if ( connFd_[x] >= 0 ) {
-		 if ( (!quietMode_[x]) || indPend[x] ){
-		   if (doalotprint) cout<<"[CntrlServer:dev] sendData from HERE 2 !"<<endl;
-		   sendData(x,msg.str().c_str(),msg.str().length());
-		 }
-               }
-            }
-         }
+   return(change);
+}
+
+// Resolve binary protocol name to id
+uint32_t ControlServer::binaryResolve ( uint8_t kind, string path ) {
+   map<string,uint32_t>::iterator iter;
+   BinaryEntry entry;
+   string      key;
+   string      part;
+   size_t      pos;
+   size_t      next;
+   size_t      brace;
+   char       *eptr;
+   uint32_t    index;
+
+   key = string(1,(char)('0' + kind)) + path;
+   if ( (iter = binIds_.find(key)) != binIds_.end() ) return(iter->second);
+
+   // Walk device path
+   entry.device   = system_;
+   entry.variable = NULL;
+   entry.kind     = kind;
+   pos = 0;
+   while ( (next = path.find(':',pos)) != string::npos ) {
+      part = path.substr(pos,next-pos);
+      index = 0;
+      if ( (brace = part.find('(')) != string::npos ) {
+         index = strtoul(part.c_str() + brace + 1,&eptr,0);
+         part  = part.substr(0,brace);
       }
-   } while ( stop != NULL && *stop == false );
+      entry.device = entry.device->device(part,index);
+      pos = next + 1;
+   }
+   entry.name = path.substr(pos);
+
+   // Check name, throws if not found
+   switch (kind) {
+      case CONTROL_BIN_KIND_VARIABLE : entry.variable = entry.device->getVariable(entry.name); break;
+      case CONTROL_BIN_KIND_REGISTER : entry.device->getRegister(entry.name); break;
+      case CONTROL_BIN_KIND_COMMAND  : entry.device->getCommand(entry.name); break;
+      default : throw(string("ControlServer::binaryResolve -> Invalid kind\n"));
+   }
+
+   binEntries_.push_back(entry);
+   binIds_.insert(make_pair(key,binEntries_.size()-1));
+   return(binEntries_.size()-1);
 }
 
+// Return binary protocol entry
+ControlServer::BinaryEntry * ControlServer::binaryEntry ( uint32_t id, uint8_t kind ) {
+   if ( id >= binEntries_.size() || binEntries_[id].kind != kind ) 
+      throw(string("ControlServer::binaryEntry -> Invalid id\n"));
+   return(&(binEntries_[id]));
+}
+
+// Close client connection
+void ControlServer::closeClient ( uint32_t idx ) {
+   if ( connFd_[idx] < 0 ) return;
+
+   epoll_ctl(epollFd_,EPOLL_CTL_DEL,connFd_[idx],NULL);
+   close(connFd_[idx]);
+   connFd_[idx]  = -1;
+   rxData_[idx]  = "";
+   txHead_[idx]  = 0;
+   txCount_[idx] = 0;
+}
 
+// Queue data to client
 void ControlServer::sendData ( uint32_t idx, const char *buffer, uint32_t size ) {
+   struct epoll_event ev;
    int32_t  ret;
    uint32_t sent;
-   uint32_t retryCount;
-   uint32_t loop;
+   uint32_t tail;
+   uint32_t len;
 
-   loop = 0;
+   if ( connFd_[idx] < 0 ) return;
    sent = 0;
-   retryCount = 0;
 
-   while ( (sent != size) && (retryCount < 1000) ) {
+   // Nothing pending, attempt direct write
+   if ( txCount_[idx] == 0 ) {
+      ret = write(connFd_[idx],buffer,size);
+      if ( ret > 0 ) sent = ret;
+      else if ( ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+         if ( debug_ ) cout << "ControlServer::sendData -> Write error. Closing connection." << endl;
+         closeClient(idx);
+         return;
+      }
+      if ( sent == size ) return;
+   }
+
+   // Client is too far behind
+   if ( (size - sent) > (TxBufferSize_ - txCount_[idx]) ) {
+      if ( debug_ ) cout << "ControlServer::sendData -> Output buffer full. Closing connection." << endl;
+      closeClient(idx);
+      return;
+   }
 
-      ret = write(connFd_[idx],buffer + sent,size-sent);
+   // Allocated on first use
+   if ( txBuffer_[idx] == NULL ) txBuffer_[idx] = (char *)malloc(TxBufferSize_);
 
-      if ( ret > 0 ) {
-         sent += ret;
-         retryCount = 0;
-      }
-      else {
-         retryCount++;
-         usleep(100);
-      }
-      loop++;
+   // Enable write notification when queue goes from empty
+   if ( txCount_[idx] == 0 ) {
+      ev.events   = EPOLLIN | EPOLLOUT;
+      ev.data.u32 = idx;
+      epoll_ctl(epollFd_,EPOLL_CTL_MOD,connFd_[idx],&ev);
+   }
+
+   // Copy remainder into ring
+   while ( sent < size ) {
+      tail = (txHead_[idx] + txCount_[idx]) % TxBufferSize_;
+      len  = TxBufferSize_ - tail;
+      if ( len > (size - sent) ) len = size - sent;
+      memcpy(txBuffer_[idx] + tail,buffer + sent,len);
+      txCount_[idx] += len;
+      sent += len;
    }
+}
+
+// Write pending output
+void ControlServer::flushData ( uint32_t idx ) {
+   struct epoll_event ev;
+   int32_t  ret;
+   uint32_t len;
 
-   if(doalotprint) cout<<"[ControlServer:dev] buffer sent ==> \n"<<buffer <<endl;
-   
-   if ( sent != size ) {
-     if(doalotprint) printf("ControlServer::sendData -> Write error. Closing connection. Sent=%i, Size=%i, loop=%i\n",sent,size,loop);
+   while ( txCount_[idx] > 0 ) {
+      len = TxBufferSize_ - txHead_[idx];
+      if ( len > txCount_[idx] ) len = txCount_[idx];
 
-      // Reset
-      rxData_[idx].str("");
+      ret = write(connFd_[idx],txBuffer_[idx] + txHead_[idx],len);
 
-      // Close socket
-      close(connFd_[idx]);
-      connFd_[idx] = -1;
+      if ( ret <= 0 ) {
+         if ( ret == 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) return;
+         if ( debug_ ) cout << "ControlServer::flushData -> Write error. Closing connection." << endl;
+         closeClient(idx);
+         return;
+      }
+      txHead_[idx]  = (txHead_[idx] + ret) % TxBufferSize_;
+      txCount_[idx] -= ret;
    }
+
+   // Queue is empty, stop write notification
+   txHead_[idx] = 0;
+   ev.events    = EPOLLIN;
+   ev.data.u32  = idx;
+   epoll_ctl(epollFd_,EPOLL_CTL_MOD,connFd_[idx],&ev);
 }
 
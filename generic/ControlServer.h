@@ -18,6 +18,10 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 08/29/2011: created
+// 10/17/2026: Moved to epoll with per client output buffers
+// 10/17/2026: Added binary control protocol
+// 10/17/2026: Added shared memory command ring
+// 10/17/2026: Unpublished ring tickets are skipped
 //-----------------------------------------------------------------------------
 #ifndef __CONTROL_SERVER_H__
 #define __CONTROL_SERVER_H__
@@ -31,12 +35,17 @@
 #include <sys/time.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <ControlCmdMem.h>
 #include <XmlVariables.h>
 #include <stdint.h>
+#include <map>
+#include <vector>
 using namespace std;
 
 class System;
+class Device;
+class Variable;
 
 //! Class to manage control interface
 class ControlServer {
@@ -44,15 +53,28 @@ class ControlServer {
       // Number of clients to support
       static const uint32_t MaxClients_ = 8;
 
+      // Output buffer size per client, a client falling further behind is dropped
+      static const uint32_t TxBufferSize_ = 4194304;
+
       // Debug flag
       bool debug_;
 
       // Server fdes
       int32_t servFd_;
 
+      // Binary protocol server fdes
+      int32_t binFd_;
+
+      // Epoll fdes
+      int32_t epollFd_;
+
       // Connection fdes
       int32_t connFd_[MaxClients_];
       bool quietMode_[MaxClients_];
+      bool binary_[MaxClients_];
+
+      // Status journal version each client is up to date with
+      uint64_t statusVersion_[MaxClients_];
 
       // Port number
       int32_t port_;
@@ -62,7 +84,12 @@ class ControlServer {
       struct sockaddr_in connAddr_;
 
       // Current received data
-      stringstream rxData_[MaxClients_];
+      string rxData_[MaxClients_];
+
+      // Pending output ring buffers
+      char   * txBuffer_[MaxClients_];
+      uint32_t txHead_[MaxClients_];
+      uint32_t txCount_[MaxClients_];
 
       // Top level device
       System *system_;
@@ -71,17 +98,82 @@ class ControlServer {
       uint32_t          smemFd_;
       ControlCmdMemory *smem_;
 
+      // Shared memory command ring, next ticket to execute and the wakeup
+      // thread which turns ring submissions into epoll events through a pipe.
+      // The run flag is shared with the thread and accessed atomically.
+      uint32_t          ringNext_;
+      int32_t           ringPipe_[2];
+      pthread_t         ringThread_;
+      bool              ringRun_;
+
+      // Time the next ticket was first seen claimed but not published
+      bool              ringWaiting_;
+      uint32_t          ringWaitTicket_;
+      uint32_t          ringWaitTime_;
+
+      // Ring wakeup thread
+      static void * ringRun ( void *t );
+      void ringHandler ( );
+
+      // Skip the next ticket if its client did not publish it in time, returns true if skipped
+      bool ringSkip ( );
+
+      // Execute shared memory command, returns the result
+      string shmCommand ( uint8_t cmdType, const char *argA, const char *argB );
+
+      // Read or write a register for a shared memory command, returns the read value
+      string shmRegister ( const char *argA, const char *argB, bool write );
+
       // Poll Variables
       char   buffer_[9001];
       char   xmlCmd_[9001];
       char   regStr_[9001];
+      char   snapValue_[CONTROL_CMD_SNAP_VALUE_SIZE];
+
+      // Binary protocol name table, shared by all clients
+      struct BinaryEntry {
+         uint8_t    kind;
+         Device   * device;
+         Variable * variable;
+         string     name;
+      };
+      vector<BinaryEntry>  binEntries_;
+      map<string,uint32_t> binIds_;
+
+      // Binary protocol response buffer
+      string binTx_;
 
       // Variable engine used in receive, must be created here so we are
       // not constantly calling the xml parser init function
       XmlVariables vars_;
 
+      // Queue data to client, writes directly if nothing is pending
       void sendData ( uint32_t idx, const char *buffer, uint32_t size );
 
+      // Write pending output, called when client socket is writable
+      void flushData ( uint32_t idx );
+
+      // Process received bytes from client
+      void rxData ( uint32_t idx, const char *buffer, uint32_t size, bool *pend );
+
+      // Close client connection
+      void closeClient ( uint32_t idx );
+
+      // Accept connection on listen socket
+      void acceptClient ( int32_t fd, bool binary );
+
+      // Process received bytes from binary client
+      void rxBinary ( uint32_t idx, const char *buffer, uint32_t size, bool *pend );
+
+      // Execute one binary request frame, returns true if state was changed
+      bool binaryFrame ( uint32_t idx, const char *data, uint32_t size );
+
+      // Resolve binary protocol name to id, throws string if not found
+      uint32_t binaryResolve ( uint8_t kind, string path );
+
+      // Return binary protocol entry, throws string if id is invalid or of another kind
+      BinaryEntry * binaryEntry ( uint32_t id, uint8_t kind );
+
    public:
 
       //! Constructor
@@ -110,6 +202,15 @@ class ControlServer {
       */
       int32_t startListen ( int32_t port );
 
+      //! Start binary protocol listen socket
+      /*! 
+       * See ControlBinary.h for the protocol. Binary clients do not 
+       * receive the xml system messages.
+       * \param port Listen port number, pass zero to auto assign
+       * resulting port number is returned
+      */
+      int32_t startBinaryListen ( int32_t port );
+
       //! Stop tcpip listen socket
       void stopListen ( );
 
@@ -33,11 +33,22 @@ bool datadebug=false;
 // Update frame state
 void Data::update() { }
 
+// Make room in the owned buffer
+void Data::alloc ( uint32_t size ) {
+   if ( size > alloc_ ) {
+      free(buff_);
+      alloc_ = size;
+      buff_  = (uint32_t *)malloc(alloc_ * sizeof(uint32_t));
+   }
+   data_ = buff_;
+}
+
 // Constructor
 Data::Data ( uint32_t *data, uint32_t size ) {
    size_  = size;
    alloc_ = size;
-   data_  = (uint32_t *)malloc(alloc_ * sizeof(uint32_t));
+   buff_  = (uint32_t *)malloc(alloc_ * sizeof(uint32_t));
+   data_  = buff_;
    memcpy(data_,data,size_*sizeof(uint32_t));
    update();
 }
@@ -46,22 +57,19 @@ Data::Data ( uint32_t *data, uint32_t size ) {
 Data::Data () {
    size_  = 0;
    alloc_ = 1;
-   data_  = (uint32_t *)malloc(sizeof(uint32_t));
+   buff_  = (uint32_t *)malloc(sizeof(uint32_t));
+   data_  = buff_;
    update();
 }
 
 // Deconstructor
 Data::~Data ( ) {
-   free(data_);
+   free(buff_);
 }
 
 // Read data from file descriptor
 bool Data::read ( int32_t fd, uint32_t size ) {
-   if ( size > alloc_ ) {
-      free(data_);
-      alloc_ = size;
-      data_ = (uint32_t *)malloc(alloc_ * sizeof(uint32_t));
-   }
+   alloc(size);
    size_ = size;
    if ( ::read(fd, data_, size_*(sizeof(uint32_t))) != (int)(size_ *sizeof(uint32_t))) {
       size_ = 0;
@@ -81,11 +89,7 @@ bool Data::read ( BZFILE *bzFile, uint32_t size ) {
 #ifdef USE_BZLIB
    int32_t bzerror;
 
-   if ( size > alloc_ ) {
-      free(data_);
-      alloc_ = size;
-      data_ = (uint32_t *)malloc(alloc_ * sizeof(uint32_t));
-   }
+   alloc(size);
    size_ = size;
    if ( BZ2_bzRead ( &bzerror,bzFile,data_,size_*(sizeof(uint32_t))) != (int)(size_*sizeof(uint32_t))) {
       size_ = 0;
@@ -101,11 +105,7 @@ bool Data::read ( BZFILE *bzFile, uint32_t size ) {
 
 // Copy data from buffer
 void Data::copy ( uint32_t *data, uint32_t size ) {
-   if ( size > alloc_ ) {
-      free(data_);
-      alloc_ = size;
-      data_ = (uint32_t *)malloc(alloc_ * sizeof(uint32_t));
-   }
+   alloc(size);
    size_ = size;
 
    // Copy data
@@ -113,6 +113,13 @@ void Data::copy ( uint32_t *data, uint32_t size ) {
    update();
 }
 
+// Point at data without copy
+void Data::view ( uint32_t *data, uint32_t size ) {
+   data_ = data;
+   size_ = size;
+   update();
+}
+
 // Get pointer to data buffer
 uint32_t *Data::data ( ) {
    return(data_);
@@ -44,6 +44,12 @@ class Data {
       // Allocation
       uint32_t alloc_;
 
+      // Owned buffer, data_ points elsewhere for a view
+      uint32_t *buff_;
+
+      // Make room in the owned buffer
+      void alloc ( uint32_t size );
+
    protected:
 
       // Data container
@@ -59,13 +65,16 @@ class Data {
 
       // Data types. 
       // Count is n*32bits for type = 0, byte count for all others
+      // CalMarker holds 32-bit words: calibration state, first channel, dac
+      // and channel stride
       enum DataType {
          RawData     = 0,
          XmlConfig   = 1,
          XmlStatus   = 2,
          XmlRunStart = 3,
          XmlRunStop  = 4,
-         XmlRunTime  = 5
+         XmlRunTime  = 5,
+         CalMarker   = 6
       };
 
       //! Constructor
@@ -102,6 +111,15 @@ class Data {
       */
       void copy ( uint32_t *data, uint32_t size );
 
+      //! Point at data without copy
+      /*! 
+       * The buffer must stay valid while the data is used, the next
+       * read or copy returns to the owned buffer.
+       * \param data Data pointer
+       * \param size Data size
+      */
+      void view ( uint32_t *data, uint32_t size );
+
       //! Get pointer to data buffer
       uint32_t *data ( );
 
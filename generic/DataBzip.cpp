@@ -0,0 +1,485 @@
+//-----------------------------------------------------------------------------
+// File          : DataBzip.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Parallel reader of bzip2 compressed files. The compressed file is mapped
+// and searched for the bit aligned block and end of stream markers. Each
+// block is wrapped into a stream of its own and decompressed by a pool of
+// threads into a ring of buffers, which the reader takes in file order.
+// Files of several concatenated streams are supported.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Merge blocks split by a marker matched in compressed data
+//-----------------------------------------------------------------------------
+#include <DataBzip.h>
+#include <bzlib.h>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+using namespace std;
+
+// Block and end of stream markers, 48 bits each
+#define BZIP_BLOCK_MAGIC 0x314159265359ULL
+#define BZIP_END_MAGIC   0x177245385090ULL
+#define BZIP_MAGIC_MASK  0xFFFFFFFFFFFFULL
+
+// Minimum size of a decompressed block buffer
+#define BZIP_SLOT_SIZE 0x100000
+
+// Time in seconds
+static double bzipTime ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Append bits, most significant first
+static void bzipPut ( uint8_t *buff, uint64_t *pos, uint64_t value, uint32_t bits ) {
+   while ( bits > 0 ) {
+      bits--;
+      if ( (value >> bits) & 1 ) buff[*pos >> 3] |= (0x80 >> (*pos & 7));
+      (*pos)++;
+   }
+}
+
+// Decompress thread
+void * DataBzip::run ( void *t ) {
+   DataBzip *ti;
+   ti = (DataBzip *)t;
+   ti->handler();
+   pthread_exit(NULL);
+   return(NULL);
+}
+
+// Claim the next block while the ring has a free slot, decompress it
+void DataBzip::handler ( ) {
+   vector<uint8_t> stream;
+   DataBzipSlot   *slot;
+   uint64_t        start;
+   uint64_t        end;
+   bool            ok;
+
+   while ( true ) {
+      pthread_mutex_lock(&mutex_);
+      while ( (head_ - tail_) >= slots_.size() && ! stop_ && ! scanDone_ ) pthread_cond_wait(&freeCondition_,&mutex_);
+      if ( stop_ || scanDone_ ) {
+         pthread_mutex_unlock(&mutex_);
+         break;
+      }
+
+      // Scanning is done in order under the lock, the block number fixes the slot
+      if ( ! nextBounds(&start,&end) ) {
+         end_ = head_;
+         pthread_cond_broadcast(&fillCondition_);
+         pthread_cond_broadcast(&freeCondition_);
+         pthread_mutex_unlock(&mutex_);
+         break;
+      }
+      slot        = &(slots_[head_ % slots_.size()]);
+      slot->ready = false;
+      slot->bit   = start;
+      slot->end   = end;
+      head_++;
+      pthread_mutex_unlock(&mutex_);
+
+      ok = decompress(start,end,stream,slot);
+
+      pthread_mutex_lock(&mutex_);
+      slot->error = ! ok;
+      slot->ready = true;
+      pthread_cond_broadcast(&fillCondition_);
+      pthread_mutex_unlock(&mutex_);
+   }
+}
+
+// Bit offset of the next block or end of stream marker at or after bit
+int64_t DataBzip::findMarker ( uint64_t bit, bool *eos ) {
+   uint64_t window;
+   uint64_t value;
+   uint64_t end;
+   off_t    x;
+   int32_t  shift;
+
+   // Bits are shifted in a byte at a time, each byte ends 8 candidate positions
+   window = 0;
+   for (x = bit >> 3; x < mapSize_; x++) {
+      window = (window << 8) | map_[x];
+      for (shift=7; shift >= 0; shift--) {
+         end = (x + 1) * 8 - shift;
+         if ( end < bit + 48 ) continue;
+         value = (window >> shift) & BZIP_MAGIC_MASK;
+         if ( value == BZIP_BLOCK_MAGIC || value == BZIP_END_MAGIC ) {
+            *eos = (value == BZIP_END_MAGIC);
+            return(end - 48);
+         }
+      }
+   }
+   return(-1);
+}
+
+// True if a stream header starts at byte
+bool DataBzip::streamHeader ( uint64_t byte ) {
+   return( (off_t)(byte + 4) <= mapSize_ && map_[byte] == 'B' && map_[byte+1] == 'Z' &&
+           map_[byte+2] == 'h' && map_[byte+3] >= '1' && map_[byte+3] <= '9' );
+}
+
+// Bounds of the next block, a block ends at the following marker
+bool DataBzip::nextBounds ( uint64_t *start, uint64_t *end ) {
+   int64_t  marker;
+   int64_t  next;
+   uint64_t byte;
+   bool     eos;
+
+   while ( ! scanDone_ ) {
+      if ( (marker = findMarker(scanBit_,&eos)) < 0 ) break;
+
+      // End of stream, marker and crc are followed by padding and maybe another stream
+      if ( eos ) {
+         byte = (marker + 80 + 7) / 8;
+         if ( streamHeader(byte) ) {
+            scanBit_ = (byte + 4) * 8;
+            continue;
+         }
+         break;
+      }
+
+      // An end of stream marker which is not followed by the file end or another
+      // stream was matched in the compressed data and is skipped. A block without
+      // a following marker is truncated, decompression reports it.
+      next = marker + 48;
+      while ( (next = findMarker(next,&eos)) >= 0 && eos ) {
+         byte = (next + 80 + 7) / 8;
+         if ( (off_t)byte >= mapSize_ || streamHeader(byte) ) break;
+         next++;
+      }
+      if ( next < 0 ) next = mapSize_ * 8;
+      *start   = marker;
+      *end     = next;
+      scanBit_ = next;
+      return(true);
+   }
+   scanDone_ = true;
+   return(false);
+}
+
+// Decompress the block between two bit offsets as a stream of one block
+bool DataBzip::decompress ( uint64_t start, uint64_t end, vector<uint8_t> &stream, DataBzipSlot *slot ) {
+   bz_stream strm;
+   uint64_t  bits;
+   uint64_t  bytes;
+   uint64_t  pos;
+   uint64_t  x;
+   uint64_t  src;
+   uint32_t  crc;
+   uint32_t  shift;
+   int32_t   ret;
+
+   bits  = end - start;
+   bytes = (bits + 7) / 8;
+
+   // Header, block bits, end marker and the stream crc, which is the block crc for one block
+   stream.assign(4 + bytes + 11,0);
+   memcpy(&(stream[0]),"BZh9",4);
+
+   shift = start & 7;
+   for (x=0; x < bytes; x++) {
+      src          = (start >> 3) + x;
+      stream[4+x]  = map_[src] << shift;
+      if ( shift != 0 && (off_t)(src + 1) < mapSize_ ) stream[4+x] |= map_[src+1] >> (8 - shift);
+   }
+   if ( bits & 7 ) stream[4+bytes-1] &= (0xFF00 >> (bits & 7));
+
+   crc = ((uint32_t)stream[10] << 24) | ((uint32_t)stream[11] << 16) | ((uint32_t)stream[12] << 8) | stream[13];
+   pos = 32 + bits;
+   bzipPut(&(stream[0]),&pos,BZIP_END_MAGIC,48);
+   bzipPut(&(stream[0]),&pos,crc,32);
+
+   memset(&strm,0,sizeof(strm));
+   if ( BZ2_bzDecompressInit(&strm,0,0) != BZ_OK ) return(false);
+
+   strm.next_in  = (char *)&(stream[0]);
+   strm.avail_in = (pos + 7) / 8;
+
+   // Runs expand well beyond the block size, the buffer grows as needed
+   if ( slot->data.size() < BZIP_SLOT_SIZE ) slot->data.resize(BZIP_SLOT_SIZE);
+   slot->fill = 0;
+   do {
+      if ( slot->fill == slot->data.size() ) slot->data.resize(slot->data.size() * 2);
+      strm.next_out  = (char *)&(slot->data[slot->fill]);
+      strm.avail_out = slot->data.size() - slot->fill;
+      ret            = BZ2_bzDecompress(&strm);
+      slot->fill     = slot->data.size() - strm.avail_out;
+   } while ( ret == BZ_OK && (strm.avail_in > 0 || strm.avail_out == 0) );
+
+   BZ2_bzDecompressEnd(&strm);
+   return(ret == BZ_STREAM_END);
+}
+
+// Wait until a block is decompressed, returns false past the last block
+bool DataBzip::waitBlock ( uint64_t block ) {
+   DataBzipSlot *slot;
+
+   slot = &(slots_[block % slots_.size()]);
+   while ( block < end_ && ! (block < head_ && slot->ready) ) pthread_cond_wait(&fillCondition_,&mutex_);
+   return(block < end_);
+}
+
+// Take the next block, returns false at end of file
+bool DataBzip::nextBlock ( ) {
+   vector<uint8_t> stream;
+   DataBzipSlot   *slot;
+   DataBzipSlot   *next;
+   double          start;
+   bool            ok;
+
+   pthread_mutex_lock(&mutex_);
+
+   // Free the block being read
+   if ( curr_ != NULL ) {
+      curr_ = NULL;
+      tail_++;
+      pthread_cond_signal(&freeCondition_);
+   }
+
+   slot = &(slots_[tail_ % slots_.size()]);
+   if ( tail_ < end_ && ! (tail_ < head_ && slot->ready) ) {
+      start = bzipTime();
+      waitBlock(tail_);
+      stallTime_ += bzipTime() - start;
+      stalls_++;
+   }
+
+   if ( tail_ >= end_ ) {
+      pthread_mutex_unlock(&mutex_);
+      return(false);
+   }
+
+   // A block marker matched in the compressed data splits a block in two parts
+   // which both fail. The failed part is merged with the following one when that
+   // fails too and the merged block replaces it, as bzip2recover does. Merging
+   // repeats for several false markers. The freed slot lets scanning go on.
+   while ( slot->error ) {
+      next = &(slots_[(tail_ + 1) % slots_.size()]);
+
+      // A bad block ends the file, it is kept so later reads fail too
+      if ( ! waitBlock(tail_ + 1) || ! next->error ) {
+         cout << "DataBzip::nextBlock -> Failed to decompress block at byte " << (slot->bit / 8) << endl;
+         pthread_mutex_unlock(&mutex_);
+         return(false);
+      }
+      next->bit = slot->bit;
+      tail_++;
+      pthread_cond_signal(&freeCondition_);
+      slot = next;
+      merges_++;
+      pthread_mutex_unlock(&mutex_);
+
+      ok = decompress(slot->bit,slot->end,stream,slot);
+
+      pthread_mutex_lock(&mutex_);
+      slot->error = ! ok;
+   }
+   curr_    = slot;
+   currPos_ = 0;
+   blocks_++;
+   pthread_mutex_unlock(&mutex_);
+   return(true);
+}
+
+// Constructor
+DataBzip::DataBzip ( ) {
+   map_       = NULL;
+   mapSize_   = 0;
+   scanBit_   = 0;
+   scanDone_  = true;
+   head_      = 0;
+   tail_      = 0;
+   end_       = 0;
+   stop_      = false;
+   curr_      = NULL;
+   currPos_   = 0;
+   pos_       = 0;
+   blocks_    = 0;
+   stallTime_ = 0;
+   stalls_    = 0;
+   merges_    = 0;
+
+   pthread_mutex_init(&mutex_,NULL);
+   pthread_cond_init(&fillCondition_,NULL);
+   pthread_cond_init(&freeCondition_,NULL);
+}
+
+// Deconstructor
+DataBzip::~DataBzip ( ) {
+   stop();
+   pthread_cond_destroy(&fillCondition_);
+   pthread_cond_destroy(&freeCondition_);
+   pthread_mutex_destroy(&mutex_);
+}
+
+// Start decompressing
+bool DataBzip::start ( int32_t fd, uint32_t threads, uint32_t blocks ) {
+   struct stat st;
+   void       *map;
+   pthread_t   thread;
+   uint32_t    x;
+
+   stop();
+
+   if ( fstat(fd,&st) != 0 || st.st_size < 4 || (uint64_t)st.st_size > (size_t)-1 ) return(false);
+   if ( (map = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0)) == MAP_FAILED ) return(false);
+   madvise(map,st.st_size,MADV_SEQUENTIAL);
+
+   map_     = (uint8_t *)map;
+   mapSize_ = st.st_size;
+
+   if ( map_[0] != 'B' || map_[1] != 'Z' || map_[2] != 'h' || map_[3] < '1' || map_[3] > '9' ) {
+      munmap(map_,mapSize_);
+      map_ = NULL;
+      return(false);
+   }
+
+   if ( threads == 0 ) threads = sysconf(_SC_NPROCESSORS_ONLN);
+   if ( threads == 0 ) threads = 1;
+   if ( blocks == 0 ) blocks = 2 * threads;
+   if ( blocks < 2 ) blocks = 2;
+
+   slots_.resize(blocks);
+   for (x=0; x < blocks; x++) {
+      slots_[x].fill  = 0;
+      slots_[x].bit   = 0;
+      slots_[x].end   = 0;
+      slots_[x].ready = false;
+      slots_[x].error = false;
+   }
+
+   scanBit_   = 32;
+   scanDone_  = false;
+   head_      = 0;
+   tail_      = 0;
+   end_       = (uint64_t)-1;
+   stop_      = false;
+   curr_      = NULL;
+   currPos_   = 0;
+   pos_       = 0;
+   blocks_    = 0;
+   stallTime_ = 0;
+   stalls_    = 0;
+   merges_    = 0;
+
+   for (x=0; x < threads; x++) {
+      if ( pthread_create(&thread,NULL,run,this) ) {
+         cout << "DataBzip::start -> Failed to create decompress thread" << endl;
+         break;
+      }
+      threads_.push_back(thread);
+   }
+   if ( threads_.empty() ) {
+      stop();
+      return(false);
+   }
+   return(true);
+}
+
+// Stop the threads and free the ring
+void DataBzip::stop ( ) {
+   uint32_t x;
+
+   pthread_mutex_lock(&mutex_);
+   stop_ = true;
+   pthread_cond_broadcast(&freeCondition_);
+   pthread_mutex_unlock(&mutex_);
+   for (x=0; x < threads_.size(); x++) pthread_join(threads_[x],NULL);
+   threads_.clear();
+
+   if ( map_ != NULL ) munmap(map_,mapSize_);
+   map_     = NULL;
+   mapSize_ = 0;
+   slots_.clear();
+   curr_ = NULL;
+}
+
+// Return true if decompressing
+bool DataBzip::active ( ) {
+   return(! slots_.empty());
+}
+
+// Copy bytes, returns false at end of file
+bool DataBzip::read ( void *buff, uint32_t size ) {
+   uint8_t  *ptr;
+   uint32_t  count;
+
+   ptr = (uint8_t *)buff;
+   while ( size > 0 ) {
+      if ( (curr_ == NULL || currPos_ == curr_->fill) && ! nextBlock() ) return(false);
+
+      count = curr_->fill - currPos_;
+      if ( count > size ) count = size;
+      memcpy(ptr,&(curr_->data[currPos_]),count);
+      ptr      += count;
+      size     -= count;
+      currPos_ += count;
+      pos_     += count;
+   }
+   return(true);
+}
+
+// Return bytes without a copy if contiguous in the current block
+uint8_t *DataBzip::get ( uint32_t size ) {
+   uint8_t *ret;
+
+   if ( (curr_ == NULL || currPos_ == curr_->fill) && ! nextBlock() ) return(NULL);
+   if ( (curr_->fill - currPos_) < size ) return(NULL);
+
+   ret       = &(curr_->data[currPos_]);
+   currPos_ += size;
+   pos_     += size;
+   return(ret);
+}
+
+// Return decompressed offset of the reader
+off_t DataBzip::pos ( ) {
+   return(pos_);
+}
+
+// Number of decompression threads
+uint32_t DataBzip::threads ( ) {
+   return(threads_.size());
+}
+
+// Blocks taken by the reader since the last start
+uint64_t DataBzip::blocks ( ) {
+   return(blocks_);
+}
+
+// Seconds the reader waited for data
+double DataBzip::stallTime ( ) {
+   return(stallTime_);
+}
+
+// Number of times the reader waited for data
+uint32_t DataBzip::stalls ( ) {
+   return(stalls_);
+}
+
+// Number of blocks merged after a marker matched in compressed data
+uint32_t DataBzip::merges ( ) {
+   return(merges_);
+}
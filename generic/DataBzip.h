@@ -0,0 +1,157 @@
+//-----------------------------------------------------------------------------
+// File          : DataBzip.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Parallel reader of bzip2 compressed files. The compressed file is mapped
+// and searched for the bit aligned block and end of stream markers. Each
+// block is wrapped into a stream of its own and decompressed by a pool of
+// threads into a ring of buffers, which the reader takes in file order.
+// Files of several concatenated streams are supported.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Merge blocks split by a marker matched in compressed data
+//-----------------------------------------------------------------------------
+#ifndef __DATA_BZIP_H__
+#define __DATA_BZIP_H__
+
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+using namespace std;
+
+//! Class to decompress a bzip2 file in parallel
+class DataBzip {
+
+      // Decompressed block
+      class DataBzipSlot {
+         public:
+            vector<uint8_t> data;
+            uint32_t        fill;
+            uint64_t        bit;
+            uint64_t        end;
+            bool            ready;
+            bool            error;
+      };
+
+      // Mapped compressed file
+      uint8_t *map_;
+      off_t    mapSize_;
+
+      // Start bit of the next block, scanning ends at the last block
+      uint64_t scanBit_;
+      bool     scanDone_;
+
+      // Ring of blocks, blocks are numbered in file order
+      vector<DataBzipSlot> slots_;
+      uint64_t             head_;
+      uint64_t             tail_;
+      uint64_t             end_;
+      bool                 stop_;
+
+      // Block being read
+      DataBzipSlot *curr_;
+      uint32_t      currPos_;
+      off_t         pos_;
+
+      // Statistics
+      uint64_t blocks_;
+      double   stallTime_;
+      uint32_t stalls_;
+      uint32_t merges_;
+
+      // Threads
+      vector<pthread_t> threads_;
+      pthread_mutex_t   mutex_;
+      pthread_cond_t    fillCondition_;
+      pthread_cond_t    freeCondition_;
+
+      // Thread routines
+      static void *run ( void *t );
+      void handler ( );
+
+      // Bit offset of the next block or end of stream marker at or after bit, -1 if none
+      int64_t findMarker ( uint64_t bit, bool *eos );
+
+      // True if a stream header starts at byte
+      bool streamHeader ( uint64_t byte );
+
+      // Bounds of the next block, false if there are no more
+      bool nextBounds ( uint64_t *start, uint64_t *end );
+
+      // Decompress the block between two bit offsets
+      bool decompress ( uint64_t start, uint64_t end, vector<uint8_t> &stream, DataBzipSlot *slot );
+
+      // Wait until a block is decompressed, returns false past the last block
+      bool waitBlock ( uint64_t block );
+
+      // Take the next block, returns false at end of file
+      bool nextBlock ( );
+
+   public:
+
+      //! Constructor
+      DataBzip ( );
+
+      //! Deconstructor
+      ~DataBzip ( );
+
+      //! Start decompressing
+      /*!
+       * \param fd      File descriptor of the compressed file
+       * \param threads Number of threads, 0 for one per processor
+       * \param blocks  Number of blocks decompressed ahead, 0 for two per thread
+      */
+      bool start ( int32_t fd, uint32_t threads = 0, uint32_t blocks = 0 );
+
+      //! Stop the threads and free the ring
+      void stop ( );
+
+      //! Return true if decompressing
+      bool active ( );
+
+      //! Copy bytes, returns false at end of file
+      bool read ( void *buff, uint32_t size );
+
+      //! Return bytes without a copy if contiguous in the current block, NULL otherwise
+      /*!
+       * The bytes are valid until the next call of read() or get().
+       * Nothing is consumed if NULL is returned.
+      */
+      uint8_t *get ( uint32_t size );
+
+      //! Return decompressed offset of the reader
+      /*!
+       * This is not comparable with the compressed file size.
+      */
+      off_t pos ( );
+
+      //! Number of decompression threads
+      uint32_t threads ( );
+
+      //! Blocks taken by the reader since the last start
+      uint64_t blocks ( );
+
+      //! Seconds the reader waited for data
+      double stallTime ( );
+
+      //! Number of times the reader waited for data
+      uint32_t stalls ( );
+
+      //! Number of blocks merged after a marker matched in compressed data
+      uint32_t merges ( );
+};
+#endif
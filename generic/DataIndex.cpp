@@ -0,0 +1,423 @@
+//-----------------------------------------------------------------------------
+// File          : DataIndex.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Sidecar record index of a data file. Each record of the data file has an
+// entry with its offset, size and type word, the event number and timestamp
+// of raw data, the calibration state in effect and the records from which
+// the config and status are replayed when seeking to it. The index is written
+// next to the data file as <file>.idx while recording, or built by scanning
+// the data file.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Added replay checkpoints of each record
+//-----------------------------------------------------------------------------
+#include <DataIndex.h>
+#include <Data.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+using namespace std;
+
+#ifdef RTEMS
+#define O_LARGEFILE 0
+#endif
+
+// Sidecar file header
+#define INDEX_MAGIC      "KPIXIDX1"
+#define INDEX_HEAD_SIZE  16
+
+// Entries written at once
+#define INDEX_FLUSH_SIZE 1024
+
+// Payload bytes of a record
+static uint32_t recordBytes ( uint32_t header ) {
+   if ( ((header >> 28) & 0xF) == Data::RawData ) return((header & 0x0FFFFFFF) * 4);
+   return(header & 0x0FFFFFFF);
+}
+
+// Value of an xml element as integer, returns false if not found
+static bool xmlValue ( const char *xml, const char *tag, uint32_t *value ) {
+   const char *ptr;
+   const char *state[3] = { "Idle", "Baseline", "Inject" };
+   uint32_t    x;
+
+   if ( (ptr = strstr(xml,tag)) == NULL ) return(false);
+   ptr += strlen(tag);
+
+   for (x=0; x < 3; x++) {
+      if ( strncmp(ptr,state[x],strlen(state[x])) == 0 ) {
+         *value = x;
+         return(true);
+      }
+   }
+   *value = strtoul(ptr,NULL,0);
+   return(true);
+}
+
+// Elements of an xml record, each ends with a closing or empty tag
+static uint32_t xmlElements ( const uint8_t *data, uint32_t size ) {
+   uint32_t count;
+   uint32_t x;
+
+   count = 0;
+   for (x=1; x < size; x++)
+      if ( (data[x-1] == '<' && data[x] == '/') || (data[x-1] == '/' && data[x] == '>') ) count++;
+   return(count);
+}
+
+// Constructor
+DataIndex::DataIndex ( ) {
+   fd_ = -1;
+   reset();
+}
+
+// Deconstructor
+DataIndex::~DataIndex ( ) {
+   close();
+}
+
+// Sidecar index file name of a data file
+string DataIndex::fileName ( string file ) {
+   return(file + ".idx");
+}
+
+// Clear record state
+void DataIndex::reset ( ) {
+   memset(&state_,0,sizeof(state_));
+   offset_         = 0;
+   records_        = 0;
+   fullConfig_     = 0;
+   fullStatus_     = 0;
+   configElements_ = 0;
+   statusElements_ = 0;
+}
+
+// Update replay checkpoints from a record payload. The checkpoints of a record
+// only cover the records before it.
+void DataIndex::checkpoint ( uint32_t header, const uint8_t *data, uint32_t size ) {
+   uint32_t type;
+
+   state_.config   = fullConfig_;
+   state_.status   = fullStatus_;
+   state_.elements = 0;
+
+   type = (header >> 28) & 0xF;
+   if ( type == Data::XmlConfig || type == Data::XmlStatus ) state_.elements = xmlElements(data,size);
+
+   if ( type == Data::XmlConfig && state_.elements >= configElements_ ) {
+      configElements_ = state_.elements;
+      fullConfig_     = records_;
+   }
+   if ( type == Data::XmlStatus && state_.elements >= statusElements_ ) {
+      statusElements_ = state_.elements;
+      fullStatus_     = records_;
+   }
+   records_++;
+}
+
+// Update calibration state from a record payload
+void DataIndex::calState ( uint32_t header, const uint8_t *data, uint32_t size ) {
+   uint32_t marker[3];
+   string   xml;
+
+   switch ( (header >> 28) & 0xF ) {
+
+      case Data::CalMarker :
+         if ( size >= 12 ) {
+            memcpy(marker,data,12);
+            state_.calState   = marker[0];
+            state_.calChannel = marker[1];
+            state_.calDac     = marker[2];
+         }
+         break;
+
+      // Files without calibration markers carry the state in the status
+      case Data::XmlStatus :
+         xml.assign((const char *)data,size);
+         xmlValue(xml.c_str(),"<CalState>",&state_.calState);
+         xmlValue(xml.c_str(),"<CalChannel>",&state_.calChannel);
+         xmlValue(xml.c_str(),"<CalDac>",&state_.calDac);
+         break;
+
+      default : break;
+   }
+}
+
+// Build entry for a record at the current offset
+void DataIndex::entry ( uint32_t header, const uint8_t *data, uint32_t size, DataIndexEntry *entry ) {
+   calState(header,data,size);
+   checkpoint(header,data,size);
+
+   *entry = state_;
+   entry->offset = offset_;
+   entry->header = header;
+   if ( ((header >> 28) & 0xF) == Data::RawData && size >= 8 ) {
+      memcpy(&(entry->event),data,4);
+      memcpy(&(entry->timestamp),data+4,4);
+   }
+   else {
+      entry->event     = 0;
+      entry->timestamp = 0;
+   }
+   offset_ += 4 + recordBytes(header);
+}
+
+// Start writing the index of a data file being recorded
+bool DataIndex::create ( string file, uint64_t offset ) {
+   uint32_t head[2];
+
+   close();
+   entries_.clear();
+   reset();
+   file_ = file;
+
+   if ( offset != 0 ) {
+      unlink(fileName(file).c_str());
+      return(false);
+   }
+
+   if ( (fd_ = ::open(fileName(file).c_str(),O_WRONLY|O_CREAT|O_TRUNC,S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH)) < 0 )
+      return(false);
+
+   head[0] = sizeof(DataIndexEntry);
+   head[1] = 0;
+   if ( write(fd_,INDEX_MAGIC,8) != 8 || write(fd_,head,8) != 8 ) {
+      ::close(fd_);
+      fd_ = -1;
+      return(false);
+   }
+   return(true);
+}
+
+// Add record written to the data file
+void DataIndex::add ( uint32_t header, const void *data ) {
+   DataIndexEntry ent;
+
+   if ( fd_ < 0 ) return;
+
+   entry(header,(const uint8_t *)data,recordBytes(header),&ent);
+   entries_.push_back(ent);
+   if ( entries_.size() >= INDEX_FLUSH_SIZE ) flush();
+}
+
+// Write pending entries to the index file
+void DataIndex::flush ( ) {
+   if ( fd_ < 0 || entries_.empty() ) return;
+
+   write(fd_,&(entries_[0]),entries_.size() * sizeof(DataIndexEntry));
+   entries_.clear();
+}
+
+// Close the index file being written
+void DataIndex::close ( ) {
+   if ( fd_ < 0 ) return;
+   flush();
+   ::close(fd_);
+   fd_ = -1;
+}
+
+// Load the sidecar index of a data file
+bool DataIndex::load ( string file ) {
+   DataIndexEntry *last;
+   struct stat     st;
+   char            head[INDEX_HEAD_SIZE];
+   uint32_t        header;
+   uint32_t        size;
+   uint32_t        type;
+   uint64_t        x;
+   int32_t         fd;
+   int32_t         dfd;
+   bool            valid;
+
+   close();
+   entries_.clear();
+   reset();
+   file_ = file;
+
+   if ( (dfd = ::open(file.c_str(),O_RDONLY | O_LARGEFILE)) < 0 ) return(false);
+   fstat(dfd,&st);
+
+   // Sidecar header, entry size must match
+   valid = false;
+   if ( (fd = ::open(fileName(file).c_str(),O_RDONLY | O_LARGEFILE)) >= 0 ) {
+      if ( read(fd,head,INDEX_HEAD_SIZE) == INDEX_HEAD_SIZE && memcmp(head,INDEX_MAGIC,8) == 0 ) {
+         memcpy(&size,head+8,4);
+         if ( size == sizeof(DataIndexEntry) ) {
+            off_t bytes = lseek(fd,0,SEEK_END) - INDEX_HEAD_SIZE;
+            entries_.resize(bytes / sizeof(DataIndexEntry));
+            valid = ( entries_.empty() ||
+                      pread(fd,&(entries_[0]),entries_.size() * sizeof(DataIndexEntry),INDEX_HEAD_SIZE) ==
+                      (ssize_t)(entries_.size() * sizeof(DataIndexEntry)) );
+         }
+      }
+      ::close(fd);
+   }
+
+   // Last entry must match the data file
+   if ( valid && ! entries_.empty() ) {
+      last  = &(entries_.back());
+      valid = ( (last->offset + 4 + recordBytes(last->header)) <= (uint64_t)st.st_size &&
+                pread(dfd,&header,4,last->offset) == 4 && header == last->header );
+      if ( valid ) {
+         state_  = *last;
+         offset_ = last->offset + 4 + recordBytes(last->header);
+      }
+   }
+   ::close(dfd);
+
+   // Checkpoints of records added later follow the loaded ones
+   if ( valid ) {
+      for (x=0; x < entries_.size(); x++) {
+         type = (entries_[x].header >> 28) & 0xF;
+         if ( type == Data::XmlConfig && entries_[x].elements >= configElements_ ) {
+            configElements_ = entries_[x].elements;
+            fullConfig_     = x;
+         }
+         if ( type == Data::XmlStatus && entries_[x].elements >= statusElements_ ) {
+            statusElements_ = entries_[x].elements;
+            fullStatus_     = x;
+         }
+      }
+      records_ = entries_.size();
+   }
+   else {
+      entries_.clear();
+      reset();
+   }
+   return(update());
+}
+
+// Scan records of the data file past the last entry
+bool DataIndex::update ( ) {
+   DataIndexEntry ent;
+   struct stat    st;
+   uint32_t       header;
+   uint32_t       size;
+   uint8_t       *buff;
+   uint32_t       alloc;
+   int32_t        fd;
+
+   if ( (fd = ::open(file_.c_str(),O_RDONLY | O_LARGEFILE)) < 0 ) return(false);
+   fstat(fd,&st);
+   posix_fadvise(fd,offset_,0,POSIX_FADV_SEQUENTIAL);
+
+   alloc = 1024;
+   buff  = (uint8_t *)malloc(alloc);
+
+   // Only the first two words of raw data are read
+   while ( (offset_ + 4) <= (uint64_t)st.st_size && pread(fd,&header,4,offset_) == 4 ) {
+      if ( header == 0 ) {
+         offset_ += 4;
+         continue;
+      }
+      size = recordBytes(header);
+      if ( (offset_ + 4 + size) > (uint64_t)st.st_size ) break;
+      if ( ((header >> 28) & 0xF) == Data::RawData && size > 8 ) size = 8;
+
+      if ( size > alloc ) {
+         free(buff);
+         alloc = size;
+         buff  = (uint8_t *)malloc(alloc);
+      }
+      if ( pread(fd,buff,size,offset_+4) != (ssize_t)size ) break;
+
+      entry(header,buff,size,&ent);
+      entries_.push_back(ent);
+   }
+   free(buff);
+   ::close(fd);
+   return(true);
+}
+
+// Write index to the sidecar file
+bool DataIndex::save ( ) {
+   uint32_t head[2];
+   string   tmp;
+   int32_t  fd;
+   bool     ret;
+
+   tmp = fileName(file_) + ".tmp";
+   if ( (fd = ::open(tmp.c_str(),O_WRONLY|O_CREAT|O_TRUNC,S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH)) < 0 )
+      return(false);
+
+   head[0] = sizeof(DataIndexEntry);
+   head[1] = 0;
+   ret = ( write(fd,INDEX_MAGIC,8) == 8 && write(fd,head,8) == 8 );
+   if ( ret && ! entries_.empty() )
+      ret = ( write(fd,&(entries_[0]),entries_.size() * sizeof(DataIndexEntry)) ==
+              (ssize_t)(entries_.size() * sizeof(DataIndexEntry)) );
+   ::close(fd);
+
+   if ( ret ) ret = ( rename(tmp.c_str(),fileName(file_).c_str()) == 0 );
+   else unlink(tmp.c_str());
+   return(ret);
+}
+
+// Number of entries
+uint64_t DataIndex::count ( ) {
+   return(entries_.size());
+}
+
+// Return entry
+DataIndexEntry *DataIndex::entry ( uint64_t index ) {
+   if ( index >= entries_.size() ) return(NULL);
+   return(&(entries_[index]));
+}
+
+// First raw data record with event number
+int64_t DataIndex::findEvent ( uint32_t event ) {
+   uint64_t x;
+
+   for (x=0; x < entries_.size(); x++)
+      if ( ((entries_[x].header >> 28) & 0xF) == Data::RawData && entries_[x].event == event ) return(x);
+   return(-1);
+}
+
+// Record number count of a given type
+int64_t DataIndex::findMarker ( uint32_t type, uint32_t count ) {
+   uint64_t x;
+
+   for (x=0; x < entries_.size(); x++) {
+      if ( ((entries_[x].header >> 28) & 0xF) == type ) {
+         if ( count == 0 ) return(x);
+         count--;
+      }
+   }
+   return(-1);
+}
+
+// First record with the calibration state, channel and dac in effect
+int64_t DataIndex::findCalibration ( uint32_t state, uint32_t channel, uint32_t dac ) {
+   uint64_t x;
+
+   for (x=0; x < entries_.size(); x++)
+      if ( entries_[x].calState == state && entries_[x].calChannel == channel && entries_[x].calDac == dac ) return(x);
+   return(-1);
+}
+
+// Last record of a type before a record
+int64_t DataIndex::findLast ( uint32_t type, uint64_t before ) {
+   uint64_t x;
+
+   if ( before > entries_.size() ) before = entries_.size();
+   for (x=before; x > 0; x--)
+      if ( ((entries_[x-1].header >> 28) & 0xF) == type ) return(x-1);
+   return(-1);
+}
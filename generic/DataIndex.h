@@ -0,0 +1,167 @@
+//-----------------------------------------------------------------------------
+// File          : DataIndex.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Sidecar record index of a data file. Each record of the data file has an
+// entry with its offset, size and type word, the event number and timestamp
+// of raw data, the calibration state in effect and the records from which
+// the config and status are replayed when seeking to it. The index is written
+// next to the data file as <file>.idx while recording, or built by scanning
+// the data file.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Added replay checkpoints of each record
+//-----------------------------------------------------------------------------
+#ifndef __DATA_INDEX_H__
+#define __DATA_INDEX_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+using namespace std;
+
+#ifdef __CINT__
+#define uint32_t unsigned int
+#endif
+
+//! Index entry of one data file record
+typedef struct {
+   uint64_t offset;      //!< Offset of the record size word
+   uint64_t config;      //!< First record to replay config from, see DataIndex
+   uint64_t status;      //!< First record to replay status from, see DataIndex
+   uint32_t header;      //!< Record size and type word
+   uint32_t event;       //!< Event number of raw data
+   uint32_t timestamp;   //!< Timestamp of raw data
+   uint32_t calState;    //!< Calibration state in effect, 0 = Idle, 1 = Baseline, 2 = Inject
+   uint32_t calChannel;  //!< Calibration channel in effect
+   uint32_t calDac;      //!< Calibration dac in effect
+   uint32_t elements;    //!< Elements of an xml config or status record
+} DataIndexEntry;
+
+//! Class to hold the record index of a data file
+/*!
+ * A config or status record with at least as many elements as the largest
+ * one of its type before it holds the whole tree. The config and status
+ * replay records of an entry are the last such records before it. Config
+ * records from the first, and status records and calibration markers from
+ * the second after the last calibration marker before it, restore the
+ * config and status in effect.
+*/
+class DataIndex {
+
+      // Entries, while writing only those not yet flushed
+      vector<DataIndexEntry> entries_;
+
+      // Index file being written
+      int32_t fd_;
+
+      // Offset of the next record and calibration state in effect
+      uint64_t       offset_;
+      DataIndexEntry state_;
+
+      // Records indexed, last whole config and status records and their elements
+      uint64_t records_;
+      uint64_t fullConfig_;
+      uint64_t fullStatus_;
+      uint32_t configElements_;
+      uint32_t statusElements_;
+
+      // Scanned data file
+      string file_;
+
+      // Clear record state
+      void reset ( );
+
+      // Update replay checkpoints from a record payload
+      void checkpoint ( uint32_t header, const uint8_t *data, uint32_t size );
+
+      // Update calibration state from a record payload
+      void calState ( uint32_t header, const uint8_t *data, uint32_t size );
+
+      // Build entry for a record at the current offset, data holds at least the first two words
+      void entry ( uint32_t header, const uint8_t *data, uint32_t size, DataIndexEntry *entry );
+
+   public:
+
+      //! Constructor
+      DataIndex ( );
+
+      //! Deconstructor
+      ~DataIndex ( );
+
+      //! Sidecar index file name of a data file
+      static string fileName ( string file );
+
+      //! Start writing the index of a data file being recorded
+      /*!
+       * Only a data file which starts empty is indexed. The sidecar of a
+       * file which is appended to is removed, it can be rebuilt offline.
+       * Returns false if the index is not written.
+       * \param file   Data file name
+       * \param offset Current size of the data file
+      */
+      bool create ( string file, uint64_t offset );
+
+      //! Add record written to the data file
+      /*!
+       * \param header Record size and type word
+       * \param data   Record payload
+      */
+      void add ( uint32_t header, const void *data );
+
+      //! Write pending entries to the index file
+      void flush ( );
+
+      //! Close the index file being written
+      void close ( );
+
+      //! Load the sidecar index of a data file and index records added since
+      /*!
+       * The data file is scanned if no valid sidecar exists.
+       * Returns false if the data file can not be read.
+       * \param file Data file name
+      */
+      bool load ( string file );
+
+      //! Scan records of the data file past the last entry
+      bool update ( );
+
+      //! Write index to the sidecar file
+      bool save ( );
+
+      //! Number of entries
+      uint64_t count ( );
+
+      //! Return entry
+      DataIndexEntry *entry ( uint64_t index );
+
+      //! First raw data record with event number, -1 if not found
+      int64_t findEvent ( uint32_t event );
+
+      //! Record number count of a given type, -1 if not found
+      /*!
+       * \param type  Data::DataType of the record
+       * \param count Number of the record of this type, starting at 0
+      */
+      int64_t findMarker ( uint32_t type, uint32_t count );
+
+      //! First record with the calibration state, channel and dac in effect, -1 if not found
+      int64_t findCalibration ( uint32_t state, uint32_t channel, uint32_t dac );
+
+      //! Last record of a type before a record, -1 if there is none
+      int64_t findLast ( uint32_t type, uint64_t before );
+};
+#endif
@@ -0,0 +1,301 @@
+//-----------------------------------------------------------------------------
+// File          : DataPrefetch.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Read ahead of a file on slow storage. A background thread reads large
+// sequential blocks into a ring of buffers ahead of the reader, which takes
+// bytes from memory and only waits when the ring is empty.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include <DataPrefetch.h>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+static double prefetchTime ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Read thread
+void * DataPrefetch::run ( void *t ) {
+   DataPrefetch *ti;
+   ti = (DataPrefetch *)t;
+   ti->handler();
+   pthread_exit(NULL);
+   return(NULL);
+}
+
+// Fill blocks until the ring is full, wait for the reader to free one
+void DataPrefetch::handler ( ) {
+   uint32_t idx;
+   off_t    offset;
+   ssize_t  ret;
+   double   start;
+
+   while ( true ) {
+      pthread_mutex_lock(&mutex_);
+      while ( (head_ - tail_) >= blocks_.size() && ! stop_ ) pthread_cond_wait(&freeCondition_,&mutex_);
+      if ( stop_ ) {
+         pthread_mutex_unlock(&mutex_);
+         break;
+      }
+      idx    = head_ % blocks_.size();
+      offset = offset_;
+      pthread_mutex_unlock(&mutex_);
+
+      // Hint the block after this one while waiting on this one
+      posix_fadvise(fd_,offset+blockSize_,blockSize_,POSIX_FADV_WILLNEED);
+
+      start = prefetchTime();
+      ret   = pread(fd_,blocks_[idx],blockSize_,offset);
+
+      pthread_mutex_lock(&mutex_);
+      if ( ret > 0 ) {
+         fill_[idx] = ret;
+         offset_   += ret;
+         bytes_    += ret;
+         readTime_ += prefetchTime() - start;
+      }
+      else fill_[idx] = 0;
+      head_++;
+      pthread_cond_signal(&fillCondition_);
+      pthread_mutex_unlock(&mutex_);
+
+      if ( ret <= 0 ) break;
+   }
+
+   pthread_mutex_lock(&mutex_);
+   running_ = false;
+   pthread_cond_signal(&fillCondition_);
+   pthread_mutex_unlock(&mutex_);
+}
+
+// Take the next block, returns false at end of file
+bool DataPrefetch::nextBlock ( ) {
+   double start;
+
+   pthread_mutex_lock(&mutex_);
+
+   // Free the block being read
+   if ( curr_ != NULL ) {
+      curr_ = NULL;
+      tail_++;
+      pthread_cond_signal(&freeCondition_);
+   }
+
+   if ( head_ == tail_ && running_ ) {
+      start = prefetchTime();
+      while ( head_ == tail_ && running_ ) pthread_cond_wait(&fillCondition_,&mutex_);
+      stallTime_ += prefetchTime() - start;
+      stalls_++;
+   }
+
+   // An empty block marks the end of file, it is kept
+   if ( head_ == tail_ || fill_[tail_ % blocks_.size()] == 0 ) {
+      pthread_mutex_unlock(&mutex_);
+      return(false);
+   }
+   curr_     = blocks_[tail_ % blocks_.size()];
+   currFill_ = fill_[tail_ % blocks_.size()];
+   currPos_  = 0;
+   pthread_mutex_unlock(&mutex_);
+   return(true);
+}
+
+// Constructor
+DataPrefetch::DataPrefetch ( ) {
+   blockSize_ = 0;
+   head_      = 0;
+   tail_      = 0;
+   stop_      = false;
+   running_   = false;
+   curr_      = NULL;
+   currFill_  = 0;
+   currPos_   = 0;
+   pos_       = 0;
+   fd_        = -1;
+   offset_    = 0;
+   bytes_     = 0;
+   readTime_  = 0;
+   stallTime_ = 0;
+   stalls_    = 0;
+
+   pthread_mutex_init(&mutex_,NULL);
+   pthread_cond_init(&fillCondition_,NULL);
+   pthread_cond_init(&freeCondition_,NULL);
+}
+
+// Deconstructor
+DataPrefetch::~DataPrefetch ( ) {
+   stop();
+   pthread_cond_destroy(&fillCondition_);
+   pthread_cond_destroy(&freeCondition_);
+   pthread_mutex_destroy(&mutex_);
+}
+
+// Start reading ahead
+bool DataPrefetch::start ( int32_t fd, off_t offset, uint32_t blockSize, uint32_t blocks ) {
+   uint32_t x;
+
+   stop();
+   if ( blocks < 2 ) blocks = 2;
+
+   blockSize_ = blockSize;
+   blocks_.resize(blocks);
+   fill_.resize(blocks);
+   for (x=0; x < blocks; x++) {
+      blocks_[x] = (uint8_t *)malloc(blockSize);
+      fill_[x]   = 0;
+   }
+
+   head_     = 0;
+   tail_     = 0;
+   stop_     = false;
+   running_  = true;
+   curr_     = NULL;
+   currFill_ = 0;
+   currPos_  = 0;
+   pos_      = offset;
+   fd_       = fd;
+   offset_   = offset;
+
+   bytes_     = 0;
+   readTime_  = 0;
+   stallTime_ = 0;
+   stalls_    = 0;
+
+   posix_fadvise(fd_,offset,0,POSIX_FADV_SEQUENTIAL);
+
+   if ( pthread_create(&thread_,NULL,run,this) ) {
+      cout << "DataPrefetch::start -> Failed to create read thread" << endl;
+      for (x=0; x < blocks; x++) free(blocks_[x]);
+      blocks_.clear();
+      fill_.clear();
+      running_ = false;
+      return(false);
+   }
+   return(true);
+}
+
+// Stop the thread and free the ring
+void DataPrefetch::stop ( ) {
+   uint32_t x;
+
+   if ( blocks_.empty() ) return;
+
+   pthread_mutex_lock(&mutex_);
+   stop_ = true;
+   pthread_cond_signal(&freeCondition_);
+   pthread_mutex_unlock(&mutex_);
+   pthread_join(thread_,NULL);
+
+   for (x=0; x < blocks_.size(); x++) free(blocks_[x]);
+   blocks_.clear();
+   fill_.clear();
+   curr_    = NULL;
+   running_ = false;
+}
+
+// Return true if reading ahead
+bool DataPrefetch::active ( ) {
+   return(! blocks_.empty());
+}
+
+// Copy bytes, returns false at end of file
+bool DataPrefetch::read ( void *buff, uint32_t size ) {
+   uint8_t  *ptr;
+   uint32_t  count;
+
+   ptr = (uint8_t *)buff;
+   while ( size > 0 ) {
+      if ( (curr_ == NULL || currPos_ == currFill_) && ! nextBlock() ) return(false);
+
+      count = currFill_ - currPos_;
+      if ( count > size ) count = size;
+      memcpy(ptr,curr_+currPos_,count);
+      ptr      += count;
+      size     -= count;
+      currPos_ += count;
+      pos_     += count;
+   }
+   return(true);
+}
+
+// Return bytes without a copy if contiguous in the current block
+uint8_t *DataPrefetch::get ( uint32_t size ) {
+   uint8_t *ret;
+
+   if ( (curr_ == NULL || currPos_ == currFill_) && ! nextBlock() ) return(NULL);
+   if ( (currFill_ - currPos_) < size ) return(NULL);
+
+   ret       = curr_ + currPos_;
+   currPos_ += size;
+   pos_     += size;
+   return(ret);
+}
+
+// Return size of each read
+uint32_t DataPrefetch::blockSize ( ) {
+   return(blockSize_);
+}
+
+// Return number of blocks read ahead
+uint32_t DataPrefetch::blockCount ( ) {
+   return(blocks_.size());
+}
+
+// Return file offset of the reader
+off_t DataPrefetch::pos ( ) {
+   return(pos_);
+}
+
+// Bytes read from the file since the last start
+uint64_t DataPrefetch::bytes ( ) {
+   uint64_t ret;
+
+   pthread_mutex_lock(&mutex_);
+   ret = bytes_;
+   pthread_mutex_unlock(&mutex_);
+   return(ret);
+}
+
+// File read rate in bytes per second of read time
+double DataPrefetch::readRate ( ) {
+   double ret;
+
+   pthread_mutex_lock(&mutex_);
+   ret = (readTime_ > 0)?(bytes_ / readTime_):0;
+   pthread_mutex_unlock(&mutex_);
+   return(ret);
+}
+
+// Seconds the reader waited for data
+double DataPrefetch::stallTime ( ) {
+   return(stallTime_);
+}
+
+// Number of times the reader waited for data
+uint32_t DataPrefetch::stalls ( ) {
+   return(stalls_);
+}
@@ -0,0 +1,130 @@
+//-----------------------------------------------------------------------------
+// File          : DataPrefetch.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Read ahead of a file on slow storage. A background thread reads large
+// sequential blocks into a ring of buffers ahead of the reader, which takes
+// bytes from memory and only waits when the ring is empty.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __DATA_PREFETCH_H__
+#define __DATA_PREFETCH_H__
+
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+using namespace std;
+
+//! Class to read a file ahead of its reader
+class DataPrefetch {
+
+      // Ring of blocks and bytes read into each, 0 at end of file
+      vector<uint8_t *>  blocks_;
+      vector<uint32_t>   fill_;
+      uint32_t           blockSize_;
+
+      // Blocks filled by the thread and taken by the reader
+      uint64_t head_;
+      uint64_t tail_;
+      bool     stop_;
+      bool     running_;
+
+      // Block being read
+      uint8_t  *curr_;
+      uint32_t  currFill_;
+      uint32_t  currPos_;
+      off_t     pos_;
+
+      // File and offset of the next block
+      int32_t fd_;
+      off_t   offset_;
+
+      // Statistics
+      uint64_t bytes_;
+      double   readTime_;
+      double   stallTime_;
+      uint32_t stalls_;
+
+      // Thread
+      pthread_t       thread_;
+      pthread_mutex_t mutex_;
+      pthread_cond_t  fillCondition_;
+      pthread_cond_t  freeCondition_;
+
+      // Thread routines
+      static void *run ( void *t );
+      void handler ( );
+
+      // Take the next block, returns false at end of file
+      bool nextBlock ( );
+
+   public:
+
+      //! Constructor
+      DataPrefetch ( );
+
+      //! Deconstructor
+      ~DataPrefetch ( );
+
+      //! Start reading ahead
+      /*!
+       * \param fd        File descriptor, its offset is not used
+       * \param offset    Offset to start reading at
+       * \param blockSize Size of each read
+       * \param blocks    Number of blocks read ahead
+      */
+      bool start ( int32_t fd, off_t offset, uint32_t blockSize, uint32_t blocks );
+
+      //! Stop the thread and free the ring
+      void stop ( );
+
+      //! Return true if reading ahead
+      bool active ( );
+
+      //! Copy bytes, returns false at end of file
+      bool read ( void *buff, uint32_t size );
+
+      //! Return bytes without a copy if contiguous in the current block, NULL otherwise
+      /*!
+       * The bytes are valid until the next call of read() or get().
+       * Nothing is consumed if NULL is returned.
+      */
+      uint8_t *get ( uint32_t size );
+
+      //! Return size of each read
+      uint32_t blockSize ( );
+
+      //! Return number of blocks read ahead
+      uint32_t blockCount ( );
+
+      //! Return file offset of the reader
+      off_t pos ( );
+
+      //! Bytes read from the file since the last start
+      uint64_t bytes ( );
+
+      //! File read rate in bytes per second of read time
+      double readRate ( );
+
+      //! Seconds the reader waited for data
+      double stallTime ( );
+
+      //! Number of times the reader waited for data
+      uint32_t stalls ( );
+};
+#endif
@@ -18,6 +18,13 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 04/12/2011: created
+// 10/17/2026: Added memory mapped file reading
+// 10/17/2026: Added record index and seeking
+// 10/17/2026: Added read ahead thread
+// 10/17/2026: Added parallel decompression of compressed files
+// 10/17/2026: Xml records are parsed on first access
+// 10/17/2026: Seeking replays from the index checkpoints
+// 10/17/2026: Record index can be shared between readers
 //-----------------------------------------------------------------------------
 
 #include <DataRead.h>
@@ -26,9 +33,11 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <stdint.h>
 using namespace std;
 
@@ -36,6 +45,9 @@ using namespace std;
 #define O_LARGEFILE 0
 #endif
 
+// Pages of a mapped file behind the read position are dropped in blocks of this size
+#define MAP_FREE_SIZE 0x4000000
+
 // Constructor
 DataRead::DataRead ( ) {
    fd_          = -1;
@@ -46,6 +58,12 @@ DataRead::DataRead ( ) {
    rdAddr_      = 0;
    rdCount_     = 0;
    smem_        = NULL;
+   map_         = NULL;
+   mapPos_      = 0;
+   mapFree_     = 0;
+   bzEnable_    = false;
+   indexLoaded_ = false;
+   sharedIndex_ = NULL;
 }
 
 // Deconstructor
@@ -57,10 +75,6 @@ void DataRead::xmlParse ( uint32_t size, char *data ) {
    uint32_t      mySize;
    uint32_t      myType;
 
-#ifdef USE_BZLIB
-   int32_t          bzerror;
-#endif
-
    // Decode size
    myType = (size >> 28) & 0xF;
    mySize = (size & 0x0FFFFFFF);
@@ -70,111 +84,164 @@ void DataRead::xmlParse ( uint32_t size, char *data ) {
    // Read file
    buff = (char *) malloc(mySize+1);
    if ( data != NULL ) memcpy(buff,data,mySize);
-   else if ( bzEnable_ ) {
-#ifdef USE_BZLIB
-      if ( BZ2_bzRead ( &bzerror,bzFile_,buff, mySize ) != (int32_t)mySize )  {
-         cout << "DataRead::xmlParse -> Read error!" << endl;
-         return;
-      }
-#endif
-   }
-
    else if ( ::read(fd_, buff, mySize) != (int32_t)mySize) {
       cout << "DataRead::xmlParse -> Read error!" << endl;
       return;
    }
    buff[mySize-1] = 0;
 
-   if ( myType == Data::XmlConfig   ) config_.parse("config",buff);
-   if ( myType == Data::XmlStatus   ) status_.parse("status",buff);
+   // Records are parsed when a variable is read, partial records are kept
+   if ( myType == Data::XmlConfig   ) config_.parseLater("config",buff);
+   if ( myType == Data::XmlStatus   ) status_.parseLater("status",buff);
    if ( myType == Data::XmlRunStart ) {
       //cout << "-----------XML Start---------------" << endl;
       //cout << buff << endl;
       //cout << "-----------------------------------" << endl;
-      start_.parse("runStart",buff);
+      start_.parseLater("runStart",buff);
    }
    if ( myType == Data::XmlRunStop  ) {
       //cout << "-----------XML Stop----------------" << endl;
       //cout << buff << endl;
       //cout << "-----------------------------------" << endl;
-      stop_.parse("runStop",buff);
+      stop_.parseLater("runStop",buff);
    }
    if ( myType == Data::XmlRunTime  ) {
       //cout << "-----------XML Time----------------" << endl;
       //cout << buff << endl;
       //cout << "-----------------------------------" << endl;
-      time_.parse("runTime",buff);
+      time_.parseLater("runTime",buff);
+   }
+
+   free(buff);
+}
+
+// Process calibration marker, stored as status variables in the form
+// previously written by the xml status record
+void DataRead::calParse ( uint32_t size, char *data ) {
+   const char   *calState[3] = { "Idle", "Baseline", "Inject" };
+   uint32_t      marker[4];
+   uint32_t      mySize;
+   char         *buff;
+   stringstream  tmp;
+
+   mySize = (size & 0x0FFFFFFF);
+
+   // Read marker
+   buff = (char *) malloc(mySize);
+   if ( data != NULL ) memcpy(buff,data,mySize);
+   else if ( ::read(fd_, buff, mySize) != (int32_t)mySize) {
+      cout << "DataRead::calParse -> Read error!" << endl;
+      free(buff);
+      return;
    }
 
+   // Stride word is optional, one channel per step without it
+   if ( mySize >= 12 ) {
+      marker[3] = 1;
+      memcpy(marker,buff,(mySize < sizeof(marker))?mySize:sizeof(marker));
+
+      status_.set("CalState",(marker[0] < 3)?calState[marker[0]]:"Idle");
+      tmp.str("");
+      tmp << "0x" << hex << marker[1];
+      status_.set("CalChannel",tmp.str());
+      tmp.str("");
+      tmp << "0x" << hex << marker[2];
+      status_.set("CalDac",tmp.str());
+      tmp.str("");
+      tmp << "0x" << hex << marker[3];
+      status_.set("CalChanStride",tmp.str());
+   }
    free(buff);
 }
 
 // Open file
 bool DataRead::open ( string file, bool compressed ) {
 
-#ifdef USE_BZLIB
    bzEnable_ = compressed;
-   int32_t    bzerror;
-   FILE * f;
-#else
-   bzEnable_ = false;
-#endif
-
-   size_ = 0;
+   size_     = 0;
    status_.clear();
    config_.clear();
+   file_        = file;
+   indexLoaded_ = false;
+   sharedIndex_ = NULL;
 
-   // Attempt to open compressed file
-   if ( bzEnable_ ) {
+   // Attempt to open file
+   if ( (fd_ = ::open (file.c_str(),O_RDONLY | O_LARGEFILE)) < 0 ) {
+      cout << "DataRead::open -> Failed to open file: " << file << endl;
+      bzEnable_ = false;
+      return(false);
+   }
 
-#ifdef USE_BZLIB
+   // Compressed blocks are decompressed ahead of the reader
+   if ( bzEnable_ && ! bzip_.start(fd_) ) {
+      cout << "DataRead::open -> Failed to open compressed file: " << file << endl;
+      ::close(fd_);
+      fd_       = -1;
+      bzEnable_ = false;
+      return(false);
+   }
+   return(true);
+}
 
-      // Open file
-      f = fopen ( file.c_str(), "r" );
+// Open file mapped into memory
+bool DataRead::openMapped ( string file ) {
+   struct stat st;
+   void        *map;
 
-      // Attempt to compress file
-      if ( f ) {
-         bzFile_ = BZ2_bzReadOpen(&bzerror,f,0,0,NULL,0);
-         if ( bzerror != BZ_OK ) bzEnable_ = false;
-      }
-      else bzEnable_ = false;
+   if ( ! open(file) ) return(false);
 
-      if ( !bzEnable_ ) {
-         cout << "DataRead::open -> Failed to open compressed file: " << file << endl;
-         return(false);
-      }
-      cout << "Opened compressed file" << endl;
-#endif
+#ifndef RTEMS
+   if ( fstat(fd_,&st) != 0 || st.st_size == 0 || (uint64_t)st.st_size > (size_t)-1 ) return(true);
 
+   if ( (map = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd_,0)) == MAP_FAILED ) {
+      cout << "DataRead::openMapped -> Failed to map file, using read: " << file << endl;
+      return(true);
    }
 
-   // Attempt to open file
-   else {
-      if ( (fd_ = ::open (file.c_str(),O_RDONLY | O_LARGEFILE)) < 0 ) {
-         cout << "DataRead::open -> Failed to open file: " << file << endl;
-         return(false);
-      }
-   }
+   // Sequential read ahead, huge pages where the file system supports them
+   madvise(map,st.st_size,MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+   madvise(map,st.st_size,MADV_HUGEPAGE);
+#endif
+
+   map_     = (uint8_t *)map;
+   size_    = st.st_size;
+   mapPos_  = 0;
+   mapFree_ = 0;
+#endif
    return(true);
 }
 
-// Open file
-void DataRead::close () {
-#ifdef USE_BZLIB
-   int32_t bzerror;
-#endif
+// Open file read ahead by a background thread
+bool DataRead::openPrefetch ( string file, uint32_t blockSize, uint32_t blocks ) {
+   if ( ! open(file) ) return(false);
+   prefetch_.start(fd_,0,blockSize,blocks);
+   return(true);
+}
 
-   if ( bzEnable_ ) {
+// Return read ahead thread
+DataPrefetch *DataRead::prefetch ( ) {
+   return(prefetch_.active()?&prefetch_:NULL);
+}
 
-#ifdef USE_BZLIB
-      BZ2_bzReadClose(&bzerror,bzFile_);
-      bzEnable_ = false;
-#endif
+// Return decompression threads
+DataBzip *DataRead::bzip ( ) {
+   return(bzip_.active()?&bzip_:NULL);
+}
 
-   } else {
-      ::close(fd_);
-      fd_ = -1;
+// Open file
+void DataRead::close () {
+
+   if ( map_ != NULL ) {
+      munmap(map_,size_);
+      map_ = NULL;
    }
+   prefetch_.stop();
+   bzip_.stop();
+   bzEnable_ = false;
+
+   ::close(fd_);
+   fd_ = -1;
 }
 
 //! Return file size in bytes
@@ -182,6 +249,7 @@ off_t DataRead::size ( ) {
    off_t curr;
 
    if ( fd_ < 0 ) return(0);
+   if ( map_ != NULL ) return(size_);
    if ( size_ == 0 ) {
       curr  = lseek(fd_, 0, SEEK_CUR);
       size_ = lseek(fd_, 0, SEEK_END);
@@ -193,6 +261,9 @@ off_t DataRead::size ( ) {
 //! Return file position in bytes
 off_t DataRead::pos ( ) {
    if ( fd_ < 0 ) return(0);
+   if ( map_ != NULL ) return(mapPos_);
+   if ( prefetch_.active() ) return(prefetch_.pos());
+   if ( bzip_.active() ) return(bzip_.pos());
    return(lseek(fd_, 0, SEEK_CUR));
 }
 
@@ -202,11 +273,9 @@ bool DataRead::next (Data *data) {
    char *shBuff;
    bool found = false;
 
-#ifdef USE_BZLIB
-   int32_t  bzerror;
-#endif
-
-   if ( fd_ < 0 && smem_ == NULL && !bzEnable_ ) return(false);
+   if ( fd_ < 0 && smem_ == NULL ) return(false);
+   if ( map_ != NULL ) return(nextMapped(data));
+   if ( prefetch_.active() || bzip_.active() ) return(nextStream(data));
 
    // Read until we get data
    do { 
@@ -217,19 +286,6 @@ bool DataRead::next (Data *data) {
             return(false);
          }
       } 
-      else if ( bzEnable_ ) {
-
-#ifdef USE_BZLIB
-
-         cout << "Reading size field" << endl;
-         if ( BZ2_bzRead ( &bzerror,bzFile_,&size,4 ) != 4 ) {
-            cout << "Size field read fail" << endl;
-            return(false);
-         }
-         shBuff = NULL;
-#endif
-
-      }
       else {
 	if ( read(fd_,&size,4) != 4 ) return(false);
          shBuff = NULL;
@@ -260,6 +316,9 @@ bool DataRead::next (Data *data) {
          // Time
          case Data::XmlRunTime : sawRunTime_ = true; xmlParse(size,shBuff); break;
 
+         // Calibration marker
+         case Data::CalMarker : calParse(size,shBuff); break;
+
          // Unknown
          default: 
             cout << "DataRead::next -> Unknown data type 0x" 
@@ -276,10 +335,233 @@ bool DataRead::next (Data *data) {
       cout<<"Read Data: I am copying!\n"; // wmq
       return(true);
    }
+   else return(data->read(fd_,size));
+}
+
+// Get next data record from mapped file
+bool DataRead::nextMapped (Data *data) {
+   uint32_t size;
+   uint32_t bytes;
+   uint8_t *buff;
+
+   do {
+      if ( (mapPos_ + 4) > size_ ) return(false);
+      memcpy(&size,map_+mapPos_,4);
+      mapPos_ += 4;
+
+      if ( size == 0 ) continue;
+
+      bytes = (size & 0x0FFFFFFF);
+      if ( ((size >> 28) & 0xF) == Data::RawData ) bytes *= 4;
+      if ( (mapPos_ + bytes) > size_ ) {
+         mapPos_ = size_;
+         return(false);
+      }
+      buff     = map_ + mapPos_;
+      mapPos_ += bytes;
+
+      // Drop pages well behind the read position, records returned earlier stay
+      // readable since the pages are read back from the file on access
+      if ( (mapPos_ - mapFree_) >= (2 * MAP_FREE_SIZE) ) {
+         madvise(map_+mapFree_,MAP_FREE_SIZE,MADV_DONTNEED);
+         mapFree_ += MAP_FREE_SIZE;
+      }
+
+      // Frame type
+      switch ( (size >> 28) & 0xF ) {
+         
+         // Data, records after xml of odd length are not word aligned. 
+         // These are copied on targets without unaligned access.
+         case Data::RawData : 
+#if defined(__i386__) || defined(__x86_64__)
+            data->view((uint32_t *)buff,size & 0x0FFFFFFF);
+#else
+            if ( ((uintptr_t)buff & 0x3) == 0 ) data->view((uint32_t *)buff,size & 0x0FFFFFFF);
+            else data->copy((uint32_t *)buff,size & 0x0FFFFFFF);
+#endif
+            return(true);
+
+         // Xml records
+         case Data::XmlConfig : xmlParse(size,(char *)buff); break;
+         case Data::XmlStatus : xmlParse(size,(char *)buff); break;
+         case Data::XmlRunStart : sawRunStart_ = true; xmlParse(size,(char *)buff); break;
+         case Data::XmlRunStop : sawRunStop_ = true; xmlParse(size,(char *)buff); break;
+         case Data::XmlRunTime : sawRunTime_ = true; xmlParse(size,(char *)buff); break;
+
+         // Calibration marker
+         case Data::CalMarker : calParse(size,(char *)buff); break;
+
+         // Unknown
+         default: 
+            cout << "DataRead::next -> Unknown data type 0x" 
+                 << hex << setw(8) << setfill('0') << ((size >> 28) & 0xF) << " skipping." << endl;
+            break;
+      }
+   } while ( true );
+}
+
+// Read from the read ahead blocks or the decompressed blocks
+bool DataRead::streamRead ( void *buff, uint32_t size ) {
+   if ( bzip_.active() ) return(bzip_.read(buff,size));
+   return(prefetch_.read(buff,size));
+}
+
+// Return bytes without a copy from the read ahead blocks or the decompressed blocks
+uint8_t *DataRead::streamGet ( uint32_t size ) {
+   if ( bzip_.active() ) return(bzip_.get(size));
+   return(prefetch_.get(size));
+}
+
+// Get next data record from read ahead or decompressed blocks
+bool DataRead::nextStream (Data *data) {
+   uint32_t size;
+   uint32_t bytes;
+   uint8_t *buff;
+
+   do {
+      if ( ! streamRead(&size,4) ) return(false);
+      if ( size == 0 ) continue;
+
+      bytes = (size & 0x0FFFFFFF);
+      if ( ((size >> 28) & 0xF) == Data::RawData ) bytes *= 4;
+
+      // Records split across blocks are assembled in the buffer
+      if ( (buff = streamGet(bytes)) == NULL ) {
+         if ( prefetchBuff_.size() < bytes ) prefetchBuff_.resize(bytes);
+         buff = &(prefetchBuff_[0]);
+         if ( ! streamRead(buff,bytes) ) return(false);
+      }
+
+      // Frame type
+      switch ( (size >> 28) & 0xF ) {
+         
+         // Data, blocks are reused so the record is copied
+         case Data::RawData : 
+            data->copy((uint32_t *)buff,size & 0x0FFFFFFF);
+            return(true);
+
+         // Xml records
+         case Data::XmlConfig : xmlParse(size,(char *)buff); break;
+         case Data::XmlStatus : xmlParse(size,(char *)buff); break;
+         case Data::XmlRunStart : sawRunStart_ = true; xmlParse(size,(char *)buff); break;
+         case Data::XmlRunStop : sawRunStop_ = true; xmlParse(size,(char *)buff); break;
+         case Data::XmlRunTime : sawRunTime_ = true; xmlParse(size,(char *)buff); break;
+
+         // Calibration marker
+         case Data::CalMarker : calParse(size,(char *)buff); break;
+
+         // Unknown
+         default: 
+            cout << "DataRead::next -> Unknown data type 0x" 
+                 << hex << setw(8) << setfill('0') << ((size >> 28) & 0xF) << " skipping." << endl;
+            break;
+      }
+   } while ( true );
+}
+
+// Return record index of the open file
+DataIndex *DataRead::index ( ) {
+   if ( fd_ < 0 || bzEnable_ ) return(NULL);
+   if ( sharedIndex_ != NULL ) return(sharedIndex_);
+
+   if ( ! indexLoaded_ ) indexLoaded_ = index_.load(file_);
+   else index_.update();
+
+   return(indexLoaded_?&index_:NULL);
+}
+
+// Use the record index of another reader of the same file
+void DataRead::shareIndex ( DataIndex *index ) {
+   sharedIndex_ = index;
+}
+
+// Replay a config, status or calibration marker record
+void DataRead::replay ( DataIndexEntry *entry ) {
+   uint32_t bytes;
+   uint32_t type;
+   char    *buff;
+
+   type  = (entry->header >> 28) & 0xF;
+   bytes = entry->header & 0x0FFFFFFF;
+
+   if ( map_ != NULL ) buff = (char *)(map_ + entry->offset + 4);
    else {
-      if (bzEnable_) return(data->read(bzFile_,size));
-      else return(data->read(fd_,size));
+      buff = (char *)malloc(bytes);
+      if ( pread(fd_,buff,bytes,entry->offset + 4) != (ssize_t)bytes ) {
+         free(buff);
+         return;
+      }
+   }
+   if ( type == Data::CalMarker ) calParse(entry->header,buff);
+   else xmlParse(entry->header,buff);
+   if ( map_ == NULL ) free(buff);
+}
+
+// Move to record, config and status are restored from the records before it
+bool DataRead::seek ( int64_t record ) {
+   DataIndex      *dataIndex;
+   DataIndexEntry *entry;
+   DataIndexEntry *prev;
+   uint32_t        type;
+   int64_t         marker;
+   int64_t         x;
+
+   if ( record < 0 || (dataIndex = index()) == NULL || (entry = dataIndex->entry(record)) == NULL ) return(false);
+
+   // Records may hold part of the variables, as the status written by the
+   // calibration did. Replay starts at the last whole config and status
+   // records, status after the last calibration marker before it.
+   config_.clear();
+   status_.clear();
+   if ( (marker = dataIndex->findLast(Data::CalMarker,entry->status)) >= 0 ) replay(dataIndex->entry(marker));
+   for (x=(entry->config < entry->status)?entry->config:entry->status; x < record; x++) {
+      prev = dataIndex->entry(x);
+      type = (prev->header >> 28) & 0xF;
+      if ( (type == Data::XmlConfig && (uint64_t)x >= entry->config) ||
+           ((type == Data::XmlStatus || type == Data::CalMarker) && (uint64_t)x >= entry->status) ) replay(prev);
+   }
+
+   sawRunStart_ = false;
+   sawRunStop_  = false;
+   sawRunTime_  = false;
+
+   entry = dataIndex->entry(record);
+   if ( map_ != NULL ) {
+      mapPos_  = entry->offset;
+      mapFree_ = mapPos_ & ~((off_t)MAP_FREE_SIZE-1);
    }
+   else if ( prefetch_.active() ) prefetch_.start(fd_,entry->offset,prefetch_.blockSize(),prefetch_.blockCount());
+   else lseek(fd_,entry->offset,SEEK_SET);
+   return(true);
+}
+
+// Move to record number
+bool DataRead::seekRecord ( uint64_t record ) {
+   return(seek(record));
+}
+
+// Move to first raw data record with event number
+bool DataRead::seekEvent ( uint32_t event ) {
+   DataIndex *dataIndex;
+
+   if ( (dataIndex = index()) == NULL ) return(false);
+   return(seek(dataIndex->findEvent(event)));
+}
+
+// Move to a marker record
+bool DataRead::seekMarker ( uint32_t type, uint32_t count ) {
+   DataIndex *dataIndex;
+
+   if ( (dataIndex = index()) == NULL ) return(false);
+   return(seek(dataIndex->findMarker(type,count)));
+}
+
+// Move to first record with the calibration state, channel and dac in effect
+bool DataRead::seekCalibration ( uint32_t state, uint32_t channel, uint32_t dac ) {
+   DataIndex *dataIndex;
+
+   if ( (dataIndex = index()) == NULL ) return(false);
+   return(seek(dataIndex->findCalibration(state,channel,dac)));
 }
 
 // Get next data record
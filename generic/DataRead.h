@@ -18,21 +18,25 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 04/12/2011: created
+// 10/17/2026: Added parallel decompression of compressed files
+// 10/17/2026: Documented pos and size of compressed files
+// 10/17/2026: Seeking replays from the index checkpoints
+// 10/17/2026: Record index can be shared between readers
 //-----------------------------------------------------------------------------
 #ifndef __DATA_READ_H__
 #define __DATA_READ_H__
 
 #include <string>
 #include <map>
+#include <vector>
 #include <Data.h>
+#include <DataIndex.h>
+#include <DataPrefetch.h>
+#include <DataBzip.h>
 #include <XmlVariables.h>
 #include <DataSharedMem.h>
 #include <stdint.h>
 
-#ifdef USE_BZLIB
-#include <bzlib.h>
-#endif
-
 using namespace std;
 
 #ifdef __CINT__
@@ -57,13 +61,47 @@ class DataRead {
       // File size
       off_t size_;
 
-      // Compression options
+      // Mapped file, NULL when reading with read()
+      uint8_t *map_;
+      off_t    mapPos_;
+      off_t    mapFree_;
+
+      // Compressed file, decompressed in parallel
       bool     bzEnable_;
-      BZFILE * bzFile_;
+      DataBzip bzip_;
 
       // Process xml
       void xmlParse ( uint32_t size, char *data );
 
+      // Process calibration marker
+      void calParse ( uint32_t size, char *data );
+
+      // Get next data record from mapped file
+      bool nextMapped ( Data *data );
+
+      // Read ahead thread and buffer for records split across its blocks
+      DataPrefetch    prefetch_;
+      vector<uint8_t> prefetchBuff_;
+
+      // Read from the read ahead blocks or the decompressed blocks
+      bool streamRead ( void *buff, uint32_t size );
+      uint8_t *streamGet ( uint32_t size );
+
+      // Get next data record from read ahead or decompressed blocks
+      bool nextStream ( Data *data );
+
+      // File name and record index, loaded on first use or shared with another reader
+      string     file_;
+      DataIndex  index_;
+      DataIndex *sharedIndex_;
+      bool       indexLoaded_;
+
+      // Replay a config, status or calibration marker record
+      void replay ( DataIndexEntry *entry );
+
+      // Move to record, config and status are restored from the records before it
+      bool seek ( int64_t record );
+
       // Variables
       XmlVariables status_;
       XmlVariables config_;
@@ -86,10 +124,44 @@ class DataRead {
 
       //! Open File
       /*! 
-       * \param file Filename
+       * Compressed files are bzip2 files. Their blocks are decompressed
+       * in parallel, one thread per processor, ahead of the reader.
+       * \param file       Filename
+       * \param compressed File is bzip2 compressed
       */
       bool open ( string file, bool compressed = false );
 
+      //! Open File mapped into memory
+      /*! 
+       * Data records returned by next() point into the mapping without
+       * a copy and are valid until the file is closed. Falls back to
+       * read() if the file can not be mapped.
+       * \param file Filename
+      */
+      bool openMapped ( string file );
+
+      //! Open File read ahead by a background thread
+      /*! 
+       * For slow and network storage. Large blocks are read ahead into
+       * a ring of buffers and records are parsed from memory.
+       * \param file      Filename
+       * \param blockSize Size of each read in bytes
+       * \param blocks    Number of blocks read ahead
+      */
+      bool openPrefetch ( string file, uint32_t blockSize = 0x400000, uint32_t blocks = 16 );
+
+      //! Return read ahead thread of a file opened with openPrefetch(), NULL otherwise
+      /*! 
+       * Reports file read rate and the time next() waited for data.
+      */
+      DataPrefetch *prefetch ( );
+
+      //! Return decompression threads of a compressed file, NULL otherwise
+      /*! 
+       * Reports the time next() waited for data.
+      */
+      DataBzip *bzip ( );
+
       //! Open Shared Memory
       /*! 
        * \param system System name
@@ -101,9 +173,15 @@ class DataRead {
       void close ( );
 
       //! Return file size in bytes
+      /*!
+       * The compressed size for a bzip2 file.
+      */
       off_t size ( );
 
       //! Return file position in bytes
+      /*!
+       * The decompressed position for a bzip2 file, which grows past size().
+      */
       off_t pos ( );
 
       //! Get next data record
@@ -119,6 +197,50 @@ class DataRead {
       */
       Data *next ( );
 
+      //! Return record index of the open file
+      /*! 
+       * The sidecar index is loaded, or the file scanned, on first use.
+       * Returns NULL for compressed files and shared memory.
+      */
+      DataIndex *index ( );
+
+      //! Use the record index of another reader of the same file
+      /*!
+       * Call after open(). The index is not updated by this reader and must
+       * stay valid while it is used, readers in several threads may share it.
+       * \param index Index returned by index() of the other reader
+      */
+      void shareIndex ( DataIndex *index );
+
+      //! Move to record number, next() returns the first raw data record from there
+      /*! 
+       * Config and status are restored to their state before the record.
+       * Returns false if there is no such record.
+       * \param record Record number, starting at 0
+      */
+      bool seekRecord ( uint64_t record );
+
+      //! Move to first raw data record with event number
+      /*! 
+       * \param event Event number
+      */
+      bool seekEvent ( uint32_t event );
+
+      //! Move to a run start, run stop, run time or calibration marker record
+      /*! 
+       * \param type  Data::DataType of the marker
+       * \param count Number of the marker of this type, starting at 0
+      */
+      bool seekMarker ( uint32_t type, uint32_t count );
+
+      //! Move to first record with the calibration state, channel and dac in effect
+      /*! 
+       * \param state   Calibration state, 0 = Idle, 1 = Baseline, 2 = Inject
+       * \param channel Calibration channel
+       * \param dac     Calibration dac
+      */
+      bool seekCalibration ( uint32_t state, uint32_t channel, uint32_t dac );
+
       //! Get a config value
       /*! 
        * \param var Config variable name
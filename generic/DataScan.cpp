@@ -0,0 +1,173 @@
+//-----------------------------------------------------------------------------
+// File          : DataScan.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Parallel data file scanner. The file is split into chunks of records using
+// its record index. A pool of threads reads the chunks, each thread passing
+// events to its own processor. The processors are merged at the end.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Workers share the index, a failed chunk fails the scan
+//-----------------------------------------------------------------------------
+#include <DataScan.h>
+#include <DataRead.h>
+#include <DataIndex.h>
+#include <Data.h>
+#include <iostream>
+using namespace std;
+
+// Processor deconstructor
+DataScanProcessor::~DataScanProcessor ( ) { }
+
+// Worker thread
+void * DataScan::run ( void *t ) {
+   DataScanThread *ti;
+   ti = (DataScanThread *)t;
+   ti->scan->worker(ti);
+   pthread_exit(NULL);
+   return(NULL);
+}
+
+// Process chunks until none are left
+void DataScan::worker ( DataScanThread *thread ) {
+   DataRead  dataRead;
+   Data     *data;
+   uint32_t  chunk;
+   off_t     start;
+
+   // A chunk which can not be read fails the scan, the others stop early
+   if ( ! dataRead.openMapped(file_) ) {
+      pthread_mutex_lock(&mutex_);
+      failed_ = true;
+      pthread_mutex_unlock(&mutex_);
+      return;
+   }
+   dataRead.shareIndex(index_);
+   data = thread->proc->data();
+
+   while ( true ) {
+      pthread_mutex_lock(&mutex_);
+      chunk = (failed_)?chunks_.size():nextChunk_++;
+      pthread_mutex_unlock(&mutex_);
+
+      if ( chunk >= chunks_.size() ) break;
+      if ( ! dataRead.seekRecord(chunks_[chunk].first) ) {
+         cout << "DataScan::worker -> Failed to seek to record " << dec << chunks_[chunk].first << endl;
+         pthread_mutex_lock(&mutex_);
+         failed_ = true;
+         pthread_mutex_unlock(&mutex_);
+         break;
+      }
+
+      // next() skips xml records, the event returned may belong to the next chunk
+      while ( dataRead.next(data) ) {
+         start = dataRead.pos() - 4 - (data->size() * 4);
+         if ( (uint64_t)start >= chunks_[chunk].end ) break;
+         thread->proc->process(data,&dataRead);
+         thread->events++;
+      }
+   }
+   dataRead.close();
+}
+
+// Constructor
+DataScan::DataScan ( ) {
+   index_     = NULL;
+   nextChunk_ = 0;
+   failed_    = false;
+   pthread_mutex_init(&mutex_,NULL);
+}
+
+// Deconstructor
+DataScan::~DataScan ( ) {
+   pthread_mutex_destroy(&mutex_);
+}
+
+// Scan a file with one thread per processor
+int64_t DataScan::scan ( string file, vector<DataScanProcessor *> &procs, uint32_t chunks ) {
+   vector<DataScanThread> threads;
+   vector<pthread_t>      ids;
+   DataScanChunk          chunk;
+   DataRead               dataRead;
+   DataIndex             *index;
+   DataIndexEntry        *entry;
+   uint64_t               total;
+   uint64_t               target;
+   uint64_t               events;
+   uint64_t               x;
+
+   if ( procs.empty() || ! dataRead.open(file) ) return(-1);
+
+   // Compressed files can not be split, read them in order
+   if ( (index = dataRead.index()) == NULL || procs.size() == 1 ) {
+      events = 0;
+      while ( dataRead.next(procs[0]->data()) ) {
+         procs[0]->process(procs[0]->data(),&dataRead);
+         events++;
+      }
+      dataRead.close();
+      return(events);
+   }
+
+   // Split records into chunks of about equal size, workers share the index
+   if ( chunks == 0 ) chunks = procs.size() * 4;
+   file_  = file;
+   index_ = index;
+   chunks_.clear();
+   nextChunk_ = 0;
+   failed_    = false;
+
+   total  = dataRead.size();
+   target = (total + chunks - 1) / chunks;
+   chunk.first = 0;
+   for (x=0; x < index->count(); x++) {
+      entry = index->entry(x);
+      if ( entry->offset >= ((chunks_.size() + 1) * target) && x > chunk.first ) {
+         chunk.end = entry->offset;
+         chunks_.push_back(chunk);
+         chunk.first = x;
+      }
+   }
+   if ( chunk.first < index->count() ) {
+      chunk.end = total;
+      chunks_.push_back(chunk);
+   }
+
+   // Start workers
+   threads.resize(procs.size());
+   ids.resize(procs.size());
+   for (x=0; x < procs.size(); x++) {
+      threads[x].scan   = this;
+      threads[x].proc   = procs[x];
+      threads[x].events = 0;
+      if ( pthread_create(&ids[x],NULL,run,&threads[x]) ) {
+         cout << "DataScan::scan -> Failed to create worker thread" << endl;
+         break;
+      }
+   }
+
+   // Threads that failed to start leave their chunks to the others
+   events = 0;
+   threads.resize(x);
+   for (x=0; x < threads.size(); x++) {
+      pthread_join(ids[x],NULL);
+      events += threads[x].events;
+      if ( x > 0 ) procs[0]->merge(procs[x]);
+   }
+   dataRead.close();
+   index_ = NULL;
+   return((threads.empty() || failed_)?-1:(int64_t)events);
+}
@@ -0,0 +1,112 @@
+//-----------------------------------------------------------------------------
+// File          : DataScan.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Parallel data file scanner. The file is split into chunks of records using
+// its record index. A pool of threads reads the chunks, each thread passing
+// events to its own processor. The processors are merged at the end.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Workers share the index, a failed chunk fails the scan
+//-----------------------------------------------------------------------------
+#ifndef __DATA_SCAN_H__
+#define __DATA_SCAN_H__
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+using namespace std;
+
+class Data;
+class DataRead;
+class DataIndex;
+
+//! Per thread event processor of a data file scan
+class DataScanProcessor {
+   public:
+
+      //! Deconstructor
+      virtual ~DataScanProcessor ( );
+
+      //! Record events are read into, a KpixEvent for KPiX data
+      virtual Data *data ( ) = 0;
+
+      //! Process an event
+      /*!
+       * Config and status of dataRead are those in effect at the event.
+       * \param data     Event, the record returned by data()
+       * \param dataRead Reader of the chunk
+      */
+      virtual void process ( Data *data, DataRead *dataRead ) = 0;
+
+      //! Merge results of another processor into this one
+      /*!
+       * \param other Processor of another thread
+      */
+      virtual void merge ( DataScanProcessor *other ) = 0;
+};
+
+//! Class to scan a data file in parallel
+class DataScan {
+
+      // Chunk of records
+      typedef struct {
+         uint64_t first;   // First record
+         uint64_t end;     // Offset past the last record
+      } DataScanChunk;
+
+      // Thread argument
+      typedef struct {
+         DataScan          *scan;
+         DataScanProcessor *proc;
+         uint64_t           events;
+      } DataScanThread;
+
+      // Scanned file, its index and chunks
+      string                file_;
+      DataIndex            *index_;
+      vector<DataScanChunk> chunks_;
+
+      // Next chunk to process, set if a worker failed to read its chunk
+      uint32_t        nextChunk_;
+      bool            failed_;
+      pthread_mutex_t mutex_;
+
+      // Thread routines
+      static void *run ( void *t );
+      void worker ( DataScanThread *thread );
+
+   public:
+
+      //! Constructor
+      DataScan ( );
+
+      //! Deconstructor
+      ~DataScan ( );
+
+      //! Scan a file with one thread per processor
+      /*!
+       * The results of all processors are merged into the first one.
+       * Compressed files are scanned by the first processor alone.
+       * Returns the number of events or -1 if the file or a chunk can not be read.
+       * \param file   Data file name
+       * \param procs  Processors, one per thread
+       * \param chunks Number of chunks, 0 for four per thread
+      */
+      int64_t scan ( string file, vector<DataScanProcessor *> &procs, uint32_t chunks = 0 );
+};
+#endif
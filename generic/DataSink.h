@@ -0,0 +1,46 @@
+//-----------------------------------------------------------------------------
+// File          : DataSink.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Receiver of the records passed through the data thread of a CommLink.
+// Records are delivered in the order they are written to the data file,
+// with the same header word.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __DATA_SINK_H__
+#define __DATA_SINK_H__
+
+#include <stdint.h>
+using namespace std;
+
+//! Receiver of data thread records
+class DataSink {
+   public:
+
+      //! Deconstructor
+      virtual ~DataSink ( );
+
+      //! Record received
+      /*!
+       * Called from the data thread, the record is only valid during the call.
+       * \param header Record header, type in bits 31:28 and size in bits 27:0.
+       *               The size is in words for data and in bytes for others.
+       * \param data   Record contents
+      */
+      virtual void rxRecord ( uint32_t header, const void *data ) = 0;
+};
+#endif
@@ -26,11 +26,13 @@
 #include <Command.h>
 #include <Variable.h>
 #include <RegisterLink.h>
+#include <XmlWriter.h>
 #include <CommLink.h>
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 #include <string.h>
+#include <stdio.h>
 #include <stdint.h>
 using namespace std;
 
@@ -232,43 +234,159 @@ bool Device::setXmlConfig( xmlNode *node ) {
    return(update);
 }
 
+// Return value of element at the reader and move to its closing element
+string Device::xmlReaderValue ( xmlTextReaderPtr reader ) {
+   const xmlChar *content;
+   string         value;
+   int32_t        depth;
+   int32_t        ret;
+   bool           first;
+
+   if ( xmlTextReaderIsEmptyElement(reader) ) return("");
+
+   depth = xmlTextReaderDepth(reader);
+   first = true;
+
+   while ( (ret = xmlTextReaderRead(reader)) == 1 ) {
+      if ( xmlTextReaderDepth(reader) == depth ) break;
+
+      // First child node holds the value
+      if ( first ) {
+         first = false;
+         if ( xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT &&
+              (content = xmlTextReaderConstValue(reader)) != NULL ) value = (const char *)content;
+      }
+   }
+   if ( ret != 1 ) throw(string("Device::xmlReaderValue -> Failed to parse string\n"));
+   return(value);
+}
+
+// Method to set variable values from xml stream
+bool Device::setXmlConfig ( xmlTextReaderPtr reader, DeviceVector &targets, XmlOpVector &ops ) {
+   DeviceMap::iterator    devMapIter;
+   DeviceVector::iterator devIter;
+   DeviceVector           *dev;
+   DeviceVector           sub;
+   XmlOp                  op;
+   const char             *nodeName;
+   char                   *attrValue;
+   int32_t                nodeIndex;
+   char                   *eptr;
+   string                 value;
+   int32_t                depth;
+   int32_t                ret;
+   uint32_t               x;
+   bool                   isDevice;
+   bool                   update;
+
+   update = false;
+   if ( xmlTextReaderIsEmptyElement(reader) ) return(false);
+   depth = xmlTextReaderDepth(reader);
+
+   // Each child element
+   while ( (ret = xmlTextReaderRead(reader)) == 1 ) {
+      if ( xmlTextReaderDepth(reader) == depth ) break;
+      if ( xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT ) continue;
+
+      // Extract name
+      nodeName = (const char *)xmlTextReaderConstName(reader);
+
+      // Extract index attribute
+      attrValue = (char *)xmlTextReaderGetAttribute(reader,(const xmlChar*)"index");
+      if ( attrValue == NULL ) nodeIndex = -1;
+      else {
+         nodeIndex = (uint32_t)strtoul(attrValue,&eptr,0);
+         if ( *eptr != '\0' || eptr == attrValue ) nodeIndex = -1;
+         xmlFree(attrValue);
+      }
+
+      // Collect matching devices from each target
+      sub.clear();
+      isDevice = false;
+      for ( x=0; x < targets.size(); x++ ) {
+         devMapIter = targets[x]->devices_.find(nodeName);
+         if ( devMapIter != targets[x]->devices_.end() ) {
+            isDevice = true;
+            dev = devMapIter->second;
+
+            // All devices
+            if ( nodeIndex == -1 ) {
+               for ( devIter = dev->begin(); devIter != dev->end(); devIter++ ) 
+                  if ((*devIter) != NULL ) sub.push_back(*devIter);
+            }
+
+            // Specific device
+            else if ( nodeIndex < (int32_t)dev->size() && dev->at(nodeIndex) != NULL ) 
+               sub.push_back(dev->at(nodeIndex));
+         }
+      }
+
+      // Element is a device, an empty set consumes the block
+      if ( isDevice ) {
+         if ( setXmlConfig(reader,sub,ops) ) update = true;
+      }
+
+      // Element is a variable
+      else {
+         op.type  = XmlOp::Set;
+         op.name  = nodeName;
+         op.value = xmlReaderValue(reader);
+         for ( x=0; x < targets.size(); x++ ) {
+            op.device = targets[x];
+            ops.push_back(op);
+            update = true;
+         }
+      }
+   }
+   if ( ret != 1 ) throw(string("Device::setXmlConfig -> Failed to parse string\n"));
+   return(update);
+}
+
 // Method to return variables in xml string
 string Device::getXmlConfig(bool top, bool common, bool hidden, uint32_t level) {
+   XmlWriter xml;
+   getXmlConfig(xml,top,common,hidden,level);
+   return(xml.str());
+}
+
+// Method to append variables in xml form
+void Device::getXmlConfig(XmlWriter &xml, bool top, bool common, bool hidden, uint32_t level) {
    DeviceMap::iterator    devMapIter;
    DeviceVector           *dev;
    DeviceVector::iterator devIter;
-   stringstream           loc;
-   stringstream           tmp;
    VariableMap::iterator  varIter;
    uint32_t               locLevel = level;;
+   uint32_t               start;
+   uint32_t               body;
    bool                   foundOne;
    Device               * first;
 
-   loc.str("");
-   tmp.str("");
+   start = xml.size();
 
    // Start device tag if not top level
    if ( !top ) {
       if ( level != 0 ) {
-         for (uint32_t l=0; l < (level*3); l++) loc << " ";
+         xml.indent(level);
          locLevel++;
       }
-      loc << "<" << name_;
-      if ( ! common ) loc << " index=\"" << dec << index_ << "\"";
-      loc << ">" << endl;
+      xml.append("<");
+      xml.append(name_);
+      if ( ! common ) {
+         xml.append(" index=\"");
+         xml.append(index_);
+         xml.append("\"");
+      }
+      xml.append(">\n");
    }
+   body = xml.size();
 
    // Each local variable
    for (varIter=variables_.begin(); varIter != variables_.end(); ++varIter) {
 
       // Return all config variables at the top, return variables based upon the hidden variable at other levels
       if ( varIter->second->type() != Variable::Status && (!varIter->second->noConfig()) && ((!varIter->second->hidden()) || top || hidden )) {
-         if ( common == true || varIter->second->perInstance() ) {
-            if ( locLevel != 0 ) for (uint32_t l=0; l < (locLevel*3); l++) tmp << " ";
-            tmp << "<" << varIter->first << ">";
-            tmp << varIter->second->get();
-            tmp << "</" << varIter->first << ">" << endl;
-         }
+         if ( common == true || varIter->second->perInstance() ) 
+            xml.element(locLevel,varIter->first,varIter->second->get());
       }
    }
 
@@ -288,7 +406,7 @@ string Device::getXmlConfig(bool top, bool common, bool hidden, uint32_t level)
 
             // Return first enabled device in common mode, if not common mode return all
             if ( (! common) || (*devIter)->getVariable("Enabled")->getInt() ) {
-               tmp << (*devIter)->getXmlConfig(false,common,hidden,locLevel);
+               (*devIter)->getXmlConfig(xml,false,common,hidden,locLevel);
                foundOne = true; // We found an enabled device
                if ( common ) break;
             }
@@ -297,44 +415,147 @@ string Device::getXmlConfig(bool top, bool common, bool hidden, uint32_t level)
 
       // If we are in common mode and walked the array of a device type and did not find an enabled entry, 
       // use the config from the first valid device we found
-      if ( common && first != NULL && !foundOne ) tmp << first->getXmlConfig(false,common,hidden,locLevel);
+      if ( common && first != NULL && !foundOne ) first->getXmlConfig(xml,false,common,hidden,locLevel);
+   }
+
+   // Return nothing if there where no local variables
+   if ( xml.size() == body ) {
+      xml.truncate(start);
+      return;
    }
 
    // End device tag
-   loc << tmp.str();
+   if ( !top ) xml.close(level,name_);
+}
+
+// Method to append config variables with their flat path
+void Device::getFlatConfig ( FlatVariableVector &vars, string path, bool top, bool common ) {
+   DeviceMap::iterator    devMapIter;
+   DeviceVector           *dev;
+   DeviceVector::iterator devIter;
+   VariableMap::iterator  varIter;
+   FlatVariable           flat;
+   char                   idx[16];
+   Device               * first;
+   bool                   foundOne;
+
+   // Device path
    if ( !top ) {
-      if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) loc << " ";
-      loc << "</" << name_ << ">" << endl;
+      if ( path != "" ) path.append(":");
+      path.append(name_);
+      if ( ! common ) {
+         sprintf(idx,"(%u)",index_);
+         path.append(idx);
+      }
+   }
+   flat.status = false;
+
+   // Each local variable
+   for (varIter=variables_.begin(); varIter != variables_.end(); ++varIter) {
+      if ( varIter->second->type() != Variable::Status && (!varIter->second->noConfig()) && ((!varIter->second->hidden()) || top )) {
+         if ( common == true || varIter->second->perInstance() ) {
+            flat.key      = path;
+            if ( path != "" ) flat.key.append(":");
+            flat.key.append(varIter->first);
+            flat.variable = varIter->second;
+            vars.push_back(flat);
+         }
+      }
+   }
+
+   // Each sub device type, common values come from the first enabled device
+   for ( devMapIter = devices_.begin(); devMapIter != devices_.end(); devMapIter++ ) {
+      dev = devMapIter->second;
+
+      first = NULL;
+      foundOne = false;
+
+      for ( devIter = dev->begin(); devIter != dev->end(); devIter++ ) {
+         if ( (*devIter) != NULL ) {
+            if ( first == NULL ) first = (*devIter);
+            if ( (! common) || (*devIter)->getVariable("Enabled")->getInt() ) {
+               (*devIter)->getFlatConfig(vars,path,false,common);
+               foundOne = true;
+               if ( common ) break;
+            }
+         }
+      }
+      if ( common && first != NULL && !foundOne ) first->getFlatConfig(vars,path,false,common);
+   }
+}
+
+// Method to append status variables with their flat path
+void Device::getFlatStatus ( FlatVariableVector &vars, string path, bool top ) {
+   DeviceMap::iterator    devMapIter;
+   DeviceVector           *dev;
+   DeviceVector::iterator devIter;
+   VariableMap::iterator  varIter;
+   FlatVariable           flat;
+   char                   idx[16];
+
+   // Device path
+   if ( !top ) {
+      if ( path != "" ) path.append(":");
+      path.append(name_);
+      sprintf(idx,"(%u)",index_);
+      path.append(idx);
+   }
+   flat.status = true;
+
+   // Each local variable, status only
+   for (varIter=variables_.begin(); varIter != variables_.end(); ++varIter) {
+      if ( varIter->second->type() == Variable::Status && (!varIter->second->hidden() || top )) {
+         flat.key      = path;
+         if ( path != "" ) flat.key.append(":");
+         flat.key.append(varIter->first);
+         flat.variable = varIter->second;
+         vars.push_back(flat);
+      }
+   }
+
+   // Each sub device
+   for ( devMapIter = devices_.begin(); devMapIter != devices_.end(); devMapIter++ ) {
+      dev = devMapIter->second;
+      for ( devIter = dev->begin(); devIter != dev->end(); devIter++ ) {
+         if ((*devIter) != NULL) (*devIter)->getFlatStatus(vars,path,false);
+      }
    }
- 
-   // Return empty string if there where no local variables
-   if ( tmp.str() != "" ) return(loc.str());
-   else return("");
 }
 
 // Method to return status in xml string
 string Device::getXmlStatus(bool top, bool hidden, uint32_t level, bool compact, bool recursive) {
+   XmlWriter xml;
+   getXmlStatus(xml,top,hidden,level,compact,recursive);
+   return(xml.str());
+}
+
+// Method to append status in xml form
+void Device::getXmlStatus(XmlWriter &xml, bool top, bool hidden, uint32_t level, bool compact, bool recursive) {
    DeviceMap::iterator    devMapIter;
    DeviceVector           *dev;
    DeviceVector::iterator devIter;
-   stringstream           tmp;
-   stringstream           loc;
    VariableMap::iterator  varIter;
    uint32_t               locLevel = level;
+   uint32_t               start;
+   uint32_t               body;
    string                 value;
    bool                   include;
 
-   loc.str("");
-   tmp.str("");
+   start = xml.size();
 
    // Start device tag if not top level
    if (!top ) {
       if ( level != 0 ) {
-         for (uint32_t l=0; l < (level*3); l++) loc << " ";
+         xml.indent(level);
          locLevel++;
       }
-      loc << "<" << name_ << " index=\"" << dec << index_ << "\">" << endl;
+      xml.append("<");
+      xml.append(name_);
+      xml.append(" index=\"");
+      xml.append(index_);
+      xml.append("\">\n");
    }
+   body = xml.size();
 
    // Each local variable, status only
    for (varIter=variables_.begin(); varIter != variables_.end(); ++varIter) {
@@ -346,12 +567,7 @@ string Device::getXmlStatus(bool top, bool hidden, uint32_t level, bool compact,
          value = varIter->second->get(compact,&include);
 
          // Update if include flag is true
-         if ( top || include ) {
-            if ( locLevel != 0 ) for (uint32_t l=0; l < (locLevel*3); l++) tmp << " ";
-            tmp << "<" << varIter->first << ">";
-            tmp << value;
-            tmp << "</" << varIter->first << ">" << endl;
-         }
+         if ( top || include ) xml.element(locLevel,varIter->first,value);
       }
    }
 
@@ -362,21 +578,75 @@ string Device::getXmlStatus(bool top, bool hidden, uint32_t level, bool compact,
 
          // Device entries
          for ( devIter = dev->begin(); devIter != dev->end(); devIter++ ) {
-            if ((*devIter) != NULL) tmp << (*devIter)->getXmlStatus(false,hidden,locLevel,compact,true);
+            if ((*devIter) != NULL) (*devIter)->getXmlStatus(xml,false,hidden,locLevel,compact,true);
          }
       }
    }
 
+   // Return nothing if there where no local entries
+   if ( xml.size() == body ) {
+      xml.truncate(start);
+      return;
+   }
+
    // End device tag
-   loc << tmp.str();
+   if (!top ) xml.close(level,name_);
+}
+
+// Method to append status changed after journal version in xml form
+void Device::getXmlStatusSince(XmlWriter &xml, bool top, bool hidden, uint32_t level, uint64_t since) {
+   DeviceMap::iterator    devMapIter;
+   DeviceVector           *dev;
+   DeviceVector::iterator devIter;
+   VariableMap::iterator  varIter;
+   uint32_t               locLevel = level;
+   uint32_t               start;
+   uint32_t               body;
+   string                 value;
+   bool                   include;
+
+   start = xml.size();
+
+   // Start device tag if not top level
    if (!top ) {
-      if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) loc << " ";
-      loc << "</" << name_ << ">" << endl;
+      if ( level != 0 ) {
+         xml.indent(level);
+         locLevel++;
+      }
+      xml.append("<");
+      xml.append(name_);
+      xml.append(" index=\"");
+      xml.append(index_);
+      xml.append("\">\n");
    }
+   body = xml.size();
 
-   // Return empty string if there where no local entries
-   if ( tmp.str() != "" ) return(loc.str());
-   else return("");
+   // Each local variable, status only
+   for (varIter=variables_.begin(); varIter != variables_.end(); ++varIter) {
+      if ( varIter->second->type() == Variable::Status && (!varIter->second->hidden() || top || hidden )) {
+         value = varIter->second->getSince(since,&include);
+         if ( include ) xml.element(locLevel,varIter->first,value);
+      }
+   }
+
+   // Get each sub device
+   for ( devMapIter = devices_.begin(); devMapIter != devices_.end(); devMapIter++ ) {
+      dev = devMapIter->second;
+
+      // Device entries
+      for ( devIter = dev->begin(); devIter != dev->end(); devIter++ ) {
+         if ((*devIter) != NULL) (*devIter)->getXmlStatusSince(xml,false,hidden,locLevel,since);
+      }
+   }
+
+   // Return nothing if there where no changed entries
+   if ( xml.size() == body ) {
+      xml.truncate(start);
+      return;
+   }
+
+   // End device tag
+   if (!top ) xml.close(level,name_);
 }
 
 // Method to execute commands from xml tree
@@ -435,41 +705,101 @@ void Device::execXmlCommand ( xmlNode *node ) {
    }
 }
 
+// Method to execute commands from xml stream
+void Device::execXmlCommand ( xmlTextReaderPtr reader, XmlOpVector &ops ) {
+   DeviceMap::iterator    devMapIter;
+   DeviceVector           *dev;
+   XmlOp                  op;
+   string                 nodeName;
+   string                 nodeValue;
+   char                   *attrValue;
+   int32_t                nodeIndex;
+   char                   *eptr;
+   int32_t                depth;
+   int32_t                ret;
+
+   if ( xmlTextReaderIsEmptyElement(reader) ) return;
+   depth = xmlTextReaderDepth(reader);
+
+   // Each child element
+   while ( (ret = xmlTextReaderRead(reader)) == 1 ) {
+      if ( xmlTextReaderDepth(reader) == depth ) break;
+      if ( xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT ) continue;
+
+      // Extract name
+      nodeName = (const char *)xmlTextReaderConstName(reader);
+
+      // Extract index attribute
+      attrValue = (char *)xmlTextReaderGetAttribute(reader,(const xmlChar*)"index");
+      if ( attrValue == NULL ) nodeIndex = 0;
+      else {
+         nodeIndex = (uint32_t)strtoul(attrValue,&eptr,0);
+         if ( *eptr != '\0' || eptr == attrValue ) nodeIndex = 0;
+         xmlFree(attrValue);
+      }
+
+      // Look for matching device
+      devMapIter = devices_.find(nodeName);
+
+      // Element is a device
+      if ( devMapIter != devices_.end() ) {
+         dev = devMapIter->second;
+         if ( nodeIndex < (int32_t)dev->size() && dev->at(nodeIndex) != NULL ) dev->at(nodeIndex)->execXmlCommand(reader,ops);
+         else xmlReaderValue(reader);
+      }
+
+      // Element is a command
+      else {
+         op.type   = XmlOp::Command;
+         op.device = this;
+         op.name   = nodeName;
+         op.value  = xmlReaderValue(reader);
+         ops.push_back(op);
+      }
+   }
+   if ( ret != 1 ) throw(string("Device::execXmlCommand -> Failed to parse string\n"));
+}
+
 // Method to get device structure in xml form.
 string Device::getXmlStructure (bool top, bool common, bool hidden, uint32_t level) {
+   XmlWriter xml;
+   getXmlStructure(xml,top,common,hidden,level);
+   return(xml.str());
+}
+
+// Method to append device structure in xml form.
+void Device::getXmlStructure (XmlWriter &xml, bool top, bool common, bool hidden, uint32_t level) {
    DeviceMap::iterator    devMapIter;
    DeviceVector           *dev;
    DeviceVector::iterator devIter;
-   stringstream           tmp;
-   stringstream           loc;
    VariableMap::iterator  varIter;
    CommandMap::iterator   cmdIter;
    uint32_t               locLevel = level;
+   uint32_t               start;
+   uint32_t               body;
 
-   tmp.str("");
-   loc.str("");
+   start = xml.size();
 
    // Start device tag, don't include for the top level device
    if ( !top ) {
       if ( level != 0 ) {
-         for (uint32_t l=0; l < (level*3); l++) loc << " ";
+         xml.indent(level);
          locLevel++;
       }
-      loc << "<device>" << endl;
+      xml.append("<device>\n");
       if ( ! common ) {
-         if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) loc << " ";
-         loc << "<index>" << index_ << "</index>" << endl;
+         xml.indent(level);
+         xml.append("<index>");
+         xml.append(index_);
+         xml.append("</index>\n");
       }
    }
+   body = xml.size();
 
    // Return name and description for top level only when in common mode
    if ( common || !top ) {
-      if ( locLevel != 0 ) for (uint32_t l=0; l < (locLevel*3); l++) tmp << " ";
-      tmp << "<name>" << name_ << "</name>" << endl;
-      if ( desc_ != "" ) {
-         if ( locLevel != 0 ) for (uint32_t l=0; l < (locLevel*3); l++) tmp << " ";
-         tmp << "<description>" << desc_ << "</description>" << endl;
-      }
+      xml.element(locLevel,"name",name_);
+      if ( desc_ != "" ) xml.element(locLevel,"description",desc_);
    }
 
    // Variables, common or specific
@@ -478,7 +808,7 @@ string Device::getXmlStructure (bool top, bool common, bool hidden, uint32_t lev
 
       // Each local variable
       for (varIter=variables_.begin(); varIter != variables_.end(); ++varIter) 
-         if ( common != varIter->second->perInstance() ) tmp << varIter->second->getXmlStructure(hidden||top,locLevel);
+         if ( common != varIter->second->perInstance() ) varIter->second->getXmlStructure(xml,hidden||top,locLevel);
 
    }
 
@@ -488,7 +818,7 @@ string Device::getXmlStructure (bool top, bool common, bool hidden, uint32_t lev
 
       // Each local command
       for (cmdIter=commands_.begin(); cmdIter != commands_.end(); ++cmdIter) 
-         tmp << cmdIter->second->getXmlStructure(hidden||top,locLevel);
+         cmdIter->second->getXmlStructure(xml,hidden||top,locLevel);
    }
 
    // Sub devices
@@ -501,23 +831,24 @@ string Device::getXmlStructure (bool top, bool common, bool hidden, uint32_t lev
          // Device entries
          for ( devIter = dev->begin(); devIter != dev->end(); devIter++ ) {
             if ( (*devIter) != NULL ) {
-               tmp << (*devIter)->getXmlStructure(false,common,hidden,locLevel);
+               (*devIter)->getXmlStructure(xml,false,common,hidden,locLevel);
                if ( common ) break; // Return first instance when in common mode
             }
          }
       }
    }
 
+   // Return nothing if there where not local entries
+   if ( xml.size() == body ) {
+      xml.truncate(start);
+      return;
+   }
+
    // End device tag
-   loc << tmp.str();
    if (!top) {
-      if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) loc << " ";
-      loc << "</device>" << endl;
+      xml.indent(level);
+      xml.append("</device>\n");
    }
-
-   // Return empty string if there where not local entries
-   if ( tmp.str() != "" ) return(loc.str());
-   else return("");
 }
 
 // Constructor
@@ -27,6 +27,7 @@
 #include <map>
 #include <vector>
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 #include <pthread.h>
 #include <stdint.h>
 #include <Variable.h>
@@ -39,6 +40,7 @@ class CommLink;
 class System;
 //class Variable;
 class RegisterLink;
+class XmlWriter;
 
 // Define local types
 typedef map<string,Variable *>     VariableMap;
@@ -48,6 +50,24 @@ typedef vector<Device *>           DeviceVector;
 typedef map<string,DeviceVector*>  DeviceMap;
 typedef vector<RegisterLink *>     RegisterLinkVector;
 
+//! Variable with its flat path, the key form used by XmlVariables
+struct FlatVariable {
+   string     key;
+   Variable * variable;
+   bool       status;
+};
+typedef vector<FlatVariable>       FlatVariableVector;
+
+//! Variable set, command or config write read from an xml stream
+struct XmlOp {
+   enum Type { Set, Command, Write };
+   Type       type;
+   Device   * device;
+   string     name;
+   string     value;
+};
+typedef vector<XmlOp>              XmlOpVector;
+
 // Macro to create lock and start try block
 #define REGISTER_LOCK pthread_mutex_lock(&mutex_); try { 
 
@@ -121,6 +141,19 @@ class Device {
       // Method to set variable values from xml tree
       bool setXmlConfig ( xmlNode *node );
 
+      // Method to read variable values from xml stream. The reader is positioned
+      // on the opening element of the block and is left on its closing element.
+      // A set of each value for every target device is appended to ops, allowing
+      // a block without an index to configure all instances in one pass. Nothing
+      // is applied, so a string failing to parse later has no effect.
+      // Throws string on error
+      static bool setXmlConfig ( xmlTextReaderPtr reader, DeviceVector &targets, XmlOpVector &ops );
+
+      // Return value of element at the reader and move to its closing element.
+      // The value is the content of the first child node, matching the tree form.
+      // Throws string on error
+      static string xmlReaderValue ( xmlTextReaderPtr reader );
+
       // Method to get config variable values in xml form.
       // Two different types of config variables can be returned
       // per-device variables and common variables. The common flag
@@ -130,16 +163,42 @@ class Device {
       // level device, determine by the top flag.
       string getXmlConfig ( bool top, bool common, bool hidden, uint32_t level );
 
+      // Method to append config variable values in xml form to
+      // the passed writer. Nothing is appended for an empty device.
+      void getXmlConfig ( XmlWriter &xml, bool top, bool common, bool hidden, uint32_t level );
+
       // Method to get status variable values in xml form.
       // The hidden flag determines if hidden status variables should 
       // be included in the string. Hidden variables will always be sent 
       // for the top level device, determine by the top flag.
       string getXmlStatus (bool top, bool hidden, uint32_t level, bool compact, bool recursive );
 
+      // Method to append status variable values in xml form to
+      // the passed writer. Nothing is appended for an empty device.
+      void getXmlStatus (XmlWriter &xml, bool top, bool hidden, uint32_t level, bool compact, bool recursive );
+
+      // Method to append status variables which changed after the passed
+      // journal version. Sub devices are always included.
+      void getXmlStatusSince (XmlWriter &xml, bool top, bool hidden, uint32_t level, uint64_t since );
+
+      // Method to append config variables with their flat path. The selection
+      // matches getXmlConfig without hidden variables, the path is empty at the top.
+      void getFlatConfig ( FlatVariableVector &vars, string path, bool top, bool common );
+
+      // Method to append status variables with their flat path. The selection
+      // matches a recursive getXmlStatus without hidden variables.
+      void getFlatStatus ( FlatVariableVector &vars, string path, bool top );
+
       // Method to execute commands from xml tree
       // Throws string on error
       void execXmlCommand ( xmlNode *node );
 
+      // Method to read commands from xml stream. The reader is positioned
+      // on the opening element of the block and is left on its closing element.
+      // Commands are appended to ops and executed by the caller.
+      // Throws string on error
+      void execXmlCommand ( xmlTextReaderPtr reader, XmlOpVector &ops );
+
       // Method to get device structure in xml form.
       // Two different types of variables and commands can be returned
       // per-device and common The common flag determines which type 
@@ -148,6 +207,9 @@ class Device {
       // sent for the top level device, determine by the top flag.
       string getXmlStructure ( bool top, bool common, bool hidden, uint32_t level);
 
+      // Method to append device structure in xml form to the passed writer.
+      void getXmlStructure ( XmlWriter &xml, bool top, bool common, bool hidden, uint32_t level);
+
       // Add registers
       void addRegister(Register *reg);
 
@@ -171,7 +171,7 @@ void MultLink::rxHandler() {
                // Data is received
                if ( type == MultDest::MultTypeData ) {
                   data = new Data((uint32_t *)ptr,ret/4);
-                  dataQueue_.push(data);
+                  dataPush(data);
                   dataThreadWakeup();
                }
 
@@ -103,7 +103,7 @@ void PgpCardG3Link::rxHandler() {
 
          if ( (vcMaskRx & vcMask) != 0 && (laneMaskRx & laneMask) != 0 ) {
             data = new Data(rxBuff,ret);
-            dataQueue_.push(data);
+            dataPush(data);
             dataThreadWakeup();
          }
 
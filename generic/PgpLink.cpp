@@ -102,7 +102,7 @@ void PgpLink::rxHandler() {
 
          if ( (vcMaskRx & vcMask) != 0 && (laneMaskRx & laneMask) != 0 ) {
             data = new Data(rxBuff,ret);
-            dataQueue_.push(data);
+            dataPush(data);
             dataThreadWakeup();
          }
 
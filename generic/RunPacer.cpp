@@ -0,0 +1,133 @@
+//-----------------------------------------------------------------------------
+// File          : RunPacer.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Software run trigger pacing. Triggers are scheduled on absolute deadlines
+// of CLOCK_MONOTONIC, one period apart, so that time spent between triggers
+// does not accumulate as drift. The interval between triggers is tracked to
+// report the achieved period and its jitter.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include <RunPacer.h>
+#include <sstream>
+#include <iomanip>
+#include <math.h>
+#include <errno.h>
+using namespace std;
+
+// Constructor
+RunPacer::RunPacer ( ) {
+   start(0);
+}
+
+// Start a new schedule
+void RunPacer::start ( uint32_t period ) {
+   period_ = period;
+   late_   = 0;
+   count_  = 0;
+   last_   = 0;
+   sum_    = 0;
+   sumSq_  = 0;
+   min_    = 0;
+   max_    = 0;
+   clock_gettime(CLOCK_MONOTONIC,&next_);
+}
+
+// Sleep until the next deadline
+void RunPacer::wait ( ) {
+   struct timespec curr;
+
+   if ( period_ == 0 ) return;
+
+   while ( clock_nanosleep(CLOCK_MONOTONIC,TIMER_ABSTIME,&next_,NULL) == EINTR );
+
+   // Next deadline is relative to this one, not to when we woke up
+   next_.tv_nsec += (period_ % 1000000) * 1000;
+   next_.tv_sec  += period_ / 1000000;
+   if ( next_.tv_nsec >= 1000000000 ) {
+      next_.tv_nsec -= 1000000000;
+      next_.tv_sec  += 1;
+   }
+
+   // Caller fell behind by more than a period, restart from now
+   clock_gettime(CLOCK_MONOTONIC,&curr);
+   if ( curr.tv_sec > next_.tv_sec || (curr.tv_sec == next_.tv_sec && curr.tv_nsec > next_.tv_nsec) ) {
+      next_ = curr;
+      late_++;
+   }
+}
+
+// Record a trigger
+void RunPacer::trigger ( ) {
+   double curr;
+   double diff;
+
+   curr = now();
+   if ( count_ > 0 ) {
+      diff = curr - last_;
+      if ( count_ == 1 || diff < min_ ) min_ = diff;
+      if ( count_ == 1 || diff > max_ ) max_ = diff;
+      sum_   += diff;
+      sumSq_ += diff * diff;
+   }
+   last_ = curr;
+   count_++;
+}
+
+// Number of recorded triggers
+uint32_t RunPacer::count ( ) {
+   return(count_);
+}
+
+// Mean trigger interval
+double RunPacer::mean ( ) {
+   if ( count_ < 2 ) return(0);
+   return(sum_ / (count_ - 1));
+}
+
+// RMS deviation of the trigger interval
+double RunPacer::jitter ( ) {
+   double avg;
+   double var;
+
+   if ( count_ < 2 ) return(0);
+   avg = mean();
+   var = (sumSq_ / (count_ - 1)) - (avg * avg);
+   return((var > 0)?sqrt(var):0);
+}
+
+// Statistics as a single line
+string RunPacer::stats ( ) {
+   stringstream tmp;
+
+   tmp << "Triggers=" << dec << count_
+       << fixed << setprecision(1)
+       << ", Period=" << mean() << "uS"
+       << ", Jitter=" << jitter() << "uS"
+       << ", Min=" << min_ << "uS"
+       << ", Max=" << max_ << "uS"
+       << ", Late=" << late_;
+   return(tmp.str());
+}
+
+// Current time in uS
+double RunPacer::now ( ) {
+   struct timespec curr;
+   clock_gettime(CLOCK_MONOTONIC,&curr);
+   return((curr.tv_sec * 1e6) + (curr.tv_nsec * 1e-3));
+}
+
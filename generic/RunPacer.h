@@ -0,0 +1,91 @@
+//-----------------------------------------------------------------------------
+// File          : RunPacer.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Software run trigger pacing. Triggers are scheduled on absolute deadlines
+// of CLOCK_MONOTONIC, one period apart, so that time spent between triggers
+// does not accumulate as drift. The interval between triggers is tracked to
+// report the achieved period and its jitter.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __RUN_PACER_H__
+#define __RUN_PACER_H__
+
+#include <string>
+#include <stdint.h>
+#include <time.h>
+using namespace std;
+
+//! Class to pace software run triggers
+class RunPacer {
+
+      // Trigger period in uS, 0 for no limit
+      uint32_t period_;
+
+      // Next deadline
+      struct timespec next_;
+
+      // Deadlines skipped because the caller fell behind
+      uint32_t late_;
+
+      // Trigger interval statistics, uS
+      uint32_t count_;
+      double   last_;
+      double   sum_;
+      double   sumSq_;
+      double   min_;
+      double   max_;
+
+   public:
+
+      //! Constructor
+      RunPacer ( );
+
+      //! Start a new schedule, first deadline is now
+      /*!
+       * \param period Trigger period in uS, 0 for no limit
+      */
+      void start ( uint32_t period );
+
+      //! Sleep until the next deadline
+      /*!
+       * Returns immediately with no limit. A caller which is more than a
+       * period behind is resynchronized to the current time rather than
+       * issuing a burst of triggers.
+      */
+      void wait ( );
+
+      //! Record a trigger for the period statistics
+      void trigger ( );
+
+      //! Number of recorded triggers
+      uint32_t count ( );
+
+      //! Mean trigger interval in uS
+      double mean ( );
+
+      //! RMS deviation of the trigger interval in uS
+      double jitter ( );
+
+      //! Statistics as a single line
+      string stats ( );
+
+      //! Current CLOCK_MONOTONIC time in uS
+      static double now ( );
+};
+#endif
+
@@ -100,7 +100,7 @@ void SimLinkByte::rxHandler() {
 
          if ( (vcMaskRx & vcMask) != 0 && (laneMaskRx & laneMask) != 0 ) {
             data = new Data(rxBuff,ret);
-            dataQueue_.push(data);
+            dataPush(data);
             dataThreadWakeup();
          }
 
@@ -28,6 +28,7 @@
 #include <iomanip>
 #include <string.h>
 #include <Variable.h>
+#include <RunPacer.h>
 #include <time.h>
 #include <stdint.h>
 using namespace std;
@@ -41,6 +42,9 @@ System::System ( string name, CommLink *commLink ) : Device(0,0,name,0,NULL) {
    hwRunning_      = false;
    allStatusReq_   = false;
    topStatusReq_   = false;
+   statusJournal_  = false;
+   snapMem_        = NULL;
+   snapVersion_    = 0;
    defaults_       = "defaults.xml";
    configureMsg_   = "System Is Not Configured.\nSet Defaults Or Load Settings!\n";
    swRunPeriod_    = 0;
@@ -60,6 +64,7 @@ System::System ( string name, CommLink *commLink ) : Device(0,0,name,0,NULL) {
 
    xmlId_ = 0;
    pthread_mutex_init(&xmlMutex_,NULL);
+   pthread_mutex_init(&xmlOutMutex_,NULL);
 
    Command  *c;
    Variable *v;
@@ -156,6 +161,10 @@ System::System ( string name, CommLink *commLink ) : Device(0,0,name,0,NULL) {
    v->setDescription("Number of unexpected receive packets");
    v->setHidden(true);
 
+   addVariable(v = new Variable("DataDropCount",Variable::Status));
+   v->setDescription("Number of received frames dropped because the data queue was full");
+   v->setHidden(true);
+
    addVariable(v = new Variable("TimeoutCount",Variable::Status));
    v->setDescription("Number of timeout errors");
    v->setHidden(true);
@@ -206,6 +215,10 @@ System::System ( string name, CommLink *commLink ) : Device(0,0,name,0,NULL) {
    v->setDescription("Run Total");
    v->setHidden(true);
 
+   addVariable(v = new Variable("RunTriggerStats",Variable::Status));
+   v->setDescription("Software trigger period and jitter of the last run");
+   v->setHidden(true);
+
    addVariable(v = new Variable("DebugEnable",Variable::Configuration));
    v->setDescription("Enable console debug messages.");
    v->setTrueFalse();
@@ -285,16 +298,12 @@ void *System::swRunStatic ( void *t ) {
 
 // Default software run thread. Should be overridden for custom designs
 void System::swRunThread() {
-   struct timespec tme;
-   ulong           ctime;
-   ulong           ltime;
+   RunPacer        pacer;
    uint32_t        runTotal;
 
    // --> wmq
    swRunning_ = true;
    swRunError_  = "";
-   clock_gettime(CLOCK_REALTIME,&tme);
-   ltime = (tme.tv_sec * 1000000) + (tme.tv_nsec/1000);
 
    // Get run attributes
    runTotal  = 0;
@@ -307,26 +316,25 @@ void System::swRunThread() {
    }
 
    // Run
+   pacer.start(swRunPeriod_);
    while ( swRunEnable_ && (runTotal < swRunCount_ || swRunCount_ == 0 )) {
 
       // Delay
-      do {
-         usleep(1);
-         clock_gettime(CLOCK_REALTIME,&tme);
-         ctime = (tme.tv_sec * 1000000) + (tme.tv_nsec/1000);
-      } while ( (ctime-ltime) < swRunPeriod_ );
+      pacer.wait();
 
       // Execute command
-      ltime = ctime;
       commLink_->queueRunCommand();
+      pacer.trigger();
       runTotal++;
       if ( swRunCount_ == 0 ) getVariable("RunProgress")->setInt(0);
       else getVariable("RunProgress")->setInt((uint32_t)(((double)runTotal/(double)swRunCount_)*100.0));
    }
 
+   getVariable("RunTriggerStats")->set(pacer.stats());
    if ( debug_ ) {
       cout << "System::runThread -> Name: " << name_ 
            << ", Run Stopped, RunTotal = " << dec << runTotal << endl;
+      cout << "System::runThread -> " << pacer.stats() << endl;
    }
 
    sleep(1);
@@ -533,14 +541,17 @@ void System::command ( string name, string arg ) {
 
 // Parse XML string
 bool System::parseXml ( string xml, bool force ) {
-   xmlDocPtr    doc;
-   xmlNodePtr   node;
-   xmlNodePtr   childNode;
-   const char   *childName;
-   string       err;
-   string       stat;
-   bool         configUpdate;
-   char         idString[200];
+   xmlTextReaderPtr reader;
+   DeviceVector     targets;
+   XmlOpVector      ops;
+   XmlOp            write;
+   const char       *childName;
+   string           err;
+   string           stat;
+   bool             configUpdate;
+   int32_t          ret;
+   uint32_t         x;
+   char             idString[200];
 
    if (wmqInSys) cout<<"[System:dev]: parseXml => "<<xml<<endl;
    // get unique xml id
@@ -550,42 +561,66 @@ bool System::parseXml ( string xml, bool force ) {
    
    stat = "";
    configUpdate = false;
+
+   // Create reader
+   reader = xmlReaderForMemory(xml.c_str(), strlen(xml.c_str()), idString, NULL, 0);
+   if ( reader == NULL ) {
+      err = "System::parseXml -> Failed to parse string\n";
+      if ( debug_ ) cout << err;
+      return false;
+   }
+
    try {
 
-      // Parse string
-      doc = xmlReadMemory(xml.c_str(), strlen(xml.c_str()), idString, NULL, 0);
-      if (doc == NULL) {
+      // Find the root element
+      while ( (ret = xmlTextReaderRead(reader)) == 1 && xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT );
+      if ( ret != 1 ) {
          err = "System::parseXml -> Failed to parse string\n";
          if ( debug_ ) cout << err;
-         //throw(err);
+         xmlFreeTextReader(reader);
          return false;
       }
 
-      // get the root element node
-      node = xmlDocGetRootElement(doc);
+      // Each block under the root is read into ops, a config block with
+      // values ends with a config write
+      write.type   = XmlOp::Write;
+      write.device = this;
+      if ( ! xmlTextReaderIsEmptyElement(reader) ) {
+         while ( (ret = xmlTextReaderRead(reader)) == 1 ) {
+            if ( xmlTextReaderDepth(reader) == 0 ) break;
+            if ( xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT ) continue;
 
-      // Look for child nodes
-      for ( childNode = node->children; childNode; childNode = childNode->next ) {
-         if ( childNode->type == XML_ELEMENT_NODE ) {
-            childName  = (const char *)childNode->name;
-            // Config<<
+            childName = (const char *)xmlTextReaderConstName(reader);
+
+            // Config
             if ( strcmp(childName,"config") == 0 ) {
-	      if (wmqInSys) cout<<"[system:dev] I am a config xml!"<<endl;
-               if ( setXmlConfig(childNode) ) {
-                  writeConfig(force);
-                  if ( force ) verifyConfig();
-                  configUpdate = true;
-               }
+               targets.assign(1,this);
+               if ( setXmlConfig(reader,targets,ops) ) ops.push_back(write);
             }
 
             // Command
-            else if ( strcmp(childName,"command") == 0 ) execXmlCommand(childNode);
+            else if ( strcmp(childName,"command") == 0 ) execXmlCommand(reader,ops);
+
+            // Other blocks are skipped
+            else xmlReaderValue(reader);
+         }
+         if ( ret != 1 ) throw(string("System::parseXml -> Failed to parse string\n"));
+      }
+
+      // Whole string parsed, apply in document order
+      for (x=0; x < ops.size(); x++) {
+         if ( ops[x].type == XmlOp::Set ) ops[x].device->set(ops[x].name,ops[x].value);
+         else if ( ops[x].type == XmlOp::Command ) ops[x].device->command(ops[x].name,ops[x].value);
+         else {
+            writeConfig(force);
+            if ( force ) verifyConfig();
+            configUpdate = true;
          }
       }
    } catch ( string error ) { stat = error; }
 
    // Cleanup
-   xmlFreeDoc(doc);
+   xmlFreeTextReader(reader);
 
    if ( stat != "" ) throw(stat);
    return(configUpdate);
@@ -598,16 +633,18 @@ void System::parseXmlString ( string xml ) {
    try { 
       if ( parseXml(xml,false) ) allConfigReq_ = true;
    } catch ( string error ) { 
-      errorBuffer_.append("<error>");
-      errorBuffer_.append(error); 
-      errorBuffer_.append("</error>\n");
-      errorFlag_     = true;
-      configureMsg_  = "A System Error Has Occured!\n";
-      configureMsg_.append("Please HardReset and then configure!\n");
+      addError(error);
    }
    topStatusReq_ = true;
 }
 
+// Apply config variables set through direct access
+void System::applyConfig ( ) {
+   writeConfig(false);
+   allConfigReq_ = true;
+   topStatusReq_ = true;
+}
+
 // Parse XML file
 void System::parseXmlFile ( string file ) {
    uint32_t     idx;
@@ -725,6 +762,7 @@ string System::poll(ControlCmdMemory *cmem) {
          getVariable("TimeoutCount")->setInt(commLink_->timeoutCount());
          getVariable("ErrorCount")->setInt(commLink_->errorCount());
          getVariable("UnexpectedCount")->setInt(commLink_->unexpectedCount());
+         getVariable("DataDropCount")->setInt(commLink_->dataDropCount());
 
          curr = commLink_->dataFileCount();
          if ( curr < lastFileCount_ ) rate = 0;
@@ -791,8 +829,8 @@ string System::poll(ControlCmdMemory *cmem) {
    // Config string is needed
    if ( allConfigReq_ ) cfgString = configString(false,false);
 
-   // Status string is needed
-   if ( topStatusReq_ || allStatusReq_ || pollStatusReq ) 
+   // Status string is needed, not generated for the message when using the journal
+   if ( (topStatusReq_ || allStatusReq_ || pollStatusReq) && (cmem != NULL || !statusJournal_) ) 
       statString = statusString(false,false,(!allStatusReq_),(allStatusReq_||pollStatusReq)); 
 
    // Generate outgoing message
@@ -800,7 +838,7 @@ string System::poll(ControlCmdMemory *cmem) {
    msg.str("");
    msg << "<system>" << endl;
    if ( errorBuffer_ != "" ) { msg << errorBuffer_; send = true; }
-   if ( topStatusReq_ || allStatusReq_ || pollStatusReq ) { msg << statString; send=true; }
+   if ( (topStatusReq_ || allStatusReq_ || pollStatusReq) && !statusJournal_ ) { msg << statString; send=true; }
    if ( allConfigReq_ ) { msg << cfgString; send=true; }
    msg << "</system>" << endl;
 
@@ -817,6 +855,7 @@ string System::poll(ControlCmdMemory *cmem) {
       }
       else if ( topStatusReq_ || pollStatusReq ) controlCmdSetPerStatus(cmem,statString.c_str());
       if ( allConfigReq_ ) controlCmdSetConfig(cmem,cfgString.c_str());
+      snapshotPublish(cmem);
    }
 
    // Clear send requests
@@ -832,40 +871,161 @@ string System::poll(ControlCmdMemory *cmem) {
 
 // Return status string
 string System::statusString(bool hidden, bool indent, bool compact, bool recursive) {
-   stringstream tmp;
-   tmp.str("");
-   if ( indent ) tmp << "   ";
-   tmp << "<status>" << endl;
-   tmp << getXmlStatus(true,hidden,((indent)?2:0),compact,recursive);
-   if ( indent ) tmp << "   ";
-   tmp << "</status>" << endl;
-   return(tmp.str());
+   string ret;
+
+   pthread_mutex_lock(&xmlOutMutex_);
+   try {
+      xmlOut_.clear();
+      if ( indent ) xmlOut_.append("   ");
+      xmlOut_.append("<status>\n");
+      getXmlStatus(xmlOut_,true,hidden,((indent)?2:0),compact,recursive);
+      if ( indent ) xmlOut_.append("   ");
+      xmlOut_.append("</status>\n");
+      ret = xmlOut_.str();
+   } catch ( string error ) {
+      pthread_mutex_unlock(&xmlOutMutex_);
+      throw(error);
+   }
+   pthread_mutex_unlock(&xmlOutMutex_);
+   return(ret);
 }
 
 // Return config string
 string System::configString(bool hidden, bool indent) {
-   stringstream tmp;
-   tmp.str("");
-   if ( indent ) tmp << "   ";
-   tmp << "<config>" << endl;
-   tmp << getXmlConfig(true,true,hidden,((indent)?2:0));  // Common
-   tmp << getXmlConfig(true,false,hidden,((indent)?2:0)); // Per-Instance
-   if ( indent ) tmp << "   ";
-   tmp << "</config>" << endl;
-   return(tmp.str());
+   string ret;
+
+   pthread_mutex_lock(&xmlOutMutex_);
+   try {
+      xmlOut_.clear();
+      if ( indent ) xmlOut_.append("   ");
+      xmlOut_.append("<config>\n");
+      getXmlConfig(xmlOut_,true,true,hidden,((indent)?2:0));  // Common
+      getXmlConfig(xmlOut_,true,false,hidden,((indent)?2:0)); // Per-Instance
+      if ( indent ) xmlOut_.append("   ");
+      xmlOut_.append("</config>\n");
+      ret = xmlOut_.str();
+   } catch ( string error ) {
+      pthread_mutex_unlock(&xmlOutMutex_);
+      throw(error);
+   }
+   pthread_mutex_unlock(&xmlOutMutex_);
+   return(ret);
+}
+
+// Publish changed variables to the shared memory snapshot
+void System::snapshotPublish ( ControlCmdMemory *cmem ) {
+   FlatVariableVector           vars;
+   FlatVariableVector::iterator iter;
+   uint64_t                     version;
+   uint32_t                     x;
+   bool                         include;
+   bool                         force;
+   string                       value;
+
+   // Variable list changes with the config, common values follow the enabled devices
+   force = false;
+   if ( allConfigReq_ || cmem != snapMem_ ) {
+      getFlatConfig(vars,"",true,true);
+      getFlatConfig(vars,"",true,false);
+      getFlatStatus(vars,"",true);
+
+      // New memory starts over, otherwise entries which moved to another variable are forced
+      if ( cmem != snapMem_ ) {
+         snapVars_.clear();
+         snapVersion_ = 0;
+      }
+      force = (vars.size() != snapVars_.size());
+      for (x=0; x < vars.size() && ! force; x++)
+         force = (vars[x].key != snapVars_[x].key || vars[x].variable != snapVars_[x].variable);
+      snapVars_ = vars;
+      snapMem_  = cmem;
+   }
+
+   // Nothing has changed since the last publish, changes made while
+   // publishing are picked up again next time
+   version = Variable::currentVersion();
+   if ( version == snapVersion_ && ! force ) return;
+
+   // Keys which left the variable list must not stay in the table
+   controlCmdSnapBegin(cmem);
+   if ( force ) controlCmdSnapClear(cmem);
+   for (iter=snapVars_.begin(); iter != snapVars_.end(); iter++) {
+      value = iter->variable->getSince((force)?0:snapVersion_,&include);
+      if ( force && !include ) value = iter->variable->get();
+      if ( force || include ) 
+         controlCmdSnapSet(cmem,(iter->status)?CONTROL_CMD_SNAP_STATUS:CONTROL_CMD_SNAP_CONFIG,iter->key.c_str(),value.c_str());
+   }
+   controlCmdSnapEnd(cmem);
+   snapVersion_ = version;
+}
+
+// Return errors queued for the next poll message
+string System::pendingErrors() {
+   return(errorBuffer_);
+}
+
+// Queue error for the next poll message
+void System::addError(string error) {
+   errorBuffer_.append("<error>");
+   errorBuffer_.append(error); 
+   errorBuffer_.append("</error>\n");
+   errorFlag_     = true;
+   configureMsg_  = "A System Error Has Occured!\n";
+   configureMsg_.append("Please HardReset and then configure!\n");
+}
+
+// Enable status change journal
+void System::setStatusJournal(bool enable) {
+   statusJournal_ = enable;
+}
+
+// Return status changed after journal version
+string System::statusChanges(uint64_t since, uint64_t *version) {
+   string   ret;
+   uint32_t body;
+
+   // Capture version first, changes made while walking are sent again next time
+   *version = Variable::currentVersion();
+   if ( *version == since ) return("");
+
+   pthread_mutex_lock(&xmlOutMutex_);
+   try {
+      xmlOut_.clear();
+      xmlOut_.append("<system>\n<status>\n");
+      body = xmlOut_.size();
+      getXmlStatusSince(xmlOut_,true,false,0,since);
+      if ( xmlOut_.size() != body ) {
+         xmlOut_.append("</status>\n</system>\n");
+         ret = xmlOut_.str();
+      }
+   } catch ( string error ) {
+      pthread_mutex_unlock(&xmlOutMutex_);
+      throw(error);
+   }
+   pthread_mutex_unlock(&xmlOutMutex_);
+   return(ret);
 }
 
 // Return structure string
 string System::structureString (bool hidden, bool indent) {
-   stringstream tmp;
-   tmp.str("");
-   if ( indent ) tmp << "   ";
-   tmp << "<structure>" << endl;
-   tmp << getXmlStructure(true,true,hidden,((indent)?2:0));  // General
-   tmp << getXmlStructure(true,false,hidden,((indent)?2:0)); // Per-Instance
-   if ( indent ) tmp << "   ";
-   tmp << "</structure>" << endl;
-   return(tmp.str());
+   string ret;
+
+   pthread_mutex_lock(&xmlOutMutex_);
+   try {
+      xmlOut_.clear();
+      if ( indent ) xmlOut_.append("   ");
+      xmlOut_.append("<structure>\n");
+      getXmlStructure(xmlOut_,true,true,hidden,((indent)?2:0));  // General
+      getXmlStructure(xmlOut_,true,false,hidden,((indent)?2:0)); // Per-Instance
+      if ( indent ) xmlOut_.append("   ");
+      xmlOut_.append("</structure>\n");
+      ret = xmlOut_.str();
+   } catch ( string error ) {
+      pthread_mutex_unlock(&xmlOutMutex_);
+      throw(error);
+   }
+   pthread_mutex_unlock(&xmlOutMutex_);
+   return(ret);
 }
 
 // Method to write configuration registers
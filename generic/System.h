@@ -28,6 +28,7 @@
 #include <map>
 #include <vector>
 #include <ControlCmdMem.h>
+#include <XmlWriter.h>
 #include <libxml/tree.h>
 #include <stdint.h>
 using namespace std;
@@ -67,6 +68,9 @@ class System : public Device {
       bool topStatusReq_;
       bool allConfigReq_;
 
+      // Status is pulled through the change journal, not sent by poll
+      bool statusJournal_;
+
       // Configure status
       string configureMsg_;
       bool   configureFlag_;
@@ -84,7 +88,7 @@ class System : public Device {
       // Run time tracker
       time_t lastRunTime_;
 
-      // Parse XML
+      // Parse XML, config and commands are applied while the string is read
       bool parseXml ( string input, bool force );
 
       // Add start xml to file
@@ -100,6 +104,18 @@ class System : public Device {
       uint xmlId_;
       pthread_mutex_t xmlMutex_;
 
+      // Reusable output buffer for status, config and structure strings
+      XmlWriter       xmlOut_;
+      pthread_mutex_t xmlOutMutex_;
+
+      // Variables published to the shared memory snapshot
+      FlatVariableVector snapVars_;
+      ControlCmdMemory * snapMem_;
+      uint64_t           snapVersion_;
+
+      // Publish changed variables to the shared memory snapshot
+      void snapshotPublish ( ControlCmdMemory *cmem );
+
    public:
 
       //! Constructor
@@ -137,6 +153,14 @@ class System : public Device {
       */
       void parseXmlString ( string input );
 
+      //! Apply config variables set through direct access
+      /*!
+       * Writes stale registers and schedules the config update to clients
+       * and data file, the same as an xml config message.
+       * Throws string on error
+      */
+      void applyConfig ( );
+
       //! Parse XML File
       /*!
        * \param xml XML string
@@ -158,6 +182,12 @@ class System : public Device {
       //! Poll system level status and process return messages
       string poll(ControlCmdMemory *cmem = NULL);
 
+      //! Return errors queued for the next poll message
+      string pendingErrors();
+
+      //! Queue error for the next poll message and flag the system error state
+      void addError(string error);
+
       //! Return structure string
       /*! 
        * \param hidden Set true to include hidden variables & commands
@@ -170,6 +200,22 @@ class System : public Device {
       //! Return config string
       string configString(bool hidden, bool indent);
 
+      //! Enable status change journal
+      /*! 
+       * When enabled the status block is left out of the poll message,
+       * receivers pull changed variables with statusChanges instead.
+       * \param enable Journal enable
+      */
+      void setStatusJournal(bool enable);
+
+      //! Return status variables changed after journal version
+      /*! 
+       * Returns a complete system message or an empty string if nothing changed.
+       * \param since   Journal version the receiver is up to date with
+       * \param version Updated with the journal version covered by the message
+      */
+      string statusChanges(uint64_t since, uint64_t *version);
+
       //! Method to write configuration registers
       /*! 
        * Throws string on error.
@@ -152,7 +152,7 @@ void UdpLink::rxHandler() {
                      for ( x=0; x < rxSize[rxIdx]; x++ ) rxBuff[rxIdx][x] = ntohl(rxBuff[rxIdx][x]);
                   }
                   data = new Data(rxBuff[rxIdx],rxSize[rxIdx]);
-                  dataQueue_.push(data);
+                  dataPush(data);
                   dataThreadWakeup();
                }
 
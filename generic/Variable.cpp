@@ -30,9 +30,13 @@
 #include <pthread.h>
 #include <stdexcept>
 #include <Device.h>
+#include <XmlWriter.h>
 #include <stdint.h>
 using namespace std;
 
+// Journal version counter
+uint64_t Variable::versionCounter_ = 0;
+
 // Constructor
 Variable::Variable ( string name, VariableType type ) {
    name_         = name;
@@ -53,6 +57,7 @@ Variable::Variable ( string name, VariableType type ) {
    base_         = 16;
    noConfig_     = false;
    hasBeenSet_   = true;
+   version_      = __sync_add_and_fetch(&versionCounter_,1);
 
    pthread_mutex_init(&mutex_,NULL);
 }
@@ -185,6 +190,7 @@ void Variable::set ( string value ) {
    string temp;
 
    pthread_mutex_lock(&mutex_);
+   if ( value_ != value ) version_ = __sync_add_and_fetch(&versionCounter_,1);
    value_ = value.c_str(); // Force copy
    hasBeenSet_ = true;
    pthread_mutex_unlock(&mutex_);
@@ -219,6 +225,7 @@ string Variable::get (bool compact, bool *include) {
 
       pthread_mutex_lock(&mutex_);
       if ( compact && include != NULL && value_ != temp ) *include = true;
+      if ( value_ != temp ) version_ = __sync_add_and_fetch(&versionCounter_,1);
       value_ = temp.c_str(); // Force copy
       pthread_mutex_unlock(&mutex_);
    } 
@@ -243,6 +250,31 @@ string Variable::get (bool compact, bool *include) {
    return(temp);
 }
 
+// Method to get variable value, journal mode
+string Variable::getSince ( uint64_t since, bool *include ) {
+   string temp;
+
+   // Linked variables are refreshed from the source first
+   if ( links_.size() == 1 ) get(false,NULL);
+
+   pthread_mutex_lock(&mutex_);
+   *include = (version_ > since);
+   if ( *include ) temp = value_.c_str(); // Force copy
+   pthread_mutex_unlock(&mutex_);
+
+   return(temp);
+}
+
+// Journal version of last value change
+uint64_t Variable::version ( ) {
+   return(version_);
+}
+
+// Current journal version
+uint64_t Variable::currentVersion ( ) {
+   return(__sync_add_and_fetch(&versionCounter_,0));
+}
+
 // Method to set variable register value
 void Variable::setInt ( uint32_t value ) {
    setInt(1,&value,0,0xFFFFFFFF);
@@ -328,73 +360,95 @@ float Variable::getFloat ( ) {
 
 //! Method to get variable information in xml form.
 string Variable::getXmlStructure (bool hidden, uint32_t level) {
+   XmlWriter xml;
+   getXmlStructure(xml,hidden,level);
+   return(xml.str());
+}
+
+// Method to append variable information in xml form.
+void Variable::getXmlStructure (XmlWriter &xml, bool hidden, uint32_t level) {
    EnumMap::iterator enumIter;
-   stringstream      tmp;
 
-   if ( (noConfig_ && type_ != Variable::Status) || (isHidden_ && !hidden) ) return(string(""));
+   if ( (noConfig_ && type_ != Variable::Status) || (isHidden_ && !hidden) ) return;
 
-   tmp.str("");
-   if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) tmp << " ";
-   tmp << "<variable>" << endl;
-   if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-   tmp << "<name>" << name_ << "</name>" << endl;
-   if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-   tmp << "<type>";
+   xml.indent(level);
+   xml.append("<variable>\n");
+   xml.indent(level,3);
+   xml.append("<name>");
+   xml.append(name_);
+   xml.append("</name>\n");
+   xml.indent(level,3);
+   xml.append("<type>");
    switch ( type_ ) {
-      case Configuration : tmp << "Configuration";  break;
-      case Status        : tmp << "Status";         break;
-      case Feedback      : tmp << "Feedback";       break;
-      default : tmp << "Unkown"; break;
+      case Configuration : xml.append("Configuration");  break;
+      case Status        : xml.append("Status");         break;
+      case Feedback      : xml.append("Feedback");       break;
+      default : xml.append("Unkown"); break;
    }
-   if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-   tmp << "</type>" << endl;
+   xml.indent(level,3);
+   xml.append("</type>\n");
 
    // Enums
    if ( values_.size() != 0 ) {
       for ( enumIter = values_.begin(); enumIter != values_.end(); enumIter++ ) {
-         if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-         tmp << "<enum>" << enumIter->second << "</enum>" << endl;
+         xml.indent(level,3);
+         xml.append("<enum>");
+         xml.append(enumIter->second);
+         xml.append("</enum>\n");
       }
    }
 
    // Computations
    if ( compValid_ ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<compA>" << compA_ << "</compA>" << endl;
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<compB>" << compB_ << "</compB>" << endl;
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<compC>" << compC_ << "</compC>" << endl;
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<compUnits>" << compUnits_ << "</compUnits>" << endl;
+      xml.indent(level,3);
+      xml.append("<compA>");
+      xml.append(compA_);
+      xml.append("</compA>\n");
+      xml.indent(level,3);
+      xml.append("<compB>");
+      xml.append(compB_);
+      xml.append("</compB>\n");
+      xml.indent(level,3);
+      xml.append("<compC>");
+      xml.append(compC_);
+      xml.append("</compC>\n");
+      xml.indent(level,3);
+      xml.append("<compUnits>");
+      xml.append(compUnits_);
+      xml.append("</compUnits>\n");
    }
 
    // Range
    if ( rangeMin_ != rangeMax_ ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<min>" << dec << rangeMin_ << "</min>" << endl;
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<max>" << dec << rangeMax_ << "</max>" << endl;
+      xml.indent(level,3);
+      xml.append("<min>");
+      xml.append(rangeMin_);
+      xml.append("</min>\n");
+      xml.indent(level,3);
+      xml.append("<max>");
+      xml.append(rangeMax_);
+      xml.append("</max>\n");
    }
 
    if ( desc_ != "" ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<description>" << desc_ << "</description>" << endl;
+      xml.indent(level,3);
+      xml.append("<description>");
+      xml.append(desc_);
+      xml.append("</description>\n");
    }
 
    if ( perInstance_ ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<perInstance/>" << endl;
+      xml.indent(level,3);
+      xml.append("<perInstance/>\n");
    }
 
    if ( isHidden_ ) {
-      if ( level != 0 ) for (uint32_t l=0; l < ((level*3)+3); l++) tmp << " ";
-      tmp << "<hidden/>" << endl;
+      xml.indent(level,3);
+      xml.append("<hidden/>\n");
    }
 
-   if ( level != 0 ) for (uint32_t l=0; l < (level*3); l++) tmp << " ";
-   tmp << "</variable>" << endl;
-   return(tmp.str());
+   xml.indent(level);
+   xml.append("</variable>\n");
 }
 
 // Create a variable link
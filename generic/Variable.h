@@ -33,6 +33,7 @@
 using namespace std;
 
 class Device;
+class XmlWriter;
 
 // Conversion and link function types
 typedef void (*VarConvFunc_t)(string *value, uint32_t size, uint32_t *data, uint32_t bit, uint32_t mask, bool set, void *userData);
@@ -76,6 +77,10 @@ class Variable {
       string value_;
       bool   hasBeenSet_;
 
+      // Change journal, version of last value change
+      uint64_t        version_;
+      static uint64_t versionCounter_;
+
       // Enum map
       EnumMap values_;
 
@@ -231,6 +236,24 @@ class Variable {
       */
       string get ( );
 
+      //! Journal get call for status variables
+      /*! 
+       * Returns variable value if it has changed after the passed journal
+       * version, an empty string otherwise.
+       * \param since   Journal version the caller is up to date with
+       * \param include pointer to include boolean
+      */
+      string getSince ( uint64_t since, bool *include );
+
+      //! Journal version of last value change
+      uint64_t version ( );
+
+      //! Current journal version, shared by all variables
+      /*! 
+       * Incremented every time a variable value changes.
+      */
+      static uint64_t currentVersion ( );
+
       //! Method to set variable integer value
       /*!
        * Throws string on error
@@ -287,6 +310,14 @@ class Variable {
       */
       string getXmlStructure ( bool hidden, uint32_t level );
 
+      //! Method to append variable information in xml form.
+      /*!
+       * \param xml    writer to append to
+       * \param hidden include hidden variables
+       * \param level  level for indents
+      */
+      void getXmlStructure ( XmlWriter &xml, bool hidden, uint32_t level );
+
       // Create a variable link
       void addLink ( Device *device, string variable, VarLinkFunc_t function = NULL, void *userData = NULL);
 
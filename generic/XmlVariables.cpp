@@ -18,6 +18,8 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 04/12/2011: created
+// 10/17/2026: Added deferred parsing
+// 10/17/2026: Deferred strings are queued, partial strings are kept
 //-----------------------------------------------------------------------------
 #include <XmlVariables.h>
 #include <unistd.h>
@@ -34,10 +36,14 @@
 #include <stdint.h>
 using namespace std;
 
+// Deferred bytes parsed at once when exceeded
+#define XML_DEFER_SIZE 4194304
+
 // Constructor
 XmlVariables::XmlVariables ( ) {
    xmlInitParser();
    vars_.clear();  
+   deferSize_ = 0;
 }
 
 // Deconstructor
@@ -49,6 +55,100 @@ XmlVariables::~XmlVariables ( ) {
 // Clear
 void XmlVariables::clear() {
    vars_.clear();
+   defer_.clear();
+   deferPost_.clear();
+   deferSize_ = 0;
+}
+
+// Parse deferred xml
+void XmlVariables::flush ( ) {
+   VariableHolder::iterator varMapIter;
+   vector<XmlDeferred>      defer;
+   uint32_t                 x;
+
+   if ( defer_.empty() ) return;
+   defer.swap(defer_);
+   deferSize_ = 0;
+
+   for (x=0; x < defer.size(); x++) {
+      for ( varMapIter = defer[x].pre.begin(); varMapIter != defer[x].pre.end(); varMapIter++ )
+         vars_[varMapIter->first] = varMapIter->second;
+      parse(defer[x].type,defer[x].xml.c_str());
+   }
+   for ( varMapIter = deferPost_.begin(); varMapIter != deferPost_.end(); varMapIter++ )
+      vars_[varMapIter->first] = varMapIter->second;
+   deferPost_.clear();
+}
+
+// Strings with the same elements and attributes, values may differ but not
+// whether they are blank, blank values are not stored by xmlLevel
+bool XmlVariables::sameLayout ( const string &a, const string &b ) {
+   const char *pa;
+   const char *pb;
+   const char *endA;
+   const char *endB;
+   bool        blankA;
+   bool        blankB;
+
+   pa   = a.c_str();
+   pb   = b.c_str();
+   endA = pa + a.size();
+   endB = pb + b.size();
+   while ( pa < endA && pb < endB ) {
+
+      // Markup must match
+      if ( *pa == '<' || *pb == '<' ) {
+         while ( pa < endA && pb < endB && *pa == *pb && *pa != '>' ) { pa++; pb++; }
+         if ( pa == endA || pb == endB || *pa != *pb ) return(false);
+         pa++;
+         pb++;
+      }
+
+      // Values
+      else {
+         blankA = true;
+         blankB = true;
+         for ( ; pa < endA && *pa != '<'; pa++ ) if ( *pa != ' ' && *pa != '\n' ) blankA = false;
+         for ( ; pb < endB && *pb != '<'; pb++ ) if ( *pb != ' ' && *pb != '\n' ) blankB = false;
+         if ( blankA != blankB ) return(false);
+      }
+   }
+   return(pa == endA && pb == endB);
+}
+
+// Store xml for parsing on next access
+void XmlVariables::parseLater ( string type, const char *str ) {
+   VariableHolder::iterator varMapIter;
+   XmlDeferred              defer;
+   uint32_t                 x;
+
+   if ( *str == 0 ) return;
+
+   defer.type = type;
+   defer.xml  = str;
+   defer.pre.swap(deferPost_);
+
+   // A pending string with the same layout is fully overwritten by this one.
+   // Variables set before it now come before the string following it.
+   for (x=0; x < defer_.size(); x++) {
+      if ( defer_[x].type == type && sameLayout(defer_[x].xml,defer.xml) ) {
+         VariableHolder &next = (x+1 < defer_.size())?defer_[x+1].pre:defer.pre;
+         for ( varMapIter = defer_[x].pre.begin(); varMapIter != defer_[x].pre.end(); varMapIter++ )
+            next.insert(*varMapIter);
+         deferSize_ -= defer_[x].xml.size();
+         defer_.erase(defer_.begin()+x);
+         break;
+      }
+   }
+
+   deferSize_ += defer.xml.size();
+   defer_.resize(defer_.size()+1);
+   defer_.back().type = type;
+   defer_.back().xml.swap(defer.xml);
+   defer_.back().pre.swap(defer.pre);
+
+   // Bound the memory held by partial strings
+   if ( deferSize_ > XML_DEFER_SIZE ) flush();
 }
 
 // Remove whitespace and newlines
@@ -71,6 +171,9 @@ bool XmlVariables::parse ( string type, const char *str ) {
    xmlNodePtr   node;
    string       name;
 
+   // Deferred xml comes first
+   flush();
+
    // Parse string
    doc = xmlReadMemory(str, strlen(str), "string.xml", NULL, 0);
    if (doc == NULL) return (false);
@@ -150,10 +253,18 @@ void XmlVariables::xmlLevel( xmlNode *node, string curr ) {
    }
 }
 
+// Set
+void XmlVariables::set ( string var, string value ) {
+   if ( defer_.empty() ) vars_[var] = value;
+   else deferPost_[var] = value;
+}
+
 // Get
 string XmlVariables::get ( string var ) {
    VariableHolder::iterator varMapIter;
 
+   flush();
+
    // Look for variable
    varMapIter = vars_.find(var);
 
@@ -170,6 +281,8 @@ uint32_t XmlVariables::getInt ( string var ) {
    const char               *sptr;
    char                     *eptr;
 
+   flush();
+
    // Look for variable
    varMapIter = vars_.find(var);
 
@@ -191,6 +304,8 @@ double XmlVariables::getDouble ( string var ) {
    const char               *sptr;
    char                     *eptr;
 
+   flush();
+
    // Look for variable
    varMapIter = vars_.find(var);
 
@@ -211,6 +326,7 @@ string XmlVariables::getList ( string prefix ) {
 
    VariableHolder::iterator varMapIter;
 
+   flush();
    for ( varMapIter = vars_.begin(); varMapIter != vars_.end(); varMapIter++ ) {
       ret << prefix << varMapIter->first << " = " << varMapIter->second << endl;
    }
@@ -326,6 +442,7 @@ string XmlVariables::getXml ( ) {
 
    VariableHolder::iterator varMapIter;
 
+   flush();
    for ( varMapIter = vars_.begin(); varMapIter != vars_.end(); varMapIter++ ) {
       nextName  = varMapIter->first;
       nextValue = varMapIter->second;
@@ -350,6 +467,7 @@ string XmlVariables::getXml ( string variable ) {
    string          currValue;
 
    ret.str("");
+   flush();
 
    // Look for variable
    varMapIter = vars_.find(variable);
@@ -23,11 +23,14 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 04/12/2011: created
+// 10/17/2026: Added deferred parsing
+// 10/17/2026: Deferred strings are queued, partial strings are kept
 //-----------------------------------------------------------------------------
 #ifndef __XML_VARIABLES_H__
 #define __XML_VARIABLES_H__
 
 #include <string>
+#include <vector>
 #include <map>
 #include <libxml/tree.h>
 #include <stdint.h>
@@ -40,6 +43,13 @@ using namespace std;
 // Define variable holder
 typedef map<string,string> VariableHolder;
 
+// Deferred xml string with the variables set before it
+typedef struct {
+   VariableHolder pre;
+   string         type;
+   string         xml;
+} XmlDeferred;
+
 //! Class to contain generic register data.
 class XmlVariables {
 
@@ -52,6 +62,18 @@ class XmlVariables {
       // Variable list
       VariableHolder vars_;
 
+      // Deferred xml strings in order, the variables set after the last
+      // one and the bytes held
+      vector<XmlDeferred> defer_;
+      VariableHolder      deferPost_;
+      uint32_t            deferSize_;
+
+      // Parse deferred xml
+      void flush ( );
+
+      // Strings with the same elements and attributes, values may differ
+      static bool sameLayout ( const string &a, const string &b );
+
    public:
 
       // Generate XML for a given level knowing the previous and next values
@@ -73,6 +95,16 @@ class XmlVariables {
       */
       bool parse ( string type, const char *xml );
 
+      //! Store XML string, parsed on the next access of the variables
+      /*! 
+       * Strings are parsed in order. A string not yet parsed is dropped
+       * when a later one has the same elements, partial strings are kept.
+       * Variables set in between keep their order relative to the strings.
+       * \param type Type of variable to parse, config or status
+       * \param xml XML String
+      */
+      void parseLater ( string type, const char *xml );
+
       //! Parse XML file
       /*! 
        * \param type Type of variable to parse, config or status
@@ -80,6 +112,13 @@ class XmlVariables {
       */
       bool parseFile ( string type, string file );
 
+      //! Set a variable value
+      /*! 
+       * \param var Variable name
+       * \param value Variable value
+      */
+      void set ( string var, string value );
+
       //! Get a variable value
       /*! 
        * \param var Variable name
@@ -0,0 +1,148 @@
+//-----------------------------------------------------------------------------
+// File          : XmlWriter.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Streaming XML text writer. All output is appended to a single buffer
+// which is retained between uses so that repeated status, config and
+// structure generation does not allocate once the buffer has grown to
+// its working size. Indentation is taken from a precomputed run of spaces.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include <XmlWriter.h>
+#include <stdio.h>
+#include <string.h>
+using namespace std;
+
+// Precomputed indentation
+const char XmlWriter::Spaces_[XmlWriter::IndentMax+1] =
+   "                                                "
+   "                                                ";
+
+// Constructor
+XmlWriter::XmlWriter ( uint32_t reserve ) {
+   if ( reserve != 0 ) buffer_.reserve(reserve);
+}
+
+// Empty buffer, capacity is retained
+void XmlWriter::clear ( ) {
+   buffer_.clear();
+}
+
+// Current buffer length
+uint32_t XmlWriter::size ( ) {
+   return(buffer_.size());
+}
+
+// Truncate buffer to passed length
+void XmlWriter::truncate ( uint32_t size ) {
+   if ( size < buffer_.size() ) buffer_.resize(size);
+}
+
+// Buffer contents
+const string & XmlWriter::str ( ) {
+   return(buffer_);
+}
+
+// Add indentation for level
+void XmlWriter::indent ( uint32_t level, uint32_t extra ) {
+   uint32_t count;
+
+   if ( level == 0 ) return;
+   count = (level * IndentStep) + extra;
+
+   while ( count > IndentMax ) {
+      buffer_.append(Spaces_,IndentMax);
+      count -= IndentMax;
+   }
+   buffer_.append(Spaces_,count);
+}
+
+// Add raw text
+void XmlWriter::append ( const string &text ) {
+   buffer_.append(text);
+}
+
+// Add raw text
+void XmlWriter::append ( const char *text ) {
+   buffer_.append(text);
+}
+
+// Add unsigned decimal value
+void XmlWriter::append ( uint32_t value ) {
+   char buff[16];
+   uint32_t len;
+
+   len = snprintf(buff,sizeof(buff),"%u",value);
+   buffer_.append(buff,len);
+}
+
+// Add double value, %g matches the default ostream formatting
+void XmlWriter::append ( double value ) {
+   char buff[32];
+   uint32_t len;
+
+   len = snprintf(buff,sizeof(buff),"%g",value);
+   buffer_.append(buff,len);
+}
+
+// Add end of line
+void XmlWriter::endl ( ) {
+   buffer_.push_back('\n');
+}
+
+// Add "<name>" with indentation
+void XmlWriter::open ( uint32_t level, const string &name ) {
+   indent(level);
+   buffer_.push_back('<');
+   buffer_.append(name);
+   buffer_.push_back('>');
+}
+
+// Add "</name>" with indentation
+void XmlWriter::close ( uint32_t level, const string &name ) {
+   indent(level);
+   buffer_.append("</",2);
+   buffer_.append(name);
+   buffer_.append(">\n",2);
+}
+
+// Add "<name>value</name>" with indentation
+void XmlWriter::element ( uint32_t level, const string &name, const string &value ) {
+   indent(level);
+   buffer_.push_back('<');
+   buffer_.append(name);
+   buffer_.push_back('>');
+   buffer_.append(value);
+   buffer_.append("</",2);
+   buffer_.append(name);
+   buffer_.append(">\n",2);
+}
+
+// Add "<name>value</name>" with indentation
+void XmlWriter::element ( uint32_t level, const char *name, const string &value ) {
+   uint32_t len = strlen(name);
+
+   indent(level);
+   buffer_.push_back('<');
+   buffer_.append(name,len);
+   buffer_.push_back('>');
+   buffer_.append(value);
+   buffer_.append("</",2);
+   buffer_.append(name,len);
+   buffer_.append(">\n",2);
+}
+
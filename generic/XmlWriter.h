@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// File          : XmlWriter.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : General Purpose
+//-----------------------------------------------------------------------------
+// Description :
+// Streaming XML text writer. All output is appended to a single buffer
+// which is retained between uses so that repeated status, config and
+// structure generation does not allocate once the buffer has grown to
+// its working size. Indentation is taken from a precomputed run of spaces.
+//-----------------------------------------------------------------------------
+// This file is part of 'SLAC Generic DAQ Software'.
+// It is subject to the license terms in the LICENSE.txt file found in the
+// top-level directory of this distribution and at:
+//    https://confluence.slac.stanford.edu/display/ppareg/LICENSE.html.
+// No part of 'SLAC Generic DAQ Software', including this file,
+// may be copied, modified, propagated, or distributed except according to
+// the terms contained in the LICENSE.txt file.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __XML_WRITER_H__
+#define __XML_WRITER_H__
+
+#include <string>
+#include <stdint.h>
+using namespace std;
+
+//! Class to stream xml text into a reusable buffer
+class XmlWriter {
+
+      // Output buffer
+      string buffer_;
+
+      // Indentation source, spaces per level
+      static const uint32_t IndentStep = 3;
+      static const uint32_t IndentMax  = 96;
+      static const char     Spaces_[IndentMax+1];
+
+   public:
+
+      //! Constructor
+      /*!
+       * \param reserve Initial buffer capacity in bytes
+      */
+      XmlWriter ( uint32_t reserve = 0 );
+
+      //! Empty buffer, capacity is retained
+      void clear ( );
+
+      //! Current buffer length
+      uint32_t size ( );
+
+      //! Truncate buffer to passed length, used to discard an empty block
+      void truncate ( uint32_t size );
+
+      //! Buffer contents
+      const string & str ( );
+
+      //! Add indentation for level, nothing is added for level 0
+      /*!
+       * \param level Indentation level
+       * \param extra Additional spaces
+      */
+      void indent ( uint32_t level, uint32_t extra = 0 );
+
+      //! Add raw text
+      void append ( const string &text );
+
+      //! Add raw text
+      void append ( const char *text );
+
+      //! Add unsigned decimal value
+      void append ( uint32_t value );
+
+      //! Add double value, formatted as an ostream with default precision
+      void append ( double value );
+
+      //! Add end of line
+      void endl ( );
+
+      //! Add "<name>" with indentation
+      void open ( uint32_t level, const string &name );
+
+      //! Add "</name>" with indentation, followed by end of line
+      void close ( uint32_t level, const string &name );
+
+      //! Add "<name>value</name>" with indentation, followed by end of line
+      void element ( uint32_t level, const string &name, const string &value );
+
+      //! Add "<name>value</name>" with indentation, followed by end of line
+      void element ( uint32_t level, const char *name, const string &value );
+
+};
+#endif
+
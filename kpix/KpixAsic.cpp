@@ -21,6 +21,7 @@
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <string.h>
 using namespace std;
 
 // Function to convert dac value into a voltage
@@ -50,6 +51,23 @@ string KpixAsic::timeString(uint period, uint value) {
    return(tmp.str());
 }
 
+// Function to convert calibration dac value into a charge string
+string KpixAsic::dacToChargeString(uint dac) {
+   stringstream tmp;
+   tmp.str("");
+   if ( getVariable("CntrlPolarity")->get() == "Positive" ) {
+      tmp << ((2.5 - dacToVolt(dac)) * 200e-15);
+      tmp << " / ";
+      tmp << (((2.5 - dacToVolt(dac)) * 200e-15) * 22.0);
+   }
+   else {
+      tmp << (dacToVolt(dac) * 200e-15);
+      tmp << " / ";
+      tmp << ((dacToVolt(dac) * 200e-15) * 22.0);
+   }
+   return(tmp.str());
+}
+
 // Channel count
 uint KpixAsic::channels() {
    if ( dummy_ ) return(0);
@@ -446,14 +464,18 @@ KpixAsic::KpixAsic ( uint destination, uint baseAddress, uint index, bool dummy,
                                             "C = Channel trigger threshold A, with calibration enabled");
       getVariable(tmp.str())->set("DDDDDDDD DDDDDDDD DDDDDDDD DDDDDDDD");
       getVariable(tmp.str())->setPerInstance(true);
+      chanMode_[x] = getVariable(tmp.str());
 
       tmp.str("");
       tmp << "ChanModeA_0x" << setw(2) << setfill('0') << hex << x;
       addRegister(new Register(tmp.str(), baseAddress_ + 0x00000040 + x));
+      chanModeA_[x] = getRegister(tmp.str());
       tmp.str("");
       tmp << "ChanModeB_0x" << setw(2) << setfill('0') << hex << x;
       addRegister(new Register(tmp.str(), baseAddress_ + 0x00000060 + x));
+      chanModeB_[x] = getRegister(tmp.str());
    }
+   calDacReg_ = getRegister("Dac4");
 
    if ( ! dummy ) getVariable("Enabled")->set("False");
 }
@@ -598,18 +620,7 @@ void KpixAsic::readConfig ( ) {
       getVariable("DacCalibration")->setInt(val);
       getVariable("DacCalibrationVolt")->set(dacToVoltString(val));
 
-      tmp.str("");
-      if ( getVariable("CntrlPolarity")->get() == "Positive" ) {
-         tmp << ((2.5 - dacToVolt(val)) * 200e-15);
-         tmp << " / ";
-         tmp << (((2.5 - dacToVolt(val)) * 200e-15) * 22.0);
-      }
-      else {
-         tmp << (dacToVolt(val) * 200e-15);
-         tmp << " / ";
-         tmp << ((dacToVolt(val) * 200e-15) * 22.0);
-      }
-      getVariable("DacCalibrationCharge")->set(tmp.str());
+      getVariable("DacCalibrationCharge")->set(dacToChargeString(val));
       
       readRegister(getRegister("Dac5"));
       val = getRegister("Dac5")->get(0,0xFF);
@@ -847,18 +858,7 @@ void KpixAsic::writeConfig ( bool force ) {
       getRegister("Dac4")->set(val,16,0xFF);
       getRegister("Dac4")->set(val,24,0xFF);
 
-      tmp.str("");
-      if ( getVariable("CntrlPolarity")->get() == "Positive" ) {
-         tmp << ((2.5 - dacToVolt(val)) * 200e-15);
-         tmp << " / ";
-         tmp << (((2.5 - dacToVolt(val)) * 200e-15) * 22.0);
-      }
-      else {
-         tmp << (dacToVolt(val) * 200e-15);
-         tmp << " / ";
-         tmp << ((dacToVolt(val) * 200e-15) * 22.0);
-      }
-      getVariable("DacCalibrationCharge")->set(tmp.str());
+      getVariable("DacCalibrationCharge")->set(dacToChargeString(val));
       
       val = getVariable("DacEventThreshold")->getInt();
       getVariable("DacEventThresholdVoltage")->set(dacToVoltString(val));
@@ -1095,3 +1095,82 @@ void KpixAsic::verifyConfig ( ) {
    REGISTER_UNLOCK
 }
 
+// Set calibration dac
+void KpixAsic::setCalibDac ( uint dac ) {
+   uint oldControl;
+   bool power;
+
+   if ( dummy_ ) return;
+
+   REGISTER_LOCK
+
+   getVariable("DacCalibration")->setInt(dac);
+   dac = getVariable("DacCalibration")->getInt();
+   getVariable("DacCalibrationVolt")->set(dacToVoltString(dac));
+   getVariable("DacCalibrationCharge")->set(dacToChargeString(dac));
+
+   calDacReg_->set(dac,0,0xFF);
+   calDacReg_->set(dac,8,0xFF);
+   calDacReg_->set(dac,16,0xFF);
+   calDacReg_->set(dac,24,0xFF);
+
+   if ( calDacReg_->stale() ) {
+
+      // Turn front end power on in kpix 9 before writing dacs, as in writeConfig
+      power = (getVariable("Version")->getInt() == 9 && getVariable("Enabled")->getInt() == 1);
+      if ( power ) {
+         oldControl = getRegister("Control")->get();
+         getRegister("Control")->set(1,24,0x1); // Disable power cycle
+         writeRegister(getRegister("Control"),true);
+      }
+
+      writeRegister(calDacReg_,false);
+
+      // Restore power state
+      if ( power ) {
+         getRegister("Control")->set(oldControl);
+         writeRegister(getRegister("Control"),true);
+      }
+   }
+
+   REGISTER_UNLOCK
+}
+
+// Set calibration injection mask
+void KpixAsic::setCalibMask ( const uint *mask ) {
+   uint   col;
+   uint   row;
+   string mode;
+
+   if ( dummy_ ) return;
+
+   REGISTER_LOCK
+
+   for (col=0; col < (channels()/32); col++) {
+
+      // Calibration mode is A=1,B=1, trigger disabled is A=1,B=0
+      chanModeB_[col]->set(mask[col]);
+      chanModeA_[col]->set(0xFFFFFFFF);
+      if ( ! chanModeB_[col]->stale() && ! chanModeA_[col]->stale() ) continue;
+
+      // Variable in the form written by writeConfig
+      mode = "DDDDDDDD DDDDDDDD DDDDDDDD DDDDDDDD";
+      for (row=0; row < 32; row++) if ( (mask[col] >> row) & 0x1 ) mode[row+(row/8)] = 'C';
+      chanMode_[col]->set(mode);
+
+      writeRegister(chanModeB_[col],false);
+      writeRegister(chanModeA_[col],false);
+   }
+
+   REGISTER_UNLOCK
+}
+
+// Set single calibration channel
+void KpixAsic::setCalibChannel ( uint channel ) {
+   uint mask[32];
+
+   memset(mask,0,sizeof(mask));
+   if ( channel < channels() ) mask[channel/32] = (1 << (channel%32));
+   setCalibMask(mask);
+}
+
@@ -31,6 +31,12 @@ class KpixAsic : public Device {
       // Time value to use for timing calculations
       static const uint KpixAcqPeriod = 50;
 
+      // Calibration dac and channel mode registers, cached for calibration steps
+      Register *calDacReg_;
+      Register *chanModeA_[32];
+      Register *chanModeB_[32];
+      Variable *chanMode_[32];
+
       // Function to convert dac value into a voltage
       static double dacToVolt(uint dac);
 
@@ -40,6 +46,9 @@ class KpixAsic : public Device {
       // Function to time value to string
       static string timeString(uint period, uint value);
 
+      // Function to convert calibration dac value into a charge string
+      string dacToChargeString(uint dac);
+
    public:
 
       //! Constructor
@@ -80,5 +89,30 @@ class KpixAsic : public Device {
       //! Channel count
       uint channels();
 
+      //! Set calibration dac
+      /*! 
+       * Only the calibration dac register is written.
+       * Throws string on error.
+       * \param dac Calibration dac value
+      */
+      void setCalibDac ( uint dac );
+
+      //! Set calibration injection mask
+      /*! 
+       * Channels set in the mask are put in calibration mode, all others
+       * have their trigger disabled. Only the channel mode registers of
+       * columns which change are written.
+       * Throws string on error.
+       * \param mask One word per column of 32 channels, channels()/32 words
+      */
+      void setCalibMask ( const uint *mask );
+
+      //! Set single calibration channel
+      /*! 
+       * Throws string on error.
+       * \param channel Channel to inject, channels() or above injects none
+      */
+      void setCalibChannel ( uint channel );
+
 };
 #endif
@@ -0,0 +1,632 @@
+//-----------------------------------------------------------------------------
+// File          : KpixCalibFit.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : KPIX Control Software
+//-----------------------------------------------------------------------------
+// Description :
+// Calibration fitter. Samples of a calibration run are accumulated per KPiX,
+// channel, bucket and range: running moments and a histogram of the baseline
+// and running moments of the injected samples at each calibration DAC value.
+// No samples are stored. The baseline gets a gaussian fit and the injection
+// curve a linear fit, in parallel across channels. The results are written
+// in the xml format read by KpixCalibRead.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "KpixCalibFit.h"
+#include "KpixSampleBatch.h"
+#include "KpixSample.h"
+using namespace std;
+
+// Entries per KPiX, 1024 channels x 4 buckets x 2 ranges
+#define CALIB_FIT_ASIC 8192
+
+// Baseline histogram bins, centered on the first value
+#define CALIB_FIT_BINS 256
+
+// Entries taken by a fit thread at a time
+#define CALIB_FIT_BLOCK 256
+
+// Gaussian fit iterations
+#define CALIB_FIT_ITER 100
+
+// Entry index
+static inline uint fitIndex ( uint address, uint channel, uint bucket, uint range ) {
+   return((address << 13) | ((channel & 0x3FF) << 3) | ((bucket & 0x3) << 1) | (range & 0x1));
+}
+
+// Invert a symmetric 3x3 matrix, false if singular
+static bool invert3 ( double a[3][3], double inv[3][3] ) {
+   double det;
+   uint   x;
+   uint   y;
+
+   inv[0][0] = a[1][1]*a[2][2] - a[1][2]*a[2][1];
+   inv[0][1] = a[0][2]*a[2][1] - a[0][1]*a[2][2];
+   inv[0][2] = a[0][1]*a[1][2] - a[0][2]*a[1][1];
+   inv[1][0] = a[1][2]*a[2][0] - a[1][0]*a[2][2];
+   inv[1][1] = a[0][0]*a[2][2] - a[0][2]*a[2][0];
+   inv[1][2] = a[0][2]*a[1][0] - a[0][0]*a[1][2];
+   inv[2][0] = a[1][0]*a[2][1] - a[1][1]*a[2][0];
+   inv[2][1] = a[0][1]*a[2][0] - a[0][0]*a[2][1];
+   inv[2][2] = a[0][0]*a[1][1] - a[0][1]*a[1][0];
+
+   det = a[0][0]*inv[0][0] + a[0][1]*inv[1][0] + a[0][2]*inv[2][0];
+   if ( det == 0 || ! isfinite(det) ) return(false);
+
+   for (x=0; x < 3; x++)
+      for (y=0; y < 3; y++) inv[x][y] /= det;
+   return(true);
+}
+
+// Add a value to running moments
+static inline void addMoment ( double &count, double &mean, double &m2, double value ) {
+   double delta;
+
+   count += 1;
+   delta  = value - mean;
+   mean  += delta / count;
+   m2    += delta * (value - mean);
+}
+
+// Merge running moments
+static inline void mergeMoment ( double &count, double &mean, double &m2, double oCount, double oMean, double oM2 ) {
+   double delta;
+   double total;
+
+   if ( oCount == 0 ) return;
+   total  = count + oCount;
+   delta  = oMean - mean;
+   mean  += delta * oCount / total;
+   m2    += oM2 + delta * delta * count * oCount / total;
+   count  = total;
+}
+
+// Entry constructor
+KpixCalibFit::KpixCalibEntry::KpixCalibEntry ( ) {
+   count             = 0;
+   mean              = 0;
+   m2                = 0;
+   histMin           = 0;
+   last              = 0;
+   baseValid         = false;
+   baseRms           = 0;
+   baseFitMean       = 0;
+   baseFitSigma      = 0;
+   baseFitMeanErr    = 0;
+   baseFitSigmaErr   = 0;
+   baseFitChisquare  = 0;
+   calibValid        = false;
+   calibGain         = 0;
+   calibIntercept    = 0;
+   calibGainErr      = 0;
+   calibInterceptErr = 0;
+   calibChisquare    = 0;
+}
+
+// Constructor
+KpixCalibFit::KpixCalibFit ( ) {
+   entries_.assign(MaxAsics * CALIB_FIT_ASIC,(KpixCalibEntry *)NULL);
+   asics_.resize(MaxAsics);
+   clear();
+   nextFit_ = 0;
+   pthread_mutex_init(&mutex_,NULL);
+}
+
+// Deconstructor
+KpixCalibFit::~KpixCalibFit ( ) {
+   clear();
+   pthread_mutex_destroy(&mutex_);
+}
+
+// Remove all accumulators and results
+void KpixCalibFit::clear ( ) {
+   uint x;
+
+   for (x=0; x < entries_.size(); x++) {
+      if ( entries_[x] != NULL ) delete entries_[x];
+      entries_[x] = NULL;
+   }
+   for (x=0; x < asics_.size(); x++) {
+      asics_[x].serial    = "";
+      asics_[x].positive  = false;
+      asics_[x].calibHigh = false;
+   }
+   window_.clear();
+}
+
+// Return entry, optional creation
+KpixCalibFit::KpixCalibEntry *KpixCalibFit::entry ( uint address, uint channel, uint bucket, uint range, bool create ) {
+   uint idx;
+
+   if ( address >= MaxAsics ) return(NULL);
+   idx = fitIndex(address,channel,bucket,range);
+   if ( entries_[idx] == NULL && create ) entries_[idx] = new KpixCalibEntry;
+   return(entries_[idx]);
+}
+
+// Set KPiX settings
+void KpixCalibFit::setAsic ( uint address, string serial, bool positive, bool calibHigh ) {
+   if ( address >= MaxAsics ) return;
+   asics_[address].serial    = serial;
+   asics_[address].positive  = positive;
+   asics_[address].calibHigh = calibHigh;
+}
+
+// Serial number of a KPiX address
+string KpixCalibFit::serial ( uint address ) {
+   if ( address >= MaxAsics ) return("");
+   return(asics_[address].serial);
+}
+
+// Only accept samples in the injection time window of their bucket
+void KpixCalibFit::setWindow ( uint *times ) {
+   if ( times == NULL ) window_.clear();
+   else window_.assign(times,times+5);
+}
+
+// Charge in fC injected at a calibration DAC value
+double KpixCalibFit::charge ( uint dac, uint bucket, bool positive, bool calibHigh ) {
+   double volt;
+   double charge;
+
+   // Voltage as in KpixAsic::dacToVolt
+   if ( dac >= 0xf6 ) volt = 2.5 - ((double)(0xff-dac))*50.0*0.0001;
+   else volt = (double)dac * 100.0 * 0.0001;
+
+   if ( positive ) charge = (2.5 - volt) * 200;
+   else charge = volt * 200;
+
+   if ( calibHigh && bucket == 0 ) charge *= 22.0;
+   return(charge);
+}
+
+// Add samples of an event
+void KpixCalibFit::fill ( KpixSampleBatch *batch, uint state, uint channel, uint stride, uint last, uint dac ) {
+   const uint16_t *address;
+   const uint16_t *chan;
+   const uint16_t *time;
+   const uint16_t *value;
+   const uint8_t  *bucket;
+   const uint8_t  *range;
+   const uint8_t  *flags;
+   const uint8_t  *type;
+   uint            x;
+
+   if ( state != Baseline && state != Inject ) return;
+
+   // One channel per step
+   if ( stride <= 1 ) {
+      stride = 1;
+      last   = channel;
+   }
+
+   address = batch->address();
+   chan    = batch->channel();
+   time    = batch->time();
+   value   = batch->value();
+   bucket  = batch->bucket();
+   range   = batch->range();
+   flags   = batch->flags();
+   type    = batch->type();
+
+   for (x=0; x < batch->count(); x++) {
+      if ( type[x] != KpixSample::Data || address[x] >= MaxAsics ) continue;
+      if ( flags[x] & (KpixSampleBatch::Empty | KpixSampleBatch::BadCount) ) continue;
+      if ( ! window_.empty() && (time[x] < window_[bucket[x]] || time[x] >= window_[bucket[x]+1]) ) continue;
+
+      if ( state == Baseline ) baseline(address[x],chan[x],bucket[x],range[x],value[x]);
+      else if ( chan[x] >= channel && chan[x] <= last && ((chan[x] - channel) % stride) == 0 )
+         inject(address[x],chan[x],bucket[x],range[x],dac,value[x]);
+   }
+}
+
+// Add a baseline sample
+void KpixCalibFit::baseline ( uint address, uint channel, uint bucket, uint range, uint value ) {
+   KpixCalibEntry *ent;
+   int             bin;
+
+   if ( (ent = entry(address,channel,bucket,range,true)) == NULL ) return;
+
+   if ( ent->hist.empty() ) {
+      ent->histMin = (int)value - CALIB_FIT_BINS/2;
+      ent->hist.assign(CALIB_FIT_BINS,0);
+   }
+   addMoment(ent->count,ent->mean,ent->m2,value);
+
+   bin = (int)value - ent->histMin;
+   if ( bin >= 0 && bin < CALIB_FIT_BINS ) ent->hist[bin]++;
+}
+
+// Add an injection sample
+void KpixCalibFit::inject ( uint address, uint channel, uint bucket, uint range, uint dac, uint value ) {
+   KpixCalibEntry *ent;
+   KpixCalibPoint  point;
+   uint            x;
+
+   if ( (ent = entry(address,channel,bucket,range,true)) == NULL ) return;
+
+   // DAC values are stepped in order, the last point is usually the one
+   if ( ent->last >= ent->points.size() || ent->points[ent->last].dac != dac ) {
+      for (x=0; x < ent->points.size() && ent->points[x].dac != dac; x++);
+      if ( x == ent->points.size() ) {
+         point.dac   = dac;
+         point.count = 0;
+         point.mean  = 0;
+         point.m2    = 0;
+         ent->points.push_back(point);
+      }
+      ent->last = x;
+   }
+   addMoment(ent->points[ent->last].count,ent->points[ent->last].mean,ent->points[ent->last].m2,value);
+}
+
+// Merge accumulators of another fitter into this one
+void KpixCalibFit::merge ( KpixCalibFit *other ) {
+   KpixCalibEntry *src;
+   KpixCalibEntry *dst;
+   uint            x;
+   uint            y;
+   uint            z;
+   int             bin;
+
+   for (x=0; x < MaxAsics; x++)
+      if ( asics_[x].serial == "" ) asics_[x] = other->asics_[x];
+
+   for (x=0; x < entries_.size(); x++) {
+      if ( (src = other->entries_[x]) == NULL ) continue;
+      if ( (dst = entries_[x]) == NULL ) dst = entries_[x] = new KpixCalibEntry;
+
+      // Baseline, bins outside of this histogram only count in the moments
+      if ( ! src->hist.empty() ) {
+         if ( dst->hist.empty() ) {
+            dst->histMin = src->histMin;
+            dst->hist.assign(CALIB_FIT_BINS,0);
+         }
+         for (y=0; y < CALIB_FIT_BINS; y++) {
+            bin = (int)y + src->histMin - dst->histMin;
+            if ( bin >= 0 && bin < CALIB_FIT_BINS ) dst->hist[bin] += src->hist[y];
+         }
+      }
+      mergeMoment(dst->count,dst->mean,dst->m2,src->count,src->mean,src->m2);
+
+      // Injection points
+      for (y=0; y < src->points.size(); y++) {
+         for (z=0; z < dst->points.size() && dst->points[z].dac != src->points[y].dac; z++);
+         if ( z == dst->points.size() ) dst->points.push_back(src->points[y]);
+         else mergeMoment(dst->points[z].count,dst->points[z].mean,dst->points[z].m2,
+                          src->points[y].count,src->points[y].mean,src->points[y].m2);
+      }
+   }
+}
+
+// Number of entries with samples
+uint KpixCalibFit::entries ( ) {
+   uint x;
+   uint ret;
+
+   ret = 0;
+   for (x=0; x < entries_.size(); x++) if ( entries_[x] != NULL ) ret++;
+   return(ret);
+}
+
+// Chi-square of a gaussian against a histogram with its curvature matrix and
+// gradient, the bin count is the variance of each bin
+static double gaussChi2 ( int histMin, vector<uint> &hist, double *p, double alpha[3][3], double beta[3] ) {
+   double chi2;
+   double d[3];
+   double e;
+   double f;
+   double w;
+   double z;
+   uint   x;
+   uint   y;
+   uint   k;
+
+   memset(alpha,0,sizeof(double)*9);
+   memset(beta,0,sizeof(double)*3);
+   chi2 = 0;
+
+   for (x=0; x < hist.size(); x++) {
+      if ( hist[x] == 0 ) continue;
+      z    = (histMin + (int)x - p[1]) / p[2];
+      e    = exp(-0.5 * z * z);
+      f    = p[0] * e;
+      w    = 1.0 / hist[x];
+      d[0] = e;
+      d[1] = f * z / p[2];
+      d[2] = f * z * z / p[2];
+      for (y=0; y < 3; y++) {
+         beta[y] += w * (hist[x] - f) * d[y];
+         for (k=0; k < 3; k++) alpha[y][k] += w * d[y] * d[k];
+      }
+      chi2 += w * (hist[x] - f) * (hist[x] - f);
+   }
+   return(chi2);
+}
+
+// Gaussian fit of the baseline histogram. The chi-square is minimized with
+// Levenberg-Marquardt steps starting from the moments. The chi-square per
+// degree of freedom is kept.
+void KpixCalibFit::fitBaseline ( KpixCalibEntry *ent ) {
+   double p[3];
+   double t[3];
+   double alpha[3][3];
+   double beta[3];
+   double talpha[3][3];
+   double tbeta[3];
+   double m[3][3];
+   double cov[3][3];
+   double chi2;
+   double tchi2;
+   double lambda;
+   uint   bins;
+   uint   iter;
+   uint   x;
+
+   if ( ent->count == 0 ) return;
+
+   ent->baseValid        = true;
+   ent->baseRms          = sqrt(ent->m2 / ent->count);
+   ent->baseFitMean      = ent->mean;
+   ent->baseFitSigma     = ent->baseRms;
+   ent->baseFitMeanErr   = ent->baseRms / sqrt(ent->count);
+   ent->baseFitSigmaErr  = ent->baseRms / sqrt(2.0 * ent->count);
+   ent->baseFitChisquare = 0;
+
+   for (bins=0, x=0; x < ent->hist.size(); x++) if ( ent->hist[x] > 0 ) bins++;
+   if ( bins <= 3 || ent->baseRms == 0 ) return;
+
+   // Amplitude, mean and sigma, bins are one ADC count wide
+   p[0]   = ent->count / (sqrt(2.0 * M_PI) * ent->baseRms);
+   p[1]   = ent->mean;
+   p[2]   = ent->baseRms;
+   lambda = 1e-3;
+   chi2   = gaussChi2(ent->histMin,ent->hist,p,alpha,beta);
+
+   for (iter=0; iter < CALIB_FIT_ITER && lambda < 1e10; iter++) {
+      memcpy(m,alpha,sizeof(m));
+      for (x=0; x < 3; x++) m[x][x] *= (1.0 + lambda);
+      if ( ! invert3(m,cov) ) break;
+
+      for (x=0; x < 3; x++) t[x] = p[x] + cov[x][0]*beta[0] + cov[x][1]*beta[1] + cov[x][2]*beta[2];
+      t[2] = fabs(t[2]);
+      if ( t[2] < 1e-6 || ! isfinite(t[0]) || ! isfinite(t[1]) ) {
+         lambda *= 10;
+         continue;
+      }
+
+      tchi2 = gaussChi2(ent->histMin,ent->hist,t,talpha,tbeta);
+      if ( ! (tchi2 <= chi2) ) {
+         lambda *= 10;
+         continue;
+      }
+
+      // Step accepted
+      memcpy(p,t,sizeof(p));
+      memcpy(alpha,talpha,sizeof(alpha));
+      memcpy(beta,tbeta,sizeof(beta));
+      lambda *= 0.1;
+      if ( (chi2 - tchi2) <= 1e-9 * (chi2 + 1e-9) ) {
+         chi2 = tchi2;
+         break;
+      }
+      chi2 = tchi2;
+   }
+
+   // Errors from the curvature at the minimum
+   if ( ! invert3(alpha,cov) || cov[1][1] < 0 || cov[2][2] < 0 ) return;
+
+   ent->baseFitMean      = p[1];
+   ent->baseFitSigma     = p[2];
+   ent->baseFitMeanErr   = sqrt(cov[1][1]);
+   ent->baseFitSigmaErr  = sqrt(cov[2][2]);
+   ent->baseFitChisquare = chi2 / (bins - 3);
+}
+
+// Weighted linear fit of the mean value against the injected charge. The
+// error of each point is the error of its mean, at least that of the ADC
+// step. The chi-square per degree of freedom is kept.
+void KpixCalibFit::fitCalib ( KpixCalibEntry *ent, uint address, uint bucket ) {
+   KpixCalibPoint *pt;
+   double          s;
+   double          sx;
+   double          sy;
+   double          sxx;
+   double          sxy;
+   double          x;
+   double          w;
+   double          var;
+   double          del;
+   double          chi2;
+   double          a;
+   double          b;
+   uint            y;
+
+   if ( ent->points.size() < 2 ) return;
+
+   s = sx = sy = sxx = sxy = 0;
+   for (y=0; y < ent->points.size(); y++) {
+      pt  = &(ent->points[y]);
+      x   = charge(pt->dac,bucket,asics_[address].positive,asics_[address].calibHigh);
+      var = (pt->count > 1)?(pt->m2 / (pt->count - 1) / pt->count):0;
+      if ( var < 1.0 / 12.0 / pt->count ) var = 1.0 / 12.0 / pt->count;
+      w    = 1.0 / var;
+      s   += w;
+      sx  += w * x;
+      sy  += w * pt->mean;
+      sxx += w * x * x;
+      sxy += w * x * pt->mean;
+   }
+   del = s * sxx - sx * sx;
+   if ( del <= 0 || ! isfinite(del) ) return;
+
+   b = (s * sxy - sx * sy) / del;
+   a = (sxx * sy - sx * sxy) / del;
+
+   chi2 = 0;
+   for (y=0; y < ent->points.size(); y++) {
+      pt  = &(ent->points[y]);
+      x   = charge(pt->dac,bucket,asics_[address].positive,asics_[address].calibHigh);
+      var = (pt->count > 1)?(pt->m2 / (pt->count - 1) / pt->count):0;
+      if ( var < 1.0 / 12.0 / pt->count ) var = 1.0 / 12.0 / pt->count;
+      chi2 += (pt->mean - a - b * x) * (pt->mean - a - b * x) / var;
+   }
+
+   // Gain in ADC per coulomb from ADC per fC
+   ent->calibValid        = true;
+   ent->calibGain         = b * 1e15;
+   ent->calibIntercept    = a;
+   ent->calibGainErr      = sqrt(s / del) * 1e15;
+   ent->calibInterceptErr = sqrt(sxx / del);
+   ent->calibChisquare    = (ent->points.size() > 2)?(chi2 / (ent->points.size() - 2)):0;
+}
+
+// Fit thread
+void *KpixCalibFit::runFit ( void *t ) {
+   KpixCalibFit *fit = (KpixCalibFit *)t;
+   fit->fitWorker();
+   pthread_exit(NULL);
+   return(NULL);
+}
+
+// Fit blocks of entries until none are left
+void KpixCalibFit::fitWorker ( ) {
+   uint first;
+   uint x;
+
+   while ( true ) {
+      pthread_mutex_lock(&mutex_);
+      first     = nextFit_;
+      nextFit_ += CALIB_FIT_BLOCK;
+      pthread_mutex_unlock(&mutex_);
+
+      if ( first >= entries_.size() ) break;
+
+      for (x=first; x < (first + CALIB_FIT_BLOCK) && x < entries_.size(); x++) {
+         if ( entries_[x] == NULL ) continue;
+         fitBaseline(entries_[x]);
+         fitCalib(entries_[x],x / CALIB_FIT_ASIC,(x >> 1) & 0x3);
+      }
+   }
+}
+
+// Fit all entries
+void KpixCalibFit::fit ( uint threads ) {
+   vector<pthread_t> thread;
+   uint              x;
+
+   if ( threads == 0 ) threads = sysconf(_SC_NPROCESSORS_ONLN);
+   if ( threads == 0 ) threads = 1;
+
+   nextFit_ = 0;
+   thread.resize(threads);
+   for (x=0; x < threads; x++) {
+      if ( pthread_create(&(thread[x]),NULL,runFit,this) ) {
+         cout << "KpixCalibFit::fit -> Failed to create fit thread" << endl;
+         thread.resize(x);
+         break;
+      }
+   }
+   for (x=0; x < thread.size(); x++) pthread_join(thread[x],NULL);
+
+   // Threads could not be started
+   if ( thread.empty() ) fitWorker();
+}
+
+// Write a value
+static void writeValue ( ostream &os, string tag, double value ) {
+   if ( ! isfinite(value) ) return;
+   os << "               <" << tag << ">" << value << "</" << tag << ">" << endl;
+}
+
+// Write results in calibration xml format
+bool KpixCalibFit::writeXml ( string file, string source ) {
+   KpixCalibEntry *ent;
+   ofstream        os;
+   char            tstr[64];
+   time_t          now;
+   const char     *user;
+   uint            address;
+   uint            channel;
+   uint            bucket;
+   uint            range;
+   bool            head;
+   bool            open;
+
+   os.open(file.c_str());
+   if ( ! os.is_open() ) return(false);
+   os << setprecision(12);
+
+   now  = time(NULL);
+   user = getenv("USER");
+   strftime(tstr,sizeof(tstr),"%Y_%m_%d_%H_%M_%S",localtime(&now));
+
+   os << "<calibrationData>" << endl;
+   os << "   <sourceFile>" << source << "</sourceFile>" << endl;
+   os << "   <user>" << ((user == NULL)?"":user) << "</user>" << endl;
+   os << "   <timestamp>" << tstr << "</timestamp>" << endl;
+
+   for (address=0; address < MaxAsics; address++) {
+      if ( asics_[address].serial == "" ) continue;
+      os << "   <kpixAsic id=\"" << asics_[address].serial << "\">" << endl;
+
+      for (channel=0; channel < 1024; channel++) {
+         head = false;
+         for (bucket=0; bucket < 4; bucket++) {
+            open = false;
+            for (range=0; range < 2; range++) {
+               ent = entries_[fitIndex(address,channel,bucket,range)];
+               if ( ent == NULL || ! (ent->baseValid || ent->calibValid) ) continue;
+
+               if ( ! head ) {
+                  os << "      <Channel id=\"" << channel << "\">" << endl;
+                  os << "         <BadChannel>0</BadChannel>" << endl;
+                  head = true;
+               }
+               if ( ! open ) {
+                  os << "         <Bucket id=\"" << bucket << "\">" << endl;
+                  open = true;
+               }
+               os << "            <Range id=\"" << range << "\">" << endl;
+               if ( ent->baseValid ) {
+                  writeValue(os,"BaseMean",ent->mean);
+                  writeValue(os,"BaseRms",ent->baseRms);
+                  writeValue(os,"BaseFitMean",ent->baseFitMean);
+                  writeValue(os,"BaseFitSigma",ent->baseFitSigma);
+                  writeValue(os,"BaseFitMeanErr",ent->baseFitMeanErr);
+                  writeValue(os,"BaseFitSigmaErr",ent->baseFitSigmaErr);
+                  writeValue(os,"BaseFitChisquare",ent->baseFitChisquare);
+               }
+               if ( ent->calibValid ) {
+                  writeValue(os,"CalibGain",ent->calibGain);
+                  writeValue(os,"CalibIntercept",ent->calibIntercept);
+                  writeValue(os,"CalibGainErr",ent->calibGainErr);
+                  writeValue(os,"CalibInterceptErr",ent->calibInterceptErr);
+                  writeValue(os,"CalibChisquare",ent->calibChisquare);
+               }
+               os << "            </Range>" << endl;
+            }
+            if ( open ) os << "         </Bucket>" << endl;
+         }
+         if ( head ) os << "      </Channel>" << endl;
+      }
+      os << "   </kpixAsic>" << endl;
+   }
+   os << "</calibrationData>" << endl;
+   os.close();
+   return(true);
+}
@@ -0,0 +1,195 @@
+//-----------------------------------------------------------------------------
+// File          : KpixCalibFit.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : KPIX Control Software
+//-----------------------------------------------------------------------------
+// Description :
+// Calibration fitter. Samples of a calibration run are accumulated per KPiX,
+// channel, bucket and range: running moments and a histogram of the baseline
+// and running moments of the injected samples at each calibration DAC value.
+// No samples are stored. The baseline gets a gaussian fit and the injection
+// curve a linear fit, in parallel across channels. The results are written
+// in the xml format read by KpixCalibRead.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __KPIX_CALIB_FIT_H__
+#define __KPIX_CALIB_FIT_H__
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include <pthread.h>
+using namespace std;
+
+class KpixSampleBatch;
+
+//! Calibration run accumulators and fits
+class KpixCalibFit {
+
+      // Running moments of the samples at one calibration DAC value
+      class KpixCalibPoint {
+         public:
+            uint   dac;
+            double count;
+            double mean;
+            double m2;
+      };
+
+      // Accumulators and results of one channel, bucket and range
+      class KpixCalibEntry {
+         public:
+
+            // Baseline moments and histogram of values histMin and up
+            double       count;
+            double       mean;
+            double       m2;
+            int          histMin;
+            vector<uint> hist;
+
+            // Injection moments by DAC value
+            vector<KpixCalibPoint> points;
+            uint                   last;
+
+            // Baseline results
+            bool   baseValid;
+            double baseRms;
+            double baseFitMean;
+            double baseFitSigma;
+            double baseFitMeanErr;
+            double baseFitSigmaErr;
+            double baseFitChisquare;
+
+            // Injection results
+            bool   calibValid;
+            double calibGain;
+            double calibIntercept;
+            double calibGainErr;
+            double calibInterceptErr;
+            double calibChisquare;
+
+            KpixCalibEntry ( );
+      };
+
+      // Settings of a KPiX address
+      class KpixCalibAsic {
+         public:
+            string serial;
+            bool   positive;
+            bool   calibHigh;
+      };
+
+      // Entries by KPiX address, channel, bucket and range, created on first use
+      vector<KpixCalibEntry *> entries_;
+
+      // KPiX settings by address
+      vector<KpixCalibAsic> asics_;
+
+      // Injection time window of each bucket, disabled when empty
+      vector<uint> window_;
+
+      // Next entry to fit
+      uint            nextFit_;
+      pthread_mutex_t mutex_;
+
+      // Return entry, optional creation
+      KpixCalibEntry *entry ( uint address, uint channel, uint bucket, uint range, bool create );
+
+      // Fit thread routines
+      static void *runFit ( void *t );
+      void fitWorker ( );
+
+      // Fit one entry
+      void fitBaseline ( KpixCalibEntry *entry );
+      void fitCalib ( KpixCalibEntry *entry, uint address, uint bucket );
+
+   public:
+
+      //! Calibration state of a calibration marker
+      enum CalState {
+         Idle     = 0,
+         Baseline = 1,
+         Inject   = 2
+      };
+
+      //! Number of KPiX addresses accumulated
+      static const uint MaxAsics = 32;
+
+      //! Constructor
+      KpixCalibFit ( );
+
+      //! Deconstructor
+      ~KpixCalibFit ( );
+
+      //! Remove all accumulators and results
+      void clear ( );
+
+      //! Set KPiX settings
+      /*!
+       * Only KPiX with a serial number are written.
+       * \param address   KPiX address
+       * \param serial    Serial number
+       * \param positive  Positive input polarity
+       * \param calibHigh Bucket 0 high range calibration
+      */
+      void setAsic ( uint address, string serial, bool positive, bool calibHigh );
+
+      //! Serial number of a KPiX address, empty if not set
+      string serial ( uint address );
+
+      //! Only accept samples in the injection time window of their bucket
+      /*!
+       * Samples of bucket b are accepted when times[b] <= time < times[b+1].
+       * \param times Five times, NULL to accept all samples
+      */
+      void setWindow ( uint *times );
+
+      //! Charge in fC injected at a calibration DAC value
+      static double charge ( uint dac, uint bucket, bool positive, bool calibHigh );
+
+      //! Add samples of an event
+      /*!
+       * Baseline samples are added to all channels. Injection samples are
+       * added to the injected channels, channel, channel+stride, ... up to
+       * last, or to channel alone for a stride of 0 or 1. Empty samples,
+       * samples with a bad count and non data samples are skipped.
+       * \param batch   Decoded samples
+       * \param state   CalState in effect
+       * \param channel First injected channel
+       * \param stride  Injected channel spacing, 0 or 1 for one channel
+       * \param last    Last channel of the run, CalChanMax
+       * \param dac     Calibration DAC value
+      */
+      void fill ( KpixSampleBatch *batch, uint state, uint channel, uint stride, uint last, uint dac );
+
+      //! Add a baseline sample
+      void baseline ( uint address, uint channel, uint bucket, uint range, uint value );
+
+      //! Add an injection sample
+      void inject ( uint address, uint channel, uint bucket, uint range, uint dac, uint value );
+
+      //! Merge accumulators of another fitter into this one
+      void merge ( KpixCalibFit *other );
+
+      //! Number of channel, bucket and range entries with samples
+      uint entries ( );
+
+      //! Fit all entries
+      /*!
+       * \param threads Number of threads, 0 for one per processor
+      */
+      void fit ( uint threads = 0 );
+
+      //! Write results in calibration xml format
+      /*!
+       * \param file   Output file
+       * \param source Data file name recorded in the output
+      */
+      bool writeXml ( string file, string source );
+};
+
+#endif
@@ -0,0 +1,158 @@
+//-----------------------------------------------------------------------------
+// File          : KpixCalibOnline.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : KPIX Control Software
+//-----------------------------------------------------------------------------
+// Description :
+// Calibration fitter attached to a CommLink as a data sink. Events of a
+// calibration run are added to the accumulators of a KpixCalibFit as they
+// are received, using the calibration markers for the state, channel and
+// dac. Memory does not grow with the number of events. At the end of the
+// run the fit and the xml output only take the fitting time.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include <sstream>
+#include <string.h>
+#include <Data.h>
+#include "KpixCalibOnline.h"
+#include "KpixSample.h"
+using namespace std;
+
+// Constructor
+KpixCalibOnline::KpixCalibOnline ( ) {
+   pthread_mutex_init(&mutex_,NULL);
+   reset();
+}
+
+// Deconstructor
+KpixCalibOnline::~KpixCalibOnline ( ) {
+   pthread_mutex_destroy(&mutex_);
+}
+
+// Remove all accumulators, KPiX settings and the calibration state
+void KpixCalibOnline::reset ( ) {
+   pthread_mutex_lock(&mutex_);
+   fit_.clear();
+   config_.clear();
+   state_   = KpixCalibFit::Idle;
+   channel_ = 0;
+   stride_  = 1;
+   dac_     = 0;
+   chanMax_ = 1023;
+   events_  = 0;
+   pthread_mutex_unlock(&mutex_);
+}
+
+// Set KPiX settings
+void KpixCalibOnline::setAsic ( uint address, string serial, bool positive, bool calibHigh ) {
+   pthread_mutex_lock(&mutex_);
+   fit_.setAsic(address,serial,positive,calibHigh);
+   pthread_mutex_unlock(&mutex_);
+}
+
+// Set the last channel of the run
+void KpixCalibOnline::setChanMax ( uint chanMax ) {
+   pthread_mutex_lock(&mutex_);
+   chanMax_ = chanMax;
+   pthread_mutex_unlock(&mutex_);
+}
+
+// KPiX settings from the configuration
+void KpixCalibOnline::setup ( ) {
+   stringstream prefix;
+   string       serial;
+   uint         x;
+
+   if ( config_.get("CalChanMax") != "" ) chanMax_ = config_.getInt("CalChanMax");
+
+   for (x=0; x < KpixCalibFit::MaxAsics; x++) {
+      prefix.str("");
+      prefix << "cntrlFpga(0):kpixAsic(" << dec << x << "):";
+      serial = config_.get(prefix.str() + "SerialNumber");
+      if ( serial == "" ) continue;
+
+      fit_.setAsic(x,serial,(config_.get(prefix.str() + "CntrlPolarity") == "Positive"),
+                            (config_.get(prefix.str() + "CntrlCalibHigh") == "True"));
+   }
+}
+
+// Record received
+void KpixCalibOnline::rxRecord ( uint32_t header, const void *data ) {
+   uint32_t marker[4];
+   uint32_t size;
+   string   xml;
+
+   size = header & 0x0FFFFFFF;
+
+   pthread_mutex_lock(&mutex_);
+   switch ( (header >> 28) & 0xF ) {
+
+      // Events of the calibration states
+      case Data::RawData :
+         if ( state_ == KpixCalibFit::Baseline || state_ == KpixCalibFit::Inject ) {
+            event_.view((uint32_t *)data,size);
+            batch_.decode(&event_,-1,KpixSample::Data);
+            fit_.fill(&batch_,state_,channel_,stride_,chanMax_,dac_);
+            events_++;
+         }
+         break;
+
+      // Stride word is optional, one channel per step without it
+      case Data::CalMarker :
+         if ( size >= 12 ) {
+            marker[3] = 1;
+            memcpy(marker,data,(size < sizeof(marker))?size:sizeof(marker));
+            state_   = marker[0];
+            channel_ = marker[1];
+            dac_     = marker[2];
+            stride_  = marker[3];
+         }
+         break;
+
+      case Data::XmlConfig :
+         xml.assign((const char *)data,size);
+         config_.parse("config",xml.c_str());
+         setup();
+         break;
+
+      default : break;
+   }
+   pthread_mutex_unlock(&mutex_);
+}
+
+// Number of calibration events added
+uint KpixCalibOnline::events ( ) {
+   uint ret;
+
+   pthread_mutex_lock(&mutex_);
+   ret = events_;
+   pthread_mutex_unlock(&mutex_);
+   return(ret);
+}
+
+// Number of channel, bucket and range entries with samples
+uint KpixCalibOnline::entries ( ) {
+   uint ret;
+
+   pthread_mutex_lock(&mutex_);
+   ret = fit_.entries();
+   pthread_mutex_unlock(&mutex_);
+   return(ret);
+}
+
+// Fit and write results in calibration xml format
+bool KpixCalibOnline::finish ( string file, string source, uint threads ) {
+   bool ret;
+
+   pthread_mutex_lock(&mutex_);
+   fit_.fit(threads);
+   ret = fit_.writeXml(file,source);
+   pthread_mutex_unlock(&mutex_);
+   return(ret);
+}
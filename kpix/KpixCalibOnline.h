@@ -0,0 +1,106 @@
+//-----------------------------------------------------------------------------
+// File          : KpixCalibOnline.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : KPIX Control Software
+//-----------------------------------------------------------------------------
+// Description :
+// Calibration fitter attached to a CommLink as a data sink. Events of a
+// calibration run are added to the accumulators of a KpixCalibFit as they
+// are received, using the calibration markers for the state, channel and
+// dac. Memory does not grow with the number of events. At the end of the
+// run the fit and the xml output only take the fitting time.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __KPIX_CALIB_ONLINE_H__
+#define __KPIX_CALIB_ONLINE_H__
+#include <string>
+#include <pthread.h>
+#include <DataSink.h>
+#include <XmlVariables.h>
+#include <KpixEvent.h>
+#include <KpixSampleBatch.h>
+#include <KpixCalibFit.h>
+using namespace std;
+
+//! Online calibration accumulators
+class KpixCalibOnline : public DataSink {
+
+      // Accumulators
+      KpixCalibFit    fit_;
+      KpixEvent       event_;
+      KpixSampleBatch batch_;
+      pthread_mutex_t mutex_;
+
+      // Configuration records received
+      XmlVariables config_;
+
+      // Calibration marker in effect
+      uint state_;
+      uint channel_;
+      uint stride_;
+      uint dac_;
+
+      // Last channel of the run, CalChanMax
+      uint chanMax_;
+
+      // Events added
+      uint events_;
+
+      // KPiX settings from the configuration
+      void setup ( );
+
+   public:
+
+      //! Constructor
+      KpixCalibOnline ( );
+
+      //! Deconstructor
+      ~KpixCalibOnline ( );
+
+      //! Remove all accumulators, KPiX settings and the calibration state
+      void reset ( );
+
+      //! Set KPiX settings
+      /*!
+       * Settings are also taken from the configuration records received.
+       * \param address   KPiX address
+       * \param serial    Serial number
+       * \param positive  Positive input polarity
+       * \param calibHigh Bucket 0 high range calibration
+      */
+      void setAsic ( uint address, string serial, bool positive, bool calibHigh );
+
+      //! Set the last channel of the run, CalChanMax
+      /*!
+       * Parallel injection groups end at this channel. It is also taken
+       * from the configuration records received.
+       * \param chanMax Last channel
+      */
+      void setChanMax ( uint chanMax );
+
+      //! Record received
+      void rxRecord ( uint32_t header, const void *data );
+
+      //! Number of calibration events added
+      uint events ( );
+
+      //! Number of channel, bucket and range entries with samples
+      uint entries ( );
+
+      //! Fit and write results in calibration xml format
+      /*!
+       * Accumulation continues afterwards, a later call fits all data.
+       * \param file    Output file
+       * \param source  Source recorded in the output
+       * \param threads Number of fit threads, 0 for one per processor
+      */
+      bool finish ( string file, string source, uint threads = 0 );
+};
+
+#endif
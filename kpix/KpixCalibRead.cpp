@@ -12,6 +12,8 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 05/31/2012: created
+// 10/17/2026: Added binary cache of parsed calibration files
+// 10/17/2026: Cache is only read when no ASICs are loaded
 //-----------------------------------------------------------------------------
 #include <iostream>
 #include <iomanip>
@@ -22,9 +24,46 @@
 #include <stdlib.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "KpixCalibRead.h"
 using namespace std;
 
+// Binary cache format, the version changes with the layout
+#define CALIB_CACHE_MAGIC   "KPIXCAL1"
+#define CALIB_CACHE_VERSION 1
+#define CALIB_CACHE_SERIAL  64
+#define CALIB_CACHE_FIELDS  13
+#define CALIB_CACHE_ENTRIES 8192
+
+// Cache file header, followed by one block per ASIC
+typedef struct {
+   char     magic[8];
+   uint32_t version;
+   uint32_t asics;
+   uint64_t xmlSize;
+   int64_t  xmlSec;
+   int64_t  xmlNsec;
+   uint64_t size;
+} CalibCacheHeader;
+
+// ASIC block: serial, values[field][(channel*4+bucket)*2+range], bad channel
+// flags, then crossTalk entries of index, length and text padded to 8 bytes
+typedef struct {
+   char     serial[CALIB_CACHE_SERIAL];
+   double   values[CALIB_CACHE_FIELDS][CALIB_CACHE_ENTRIES];
+   uint32_t badChannel[1024];
+   uint32_t crossTalk;
+   uint32_t pad;
+} CalibCacheAsic;
+
+// Value element names in cache field order
+static const char *calibFields[CALIB_CACHE_FIELDS] = {
+   "BaseMean", "BaseRms", "BaseFitMean", "BaseFitSigma", "BaseFitMeanErr", "BaseFitSigmaErr",
+   "BaseFitChisquare", "CalibGain", "CalibIntercept", "CalibGainErr", "CalibGainRms",
+   "CalibInterceptErr", "CalibChisquare" };
+
 // Calib Data Class Constructor
 KpixCalibRead::KpixCalibRead ( ) {
    xmlInitParser();
@@ -37,13 +76,202 @@ KpixCalibRead::~KpixCalibRead ( ) {
    xmlMemoryDump();
 }
 
+// Index of a value element name
+int KpixCalibRead::fieldIndex ( string name ) {
+   uint x;
+
+   for (x=0; x < CALIB_CACHE_FIELDS; x++)
+      if ( name == calibFields[x] ) return(x);
+   return(-1);
+}
+
+// Return pointer to value by index
+double *KpixCalibRead::field ( KpixCalibData *data, uint index ) {
+   switch ( index ) {
+      case  0: return(&(data->baseMean));
+      case  1: return(&(data->baseRms));
+      case  2: return(&(data->baseFitMean));
+      case  3: return(&(data->baseFitSigma));
+      case  4: return(&(data->baseFitMeanErr));
+      case  5: return(&(data->baseFitSigmaErr));
+      case  6: return(&(data->baseFitChisquare));
+      case  7: return(&(data->calibGain));
+      case  8: return(&(data->calibIntercept));
+      case  9: return(&(data->calibGainErr));
+      case 10: return(&(data->calibGainRms));
+      case 11: return(&(data->calibInterceptErr));
+      default: return(&(data->calibChisquare));
+   }
+}
+
+// Binary cache file name of a calibration file
+string KpixCalibRead::cacheFile ( string calibFile ) {
+   return(calibFile + ".cache");
+}
+
+// Load ASICs from the binary cache of a calibration file
+bool KpixCalibRead::readCache ( string calibFile ) {
+   struct stat       xst;
+   struct stat       cst;
+   CalibCacheHeader *head;
+   CalibCacheAsic   *block;
+   KpixCalibAsic    *asic;
+   uint8_t          *buff;
+   uint64_t          pos;
+   uint32_t          entry[2];
+   uint32_t          x;
+   uint32_t          y;
+   uint32_t          z;
+   int32_t           fd;
+   bool              valid;
+   string            serial;
+
+   if ( stat(calibFile.c_str(),&xst) != 0 ) return(false);
+   if ( (fd = ::open(cacheFile(calibFile).c_str(),O_RDONLY)) < 0 ) return(false);
+   if ( fstat(fd,&cst) != 0 || (uint64_t)cst.st_size < sizeof(CalibCacheHeader) ) {
+      ::close(fd);
+      return(false);
+   }
+   buff = (uint8_t *)mmap(NULL,cst.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+   ::close(fd);
+   if ( buff == MAP_FAILED ) return(false);
+
+   // Header must match the calibration file
+   head  = (CalibCacheHeader *)buff;
+   valid = ( memcmp(head->magic,CALIB_CACHE_MAGIC,8) == 0 && head->version == CALIB_CACHE_VERSION &&
+             head->size == (uint64_t)cst.st_size && head->xmlSize == (uint64_t)xst.st_size &&
+             head->xmlSec == xst.st_mtim.tv_sec && head->xmlNsec == xst.st_mtim.tv_nsec );
+
+   // Check block bounds before loading anything
+   pos = sizeof(CalibCacheHeader);
+   for (x=0; valid && x < head->asics; x++) {
+      if ( (pos + sizeof(CalibCacheAsic)) > head->size ) valid = false;
+      else {
+         block = (CalibCacheAsic *)(buff + pos);
+         pos  += sizeof(CalibCacheAsic);
+         for (y=0; valid && y < block->crossTalk; y++) {
+            if ( (pos + 8) > head->size ) valid = false;
+            else {
+               memcpy(entry,buff+pos,8);
+               pos += 8 + ((entry[1] + 7) & ~7);
+               if ( pos > head->size || entry[0] >= CALIB_CACHE_ENTRIES ) valid = false;
+            }
+         }
+      }
+   }
+   if ( ! valid ) {
+      munmap(buff,cst.st_size);
+      return(false);
+   }
+
+   pos = sizeof(CalibCacheHeader);
+   for (x=0; x < head->asics; x++) {
+      block  = (CalibCacheAsic *)(buff + pos);
+      pos   += sizeof(CalibCacheAsic);
+      serial = string(block->serial,strnlen(block->serial,CALIB_CACHE_SERIAL));
+      findKpix(serial,0,0,0,true);
+      asic = asicList_[serial];
+
+      for (y=0; y < CALIB_CACHE_ENTRIES; y++)
+         for (z=0; z < CALIB_CACHE_FIELDS; z++)
+            *field(asic->data[y>>3][(y>>1)&3][y&1],z) = block->values[z][y];
+      for (y=0; y < 1024; y++) asic->data[y][0][0]->badChannel = block->badChannel[y];
+
+      for (y=0; y < block->crossTalk; y++) {
+         memcpy(entry,buff+pos,8);
+         asic->data[entry[0]>>3][(entry[0]>>1)&3][entry[0]&1]->calibCrossTalk = string((char *)buff+pos+8,entry[1]);
+         pos += 8 + ((entry[1] + 7) & ~7);
+      }
+   }
+   munmap(buff,cst.st_size);
+   return(true);
+}
+
+// Write all ASICs to the binary cache of a calibration file
+bool KpixCalibRead::writeCache ( string calibFile ) {
+   map<string,KpixCalibAsic *>::iterator iter;
+   struct stat       xst;
+   CalibCacheHeader  head;
+   CalibCacheAsic   *block;
+   KpixCalibData    *data;
+   string            tmp;
+   uint32_t          entry[2];
+   uint64_t          zero;
+   uint32_t          y;
+   uint32_t          z;
+   int32_t           fd;
+   bool              ret;
+
+   if ( stat(calibFile.c_str(),&xst) != 0 ) return(false);
+   for (iter=asicList_.begin(); iter != asicList_.end(); iter++)
+      if ( iter->first.size() >= CALIB_CACHE_SERIAL ) return(false);
+
+   tmp = cacheFile(calibFile) + ".tmp";
+   if ( (fd = ::open(tmp.c_str(),O_WRONLY|O_CREAT|O_TRUNC,S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH)) < 0 ) return(false);
+
+   memset(&head,0,sizeof(head));
+   memcpy(head.magic,CALIB_CACHE_MAGIC,8);
+   head.version = CALIB_CACHE_VERSION;
+   head.asics   = asicList_.size();
+   head.xmlSize = xst.st_size;
+   head.xmlSec  = xst.st_mtim.tv_sec;
+   head.xmlNsec = xst.st_mtim.tv_nsec;
+   head.size    = sizeof(head);
+   ret          = ( write(fd,&head,sizeof(head)) == sizeof(head) );
+
+   zero  = 0;
+   block = (CalibCacheAsic *)malloc(sizeof(CalibCacheAsic));
+   for (iter=asicList_.begin(); ret && iter != asicList_.end(); iter++) {
+      memset(block,0,sizeof(CalibCacheAsic));
+      strcpy(block->serial,iter->first.c_str());
+
+      for (y=0; y < CALIB_CACHE_ENTRIES; y++) {
+         data = iter->second->data[y>>3][(y>>1)&3][y&1];
+         for (z=0; z < CALIB_CACHE_FIELDS; z++) block->values[z][y] = *field(data,z);
+         if ( data->calibCrossTalk != "" ) block->crossTalk++;
+      }
+      for (y=0; y < 1024; y++) block->badChannel[y] = iter->second->data[y][0][0]->badChannel;
+
+      ret = ( write(fd,block,sizeof(CalibCacheAsic)) == sizeof(CalibCacheAsic) );
+      head.size += sizeof(CalibCacheAsic);
+
+      for (y=0; ret && y < CALIB_CACHE_ENTRIES; y++) {
+         data = iter->second->data[y>>3][(y>>1)&3][y&1];
+         if ( data->calibCrossTalk == "" ) continue;
+         entry[0] = y;
+         entry[1] = data->calibCrossTalk.size();
+         z        = ((entry[1] + 7) & ~7) - entry[1];
+         ret = ( write(fd,entry,8) == 8 &&
+                 write(fd,data->calibCrossTalk.c_str(),entry[1]) == (ssize_t)entry[1] &&
+                 write(fd,&zero,z) == (ssize_t)z );
+         head.size += 8 + entry[1] + z;
+      }
+   }
+   free(block);
+
+   // Final size goes in the header last
+   if ( ret ) ret = ( pwrite(fd,&head,sizeof(head),0) == sizeof(head) );
+   ::close(fd);
+
+   if ( ret ) ret = ( rename(tmp.c_str(),cacheFile(calibFile).c_str()) == 0 );
+   else unlink(tmp.c_str());
+   return(ret);
+}
+
 // Parse xml file
-bool KpixCalibRead::parse ( string calibFile ) {
+bool KpixCalibRead::parse ( string calibFile, bool cache ) {
    xmlDocPtr    doc;
    xmlNodePtr   node;
    ifstream     is;
    stringstream buffer;
+   string       xml;
    bool         ret;
+   bool         empty;
+
+   // The cache holds this file alone with all values, it is only used when no
+   // ASICs are loaded, values missing from a later file keep the earlier ones
+   empty = asicList_.empty();
+   if ( cache && empty && readCache(calibFile) ) return(true);
 
    // Open file
    is.open(calibFile.c_str());
@@ -55,10 +283,11 @@ bool KpixCalibRead::parse ( string calibFile ) {
    buffer.str("");
    buffer << is.rdbuf();
    is.close();
+   xml = buffer.str();
    ret = false;
 
    // Parse string
-   doc = xmlReadMemory(buffer.str().c_str(), strlen(buffer.str().c_str()), "calib.xml", NULL, 0);
+   doc = xmlReadMemory(xml.c_str(), xml.size(), "calib.xml", NULL, 0);
    if (doc != NULL) {
 
       // get the root element node
@@ -73,6 +302,8 @@ bool KpixCalibRead::parse ( string calibFile ) {
    }
    xmlCleanupParser();
    xmlMemoryDump();
+
+   if ( ret && cache && empty ) writeCache(calibFile);
    return(ret);
 }
 
@@ -87,11 +318,13 @@ void KpixCalibRead::parseXmlLevel ( xmlNode *node, string kpix, uint channel, ui
    string     kpixLocal;
    char       *nodeValue;
    double     value;
+   int        fieldIdx;
 
    kpixLocal = kpix;
 
    // Top level node name
-   topStr = (char *)node->name;
+   topStr   = (char *)node->name;
+   fieldIdx = fieldIndex(topStr);
 
    // Look for child nodes
    for ( childNode = node->children; childNode; childNode = childNode->next ) {
@@ -132,22 +365,11 @@ void KpixCalibRead::parseXmlLevel ( xmlNode *node, string kpix, uint channel, ui
             sscanf(nodeValue,"%lf",&value);
 
             // What do we do with this value
+            // The element name is matched once per level
             if ( bucket < 4 && channel < 1024 && range < 2 ) {
-               if ( topStr == "BaseMean" )          findKpix(kpix,channel,bucket,range,true)->baseMean          = value;
-               if ( topStr == "BaseRms" )           findKpix(kpix,channel,bucket,range,true)->baseRms           = value;
-               if ( topStr == "BaseFitMean" )       findKpix(kpix,channel,bucket,range,true)->baseFitMean       = value;
-               if ( topStr == "BaseFitSigma" )      findKpix(kpix,channel,bucket,range,true)->baseFitSigma      = value;
-               if ( topStr == "BaseFitMeanErr" )    findKpix(kpix,channel,bucket,range,true)->baseFitMeanErr    = value;
-               if ( topStr == "BaseFitSigmaErr" )   findKpix(kpix,channel,bucket,range,true)->baseFitSigmaErr   = value;
-               if ( topStr == "BaseFitChisquare" )  findKpix(kpix,channel,bucket,range,true)->baseFitChisquare  = value;
-               if ( topStr == "CalibGain" )         findKpix(kpix,channel,bucket,range,true)->calibGain         = value;
-               if ( topStr == "CalibIntercept" )    findKpix(kpix,channel,bucket,range,true)->calibIntercept    = value;
-               if ( topStr == "CalibGainErr" )      findKpix(kpix,channel,bucket,range,true)->calibGainErr      = value;
-               if ( topStr == "CalibGainRms" )      findKpix(kpix,channel,bucket,range,true)->calibGainRms      = value;
-               if ( topStr == "CalibInterceptErr" ) findKpix(kpix,channel,bucket,range,true)->calibInterceptErr = value;
-               if ( topStr == "CalibChisquare" )    findKpix(kpix,channel,bucket,range,true)->calibChisquare    = value;
-               if ( topStr == "CalibCrossTalk" )    findKpix(kpix,channel,bucket,range,true)->calibCrossTalk    = nodeValue;
-               if ( topStr == "BadChannel"        ) findKpix(kpix,channel,0     ,0    ,true)->badChannel        = (uint)value;
+               if ( fieldIdx >= 0 )                 *field(findKpix(kpix,channel,bucket,range,true),fieldIdx) = value;
+               else if ( topStr == "CalibCrossTalk" ) findKpix(kpix,channel,bucket,range,true)->calibCrossTalk = nodeValue;
+               else if ( topStr == "BadChannel"     ) findKpix(kpix,channel,0     ,0    ,true)->badChannel     = (uint)value;
             }
          }
       }
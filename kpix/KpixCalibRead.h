@@ -12,6 +12,7 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 05/31/2012: created
+// 10/17/2026: Added binary cache of parsed calibration files
 //-----------------------------------------------------------------------------
 #ifndef __KPIX_CALIB_READ_H__
 #define __KPIX_CALIB_READ_H__
@@ -96,6 +97,18 @@ class KpixCalibRead {
       // Vector of KPIXs
       map<string,KpixCalibAsic *> asicList_;
 
+      // Index of a value element name, -1 if not a value
+      static int fieldIndex ( string name );
+
+      // Return pointer to value by index
+      static double *field ( KpixCalibData *data, uint index );
+
+      // Load ASICs from the binary cache of a calibration file, false if not valid
+      bool readCache ( string calibFile );
+
+      // Write all ASICs to the binary cache of a calibration file
+      bool writeCache ( string calibFile );
+
       // Parse XML level
       void parseXmlLevel ( xmlNode *node, string kpix, uint channel, uint bucket, uint range );
 
@@ -111,7 +124,18 @@ class KpixCalibRead {
       ~KpixCalibRead ( );
 
       //! Parse XML file
-      bool parse ( string calibFile );
+      /*!
+       * The parsed values are kept in a binary cache next to the file,
+       * <calibFile>.cache, which is used while the size and modification
+       * time of the file are unchanged. Files parsed after another one are
+       * always read from the xml, their values are added to the loaded ones.
+       * \param calibFile Calibration file
+       * \param cache     Use and write the binary cache
+      */
+      bool parse ( string calibFile, bool cache = true );
+
+      //! Binary cache file name of a calibration file
+      static string cacheFile ( string calibFile );
 
       //! Get baseline mean value
       double baseMean ( string kpix, uint channel, uint bucket, uint range );
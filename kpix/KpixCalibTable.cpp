@@ -0,0 +1,189 @@
+//-----------------------------------------------------------------------------
+// File          : KpixCalibTable.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : KPIX Control Software
+//-----------------------------------------------------------------------------
+// Description :
+// Calibration constants compiled into dense arrays. Baseline mean and gain
+// are stored as float in one array each, indexed by KPiX address, channel,
+// bucket and range. Serial numbers are resolved to addresses once when the
+// table is built from a KpixCalibRead.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include "KpixCalibTable.h"
+#include "KpixCalibRead.h"
+#include "KpixSampleBatch.h"
+#include "KpixSample.h"
+using namespace std;
+
+#if defined(__x86_64__) || defined(__SSE2__)
+#define KPIX_TABLE_SIMD
+#include <immintrin.h>
+#endif
+
+// Entries per KPiX, 1024 channels x 4 buckets x 2 ranges
+#define KPIX_TABLE_ASIC 8192
+
+// Entry index
+static inline uint tableIndex ( uint address, uint channel, uint bucket, uint range ) {
+   return((address << 13) | ((channel & 0x3FF) << 3) | ((bucket & 0x3) << 1) | (range & 0x1));
+}
+
+// Constructor
+KpixCalibTable::KpixCalibTable ( ) { }
+
+// Deconstructor
+KpixCalibTable::~KpixCalibTable ( ) { }
+
+// Build table
+void KpixCalibTable::build ( KpixCalibRead *calib, vector<string> &serials ) {
+   uint   address;
+   uint   channel;
+   uint   bucket;
+   uint   range;
+   uint   idx;
+   double gain;
+
+   serials_ = serials;
+   mean_.assign(serials_.size() * KPIX_TABLE_ASIC,0);
+   gain_.assign(serials_.size() * KPIX_TABLE_ASIC,0);
+   scale_.assign(serials_.size() * KPIX_TABLE_ASIC,0);
+
+   for (address=0; address < serials_.size(); address++) {
+      if ( serials_[address] == "" ) continue;
+
+      for (channel=0; channel < 1024; channel++) {
+         for (bucket=0; bucket < 4; bucket++) {
+            for (range=0; range < 2; range++) {
+               idx = tableIndex(address,channel,bucket,range);
+               gain       = calib->calibGain(serials_[address],channel,bucket,range);
+               mean_[idx] = calib->baseMean(serials_[address],channel,bucket,range);
+               gain_[idx] = gain;
+               if ( gain != 0 ) scale_[idx] = 1.0 / gain;
+            }
+         }
+      }
+   }
+}
+
+// Number of KPiX addresses in the table
+uint KpixCalibTable::count ( ) {
+   return(serials_.size());
+}
+
+// Serial number of a KPiX address
+string KpixCalibTable::serial ( uint address ) {
+   if ( address >= serials_.size() ) return("");
+   return(serials_[address]);
+}
+
+// KPiX address of a serial number
+int KpixCalibTable::address ( string serial ) {
+   uint x;
+
+   for (x=0; x < serials_.size(); x++)
+      if ( serials_[x] == serial ) return(x);
+   return(-1);
+}
+
+// Get baseline mean value
+float KpixCalibTable::baseMean ( uint address, uint channel, uint bucket, uint range ) {
+   if ( address >= serials_.size() ) return(0.0);
+   return(mean_[tableIndex(address,channel,bucket,range)]);
+}
+
+// Get calibration gain
+float KpixCalibTable::calibGain ( uint address, uint channel, uint bucket, uint range ) {
+   if ( address >= serials_.size() ) return(0.0);
+   return(gain_[tableIndex(address,channel,bucket,range)]);
+}
+
+// Charge of a sample value
+float KpixCalibTable::charge ( uint address, uint channel, uint bucket, uint range, uint value ) {
+   uint idx;
+
+   if ( address >= serials_.size() ) return(0.0);
+   idx = tableIndex(address,channel,bucket,range);
+   return(((float)value - mean_[idx]) * scale_[idx]);
+}
+
+#ifdef KPIX_TABLE_SIMD
+
+// Convert eight samples at a time with AVX2 gathers
+__attribute__((target("avx2")))
+uint KpixCalibTable::chargeAvx2 ( KpixSampleBatch *batch, float *charge, uint start ) {
+   __m256i addr, chan, buck, rang, type, val, valid, idx;
+   __m256  mean, scale, res;
+   __m256i asics;
+   uint    x;
+
+   asics = _mm256_set1_epi32(serials_.size());
+
+   for (x=start; (x+8) <= batch->count(); x+=8) {
+      addr = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(batch->address()+x)));
+      chan = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(batch->channel()+x)));
+      val  = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(batch->value()+x)));
+      buck = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(batch->bucket()+x)));
+      rang = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(batch->range()+x)));
+      type = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(batch->type()+x)));
+
+      // Data samples of KPiX in the table, others read entry 0 and are cleared
+      valid = _mm256_and_si256(_mm256_cmpgt_epi32(asics,addr),
+                               _mm256_cmpeq_epi32(type,_mm256_set1_epi32(KpixSample::Data)));
+      idx   = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(addr,13),_mm256_slli_epi32(chan,3)),
+                              _mm256_or_si256(_mm256_slli_epi32(buck,1),rang));
+      idx   = _mm256_and_si256(idx,valid);
+
+      mean  = _mm256_i32gather_ps(&(mean_[0]),idx,4);
+      scale = _mm256_i32gather_ps(&(scale_[0]),idx,4);
+      res   = _mm256_mul_ps(_mm256_sub_ps(_mm256_cvtepi32_ps(val),mean),scale);
+      _mm256_storeu_ps(charge+x,_mm256_and_ps(res,_mm256_castsi256_ps(valid)));
+   }
+   return(x);
+}
+
+#else
+
+uint KpixCalibTable::chargeAvx2 ( KpixSampleBatch *batch, float *charge, uint start ) {
+   return(start);
+}
+
+#endif
+
+// Charge of decoded samples
+void KpixCalibTable::charge ( KpixSampleBatch *batch, float *charge ) {
+   const uint16_t *address;
+   const uint16_t *channel;
+   const uint16_t *value;
+   const uint8_t  *bucket;
+   const uint8_t  *range;
+   const uint8_t  *type;
+   uint            idx;
+   uint            x;
+
+   x = 0;
+#ifdef KPIX_TABLE_SIMD
+   if ( ! serials_.empty() && __builtin_cpu_supports("avx2") ) x = chargeAvx2(batch,charge,x);
+#endif
+
+   address = batch->address();
+   channel = batch->channel();
+   value   = batch->value();
+   bucket  = batch->bucket();
+   range   = batch->range();
+   type    = batch->type();
+
+   for (; x < batch->count(); x++) {
+      if ( address[x] >= serials_.size() || type[x] != KpixSample::Data ) charge[x] = 0;
+      else {
+         idx       = tableIndex(address[x],channel[x],bucket[x],range[x]);
+         charge[x] = ((float)value[x] - mean_[idx]) * scale_[idx];
+      }
+   }
+}
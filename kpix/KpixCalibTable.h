@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+// File          : KpixCalibTable.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : KPIX Control Software
+//-----------------------------------------------------------------------------
+// Description :
+// Calibration constants compiled into dense arrays. Baseline mean and gain
+// are stored as float in one array each, indexed by KPiX address, channel,
+// bucket and range. Serial numbers are resolved to addresses once when the
+// table is built from a KpixCalibRead.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __KPIX_CALIB_TABLE_H__
+#define __KPIX_CALIB_TABLE_H__
+#include <string>
+#include <vector>
+#include <sys/types.h>
+using namespace std;
+
+class KpixCalibRead;
+class KpixSampleBatch;
+
+//! Dense table of calibration constants
+class KpixCalibTable {
+
+      // Mean, gain and inverse gain, 0 where the gain is 0
+      vector<float> mean_;
+      vector<float> gain_;
+      vector<float> scale_;
+
+      // Serial number of each KPiX address
+      vector<string> serials_;
+
+      // Convert samples from index start on, returns the index converted up to
+      uint chargeAvx2 ( KpixSampleBatch *batch, float *charge, uint start );
+
+   public:
+
+      //! Constructor
+      KpixCalibTable ( );
+
+      //! Deconstructor
+      ~KpixCalibTable ( );
+
+      //! Build table
+      /*!
+       * \param calib   Parsed calibration data
+       * \param serials Serial number of each KPiX address, empty for none
+      */
+      void build ( KpixCalibRead *calib, vector<string> &serials );
+
+      //! Number of KPiX addresses in the table
+      uint count ( );
+
+      //! Serial number of a KPiX address
+      string serial ( uint address );
+
+      //! KPiX address of a serial number, -1 if not in the table
+      int address ( string serial );
+
+      //! Get baseline mean value
+      float baseMean ( uint address, uint channel, uint bucket, uint range );
+
+      //! Get calibration gain
+      float calibGain ( uint address, uint channel, uint bucket, uint range );
+
+      //! Charge of a sample value, 0 if there is no gain
+      float charge ( uint address, uint channel, uint bucket, uint range, uint value );
+
+      //! Charge of decoded samples
+      /*!
+       * Samples which are not data, of KPiX outside the table or
+       * without a gain are set to 0.
+       * \param batch  Decoded samples
+       * \param charge Charge of each sample, batch->count() entries
+      */
+      void charge ( KpixSampleBatch *batch, float *charge );
+};
+
+#endif
@@ -12,18 +12,22 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 04/12/2011: created
+// 10/17/2026: Added online calibration fit
 //-----------------------------------------------------------------------------
 #include <KpixControl.h>
 #include <OptoFpga.h>
 #include <ConFpga.h>
+#include <KpixAsic.h>
 #include <Register.h>
 #include <Variable.h>
 #include <Command.h>
 #include <CommLink.h>
+#include <RunPacer.h>
 #include <sstream>
 #include <iostream>
 #include <string>
 #include <iomanip>
+#include <string.h>
 using namespace std;
 bool wmqInKpixCon = false;
 
@@ -69,6 +73,24 @@ KpixControl::KpixControl ( CommLink *commLink, string defFile, uint kpixCount )
    rates[12] = "No Limit";
    getVariable("RunRate")->setEnums(rates);
 
+   addVariable(new Variable("RunCredits",Variable::Configuration));
+   getVariable("RunCredits")->setDescription("Maximum triggers outstanding in a No Limit run.\n"
+                                             "Timed and calibration runs always wait for each event.");
+   getVariable("RunCredits")->setRange(1,64);
+   getVariable("RunCredits")->setInt(1);
+
+   addVariable(new Variable("RunQueueLimit",Variable::Configuration));
+   getVariable("RunQueueLimit")->setDescription("No Limit runs hold the next trigger while this many received\n"
+                                                "frames are waiting for the data thread.");
+   getVariable("RunQueueLimit")->setRange(1,999);
+   getVariable("RunQueueLimit")->setInt(500);
+
+   addVariable(new Variable("RunLagLimit",Variable::Configuration));
+   getVariable("RunLagLimit")->setDescription("No Limit runs hold the next trigger while this many written\n"
+                                              "frames are waiting for the eudaq producer.");
+   getVariable("RunLagLimit")->setRange(1,1000000);
+   getVariable("RunLagLimit")->setInt(1000);
+
    // Data file nameing controls
    addVariable(new Variable("DataBase",Variable::Configuration));
    getVariable("DataBase")->setDescription("Base directory for auto data data files");
@@ -113,6 +135,31 @@ KpixControl::KpixControl ( CommLink *commLink, string defFile, uint kpixCount )
    getVariable("CalChanMax")->setRange(0,1023);
    getVariable("CalChanMax")->setInt(1023);
 
+   addVariable(new Variable("CalChanStride",Variable::Configuration));
+   getVariable("CalChanStride")->setDescription("Calibration channel spacing for parallel injection.\n"
+                                                "Channels CalChannel, CalChannel+CalChanStride, ... up to CalChanMax\n"
+                                                "are injected together, stepping CalChannel through the first\n"
+                                                "CalChanStride channels. 0 or 1 injects one channel per step.");
+   getVariable("CalChanStride")->setRange(0,1024);
+   getVariable("CalChanStride")->setInt(0);
+
+   addVariable(new Variable("CalChanSettle",Variable::Configuration));
+   getVariable("CalChanSettle")->setDescription("Settle time in uS after the calibration channel changes,\n"
+                                                "applied after the registers are written and before the next trigger.");
+   getVariable("CalChanSettle")->setRange(0,10000000);
+   getVariable("CalChanSettle")->setInt(100000);
+
+   addVariable(new Variable("CalPhaseSettle",Variable::Configuration));
+   getVariable("CalPhaseSettle")->setDescription("Settle time in uS when calibration moves from baseline to injection,\n"
+                                                 "applied after the registers are written and before the next trigger.");
+   getVariable("CalPhaseSettle")->setRange(0,10000000);
+   getVariable("CalPhaseSettle")->setInt(100000);
+
+   addVariable(new Variable("CalOnlineFile",Variable::Configuration));
+   getVariable("CalOnlineFile")->setDescription("Calibration xml file fitted from the data of a calibration run\n"
+                                                "as it is taken, written when the run ends. Empty to disable.");
+   getVariable("CalOnlineFile")->set("");
+
    addVariable(new Variable("CalState",Variable::Status));
    getVariable("CalState")->setDescription("Calibration state");
    vector<string> calState;
@@ -132,6 +179,12 @@ KpixControl::KpixControl ( CommLink *commLink, string defFile, uint kpixCount )
    getVariable("CalDac")->setComp(0,1,0,"");
    getVariable("CalDac")->setInt(0);
 
+   addVariable(new Variable("CalStepRate",Variable::Status));
+   getVariable("CalStepRate")->setDescription("Calibration points per second during injection");
+
+   addVariable(new Variable("CalDeadTime",Variable::Status));
+   getVariable("CalDeadTime")->setDescription("Fraction of the calibration run spent reconfiguring and settling");
+
    addVariable(new Variable("UserDataA",Variable::Configuration));
    getVariable("UserDataA")->setDescription("User defined data field");
 
@@ -186,24 +239,102 @@ void KpixControl::calibConfig ( uint channel, uint dac ) {
    newConfig << "</kpixAsic></cntrlFpga></config></system>\n";
    parseXml(newConfig.str(),false);
 
-   // Update a few status variables in data file
-   newConfig.str("");
-   newConfig << "<status>" << endl;
-   newConfig << "<CalState>"   << getVariable("CalState")->get()   << "</CalState>" << endl;
-   newConfig << "<CalChannel>" << getVariable("CalChannel")->get() << "</CalChannel>" << endl;
-   newConfig << "<CalDac>"     << getVariable("CalDac")->get()     << "</CalDac>" << endl;
-   newConfig << "</status>" << endl;
-   commLink_->addStatus(newConfig.str());
-   usleep(100);
+   // Mark calibration state in data file
+   commLink_->addCalMarker(getVariable("CalState")->getInt(),channel,dac,1);
+}
+
+// Prepare the injection mask of the next calibration point. Channels
+// channel, channel+stride, ... up to last are injected, a stride of 0 or 1
+// injects channel only.
+void KpixControl::calibPrepare ( uint channel, uint stride, uint last ) {
+   uint x;
+
+   memset(calMask_,0,sizeof(calMask_));
+   if ( stride <= 1 ) {
+      if ( channel < 1024 ) calMask_[channel/32] |= (1 << (channel%32));
+   }
+   else for (x=channel; x <= last && x < 1024; x += stride) calMask_[x/32] |= (1 << (x%32));
+}
+
+// Write the prepared calibration point. Only the calibration dac and the
+// channel mode registers which change are written.
+void KpixControl::calibCommit ( uint channel, uint stride, uint dac ) {
+   Device *fpga;
+   uint    x;
+
+   fpga = device("cntrlFpga",0);
+   for (x=0; x < fpga->deviceCount("kpixAsic"); x++) {
+      KpixAsic *asic = (KpixAsic *)fpga->device("kpixAsic",x);
+      asic->setCalibDac(dac);
+      asic->setCalibMask(calMask_);
+   }
+
+   // Mark calibration state in data file
+   commLink_->addCalMarker(getVariable("CalState")->getInt(),channel,dac,(stride==0)?1:stride);
+}
+
+// Time in seconds for calibration statistics
+static double calibTime ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Attach online calibration accumulators. KPiX settings are taken from
+// the devices, the configuration record may precede the attach.
+void KpixControl::calibOnlineStart ( ) {
+   Device *fpga;
+   Device *asic;
+   uint    x;
+
+   calibOnlineFile_ = getVariable("CalOnlineFile")->get();
+   if ( calibOnlineFile_ == "" ) return;
+
+   calibOnline_.reset();
+   fpga = device("cntrlFpga",0);
+   for (x=0; x < fpga->deviceCount("kpixAsic") && x < KpixCalibFit::MaxAsics; x++) {
+      asic = fpga->device("kpixAsic",x);
+      if ( asic->get("SerialNumber") == "" ) continue;
+      calibOnline_.setAsic(x,asic->get("SerialNumber"),(asic->get("CntrlPolarity") == "Positive"),
+                                                       (asic->get("CntrlCalibHigh") == "True"));
+   }
+   calibOnline_.setChanMax(getVariable("CalChanMax")->getInt());
+   commLink_->addDataSink(&calibOnline_);
+}
+
+// Detach online calibration accumulators and write the results
+void KpixControl::calibOnlineFinish ( ) {
+   double start;
+
+   if ( calibOnlineFile_ == "" ) return;
+
+   // Events of the run still queued are passed on before the detach
+   if ( ! commLink_->waitDataDrain(5000000) )
+      cout << "KpixControl::runThread -> Timeout waiting for queued data, " << dec << commLink_->dataQueueDepth()
+           << " records are not in the calibration fit" << endl;
+   commLink_->removeDataSink(&calibOnline_);
+
+   start = calibTime();
+   if ( calibOnline_.finish(calibOnlineFile_,"online") )
+      cout << "KpixControl::runThread -> Calibration fit of " << dec << calibOnline_.events() << " events written to "
+           << calibOnlineFile_ << " in " << fixed << setprecision(2) << (calibTime() - start) << " sec" << endl;
+   else cout << "KpixControl::runThread -> Failed to write calibration fit to " << calibOnlineFile_ << endl;
 }
 
 void KpixControl::swRunThread() {
-   struct timespec tme;
-   ulong           ctime;
-   ulong           ltime;
+   RunPacer        pacer;
+   double          waitStart;
    uint            runTotal;
    uint            stepTotal;
    uint            lastData;
+   uint            currData;
+   uint            events;
+   uint            issued;
+   uint            credits;
+   uint            queueLimit;
+   uint            lagLimit;
+   uint            throttled;
+   bool            throttle;
    uint            calMeanCount;
    uint            calDacCount;
    uint            calDacMin;
@@ -211,9 +342,28 @@ void KpixControl::swRunThread() {
    uint            calDacStep;
    uint            calChanMin;
    uint            calChanMax;
+   uint            calChanStride;
+   uint            calChanLast;
+   uint            calChanSettle;
+   uint            calPhaseSettle;
    uint            calTotal;
    uint            calChan;
    uint            calDac;
+   uint            calNextChan;
+   uint            calNextDac;
+   uint            calSettle;
+   uint            calSteps;
+   bool            calRun;
+   bool            calInject;
+   bool            calNextSettle;
+   bool            calNextDone;
+   bool            calPrepare;
+   double          calStart;
+   double          calInjectStart;
+   double          calDead;
+   double          calDeadStart;
+   double          calNow;
+   stringstream    calStat;
    bool            gotEvent;
    stringstream    oldConfig;
    stringstream    xml;
@@ -226,10 +376,10 @@ void KpixControl::swRunThread() {
    lastData    = commLink_->dataRxCount();
    runTotal    = 0;
    stepTotal   = 0;
+   issued      = 0;
+   throttled   = 0;
    swRunning_  = true;
    swRunError_ = "";
-   clock_gettime(CLOCK_REALTIME,&tme);
-   ltime = (tme.tv_sec * 1000000) + (tme.tv_nsec/1000);
 
    // Show start
    if ( debug_ ) {
@@ -247,7 +397,10 @@ void KpixControl::swRunThread() {
       writeConfig(false);
 
       // Calibration run enabled
-      if ( getVariable("RunState")->get() == "Running Calibration" ) {
+      calRun     = (getVariable("RunState")->get() == "Running Calibration");
+      calInject  = false;
+      calPrepare = false;
+      if ( calRun ) {
          calMeanCount = getVariable("CalMeanCount")->getInt();
          calDacCount  = getVariable("CalDacCount")->getInt();
          calDacMin    = getVariable("CalDacMin")->getInt();
@@ -255,13 +408,26 @@ void KpixControl::swRunThread() {
          calDacStep   = getVariable("CalDacStep")->getInt();
          calChanMin   = getVariable("CalChanMin")->getInt();
          calChanMax   = getVariable("CalChanMax")->getInt();
-         calTotal     = calMeanCount + ((calChanMax - calChanMin + 1) * ((calDacMax - calDacMin + 1)/calDacStep) * calDacCount);
+         calChanStride = getVariable("CalChanStride")->getInt();
+         calChanSettle  = getVariable("CalChanSettle")->getInt();
+         calPhaseSettle = getVariable("CalPhaseSettle")->getInt();
+
+         // Parallel injection steps through the first stride channels only,
+         // a stride of 0 or 1 steps through every channel one at a time
+         if ( calChanStride == 0 ) calChanStride = 1;
+         calChanLast  = calChanMax;
+         if ( calChanStride > 1 && calChanMin + calChanStride - 1 < calChanMax ) calChanLast = calChanMin + calChanStride - 1;
+
+         calTotal     = calMeanCount + ((calChanLast - calChanMin + 1) * ((calDacMax - calDacMin + 1)/calDacStep) * calDacCount);
          calChan      = calChanMin;
          calDac       = calDacMin;
 
          // Save old configuration
          oldConfig << "<system>" << endl << configString(true,false) << "</system>" << endl;
 
+         // Accumulate from the first calibration marker on
+         calibOnlineStart();
+
          // Update variables
          getVariable("CalState")->set("Baseline");
          getVariable("CalChannel")->setInt(0);
@@ -269,30 +435,44 @@ void KpixControl::swRunThread() {
 
          // Update config
          calibConfig(9999,calDac);
+
+         // First injection point, written when the baseline is done
+         calNextChan   = calChanMin;
+         calNextDac    = calDacMin;
+         calNextSettle = false;
+         calNextDone   = false;
+         calibPrepare(calNextChan,calChanStride,calChanMax);
+
+         calSteps       = 0;
+         calDead        = 0;
+         calStart       = calibTime();
+         calInjectStart = calStart;
       }
       else getVariable("CalState")->set("Idle");
 
-      // Run
-      while ( swRunEnable_ ) {
+      // Outstanding triggers allowed. Calibration and timed runs wait for each
+      // event, no limit runs keep up to RunCredits triggers in flight.
+      credits = getVariable("RunCredits")->getInt();
+      if ( calRun || swRunPeriod_ != 0 || credits == 0 ) credits = 1;
 
-         // Delay between attempts
-         do {
-            usleep(1);
-            clock_gettime(CLOCK_REALTIME,&tme);
-            ctime = (tme.tv_sec * 1000000) + (tme.tv_nsec/1000);
-         } while ( (ctime-ltime) < swRunPeriod_);
+      // No limit runs also hold triggers while the data pipeline is backed up
+      throttle   = ( !calRun && swRunPeriod_ == 0 );
+      queueLimit = getVariable("RunQueueLimit")->getInt();
+      lagLimit   = getVariable("RunLagLimit")->getInt();
 
-         // Check that we received a data frame
-         gotEvent = true;
+      // Run
+      pacer.start(swRunPeriod_);
+      while ( swRunEnable_ ) {
 
-         while ( commLink_->dataRxCount() == lastData ) {
-            usleep(1);
-            clock_gettime(CLOCK_REALTIME,&tme);
-            ctime = (tme.tv_sec * 1000000) + (tme.tv_nsec/1000);
+         // Wait for a data frame when no credit is free
+         gotEvent  = true;
+         waitStart = RunPacer::now();
+         while ( issued >= credits || (!calRun && swRunCount_ != 0 && runTotal + issued >= swRunCount_) ) {
+            if ( commLink_->waitData(lastData,100000) ) break;
 
             // One second has passed. event was missed.
-            if ( (ctime-ltime) > 1000000) {
-               ltime = ctime;
+            if ( (RunPacer::now() - waitStart) > 1000000 ) {
+               waitStart = RunPacer::now();
 
                // In Simulation just make some noise
                if ( getInt("Simulation") ) {
@@ -313,78 +493,116 @@ void KpixControl::swRunThread() {
          }
          if ( !swRunEnable_ ) break; 
 
+         // Return credits for received events, a missed event frees its credit
+         currData = commLink_->dataRxCount();
+         events   = currData - lastData;
+         lastData = currData;
+         if ( events > issued ) events = issued;
+         issued -= events;
+         if ( !gotEvent && issued > 0 ) issued--;
+
          // Setup next calibration data point
-         if ( getVariable("RunState")->get() == "Running Calibration" ) {
-            if ( gotEvent ) {
-               runTotal++;
-               stepTotal++;
-            }
+         if ( calRun ) {
+            runTotal  += events;
+            stepTotal += events;
             getVariable("RunProgress")->setInt((uint)(((double)runTotal/(double)calTotal)*100.0));
 
-            // running baseline
-            if ( gotEvent && getVariable("CalState")->get() == "Baseline" ) {
-
-               // Mean run is done
-               if ( runTotal >= calMeanCount ) {
-
-                  // Cal count value is zero
-                  if ( calDacCount == 0 ) break;
-
-                  // Setup calibration
-                  else {
-                     usleep(100000);
-                     getVariable("CalState")->set("Inject");
-                     calChan = calChanMin;
-                     calDac  = calDacMin;
-                     getVariable("CalChannel")->setInt(calChan);
-                     getVariable("CalDac")->setInt(calDac);
-                     calibConfig(calChan,calDac);
-                     stepTotal = 0;
-                  }
-               }
-            }
-
-            // running calibration
-            else if ( gotEvent && getVariable("CalState")->get() == "Inject" ) {
-
-               // Have we taken enough points at this value?
-               if ( stepTotal >= calDacCount ) {
-
-                  // Increment cal dac
-                  calDac += calDacStep;
-                  if ( calDac > calDacMax ) {
-                     usleep(100000);
-                     calDac = calDacMin;
-                     calChan++;
-                  }
+            // Baseline or the current point is done, write the prepared point
+            if ( events > 0 && ((!calInject && runTotal >= calMeanCount) || (calInject && stepTotal >= calDacCount)) ) {
+               calDeadStart = calibTime();
 
-                  // Are we done?
-                  if ( calChan > calChanMax ) break;
+               // Cal count value is zero or all points are done
+               if ( calDacCount == 0 || calNextDone ) break;
 
-                  // Write config
-                  getVariable("CalChannel")->setInt(calChan);
-                  getVariable("CalDac")->setInt(calDac);
-                  calibConfig(calChan,calDac);
-                  stepTotal = 0;
+               if ( ! calInject ) {
+                  getVariable("CalState")->set("Inject");
+                  calInject      = true;
+                  calInjectStart = calDeadStart;
+                  calSettle      = calPhaseSettle;
                }
+               else calSettle = calNextSettle?calChanSettle:0;
+
+               calChan = calNextChan;
+               calDac  = calNextDac;
+               getVariable("CalChannel")->setInt(calChan);
+               getVariable("CalDac")->setInt(calDac);
+               calibCommit(calChan,calChanStride,calDac);
+               stepTotal = 0;
+               calSteps++;
+
+               // Settle after the registers are written, before the next trigger
+               if ( calSettle > 0 ) usleep(calSettle);
+
+               calNow   = calibTime();
+               calDead += (calNow - calDeadStart);
+               calPrepare = true;
+
+               // Statistics
+               calStat.str("");
+               calStat << fixed << setprecision(1) << ((calSteps > 1)?((calSteps-1) / (calNow - calInjectStart)):0.0) << " steps/s";
+               getVariable("CalStepRate")->set(calStat.str());
+               calStat.str("");
+               calStat << fixed << setprecision(1) << ((calDead * 100.0) / (calNow - calStart)) << " %";
+               getVariable("CalDeadTime")->set(calStat.str());
             }
          }
          else {
 	   //std::cout<<"[DEV] I am here!";
-            if ( gotEvent ) runTotal++;
+            runTotal += events;
             if ( swRunCount_ == 0 ) getVariable("RunProgress")->setInt(0);
             else getVariable("RunProgress")->setInt((uint)(((double)runTotal/(double)swRunCount_)*100.0));
             if ( swRunCount_ != 0 && runTotal >= swRunCount_ ) break;
+            if ( swRunCount_ != 0 && runTotal + issued >= swRunCount_ ) continue;
+         }
+
+         // Back-pressure, wait for the data thread and the eudaq producer to drain
+         if ( throttle && (commLink_->dataQueueDepth() >= queueLimit || commLink_->dataWriteLag() >= lagLimit) ) {
+            throttled++;
+            while ( swRunEnable_ && (commLink_->dataQueueDepth() >= queueLimit || commLink_->dataWriteLag() >= lagLimit) )
+               commLink_->waitData(commLink_->dataRxCount(),1000);
+            if ( !swRunEnable_ ) break;
          }
 
-         // Execute command
-         lastData = commLink_->dataRxCount();
-         ltime = ctime;
+         // Execute command on the next deadline
+         pacer.wait();
+         if ( !swRunEnable_ ) break;
          commLink_->queueRunCommand();
+         pacer.trigger();
+         issued++;
+
+         // Prepare the following calibration point while this acquisition is in flight
+         if ( calPrepare ) {
+            calNextChan   = calChan;
+            calNextDac    = calDac + calDacStep;
+            calNextSettle = false;
+            if ( calNextDac > calDacMax ) {
+               calNextDac    = calDacMin;
+               calNextChan   = calChan + 1;
+               calNextSettle = true;
+            }
+            calNextDone = (calNextChan > calChanLast);
+            if ( ! calNextDone ) calibPrepare(calNextChan,calChanStride,calChanMax);
+            calPrepare = false;
+         }
+      }
+
+      // Trigger statistics
+      getVariable("RunTriggerStats")->set(pacer.stats());
+      if ( debug_ ) {
+         cout << "KpixControl::runThread -> " << pacer.stats()
+              << ", Throttled=" << dec << throttled
+              << ", Dropped=" << dec << commLink_->dataDropCount() << endl;
       }
 
       // Restore configuration here
-      if ( getVariable("RunState")->get() == "Running Calibration" ) {
+      if ( calRun ) {
+         calNow = calibTime();
+         cout << "KpixControl::runThread -> Calibration points=" << dec << calSteps
+              << ", Steps/s=" << fixed << setprecision(1) << ((calSteps > 1)?((calSteps-1) / (calNow - calInjectStart)):0.0)
+              << ", DeadTime=" << ((calDead * 100.0) / (calNow - calStart)) << "%" << endl;
+
+         calibOnlineFinish();
+
          getVariable("CalState")->set("Idle");
          getVariable("CalChannel")->setInt(0);
          parseXml(oldConfig.str(),false);
@@ -399,6 +617,7 @@ void KpixControl::swRunThread() {
    } catch (string error) { swRunError_ = error; }
 
    // Cleanup
+   commLink_->removeDataSink(&calibOnline_);
    sleep(1);
 
    getVariable("RunState")->set(swRunRetState_);
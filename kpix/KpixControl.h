@@ -12,11 +12,13 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 11/20/2011: created
+// 10/17/2026: Added online calibration fit
 //-----------------------------------------------------------------------------
 #ifndef __KPIX_CONTROL_H__
 #define __KPIX_CONTROL_H__
 
 #include <System.h>
+#include <KpixCalibOnline.h>
 using namespace std;
 
 class CommLink;
@@ -27,6 +29,25 @@ class KpixControl : public System {
       // setup calibration config
       void calibConfig ( uint channel, uint dac );
 
+      // Injection mask of the prepared calibration point
+      uint calMask_[32];
+
+      // prepare injection mask for the next calibration point
+      void calibPrepare ( uint channel, uint stride, uint last );
+
+      // write calibration dac and prepared mask
+      void calibCommit ( uint channel, uint stride, uint dac );
+
+      // Calibration accumulators fed by the data thread during calibration runs
+      KpixCalibOnline calibOnline_;
+      string          calibOnlineFile_;
+
+      // attach online calibration accumulators
+      void calibOnlineStart ( );
+
+      // detach online calibration accumulators and write the results
+      void calibOnlineFinish ( );
+
       // Software run thread
       void swRunThread();
 
@@ -26,6 +26,7 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 05/29/2012: created
+// 10/17/2026: Sample count computed once per event
 //----------------------------------------------------------------------------
 #include <iostream>
 #include <string>
@@ -39,7 +40,9 @@
 using namespace std;
 
 // Constructor
-KpixEvent::KpixEvent () : Data() { }
+KpixEvent::KpixEvent () : Data() {
+   update();
+}
 
 // Deconstructor
 KpixEvent::~KpixEvent () { }
@@ -54,21 +57,28 @@ uint KpixEvent::timestamp ( ) {
    return(data_[1]);
 }
 
-// Get sample count
-uint KpixEvent::count ( ) {
+// Update sample count after new data
+void KpixEvent::update ( ) {
    uint rem = 0;
-   if ( size_ <= (headSize_ + tailSize_)) return(0);
+
+   count_ = 0;
+   if ( size_ <= (headSize_ + tailSize_)) return;
 
    rem = (size_-(headSize_ + tailSize_));
 
-   if ( (rem % sampleSize_) != 0 ) return(0);
+   if ( (rem % sampleSize_) != 0 ) return;
 
-   return(rem/sampleSize_);
+   count_ = rem/sampleSize_;
+}
+
+// Get sample count
+uint KpixEvent::count ( ) {
+   return(count_);
 }
 
 // Get sample at index
 KpixSample *KpixEvent::sample (uint index) {
-   if ( index >= count() ) return(NULL);
+   if ( index >= count_ ) return(NULL);
    else {
       sample_.setData(&(data_[headSize_+(index*sampleSize_)]),eventNumber());
       return(&sample_);
@@ -79,7 +89,7 @@ KpixSample *KpixEvent::sample (uint index) {
 KpixSample *KpixEvent::sampleCopy (uint index) {
    KpixSample *tmp;
 
-   if ( index >= count() ) return(NULL);
+   if ( index >= count_ ) return(NULL);
    else {
       tmp = new KpixSample (&(data_[headSize_+(index*sampleSize_)]),eventNumber());
       return(tmp);
@@ -26,6 +26,7 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 05/29/2012: created
+// 10/17/2026: Sample count computed once per event
 //----------------------------------------------------------------------------
 #ifndef __KPIX_EVENT_H__
 #define __KPIX_EVENT_H__
@@ -50,6 +51,14 @@ class KpixEvent : public Data {
       // Internal sample contrainer
       KpixSample sample_;
 
+      // Sample count of the current data
+      uint count_;
+
+   protected:
+
+      // Update sample count after new data
+      void update ( );
+
    public:
 
       //! Constructor
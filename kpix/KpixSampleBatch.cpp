@@ -0,0 +1,279 @@
+//-----------------------------------------------------------------------------
+// File          : KpixSampleBatch.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix DAQ
+//-----------------------------------------------------------------------------
+// Description :
+// Samples of an event decoded into one array per field. All samples are
+// decoded in a single pass, eight at a time with AVX2 or four at a time with
+// SSE2 where available. A filtered decode keeps the samples of one KPiX
+// and/or one sample type.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#include <string.h>
+#include "KpixSampleBatch.h"
+#include "KpixEvent.h"
+using namespace std;
+
+#if defined(__x86_64__) || defined(__SSE2__)
+#define KPIX_BATCH_SIMD
+#include <immintrin.h>
+#endif
+
+// Sample words start after the 8 word header
+#define KPIX_BATCH_HEAD 8
+
+// Constructor
+KpixSampleBatch::KpixSampleBatch ( ) {
+   count_       = 0;
+   eventNumber_ = 0;
+}
+
+// Deconstructor
+KpixSampleBatch::~KpixSampleBatch ( ) { }
+
+// Decode samples one at a time
+uint KpixSampleBatch::decodeScalar ( const uint *data, uint start, uint count ) {
+   uint w0;
+   uint w1;
+   uint x;
+
+   for (x=start; x < count; x++) {
+      w0 = data[2*x];
+      w1 = data[2*x+1];
+      address_[x] = (w0 >> 16) & 0xFFF;
+      channel_[x] = w0 & 0x3FF;
+      bucket_[x]  = (w0 >> 10) & 0x3;
+      range_[x]   = (w0 >> 13) & 0x1;
+      flags_[x]   = ((w0 >> 15) & Empty) | ((w0 >> 13) & BadCount) | ((w0 >> 10) & TrigType);
+      type_[x]    = (w0 >> 28) & 0xF;
+      time_[x]    = (w1 >> 16) & 0x1FFF;
+      value_[x]   = w1 & 0x1FFF;
+   }
+   return(count);
+}
+
+#ifdef KPIX_BATCH_SIMD
+
+// Store four 32-bit lanes as 16 and 8 bit values, all fields fit in 15 bits
+static inline void store16 ( uint16_t *dst, __m128i v ) {
+   _mm_storel_epi64((__m128i *)dst,_mm_packs_epi32(v,v));
+}
+
+static inline void store8 ( uint8_t *dst, __m128i v ) {
+   int32_t tmp;
+   v   = _mm_packs_epi32(v,v);
+   tmp = _mm_cvtsi128_si32(_mm_packus_epi16(v,v));
+   memcpy(dst,&tmp,4);
+}
+
+// Decode four samples at a time with SSE2
+uint KpixSampleBatch::decodeSse ( const uint *data, uint start, uint count ) {
+   __m128i a, b, w0, w1;
+   __m128i m1, m3, mc, mf;
+   uint    x;
+
+   m1 = _mm_set1_epi32(0x1);
+   m3 = _mm_set1_epi32(0x3);
+   mc = _mm_set1_epi32(0x3FF);
+   mf = _mm_set1_epi32(0xFFF);
+
+   for (x=start; (x+4) <= count; x+=4) {
+
+      // Split the word pairs of four samples
+      a  = _mm_loadu_si128((const __m128i *)(data+2*x));
+      b  = _mm_loadu_si128((const __m128i *)(data+2*x+4));
+      w0 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),_mm_castsi128_ps(b),_MM_SHUFFLE(2,0,2,0)));
+      w1 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a),_mm_castsi128_ps(b),_MM_SHUFFLE(3,1,3,1)));
+
+      store16(&(address_[x]),_mm_and_si128(_mm_srli_epi32(w0,16),mf));
+      store16(&(channel_[x]),_mm_and_si128(w0,mc));
+      store8(&(bucket_[x]),  _mm_and_si128(_mm_srli_epi32(w0,10),m3));
+      store8(&(range_[x]),   _mm_and_si128(_mm_srli_epi32(w0,13),m1));
+      store8(&(flags_[x]),   _mm_or_si128(_mm_or_si128(
+                                _mm_and_si128(_mm_srli_epi32(w0,15),_mm_set1_epi32(Empty)),
+                                _mm_and_si128(_mm_srli_epi32(w0,13),_mm_set1_epi32(BadCount))),
+                                _mm_and_si128(_mm_srli_epi32(w0,10),_mm_set1_epi32(TrigType))));
+      store8(&(type_[x]),    _mm_srli_epi32(w0,28));
+      store16(&(time_[x]),   _mm_and_si128(_mm_srli_epi32(w1,16),_mm_set1_epi32(0x1FFF)));
+      store16(&(value_[x]),  _mm_and_si128(w1,_mm_set1_epi32(0x1FFF)));
+   }
+   return(x);
+}
+
+// Store eight 32-bit lanes as 16 and 8 bit values
+__attribute__((target("avx2")))
+static inline __m128i pack16 ( __m256i v ) {
+   return(_mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi32(v,v),0x08)));
+}
+
+__attribute__((target("avx2")))
+static inline void store16x8 ( uint16_t *dst, __m256i v ) {
+   _mm_storeu_si128((__m128i *)dst,pack16(v));
+}
+
+__attribute__((target("avx2")))
+static inline void store8x8 ( uint8_t *dst, __m256i v ) {
+   __m128i p = pack16(v);
+   _mm_storel_epi64((__m128i *)dst,_mm_packus_epi16(p,p));
+}
+
+// Decode eight samples at a time with AVX2
+__attribute__((target("avx2")))
+uint KpixSampleBatch::decodeAvx2 ( const uint *data, uint start, uint count ) {
+   __m256 a, b;
+   __m256i w0, w1;
+   __m256i m1, m3, mc, mf, mt;
+   uint    x;
+
+   m1 = _mm256_set1_epi32(0x1);
+   m3 = _mm256_set1_epi32(0x3);
+   mc = _mm256_set1_epi32(0x3FF);
+   mf = _mm256_set1_epi32(0xFFF);
+   mt = _mm256_set1_epi32(0x1FFF);
+
+   for (x=start; (x+8) <= count; x+=8) {
+
+      // Split the word pairs of eight samples, the shuffle leaves them in the
+      // order 0,1,4,5,2,3,6,7 which the permute restores
+      a  = _mm256_loadu_ps((const float *)(data+2*x));
+      b  = _mm256_loadu_ps((const float *)(data+2*x+8));
+      w0 = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(a,b,_MM_SHUFFLE(2,0,2,0))),_MM_SHUFFLE(3,1,2,0));
+      w1 = _mm256_permute4x64_epi64(_mm256_castps_si256(_mm256_shuffle_ps(a,b,_MM_SHUFFLE(3,1,3,1))),_MM_SHUFFLE(3,1,2,0));
+
+      store16x8(&(address_[x]),_mm256_and_si256(_mm256_srli_epi32(w0,16),mf));
+      store16x8(&(channel_[x]),_mm256_and_si256(w0,mc));
+      store8x8(&(bucket_[x]),  _mm256_and_si256(_mm256_srli_epi32(w0,10),m3));
+      store8x8(&(range_[x]),   _mm256_and_si256(_mm256_srli_epi32(w0,13),m1));
+      store8x8(&(flags_[x]),   _mm256_or_si256(_mm256_or_si256(
+                                  _mm256_and_si256(_mm256_srli_epi32(w0,15),_mm256_set1_epi32(Empty)),
+                                  _mm256_and_si256(_mm256_srli_epi32(w0,13),_mm256_set1_epi32(BadCount))),
+                                  _mm256_and_si256(_mm256_srli_epi32(w0,10),_mm256_set1_epi32(TrigType))));
+      store8x8(&(type_[x]),    _mm256_srli_epi32(w0,28));
+      store16x8(&(time_[x]),   _mm256_and_si256(_mm256_srli_epi32(w1,16),mt));
+      store16x8(&(value_[x]),  _mm256_and_si256(w1,mt));
+   }
+   return(x);
+}
+
+#else
+
+uint KpixSampleBatch::decodeSse ( const uint *data, uint start, uint count ) {
+   return(start);
+}
+
+uint KpixSampleBatch::decodeAvx2 ( const uint *data, uint start, uint count ) {
+   return(start);
+}
+
+#endif
+
+// Keep samples matching the filter
+void KpixSampleBatch::filter ( int address, int type ) {
+   uint x;
+   uint y;
+
+   for (x=0, y=0; x < count_; x++) {
+      address_[y] = address_[x];
+      channel_[y] = channel_[x];
+      bucket_[y]  = bucket_[x];
+      range_[y]   = range_[x];
+      flags_[y]   = flags_[x];
+      type_[y]    = type_[x];
+      time_[y]    = time_[x];
+      value_[y]   = value_[x];
+      y += ( (address < 0 || address_[x] == address) && (type < 0 || type_[x] == type) );
+   }
+   count_ = y;
+}
+
+// Decode samples of an event
+uint KpixSampleBatch::decode ( KpixEvent *event, int address, int type ) {
+   const uint *data;
+   uint        size;
+   uint        x;
+
+   count_       = event->count();
+   eventNumber_ = (event->size() > 0)?event->eventNumber():0;
+   if ( count_ == 0 ) return(0);
+
+   size = (count_ + 7) & ~7;
+   if ( address_.size() < size ) {
+      address_.resize(size);
+      channel_.resize(size);
+      bucket_.resize(size);
+      range_.resize(size);
+      flags_.resize(size);
+      type_.resize(size);
+      time_.resize(size);
+      value_.resize(size);
+   }
+
+   data = event->data() + KPIX_BATCH_HEAD;
+   x    = 0;
+
+#ifdef KPIX_BATCH_SIMD
+   if ( __builtin_cpu_supports("avx2") ) x = decodeAvx2(data,x,count_);
+   x = decodeSse(data,x,count_);
+#endif
+   decodeScalar(data,x,count_);
+
+   if ( address >= 0 || type >= 0 ) filter(address,type);
+   return(count_);
+}
+
+// Number of decoded samples
+uint KpixSampleBatch::count ( ) {
+   return(count_);
+}
+
+// Event number of the decoded samples
+uint KpixSampleBatch::eventNumber ( ) {
+   return(eventNumber_);
+}
+
+// KPiX address of each sample
+const uint16_t *KpixSampleBatch::address ( ) {
+   return(address_.empty()?NULL:&(address_[0]));
+}
+
+// KPiX channel of each sample
+const uint16_t *KpixSampleBatch::channel ( ) {
+   return(channel_.empty()?NULL:&(channel_[0]));
+}
+
+// Bucket of each sample
+const uint8_t *KpixSampleBatch::bucket ( ) {
+   return(bucket_.empty()?NULL:&(bucket_[0]));
+}
+
+// Range of each sample
+const uint8_t *KpixSampleBatch::range ( ) {
+   return(range_.empty()?NULL:&(range_[0]));
+}
+
+// Time of each sample
+const uint16_t *KpixSampleBatch::time ( ) {
+   return(time_.empty()?NULL:&(time_[0]));
+}
+
+// ADC value of each sample
+const uint16_t *KpixSampleBatch::value ( ) {
+   return(value_.empty()?NULL:&(value_[0]));
+}
+
+// SampleFlags of each sample
+const uint8_t *KpixSampleBatch::flags ( ) {
+   return(flags_.empty()?NULL:&(flags_[0]));
+}
+
+// KpixSample::SampleType of each sample
+const uint8_t *KpixSampleBatch::type ( ) {
+   return(type_.empty()?NULL:&(type_[0]));
+}
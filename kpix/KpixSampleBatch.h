@@ -0,0 +1,110 @@
+//-----------------------------------------------------------------------------
+// File          : KpixSampleBatch.h
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix DAQ
+//-----------------------------------------------------------------------------
+// Description :
+// Samples of an event decoded into one array per field. All samples are
+// decoded in a single pass, eight at a time with AVX2 or four at a time with
+// SSE2 where available. A filtered decode keeps the samples of one KPiX
+// and/or one sample type.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//-----------------------------------------------------------------------------
+#ifndef __KPIX_SAMPLE_BATCH_H__
+#define __KPIX_SAMPLE_BATCH_H__
+#include <vector>
+#include <stdint.h>
+#include <sys/types.h>
+using namespace std;
+
+class KpixEvent;
+
+//! Samples of an event as structure of arrays
+class KpixSampleBatch {
+
+      // Fields, sized to a multiple of eight samples
+      vector<uint16_t> address_;
+      vector<uint16_t> channel_;
+      vector<uint16_t> time_;
+      vector<uint16_t> value_;
+      vector<uint8_t>  bucket_;
+      vector<uint8_t>  range_;
+      vector<uint8_t>  flags_;
+      vector<uint8_t>  type_;
+
+      // Decoded samples
+      uint count_;
+
+      // Event number of the samples
+      uint eventNumber_;
+
+      // Decode samples from index start on, returns the index decoded up to
+      uint decodeScalar ( const uint *data, uint start, uint count );
+      uint decodeSse    ( const uint *data, uint start, uint count );
+      uint decodeAvx2   ( const uint *data, uint start, uint count );
+
+      // Keep samples matching the filter
+      void filter ( int address, int type );
+
+   public:
+
+      //! Sample flag bits
+      enum SampleFlags {
+         Empty    = 0x1,
+         BadCount = 0x2,
+         TrigType = 0x4
+      };
+
+      //! Constructor
+      KpixSampleBatch ( );
+
+      //! Deconstructor
+      ~KpixSampleBatch ( );
+
+      //! Decode samples of an event
+      /*!
+       * Returns the number of samples kept.
+       * \param event   Event to decode
+       * \param address Keep samples of this KPiX only, -1 for all
+       * \param type    Keep samples of this KpixSample::SampleType only, -1 for all
+      */
+      uint decode ( KpixEvent *event, int address = -1, int type = -1 );
+
+      //! Number of decoded samples
+      uint count ( );
+
+      //! Event number of the decoded samples
+      uint eventNumber ( );
+
+      //! KPiX address of each sample
+      const uint16_t *address ( );
+
+      //! KPiX channel of each sample
+      const uint16_t *channel ( );
+
+      //! Bucket of each sample
+      const uint8_t *bucket ( );
+
+      //! Range of each sample, 1 = low gain
+      const uint8_t *range ( );
+
+      //! Time of each sample
+      const uint16_t *time ( );
+
+      //! ADC value of each sample
+      const uint16_t *value ( );
+
+      //! SampleFlags of each sample
+      const uint8_t *flags ( );
+
+      //! KpixSample::SampleType of each sample
+      const uint8_t *type ( );
+};
+
+#endif
@@ -249,10 +249,7 @@ void OptoFpgaLink::ioHandler() {
                if ( (rxRet % 2) != 0 ) dataSize = (rxRet + 1) / 2;
                else dataSize = rxRet / 2;
                rxData = new Data(rxBuff,dataSize);
-               if ( ! dataQueue_.push(rxData) ) {
-                  unexpCount_++;
-                  delete rxData;
-               }
+               dataPush(rxData);
             }
 
             // Data matches outstanding register request
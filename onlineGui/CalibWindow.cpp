@@ -139,7 +139,7 @@ void CalibWindow::setCalibData(uint kpix, uint chan, uint bucket) {
    }
 }
 
-void CalibWindow::rxData (KpixEvent *event, uint calChan, uint calDac, bool calPos, bool calHigh) {
+void CalibWindow::rxData (KpixEvent *event, uint calChan, uint calStride, uint calLast, uint calDac, bool calPos, bool calHigh) {
    uint       x;
    uint       channel;
    uint       bucket;
@@ -158,10 +158,11 @@ void CalibWindow::rxData (KpixEvent *event, uint calChan, uint calDac, bool calP
       range   = sample->getSampleRange();
       type    = sample->getSampleType();
 
-      if ( type == 0 && calChan == channel ) {
-         charge_[kpix][calChan][bucket][range][calDac] = dacToCharge ( calDac, calPos, (calHigh && bucket==0));
-         value_[kpix][calChan][bucket][range][calDac]  = value;
-         valid_[kpix][calChan][bucket][range][calDac]  = true;
+      // Injected channels are calChan, calChan+calStride, ... up to calLast
+      if ( type == 0 && channel >= calChan && channel <= calLast && ((channel - calChan) % calStride) == 0 ) {
+         charge_[kpix][channel][bucket][range][calDac] = dacToCharge ( calDac, calPos, (calHigh && bucket==0));
+         value_[kpix][channel][bucket][range][calDac]  = value;
+         valid_[kpix][channel][bucket][range][calDac]  = true;
       }
    }
 }
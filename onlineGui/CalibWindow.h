@@ -52,7 +52,7 @@ class CalibWindow : public QWidget {
       // Delete
       ~CalibWindow ( );
 
-      void rxData (KpixEvent *event, uint calChan, uint calDac, bool calPos, bool calHigh);
+      void rxData (KpixEvent *event, uint calChan, uint calStride, uint calLast, uint calDac, bool calPos, bool calHigh);
       void rePlot(uint kpix, uint chan);
       void resetPlot();
 
@@ -90,6 +90,8 @@ MainWindow::MainWindow ( DataRead *dread, KpixEvent *event, QWidget *parent ) :
    timer_.start(500);
 
    calChannel_  = 0;
+   calStride_   = 1;
+   calLast_     = 1023;
    calDac_      = 0;
    calInject_   = false;
    kpixPol_     = true;
@@ -112,12 +114,17 @@ void MainWindow::event () {
    calChannel_ = dread_->getStatusInt("CalChannel");
    calDac_     = dread_->getStatusInt("CalDac");
 
+   // Parallel injection, older files inject one channel per step
+   calStride_  = dread_->getStatusInt("CalChanStride");
+   if ( calStride_ == 0 ) calStride_ = 1;
+   calLast_    = (calStride_ == 1)?calChannel_:dread_->getConfigInt("CalChanMax");
+
    kpixCalHigh_ = ( dread_->getConfig("kpixFpga:kpixAsic:CntrlCalibHigh") == "True" );
 
    if ( dread_->getConfig("kpixFpga:kpixAsic:CntrlPolarity") == "Negative" ) kpixPol_ = false;
    else kpixPol_ = true;
 
-   if ( calInject_ ) calib_->rxData (event_, calChannel_, calDac_, kpixPol_, kpixCalHigh_);
+   if ( calInject_ ) calib_->rxData (event_, calChannel_, calStride_, calLast_, calDac_, kpixPol_, kpixCalHigh_);
    else hist_->rxData(event_);
    time_->rxData(event_);
    hits_->rxData(event_);
@@ -53,6 +53,8 @@ class MainWindow : public QWidget {
       QTimer      timer_;
 
       uint  calChannel_;
+      uint  calStride_;
+      uint  calLast_;
       uint  calDac_;
       bool  calInject_;
       bool  kpixPol_;
@@ -0,0 +1,81 @@
+#!/usr/bin/env python
+
+import mmap
+import numpy
+import pythonDaq
+
+__version__ = "1.0"
+
+# Decoded KPiX sample, matches DecodedSample in pythonDaq.cpp
+# flags: bit 0 empty, bit 1 bad count, bit 2 trigger type
+SampleDtype = numpy.dtype([('event',   '<u4'),
+                           ('address', '<u2'),
+                           ('channel', '<u2'),
+                           ('time',    '<u2'),
+                           ('value',   '<u2'),
+                           ('bucket',  'u1'),
+                           ('range',   'u1'),
+                           ('flags',   'u1'),
+                           ('type',    'u1')])
+
+# Record index entry, matches RecordIndex in pythonDaq.cpp
+# offset is the byte offset of the record payload, size is in bytes
+RecordDtype = numpy.dtype([('offset', '<u8'),
+                           ('size',   '<u4'),
+                           ('type',   '<u4')])
+
+# Record types
+RawData     = 0
+XmlConfig   = 1
+XmlStatus   = 2
+XmlRunStart = 3
+XmlRunStop  = 4
+XmlRunTime  = 5
+CalMarker   = 6
+
+def sharedFrame():
+    """Next shared memory frame as (type, array) without a copy, (None, None) if none
+    is pending. Raw data frames are uint32 words, all others bytes. The array is only
+    valid until the writer wraps around the shared buffers, copy it to keep it."""
+    count, ftype, view = pythonDaq.daqSharedDataView()
+    if view is None:
+        return (None, None)
+    return (ftype, numpy.frombuffer(view, numpy.uint32 if ftype == RawData else numpy.uint8))
+
+def decodeEvent(words):
+    """Samples of one KPiX event payload as a structured array of SampleDtype."""
+    return numpy.frombuffer(pythonDaq.daqDecodeEvent(words), SampleDtype)
+
+class DataFile(object):
+    """Uncompressed data file mapped into memory. data is a uint8 array of the
+    whole file, records a structured array of RecordDtype indexing it."""
+
+    def __init__(self, path):
+        self._file   = open(path, 'rb')
+        self._map    = mmap.mmap(self._file.fileno(), 0, access=mmap.ACCESS_READ)
+        self.data    = numpy.frombuffer(self._map, numpy.uint8)
+        self.records = numpy.frombuffer(pythonDaq.daqRecordIndex(self.data), RecordDtype)
+
+    def close(self):
+        self.data    = None
+        self.records = None
+        self._map.close()
+        self._file.close()
+
+    def record(self, index):
+        """Payload of record as a view, uint32 words for raw data, bytes otherwise."""
+        rec  = self.records[index]
+        data = self.data[rec['offset']:rec['offset'] + rec['size']]
+        return data.view(numpy.uint32) if rec['type'] == RawData else data
+
+    def events(self):
+        """Indexes of the raw data records."""
+        return numpy.nonzero(self.records['type'] == RawData)[0]
+
+    def samples(self, first=0, last=None):
+        """Samples of all events in records first to last as a structured array of SampleDtype."""
+        recs = self.records[first:last]
+        if len(recs) == 0:
+            return numpy.zeros(0, SampleDtype)
+        end = recs[-1]['offset'] + recs[-1]['size']
+        return numpy.frombuffer(pythonDaq.daqDecodeEvents(self.data[recs[0]['offset'] - 4:end]), SampleDtype)
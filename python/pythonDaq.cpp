@@ -18,16 +18,95 @@ static PyObject         * DaqError;
 static bool               toDisable;
 static uint32_t           rdCount;
 static uint32_t           rdAddr;
+static char               lastError[CONTROL_CMD_ERROR_SIZE];
+
+// Decoded KPiX sample, matches the numpy dtype in pylib/daq_numpy.py
+typedef struct {
+   uint32_t event;
+   uint16_t address;
+   uint16_t channel;
+   uint16_t time;
+   uint16_t value;
+   uint8_t  bucket;
+   uint8_t  range;
+   uint8_t  flags;   // Bit 0 empty, bit 1 bad count, bit 2 trigger type
+   uint8_t  type;
+} DecodedSample;
+
+// Record index entry, matches the numpy dtype in pylib/daq_numpy.py
+typedef struct {
+   uint64_t offset;  // Byte offset of the record payload
+   uint32_t size;    // Payload size in bytes
+   uint32_t type;
+} RecordIndex;
+
+// KPiX event layout in 32-bit words
+#define EVENT_HEAD_SIZE   8
+#define EVENT_TAIL_SIZE   1
+#define EVENT_SAMPLE_SIZE 2
+
+// Convert command result
+static PyObject *intResult (const char *result, bool retString) {
+   uint32_t  ret;
+
+   if ( retString ) return(Py_BuildValue("s",result));
+   else if ( strlen(result) == 0 ) return(Py_BuildValue("i",1));
+   else {
+      ret = (uint32_t)strtoul(result,NULL,0);
+      return(Py_BuildValue("i",ret));
+   }
+}
+
+// Wait for ring command result
+static PyObject *intRingResult (uint32_t ticket, bool retString) {
+   char      result[CONTROL_CMD_STR_SIZE];
+   int32_t   ret;
+
+   Py_BEGIN_ALLOW_THREADS
+   ret = controlCmdRingResult(cmem,ticket,result,lastError,10000);
+   Py_END_ALLOW_THREADS
+
+   if ( ret != 1 ) {
+      PyErr_SetString(DaqError,(ret == 0)?"Timeout waiting for command result":"Unknown command ticket");
+      return(NULL);
+   }
+   if ( strlen(lastError) != 0 ) {
+      PyErr_SetString(DaqError,lastError);
+      return(NULL);
+   }
+   return(intResult(result,retString));
+}
+
+// Submit command to the ring, returns -1 if it does not fit a ring slot
+static int64_t intRingSubmit (const char type, const char *argA, const char *argB) {
+   uint32_t  ticket;
+   int32_t   ret;
+
+   Py_BEGIN_ALLOW_THREADS
+   ret = controlCmdRingSubmit(cmem,type,argA,argB,&ticket,10000);
+   Py_END_ALLOW_THREADS
+
+   if ( ret < 0 ) return(-1);
+   if ( ret == 0 ) {
+      PyErr_SetString(DaqError,"Timeout waiting for free command slot");
+      return(-2);
+   }
+   return(ticket);
+}
 
 static PyObject *intSendCmd (const char type, const char *argA, const char *argB, bool retString) {
    time_t    ctme;
    time_t    stme;
    char      result[CONTROL_CMD_STR_SIZE];
-   uint32_t  ret;
+   int64_t   ticket;
 
    if ( cmem == NULL ) return(NULL);
 
-   // Send command
+   // Command ring
+   if ( (ticket = intRingSubmit(type,argA,argB)) == -2 ) return(NULL);
+   else if ( ticket >= 0 ) return(intRingResult((uint32_t)ticket,retString));
+
+   // Long xml strings use the single command slot
    controlCmdSetCommand(cmem,type,argA,argB);
 
    // Get time
@@ -44,22 +123,29 @@ static PyObject *intSendCmd (const char type, const char *argA, const char *argB
          return(NULL);
       }
    }
-   usleep(100);
 
    // Check error buffer
-   if ( strlen(controlCmdGetError(cmem)) != 0 ) {
-      PyErr_SetString(DaqError,controlCmdGetError(cmem));
+   strcpy(lastError,controlCmdGetError(cmem));
+   if ( strlen(lastError) != 0 ) {
+      PyErr_SetString(DaqError,lastError);
       return(NULL);
    }
-   usleep(100);
 
    // Success
-   if ( retString ) return(Py_BuildValue("s",result));
-   else if ( strlen(result) == 0 ) return(Py_BuildValue("i",1));
-   else {
-      ret = (uint32_t)strtoul(result,NULL,0);
-      return(Py_BuildValue("i",ret));
-   }
+   return(intResult(result,retString));
+}
+
+// Submit command without waiting, returns ticket for daqWaitResult. A result
+// not collected within CONTROL_CMD_RING_RECLAIM ms is freed by the server.
+static PyObject *intSubmitCmd (const char type, const char *argA, const char *argB) {
+   int64_t ticket;
+
+   if ( cmem == NULL ) return(NULL);
+
+   ticket = intRingSubmit(type,argA,argB);
+   if ( ticket == -1 ) PyErr_SetString(DaqError,"Command too long for command slot");
+   if ( ticket < 0 ) return(NULL);
+   return(Py_BuildValue("I",(uint32_t)ticket));
 }
 
 static PyObject *intSendXml (const char *xml ) {
@@ -158,12 +244,20 @@ static PyObject *daqReadStatus (PyObject *self, PyObject *args) {
    return (intSendXml("<system><command><ReadStatus/></command></system>\n"));
 }
 
+// Read variable from the snapshot, falls back to a command for keys it does not hold
+static PyObject *intSnapGet (uint8_t cmdType, uint8_t kind, const char *var) {
+   char value[CONTROL_CMD_SNAP_VALUE_SIZE];
+
+   if ( cmem != NULL && controlCmdSnapGet(cmem,kind,var,value) == 1 ) return(Py_BuildValue("s",value));
+   return(intSendCmd (cmdType, var, NULL, true));
+}
+
 static PyObject *daqGetStatus (PyObject *self, PyObject *args) {
    const char   *var;
 
    if (!PyArg_ParseTuple(args, "s", &var)) return NULL;
 
-   return(intSendCmd (CONTROL_CMD_TYPE_GET_STATUS, var, NULL, true));
+   return(intSnapGet (CONTROL_CMD_TYPE_GET_STATUS, CONTROL_CMD_SNAP_STATUS, var));
 }
 
 static PyObject *daqReadConfig (PyObject *self, PyObject *args) {
@@ -188,12 +282,50 @@ static PyObject *daqGetConfig (PyObject *self, PyObject *args) {
 
    if (!PyArg_ParseTuple(args, "s", &var)) return NULL;
 
-   return(intSendCmd (CONTROL_CMD_TYPE_GET_CONFIG, var, NULL, true));
+   return(intSnapGet (CONTROL_CMD_TYPE_GET_CONFIG, CONTROL_CMD_SNAP_CONFIG, var));
 }
 
 static PyObject *daqGetError (PyObject *self, PyObject *args) {
    if ( cmem == NULL ) return(NULL);
-   return(Py_BuildValue("s",controlCmdGetError(cmem)));
+   return(Py_BuildValue("s",lastError));
+}
+
+static PyObject *daqSubmitXml (PyObject *self, PyObject *args) {
+   const char *xml;
+
+   if (!PyArg_ParseTuple(args, "s", &xml)) return NULL;
+
+   return(intSubmitCmd (CONTROL_CMD_TYPE_SEND_XML, xml, NULL));
+}
+
+static PyObject *daqSubmitConfig (PyObject *self, PyObject *args) {
+   const char   *var;
+   const char   *arg;
+
+   if (!PyArg_ParseTuple(args, "ss", &var,&arg)) return NULL;
+
+   return(intSubmitCmd (CONTROL_CMD_TYPE_SET_CONFIG, var, arg));
+}
+
+static PyObject *daqSubmitWriteRegister (PyObject *self, PyObject *args) {
+   char          buffer[1024];
+   const char *  dev;
+   const char *  reg;
+   uint32_t      val;
+
+   if (!PyArg_ParseTuple(args, "ssi",&dev,&reg,&val)) return NULL;
+
+   sprintf(buffer,"%s 0x%x",reg,val);
+   return(intSubmitCmd (CONTROL_CMD_TYPE_SET_REGISTER, dev, buffer));
+}
+
+static PyObject *daqWaitResult (PyObject *self, PyObject *args) {
+   uint32_t ticket;
+
+   if (!PyArg_ParseTuple(args, "I", &ticket)) return NULL;
+   if ( cmem == NULL ) return(NULL);
+
+   return(intRingResult(ticket,true));
 }
 
 static PyObject *daqSendXml (PyObject *self, PyObject *args) {
@@ -287,9 +419,9 @@ static PyObject *daqSharedDataRead (PyObject *self, PyObject *args) {
    if ( ret == 0 ) {
       PyTuple_SetItem(tupleA,2,Py_BuildValue("i",0));
    }
-   else if ( type == 0 ) {
+   else if ( type == 0 || type == 6 ) {
       idata  = (uint32_t *)data;
-      icount = count;
+      icount = (type == 0)?count:(count/4);
 
       PyObject* tupleB = PyTuple_New(icount); 
 
@@ -304,6 +436,174 @@ static PyObject *daqSharedDataRead (PyObject *self, PyObject *args) {
    return tupleA; 
 }
 
+// Shared memory frame without copy, returns count, type and a read only memoryview.
+// The view is valid until the writer wraps around the shared buffers.
+static PyObject *daqSharedDataView (PyObject *self, PyObject *args) {
+   uint8_t  * data;
+   uint32_t   flag;
+   uint32_t   count;
+   uint32_t   type;
+   Py_buffer  view;
+
+   if ( dmem == NULL || dataSharedRead(dmem,&rdAddr,&rdCount,&flag,&data) == 0 ) 
+      return(Py_BuildValue("iiO",0,0,Py_None));
+
+   type  = (flag >> 28) & 0xF;
+   count = flag & 0x0FFFFFFF;
+
+   if ( PyBuffer_FillInfo(&view,NULL,data,(type == 0)?(count*4):count,1,PyBUF_CONTIG_RO) < 0 ) return(NULL);
+   return(Py_BuildValue("iiN",count,type,PyMemoryView_FromBuffer(&view)));
+}
+
+// Number of samples in a KPiX event of size words
+static uint32_t intEventCount (uint32_t size) {
+   if ( size <= (EVENT_HEAD_SIZE + EVENT_TAIL_SIZE) ) return(0);
+   if ( ((size - EVENT_HEAD_SIZE - EVENT_TAIL_SIZE) % EVENT_SAMPLE_SIZE) != 0 ) return(0);
+   return((size - EVENT_HEAD_SIZE - EVENT_TAIL_SIZE) / EVENT_SAMPLE_SIZE);
+}
+
+// Decode the samples of a KPiX event of size words
+static DecodedSample *intDecodeEvent (const uint32_t *data, uint32_t size, DecodedSample *out) {
+   const uint32_t *sample;
+   uint32_t        count;
+   uint32_t        x;
+
+   count  = intEventCount(size);
+   sample = data + EVENT_HEAD_SIZE;
+
+   for (x=0; x < count; x++) {
+      out->event   = data[0];
+      out->address = (sample[0] >> 16) & 0xFFF;
+      out->channel = sample[0] & 0x3FF;
+      out->bucket  = (sample[0] >> 10) & 0x3;
+      out->range   = (sample[0] >> 13) & 0x1;
+      out->flags   = ((sample[0] >> 15) & 0x1) | (((sample[0] >> 14) & 0x1) << 1) | (((sample[0] >> 12) & 0x1) << 2);
+      out->type    = (sample[0] >> 28) & 0xF;
+      out->time    = (sample[1] >> 16) & 0x1FFF;
+      out->value   = sample[1] & 0x1FFF;
+      sample += EVENT_SAMPLE_SIZE;
+      out++;
+   }
+   return(out);
+}
+
+// Index the records in a buffer holding a data file, returns the record count.
+// Only counts if idx is NULL. A partial record at the end is left out.
+static uint64_t intRecordIndex (const uint8_t *buff, uint64_t len, RecordIndex *idx) {
+   uint64_t pos;
+   uint64_t count;
+   uint32_t head;
+   uint32_t type;
+   uint32_t size;
+
+   pos   = 0;
+   count = 0;
+   while ( (pos + 4) <= len ) {
+      memcpy(&head,buff+pos,4);
+      pos += 4;
+      if ( head == 0 ) continue;
+
+      type = (head >> 28) & 0xF;
+      size = (type == 0)?((head & 0x0FFFFFFF) * 4):(head & 0x0FFFFFFF);
+      if ( (pos + size) > len ) break;
+
+      if ( idx != NULL ) {
+         idx[count].offset = pos;
+         idx[count].size   = size;
+         idx[count].type   = type;
+      }
+      count++;
+      pos += size;
+   }
+   return(count);
+}
+
+// Index of the records in a buffer holding a data file, returns bytearray of RecordIndex
+static PyObject *daqRecordIndex (PyObject *self, PyObject *args) {
+   Py_buffer  buff;
+   PyObject * ret;
+   uint64_t   count;
+
+   if (!PyArg_ParseTuple(args, "s*", &buff)) return NULL;
+
+   count = intRecordIndex((const uint8_t *)buff.buf,buff.len,NULL);
+   ret   = PyByteArray_FromStringAndSize(NULL,count * sizeof(RecordIndex));
+   if ( ret != NULL ) intRecordIndex((const uint8_t *)buff.buf,buff.len,(RecordIndex *)PyByteArray_AS_STRING(ret));
+
+   PyBuffer_Release(&buff);
+   return(ret);
+}
+
+// Decode one KPiX event payload, returns bytearray of DecodedSample
+static PyObject *daqDecodeEvent (PyObject *self, PyObject *args) {
+   Py_buffer  buff;
+   PyObject * ret;
+
+   if (!PyArg_ParseTuple(args, "s*", &buff)) return NULL;
+
+   ret = PyByteArray_FromStringAndSize(NULL,intEventCount(buff.len/4) * sizeof(DecodedSample));
+   if ( ret != NULL ) intDecodeEvent((const uint32_t *)buff.buf,buff.len/4,(DecodedSample *)PyByteArray_AS_STRING(ret));
+
+   PyBuffer_Release(&buff);
+   return(ret);
+}
+
+// Decode all KPiX events in a buffer holding a data file, returns bytearray of DecodedSample
+static PyObject *daqDecodeEvents (PyObject *self, PyObject *args) {
+   Py_buffer       buff;
+   PyObject      * ret;
+   RecordIndex   * idx;
+   DecodedSample * out;
+   const uint8_t * data;
+   uint32_t      * copy;
+   uint32_t        alloc;
+   uint64_t        records;
+   uint64_t        count;
+   uint64_t        x;
+
+   if (!PyArg_ParseTuple(args, "s*", &buff)) return NULL;
+   data  = (const uint8_t *)buff.buf;
+   copy  = NULL;
+   alloc = 0;
+
+   records = intRecordIndex(data,buff.len,NULL);
+   if ( (idx = (RecordIndex *)malloc((records + 1) * sizeof(RecordIndex))) == NULL ) {
+      PyBuffer_Release(&buff);
+      return(PyErr_NoMemory());
+   }
+   intRecordIndex(data,buff.len,idx);
+
+   count = 0;
+   for (x=0; x < records; x++) 
+      if ( idx[x].type == 0 ) count += intEventCount(idx[x].size/4);
+
+   if ( (ret = PyByteArray_FromStringAndSize(NULL,count * sizeof(DecodedSample))) != NULL ) {
+      out = (DecodedSample *)PyByteArray_AS_STRING(ret);
+
+      // Events after xml records of odd length are not word aligned, decoded from a copy
+      Py_BEGIN_ALLOW_THREADS
+      for (x=0; x < records; x++) {
+         if ( idx[x].type != 0 ) continue;
+         if ( ((uintptr_t)(data+idx[x].offset) & 0x3) == 0 ) 
+            out = intDecodeEvent((const uint32_t *)(data+idx[x].offset),idx[x].size/4,out);
+         else {
+            if ( idx[x].size > alloc ) {
+               free(copy);
+               alloc = idx[x].size;
+               copy  = (uint32_t *)malloc(alloc);
+            }
+            memcpy(copy,data+idx[x].offset,idx[x].size);
+            out = intDecodeEvent(copy,idx[x].size/4,out);
+         }
+      }
+      Py_END_ALLOW_THREADS
+   }
+   free(copy);
+   free(idx);
+   PyBuffer_Release(&buff);
+   return(ret);
+}
+
 static PyMethodDef DaqMethods[] = {
    {"daqOpen",             daqOpen,             METH_VARARGS, ""},
    {"daqHardReset",        daqHardReset,        METH_VARARGS, ""},
@@ -326,12 +626,20 @@ static PyMethodDef DaqMethods[] = {
    {"daqSetConfig",        daqSetConfig,        METH_VARARGS, ""},
    {"daqGetConfig",        daqGetConfig,        METH_VARARGS, ""},
    {"daqGetError",         daqGetError,         METH_VARARGS, ""},
+   {"daqSubmitXml",        daqSubmitXml,        METH_VARARGS, ""},
+   {"daqSubmitConfig",     daqSubmitConfig,     METH_VARARGS, ""},
+   {"daqSubmitWriteRegister", daqSubmitWriteRegister, METH_VARARGS, ""},
+   {"daqWaitResult",       daqWaitResult,       METH_VARARGS, ""},
    {"daqSendXml",          daqSendXml,          METH_VARARGS, ""},
    {"daqDisableTimeout",   daqDisableTimeout,   METH_VARARGS, ""},
    {"daqReadRegister",     daqReadRegister,     METH_VARARGS, ""},
    {"daqWriteRegister",    daqWriteRegister,    METH_VARARGS, ""},
    {"daqSharedDataOpen",   daqSharedDataOpen,   METH_VARARGS, ""},
    {"daqSharedDataRead",   daqSharedDataRead,   METH_VARARGS, ""},
+   {"daqSharedDataView",   daqSharedDataView,   METH_VARARGS, ""},
+   {"daqRecordIndex",      daqRecordIndex,      METH_VARARGS, ""},
+   {"daqDecodeEvent",      daqDecodeEvent,      METH_VARARGS, ""},
+   {"daqDecodeEvents",     daqDecodeEvents,     METH_VARARGS, ""},
    {NULL,                  NULL,                0,            NULL} /* Sentinel */
 };
 
@@ -0,0 +1,245 @@
+//-----------------------------------------------------------------------------
+// File          : bzipReadBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of reading bzip2 compressed data files. A data file of KPiX
+// events with periodic xml status records is compressed as two concatenated
+// streams. It is read through a single BZ2_bzRead stream, as DataRead did,
+// and through DataRead with the blocks decompressed by one thread and by one
+// thread per processor. All must return the same records.
+//
+// Usage: bzipReadBench [size_mb] [threads]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Print merged blocks
+//----------------------------------------------------------------------------
+#include <bzlib.h>
+#include <DataRead.h>
+#include <DataBzip.h>
+#include <Data.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Write a compressed test file of size MB in two streams, returns uncompressed bytes
+uint64_t writeFile ( string file, uint32_t size ) {
+   uint32_t  buff[8+2*1024+1];
+   uint32_t  count;
+   uint32_t  event;
+   uint32_t  x;
+   uint64_t  total;
+   FILE     *f;
+   void     *bz;
+   string    xml;
+   int32_t   bzerror;
+   uint32_t  stream;
+
+   if ( (f = fopen(file.c_str(),"w")) == NULL ) return(0);
+
+   total = 0;
+   event = 0;
+   for (stream=0; stream < 2; stream++) {
+      bz = BZ2_bzWriteOpen(&bzerror,f,9,0,0);
+      if ( bzerror != BZ_OK ) return(0);
+
+      while ( total < ((uint64_t)size << 19) * (stream + 1) ) {
+
+         // Status record of odd length now and then
+         if ( (event % 1000) == 0 ) {
+            stringstream tmp;
+            tmp << "<status><RunProgress>" << dec << event << "</RunProgress></status>\n";
+            xml   = tmp.str();
+            count = (Data::XmlStatus << 28) | xml.size();
+            BZ2_bzWrite(&bzerror,bz,&count,4);
+            BZ2_bzWrite(&bzerror,bz,(void *)xml.c_str(),xml.size());
+            total += 4 + xml.size();
+         }
+
+         // Event of 64 to 1023 samples near a baseline
+         count   = 64 + rand() % 960;
+         buff[0] = event;
+         for (x=1; x < 8; x++) buff[x] = rand() & 0xFFFF;
+         for (x=0; x < count; x++) {
+            buff[8+2*x]   = ((rand() % 4) << 16) | (rand() & 0x3FFF);
+            buff[8+2*x+1] = ((rand() & 0x1FFF) << 16) | (300 + rand() % 64);
+         }
+         buff[8+2*count] = 0;
+         x = 8+2*count+1;
+         BZ2_bzWrite(&bzerror,bz,&x,4);
+         BZ2_bzWrite(&bzerror,bz,buff,x*4);
+         total += 4 + (x * 4);
+         event++;
+      }
+      BZ2_bzWriteClose(&bzerror,bz,0,NULL,NULL);
+   }
+   fclose(f);
+   return(total);
+}
+
+// Sequential reader of concatenated BZ2_bzRead streams
+class BzipStream {
+   public:
+      FILE    *f;
+      void    *bz;
+      int32_t  bzerror;
+
+      // Read bytes, the next stream starts with the bytes read past the end of this one
+      bool read ( void *buff, uint32_t size ) {
+         char    rest[BZ_MAX_UNUSED];
+         void   *unused;
+         int32_t nUnused;
+         int32_t ret;
+
+         while ( size > 0 ) {
+            ret = BZ2_bzRead(&bzerror,bz,buff,size);
+            if ( bzerror != BZ_OK && bzerror != BZ_STREAM_END ) return(false);
+            buff  = (char *)buff + ret;
+            size -= ret;
+
+            if ( bzerror == BZ_STREAM_END ) {
+               BZ2_bzReadGetUnused(&bzerror,bz,&unused,&nUnused);
+               memcpy(rest,unused,nUnused);
+               BZ2_bzReadClose(&bzerror,bz);
+               bz = NULL;
+               if ( nUnused == 0 && fgetc(f) == EOF ) return(size == 0);
+               if ( nUnused == 0 ) fseek(f,-1,SEEK_CUR);
+               bz = BZ2_bzReadOpen(&bzerror,f,0,0,rest,nUnused);
+               if ( bzerror != BZ_OK ) return(false);
+            }
+         }
+         return(true);
+      }
+};
+
+// Read all records through one BZ2_bzRead stream at a time, returns sum of all words
+uint64_t readStream ( string file, uint32_t *records, double *time ) {
+   vector<uint32_t> buff;
+   BzipStream       stream;
+   uint64_t         sum;
+   uint32_t         size;
+   uint32_t         bytes;
+   uint32_t         x;
+   double           start;
+
+   sum      = 0;
+   *records = 0;
+   start    = now();
+
+   if ( (stream.f = fopen(file.c_str(),"r")) == NULL ) return(0);
+   stream.bz = BZ2_bzReadOpen(&stream.bzerror,stream.f,0,0,NULL,0);
+
+   while ( stream.bz != NULL && stream.read(&size,4) ) {
+      bytes = size & 0x0FFFFFFF;
+      if ( ((size >> 28) & 0xF) == Data::RawData ) bytes *= 4;
+      if ( buff.size() * 4 < bytes + 4 ) buff.resize(bytes / 4 + 1);
+      if ( ! stream.read(&(buff[0]),bytes) ) break;
+      if ( ((size >> 28) & 0xF) != Data::RawData ) continue;
+
+      for (x=0; x < (size & 0x0FFFFFFF); x++) sum += buff[x];
+      (*records)++;
+   }
+   if ( stream.bz != NULL ) BZ2_bzReadClose(&stream.bzerror,stream.bz);
+   fclose(stream.f);
+   *time = now() - start;
+   return(sum);
+}
+
+// Read all records through DataRead, returns sum of all words
+uint64_t readFile ( string file, uint32_t threads, uint32_t *records, double *time, string *progress ) {
+   DataRead  dataRead;
+   Data      data;
+   uint64_t  sum;
+   uint32_t *buff;
+   uint32_t  x;
+   int32_t   fd;
+   double    start;
+
+   sum      = 0;
+   *records = 0;
+   start    = now();
+
+   if ( ! dataRead.open(file,true) ) return(0);
+
+   // Restart with the requested threads
+   fd = open(file.c_str(),O_RDONLY);
+   dataRead.bzip()->start(fd,threads);
+   close(fd);
+
+   while ( dataRead.next(&data) ) {
+      buff = data.data();
+      for (x=0; x < data.size(); x++) sum += buff[x];
+      (*records)++;
+   }
+   *time     = now() - start;
+   *progress = dataRead.getStatus("RunProgress");
+
+   cout << "   threads=" << dec << dataRead.bzip()->threads()
+        << " blocks=" << dataRead.bzip()->blocks()
+        << " stalls=" << dataRead.bzip()->stalls()
+        << " merges=" << dataRead.bzip()->merges()
+        << " stall sec=" << fixed << setprecision(3) << dataRead.bzip()->stallTime() << endl;
+   dataRead.close();
+   return(sum);
+}
+
+int main (int argc, char **argv) {
+   string    file = "/tmp/bzipReadBench.bin.bz2";
+   string    progress[2];
+   uint32_t  size    = 256;
+   uint32_t  threads = sysconf(_SC_NPROCESSORS_ONLN);
+   uint32_t  records[3];
+   uint64_t  sum[3];
+   uint64_t  bytes;
+   double    time[3];
+   uint32_t  x;
+
+   if ( argc > 1 ) size = atoi(argv[1]);
+   if ( argc > 2 ) threads = atoi(argv[2]);
+
+   cout << "Writing " << dec << size << " MB compressed to " << file << endl;
+   if ( (bytes = writeFile(file,size)) == 0 ) {
+      cout << "Failed to write " << file << endl;
+      return(1);
+   }
+
+   sum[0] = readStream(file,&records[0],&time[0]);
+   sum[1] = readFile(file,1,&records[1],&time[1],&progress[0]);
+   sum[2] = readFile(file,threads,&records[2],&time[2],&progress[1]);
+
+   for (x=0; x < 3; x++)
+      cout << setw(12) << left << ((x == 0)?"BZ2_bzRead":((x == 1)?"1 thread":"threads")) << right
+           << " records=" << dec << records[x]
+           << " MB/s=" << setw(8) << fixed << setprecision(0) << ((bytes / (1024.0 * 1024.0)) / time[x])
+           << " sec=" << setprecision(2) << time[x] << endl;
+   cout << "Speedup " << fixed << setprecision(2) << (time[0] / time[2]) << endl;
+
+   unlink(file.c_str());
+   if ( sum[0] != sum[1] || sum[0] != sum[2] || records[0] != records[1] || records[0] != records[2] ||
+        records[0] == 0 || progress[0] != progress[1] || progress[0] == "" ) {
+      cout << "Readers differ" << endl;
+      return(1);
+   }
+   return(0);
+}
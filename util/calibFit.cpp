@@ -0,0 +1,187 @@
+//-----------------------------------------------------------------------------
+// File          : calibFit.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix DAQ
+//-----------------------------------------------------------------------------
+// Description :
+// Fit a calibration run. The data file is scanned in parallel, samples are
+// sorted into baseline and injection data by the CalState, CalChannel and
+// CalDac status in effect. Baselines get a gaussian fit and the injection
+// curves a linear fit. Results are written in calibration xml format to
+// the output file, datafile.xml by default.
+//
+// With -w only samples in the injection time window of their bucket are
+// used, the windows start at the Cal0Delay to Cal3Delay settings.
+//
+// Usage: calibFit [-w] [-t threads] datafile [output]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Injection groups end at CalChanMax, stride 0 or 1 is one channel
+//----------------------------------------------------------------------------
+#include <KpixEvent.h>
+#include <KpixSample.h>
+#include <KpixSampleBatch.h>
+#include <KpixCalibFit.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <Data.h>
+#include <DataRead.h>
+#include <DataScan.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Calibration accumulators of one scan thread
+class CalibScan : public DataScanProcessor {
+   public:
+      KpixEvent       event;
+      KpixSampleBatch batch;
+      KpixCalibFit    fit;
+      bool            window;
+      bool            config;
+      uint            last;
+
+      CalibScan ( bool win ) {
+         window = win;
+         config = false;
+         last   = 1023;
+      }
+
+      Data *data ( ) {
+         return(&event);
+      }
+
+      // KPiX settings from the configuration of the first event
+      void setup ( DataRead *dataRead ) {
+         stringstream prefix;
+         string       serial;
+         uint         times[5];
+         uint         x;
+         bool         win;
+
+         // Parallel injection groups end at the last channel of the run
+         last = (dataRead->getConfig("CalChanMax") == "")?1023:dataRead->getConfigInt("CalChanMax");
+
+         win = false;
+         for (x=0; x < KpixCalibFit::MaxAsics; x++) {
+            prefix.str("");
+            prefix << "cntrlFpga(0):kpixAsic(" << dec << x << "):";
+            serial = dataRead->getConfig(prefix.str() + "SerialNumber");
+            if ( serial == "" ) continue;
+
+            fit.setAsic(x,serial,(dataRead->getConfig(prefix.str() + "CntrlPolarity") == "Positive"),
+                                 (dataRead->getConfig(prefix.str() + "CntrlCalibHigh") == "True"));
+
+            // Injection windows of the first KPiX
+            if ( window && ! win ) {
+               times[0] = dataRead->getConfigInt(prefix.str() + "Cal0Delay");
+               times[1] = times[0] + dataRead->getConfigInt(prefix.str() + "Cal1Delay");
+               times[2] = times[1] + dataRead->getConfigInt(prefix.str() + "Cal2Delay");
+               times[3] = times[2] + dataRead->getConfigInt(prefix.str() + "Cal3Delay");
+               times[4] = 8192;
+               fit.setWindow(times);
+               win = true;
+            }
+         }
+         config = true;
+      }
+
+      void process ( Data *data, DataRead *dataRead ) {
+         string state;
+         uint   stride;
+
+         if ( ! config ) setup(dataRead);
+
+         state = dataRead->getStatus("CalState");
+         if ( state != "Baseline" && state != "Inject" ) return;
+
+         stride = dataRead->getStatusInt("CalChanStride");
+         if ( stride == 0 ) stride = dataRead->getConfigInt("CalChanStride");
+
+         batch.decode(&event,-1,KpixSample::Data);
+         fit.fill(&batch,(state == "Baseline")?KpixCalibFit::Baseline:KpixCalibFit::Inject,
+                  dataRead->getStatusInt("CalChannel"),stride,last,dataRead->getStatusInt("CalDac"));
+      }
+
+      void merge ( DataScanProcessor *other ) {
+         fit.merge(&(((CalibScan *)other)->fit));
+      }
+};
+
+int main (int argc, char **argv) {
+   DataScan                   dataScan;
+   vector<DataScanProcessor*> procs;
+   CalibScan                 *calib;
+   string                     file;
+   string                     output;
+   int64_t                    events;
+   double                     start;
+   double                     scanTime;
+   uint                       threads;
+   uint                       asics;
+   uint                       x;
+   bool                       window;
+   int                        c;
+
+   threads = sysconf(_SC_NPROCESSORS_ONLN);
+   window  = false;
+
+   while ( (c = getopt(argc,argv,"wt:")) != -1 ) {
+      if ( c == 'w' ) window = true;
+      else if ( c == 't' ) threads = atoi(optarg);
+      else {
+         cout << "Usage: calibFit [-w] [-t threads] datafile [output]" << endl;
+         return(1);
+      }
+   }
+   if ( optind >= argc || (argc - optind) > 2 ) {
+      cout << "Usage: calibFit [-w] [-t threads] datafile [output]" << endl;
+      return(1);
+   }
+   if ( threads < 1 ) threads = 1;
+   file   = argv[optind];
+   output = ((argc - optind) == 2)?argv[optind+1]:(file + ".xml");
+
+   // One processor per thread
+   for (x=0; x < threads; x++) procs.push_back(new CalibScan(window));
+
+   start = now();
+   if ( (events = dataScan.scan(file,procs)) < 0 ) {
+      cout << "Error opening file " << file << endl;
+      return(2);
+   }
+   scanTime = now() - start;
+   calib    = (CalibScan *)procs[0];
+
+   for (asics=0, x=0; x < KpixCalibFit::MaxAsics; x++) if ( calib->fit.serial(x) != "" ) asics++;
+   cout << "Read " << dec << events << " events in " << fixed << setprecision(2) << scanTime << " sec, "
+        << calib->fit.entries() << " entries, " << asics << " KPiX" << endl;
+
+   start = now();
+   calib->fit.fit(threads);
+   cout << "Fit in " << fixed << setprecision(2) << (now() - start) << " sec" << endl;
+
+   if ( ! calib->fit.writeXml(output,file) ) {
+      cout << "Failed to write " << output << endl;
+      return(3);
+   }
+   cout << "Wrote " << output << endl;
+
+   for (x=0; x < procs.size(); x++) delete procs[x];
+   return(0);
+}
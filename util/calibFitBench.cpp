@@ -0,0 +1,153 @@
+//-----------------------------------------------------------------------------
+// File          : calibFitBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Check and benchmark of KpixCalibFit::fill. Calibration runs of one KPiX
+// are simulated, every event holds a sample of each channel and only the
+// injected channels see the calibration charge. Runs with one channel per
+// step and with parallel injection up to CalChanMax are filled from the
+// decoded events and fitted. The results must match a fit given each
+// injected channel's samples alone.
+//
+// Usage: calibFitBench [events_per_point]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//----------------------------------------------------------------------------
+#include <KpixEvent.h>
+#include <KpixSample.h>
+#include <KpixSampleBatch.h>
+#include <KpixCalibFit.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+using namespace std;
+
+// Channels read out, more than the calibrated ones
+#define BENCH_CHANNELS 64
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Fit results without the timestamp
+string results ( KpixCalibFit *fit, string file ) {
+   ifstream     is;
+   stringstream ret;
+   string       line;
+
+   fit->fit(1);
+   fit->writeXml(file,"calibFitBench");
+   is.open(file.c_str());
+   while ( getline(is,line) ) if ( line.find("<timestamp>") == string::npos ) ret << line << endl;
+   is.close();
+   unlink(file.c_str());
+   return(ret.str());
+}
+
+// Simulate a run, fill one fitter from the events and the other from the
+// injected channels only. Returns true if the results match.
+bool run ( uint stride, uint last, uint count, uint *events, double *time ) {
+   KpixCalibFit    fit[2];
+   KpixEvent       event;
+   KpixSampleBatch batch;
+   vector<bool>    injected;
+   uint            buff[8+2*BENCH_CHANNELS+1];
+   uint            step;
+   uint            channel;
+   uint            chanLast;
+   uint            state;
+   uint            value;
+   uint            dac;
+   uint            x;
+   uint            y;
+   double          start;
+   bool            ret;
+
+   fit[0].setAsic(0,"1",true,false);
+   fit[1].setAsic(0,"1",true,false);
+
+   // Parallel injection steps through the first stride channels
+   chanLast = (stride <= 1)?last:(stride - 1);
+   if ( chanLast > last ) chanLast = last;
+
+   *events = 0;
+   *time   = 0;
+   srand(1);
+   for (step=0; step <= chanLast + 1; step++) {
+
+      // Baseline first, then the injection points of each channel
+      state   = (step == 0)?KpixCalibFit::Baseline:KpixCalibFit::Inject;
+      channel = (step == 0)?0:(step - 1);
+
+      injected.assign(BENCH_CHANNELS,false);
+      if ( state == KpixCalibFit::Inject ) {
+         if ( stride <= 1 ) injected[channel] = true;
+         else for (x=channel; x <= last && x < BENCH_CHANNELS; x += stride) injected[x] = true;
+      }
+
+      for (dac=0; dac < ((state == KpixCalibFit::Baseline)?1:256); dac += 32) {
+         for (y=0; y < count; y++) {
+            buff[0] = *events;
+            for (x=1; x < 8; x++) buff[x] = 0;
+            for (x=0; x < BENCH_CHANNELS; x++) {
+               value = 300 + (rand() % 8);
+               if ( injected[x] ) value += dac * (2 + (x % 3));
+               buff[8+2*x]   = (KpixSample::Data << 28) | x;
+               buff[8+2*x+1] = ((rand() & 0x1FFF) << 16) | (value & 0x1FFF);
+               if ( state == KpixCalibFit::Baseline ) fit[1].baseline(0,x,0,0,value & 0x1FFF);
+               else if ( injected[x] ) fit[1].inject(0,x,0,0,dac,value & 0x1FFF);
+            }
+            buff[8+2*BENCH_CHANNELS] = 0;
+
+            event.view(buff,8+2*BENCH_CHANNELS+1);
+            start = now();
+            batch.decode(&event,-1,KpixSample::Data);
+            fit[0].fill(&batch,state,channel,stride,last,dac);
+            *time += now() - start;
+            (*events)++;
+         }
+      }
+   }
+
+   ret = ( results(&fit[0],"/tmp/calibFitBench0.xml") == results(&fit[1],"/tmp/calibFitBench1.xml") );
+   ret = ret && ( fit[0].entries() == BENCH_CHANNELS );
+   return(ret);
+}
+
+int main (int argc, char **argv) {
+   uint   count = 20;
+   uint   events;
+   uint   errors;
+   uint   x;
+   double time;
+   bool   match;
+   uint   stride[3] = { 0, 1, 4 };
+   uint   last[3]   = { 47, 47, 47 };
+
+   if ( argc > 1 ) count = atoi(argv[1]);
+   if ( count == 0 ) count = 1;
+
+   errors = 0;
+   for (x=0; x < 3; x++) {
+      if ( ! (match = run(stride[x],last[x],count,&events,&time)) ) errors++;
+      cout << "Stride " << dec << stride[x] << ", CalChanMax " << last[x] << ", " << events << " events,"
+           << " fill us/event=" << fixed << setprecision(2) << ((time * 1e6) / events)
+           << ", match per channel fit: " << (match?"yes":"NO") << endl;
+   }
+   return((errors == 0)?0:1);
+}
@@ -0,0 +1,174 @@
+//-----------------------------------------------------------------------------
+// File          : calibStepBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of a calibration step through the xml config path against the
+// typed KpixAsic calibration calls. No hardware is needed, the tree is
+// attached to the generic comm link which acknowledges all register
+// transactions. Both paths are checked to leave the same calibration dac
+// and channel mode register values.
+//
+// Usage: calibStepBench [steps]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//----------------------------------------------------------------------------
+#include <CommLink.h>
+#include <KpixControl.h>
+#include <KpixAsic.h>
+#include <Variable.h>
+#include <Register.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Calibration step as xml, the form used before the typed calls
+void xmlStep ( KpixControl *kpix, CommLink *link, uint channel, uint dac ) {
+   uint         x;
+   uint         col;
+   uint         row;
+   string       modeString;
+   stringstream newConfig;
+
+   col = (channel>1023)?32:(channel/32);
+   row = channel%32;
+
+   newConfig << "<system><config><cntrlFpga>";
+   newConfig << "<RunMode>Calibrate</RunMode>";
+   newConfig << "<kpixAsic>";
+   newConfig << "<CntrlCalSource>Internal</CntrlCalSource>";
+   newConfig << "<CntrlForceTrigSource>Internal</CntrlForceTrigSource>";
+   newConfig << "<CntrlTrigDisable>True</CntrlTrigDisable>";
+   newConfig << "<DacCalibration>"<< dec << dac << "</DacCalibration>";
+   for (x=0; x < 32; x++) {
+      newConfig << "<Chan_" << setw(4) << setfill('0') << dec << (x*32) << "_" << setw(4) << setfill('0') << dec << ((x*32)+31) << ">";
+      modeString = "DDDDDDDDDDDDDDDDDDDDDDDDDDDDDDDD";
+      if ( col == x ) modeString[row] = 'C';
+      newConfig << modeString;
+      newConfig << "</Chan_" << setw(4) << setfill('0') << dec << (x*32) << "_" << setw(4) << setfill('0') << dec << ((x*32)+31) << ">";
+   }
+   newConfig << "</kpixAsic></cntrlFpga></config></system>\n";
+   kpix->parseXmlString(newConfig.str());
+
+   newConfig.str("");
+   newConfig << "<status>" << endl;
+   newConfig << "<CalState>"   << kpix->getVariable("CalState")->get()   << "</CalState>" << endl;
+   newConfig << "<CalChannel>" << kpix->getVariable("CalChannel")->get() << "</CalChannel>" << endl;
+   newConfig << "<CalDac>"     << kpix->getVariable("CalDac")->get()     << "</CalDac>" << endl;
+   newConfig << "</status>" << endl;
+   link->addStatus(newConfig.str());
+   usleep(100);
+}
+
+// Calibration step with the typed calls
+void typedStep ( KpixControl *kpix, CommLink *link, uint channel, uint dac ) {
+   Device *fpga;
+   uint    x;
+
+   fpga = kpix->device("cntrlFpga",0);
+   for (x=0; x < fpga->deviceCount("kpixAsic"); x++) {
+      KpixAsic *asic = (KpixAsic *)fpga->device("kpixAsic",x);
+      asic->setCalibDac(dac);
+      asic->setCalibChannel(channel);
+   }
+   link->addCalMarker(kpix->getVariable("CalState")->getInt(),channel,dac,1);
+}
+
+// Calibration dac and channel mode register values of all ASICs
+string calibRegisters ( KpixControl *kpix ) {
+   Device       *fpga;
+   Device       *asic;
+   uint          x;
+   uint          col;
+   stringstream  tmp;
+   stringstream  name;
+
+   fpga = kpix->device("cntrlFpga",0);
+   for (x=0; x < fpga->deviceCount("kpixAsic"); x++) {
+      asic = fpga->device("kpixAsic",x);
+      tmp << hex << asic->getRegister("Dac4")->get();
+      for (col=0; col < 32; col++) {
+         name.str("");
+         name << "ChanModeA_0x" << setw(2) << setfill('0') << hex << col;
+         tmp << " " << asic->getRegister(name.str())->get();
+         name.str("");
+         name << "ChanModeB_0x" << setw(2) << setfill('0') << hex << col;
+         tmp << " " << asic->getRegister(name.str())->get();
+      }
+      tmp << endl;
+   }
+   return(tmp.str());
+}
+
+int main (int argc, char **argv) {
+   uint32_t steps = 1000;
+   uint32_t x;
+   double   start;
+   double   timeXml;
+   double   timeTyped;
+   string   cfgXml;
+   string   cfgTyped;
+
+   if ( argc > 1 ) steps = atoi(argv[1]);
+   if ( steps == 0 ) steps = 1;
+
+   try {
+      CommLink    linkXml;
+      CommLink    linkTyped;
+      KpixControl kpixXml(&linkXml,"",5);
+      KpixControl kpixTyped(&linkTyped,"",5);
+
+      linkXml.open();
+      linkTyped.open();
+      kpixXml.parseXmlFile("xml/defaults.xml");
+      kpixTyped.parseXmlFile("xml/defaults.xml");
+
+      // Common starting point, the full calibration setup
+      xmlStep(&kpixXml,&linkXml,9999,0);
+      xmlStep(&kpixTyped,&linkTyped,9999,0);
+
+      cout << "KPiX tree with 5 ASICs, " << dec << steps << " calibration steps" << endl;
+
+      // Channel advances every 8 dac points, as in a calibration scan
+      start = now();
+      for (x=0; x < steps; x++) xmlStep(&kpixXml,&linkXml,(x/8)%1024,(x%8)*32);
+      timeXml = now() - start;
+
+      start = now();
+      for (x=0; x < steps; x++) typedStep(&kpixTyped,&linkTyped,(x/8)%1024,(x%8)*32);
+      timeTyped = now() - start;
+
+      cfgXml   = calibRegisters(&kpixXml);
+      cfgTyped = calibRegisters(&kpixTyped);
+
+      cout << "Register match: " << ((cfgXml == cfgTyped)?"yes":"NO") << endl;
+      cout << setw(8) << left << "xml"   << right << " us/step=" << setw(10) << fixed << setprecision(2) << ((timeXml * 1e6) / steps) << endl;
+      cout << setw(8) << left << "typed" << right << " us/step=" << setw(10) << fixed << setprecision(2) << ((timeTyped * 1e6) / steps) << endl;
+      cout << "Speedup: " << setprecision(1) << (timeXml / timeTyped) << "x" << endl;
+
+      if ( cfgXml != cfgTyped ) return(1);
+
+   } catch ( string error ) {
+      cout << "Caught Error: " << endl;
+      cout << error << endl;
+      return(1);
+   }
+   return(0);
+}
+
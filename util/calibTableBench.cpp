@@ -0,0 +1,279 @@
+//-----------------------------------------------------------------------------
+// File          : calibTableBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of charge conversion through KpixCalibRead lookups by serial
+// number, KpixCalibTable lookups by address and the KpixCalibTable batch
+// conversion of decoded events. A calibration file with random constants
+// for four KPiX is written first. All three must agree. Loading the file
+// from xml is timed against loading its binary cache, which must give the
+// same values. A file with some values parsed after it must keep the others,
+// also when that file has a cache.
+//
+// Usage: calibTableBench [events]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Added binary cache load
+// 10/17/2026: Added check of a cached file parsed after another
+//----------------------------------------------------------------------------
+#include <KpixEvent.h>
+#include <KpixSample.h>
+#include <KpixSampleBatch.h>
+#include <KpixCalibRead.h>
+#include <KpixCalibTable.h>
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Write calibration file with random constants
+bool writeCalib ( string file, vector<string> &serials ) {
+   ofstream os;
+   uint     x;
+   uint     channel;
+   uint     bucket;
+   uint     range;
+
+   os.open(file.c_str());
+   if ( ! os.is_open() ) return(false);
+
+   os << "<calibrationData>" << endl;
+   for (x=0; x < serials.size(); x++) {
+      if ( serials[x] == "" ) continue;
+      os << "<kpixAsic id=\"" << serials[x] << "\">" << endl;
+      for (channel=0; channel < 1024; channel++) {
+         os << "<Channel id=\"" << channel << "\">";
+         for (bucket=0; bucket < 4; bucket++) {
+            os << "<Bucket id=\"" << bucket << "\">";
+            for (range=0; range < 2; range++) {
+               os << "<Range id=\"" << range << "\">";
+               os << "<BaseMean>" << (200 + (rand() % 4000) / 10.0) << "</BaseMean>";
+               if ( (rand() % 64) != 0 ) os << "<CalibGain>" << ((1 + rand() % 1000) * 1e13) << "</CalibGain>";
+               os << "<BaseRms>" << ((rand() % 1000) / 100.0) << "</BaseRms>";
+               os << "<CalibIntercept>" << ((rand() % 1000) / 10.0) << "</CalibIntercept>";
+               if ( (rand() % 256) == 0 ) os << "<CalibCrossTalk>" << channel << " " << rand() << "</CalibCrossTalk>";
+               os << "</Range>";
+            }
+            os << "</Bucket>";
+         }
+         os << "</Channel>" << endl;
+      }
+      os << "</kpixAsic>" << endl;
+   }
+   os << "</calibrationData>" << endl;
+   os.close();
+   return(true);
+}
+
+// Values compared between xml and cache
+static const char *fields[13] = {
+   "baseMean", "baseRms", "baseFitMean", "baseFitSigma", "baseFitMeanErr", "baseFitSigmaErr",
+   "baseFitChisquare", "calibGain", "calibIntercept", "calibGainErr", "calibGainRms",
+   "calibInterceptErr", "calibChisquare" };
+
+int main (int argc, char **argv) {
+   vector<KpixEvent *> events;
+   vector<string>      serials;
+   vector<float>       charge;
+   KpixCalibRead       calibRead;
+   KpixCalibRead      *xmlRead;
+   KpixCalibRead      *cacheRead;
+   KpixCalibTable      calibTable;
+   KpixSampleBatch     batch;
+   KpixSample         *sample;
+   string              file = "/tmp/calibTableBench.xml";
+   string              serial;
+   uint                count;
+   uint                samples;
+   uint                errors;
+   uint                x;
+   uint                y;
+   uint                z;
+   uint               *buff;
+   double              mean;
+   double              gain;
+   double              ref;
+   double              sum[3];
+   double              time[3];
+   double              start;
+   float               res;
+
+   count = 2000;
+   if ( argc > 1 ) count = atoi(argv[1]);
+
+   // Four KPiX on addresses 0 to 3, none on 4
+   srand(1);
+   serials.push_back("0x101");
+   serials.push_back("0x102");
+   serials.push_back("0x103");
+   serials.push_back("0x104");
+   serials.push_back("");
+
+   if ( ! writeCalib(file,serials) ) {
+      cout << "Failed to write " << file << endl;
+      return(1);
+   }
+
+   // Xml alone, xml writing the cache, then the cache
+   unlink(KpixCalibRead::cacheFile(file).c_str());
+   for (x=0; x < 3; x++) {
+      KpixCalibRead *load = (x == 2)?&calibRead:new KpixCalibRead;
+      start = now();
+      if ( ! load->parse(file,(x != 0)) ) {
+         cout << "Failed to parse " << file << endl;
+         return(1);
+      }
+      time[x] = now() - start;
+      if ( x == 1 ) cacheRead = load;
+      else if ( x == 0 ) xmlRead = load;
+   }
+   cout << "Load xml " << fixed << setprecision(3) << time[0] << " sec, xml and write cache "
+        << time[1] << " sec, cache " << time[2] << " sec" << endl;
+
+   // Cache must hold the values of the xml
+   errors = 0;
+   for (x=0; x < serials.size(); x++) {
+      for (y=0; y < 8192; y++) {
+         for (z=0; z < 13; z++) {
+            if ( xmlRead->calibByName(serials[x],y>>3,(y>>1)&3,y&1,fields[z]) !=
+                 calibRead.calibByName(serials[x],y>>3,(y>>1)&3,y&1,fields[z]) ) errors++;
+         }
+         if ( xmlRead->calibCrossTalk(serials[x],y>>3,(y>>1)&3,y&1) !=
+              calibRead.calibCrossTalk(serials[x],y>>3,(y>>1)&3,y&1) ) errors++;
+      }
+   }
+
+   // Gain of one channel from a second file with a cache, parsed after the first
+   {
+      KpixCalibRead first;
+      KpixCalibRead both;
+      ofstream      os;
+      string        file2 = "/tmp/calibTableBench2.xml";
+
+      os.open(file2.c_str());
+      os << "<calibrationData><kpixAsic id=\"" << serials[0] << "\"><Channel id=\"0\"><Bucket id=\"0\"><Range id=\"0\">"
+         << "<CalibGain>5e+13</CalibGain></Range></Bucket></Channel></kpixAsic></calibrationData>" << endl;
+      os.close();
+      first.parse(file2);
+      both.parse(file);
+      both.parse(file2);
+      if ( both.calibGain(serials[0],0,0,0) != 5e13 ||
+           both.baseMean(serials[0],0,0,0) != xmlRead->baseMean(serials[0],0,0,0) ||
+           both.calibIntercept(serials[0],0,0,0) != xmlRead->calibIntercept(serials[0],0,0,0) ) errors++;
+      unlink(file2.c_str());
+      unlink(KpixCalibRead::cacheFile(file2).c_str());
+   }
+   cout << "Cache mismatches=" << dec << errors << endl;
+   delete xmlRead;
+   delete cacheRead;
+   unlink(file.c_str());
+   unlink(KpixCalibRead::cacheFile(file).c_str());
+
+   start = now();
+   calibTable.build(&calibRead,serials);
+   cout << "Table built in " << fixed << setprecision(3) << (now() - start) << " sec" << endl;
+
+   // Events with samples of all five addresses and some temperature samples
+   samples = 0;
+   for (x=0; x < count; x++) {
+      y    = rand() % 1024;
+      buff = (uint *)calloc(8 + 2*y + 1,sizeof(uint));
+      buff[0] = x;
+      for (z=0; z < y; z++) {
+         buff[8+2*z]   = (rand() & 0x3FFF) | ((rand() % 5) << 16) | (((rand() % 8) == 0) << 28);
+         buff[8+2*z+1] = rand();
+      }
+      events.push_back(new KpixEvent);
+      events.back()->copy(buff,8+2*y+1);
+      samples += y;
+      free(buff);
+   }
+   charge.resize(1024);
+
+   // Lookups by serial number as readExample did
+   sum[0] = 0;
+   start  = now();
+   for (x=0; x < count; x++) {
+      for (y=0; y < events[x]->count(); y++) {
+         sample = events[x]->sample(y);
+         if ( sample->getSampleType() != KpixSample::Data ) continue;
+         serial = (sample->getKpixAddress() < serials.size())?serials[sample->getKpixAddress()]:"";
+         mean   = calibRead.baseMean(serial,sample->getKpixChannel(),sample->getKpixBucket(),sample->getSampleRange());
+         gain   = calibRead.calibGain(serial,sample->getKpixChannel(),sample->getKpixBucket(),sample->getSampleRange());
+         if ( gain != 0 ) sum[0] += ((double)sample->getSampleValue() - mean) / gain;
+      }
+   }
+   time[0] = now() - start;
+
+   // Table lookups by address
+   sum[1] = 0;
+   start  = now();
+   for (x=0; x < count; x++) {
+      for (y=0; y < events[x]->count(); y++) {
+         sample = events[x]->sample(y);
+         if ( sample->getSampleType() != KpixSample::Data ) continue;
+         sum[1] += calibTable.charge(sample->getKpixAddress(),sample->getKpixChannel(),
+                                     sample->getKpixBucket(),sample->getSampleRange(),sample->getSampleValue());
+      }
+   }
+   time[1] = now() - start;
+
+   // Batch conversion of decoded events
+   sum[2] = 0;
+   start  = now();
+   for (x=0; x < count; x++) {
+      batch.decode(events[x]);
+      calibTable.charge(&batch,&(charge[0]));
+      for (y=0; y < batch.count(); y++) sum[2] += charge[y];
+   }
+   time[2] = now() - start;
+
+   // Check every sample against the double precision lookup
+   for (x=0; x < count; x++) {
+      batch.decode(events[x]);
+      calibTable.charge(&batch,&(charge[0]));
+      for (y=0; y < batch.count(); y++) {
+         sample = events[x]->sample(y);
+         serial = (sample->getKpixAddress() < serials.size())?serials[sample->getKpixAddress()]:"";
+         mean   = calibRead.baseMean(serial,sample->getKpixChannel(),sample->getKpixBucket(),sample->getSampleRange());
+         gain   = calibRead.calibGain(serial,sample->getKpixChannel(),sample->getKpixBucket(),sample->getSampleRange());
+         ref    = (gain != 0 && sample->getSampleType() == KpixSample::Data)?(((double)sample->getSampleValue() - mean) / gain):0;
+         res    = calibTable.charge(sample->getKpixAddress(),sample->getKpixChannel(),
+                                    sample->getKpixBucket(),sample->getSampleRange(),sample->getSampleValue());
+         if ( sample->getSampleType() != KpixSample::Data ) res = 0;
+         if ( res != charge[y] ) errors++;
+
+         // Float constants, compare against the charge scale of the value
+         if ( gain != 0 && fabs(charge[y] - ref) > (1e-6 * (sample->getSampleValue() + mean) / fabs(gain)) ) errors++;
+         if ( gain == 0 && charge[y] != 0 ) errors++;
+      }
+   }
+
+   cout << "Events=" << dec << count << " samples=" << samples << " mismatches=" << errors << endl;
+   cout << "Serial lookup " << fixed << setprecision(2) << (time[0] * 1e9 / samples) << " ns/sample" << endl;
+   cout << "Table lookup  " << fixed << setprecision(2) << (time[1] * 1e9 / samples) << " ns/sample" << endl;
+   cout << "Batch         " << fixed << setprecision(2) << (time[2] * 1e9 / samples) << " ns/sample" << endl;
+   cout << "Sums " << scientific << setprecision(6) << sum[0] << " " << sum[1] << " " << sum[2] << endl;
+
+   for (x=0; x < count; x++) delete events[x];
+   return((errors == 0)?0:1);
+}
@@ -0,0 +1,204 @@
+//-----------------------------------------------------------------------------
+// File          : cmdRingBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of the shared memory command ring against the single command
+// slot. A ControlServer with a KPiX device tree attached to the generic comm
+// link runs in a second thread. The single slot is driven the way the python
+// client does it, spinning on the ack count. The ring is driven by several
+// client threads, one command in flight each, and by one client keeping a
+// window of commands in flight. Commands of a type the server ignores
+// measure the transport alone, config writes add the server side work.
+// Results never collected must be reclaimed so the ring does not block, and
+// a ticket claimed by a client which died before publishing it is skipped.
+//
+// Usage: cmdRingBench [commands] [clients] [window]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Added uncollected result check
+// 10/17/2026: Added unpublished ticket check
+//----------------------------------------------------------------------------
+#include <CommLink.h>
+#include <KpixControl.h>
+#include <ControlServer.h>
+#include <ControlCmdMem.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+using namespace std;
+
+// Server thread
+ControlServer *server;
+bool           stop;
+
+void *serverRun ( void * ) {
+   server->receive(100,1000000,&stop);
+   return(NULL);
+}
+
+// Client threads
+ControlCmdMemory *cmem;
+uint8_t           cmdType;
+uint32_t          perClient;
+uint32_t          failed;
+
+void *clientRun ( void * ) {
+   char     value[20];
+   uint32_t ticket;
+   uint32_t x;
+
+   for (x=0; x < perClient; x++) {
+      sprintf(value,"0x%x",x & 0xFF);
+      if ( controlCmdRingSubmit(cmem,cmdType,"cntrlFpga(0):kpixAsic(0):DacCalibration",value,&ticket,10000) != 1 ||
+           controlCmdRingResult(cmem,ticket,NULL,NULL,10000) != 1 ) __sync_fetch_and_add(&failed,1);
+   }
+   return(NULL);
+}
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Print result line
+void result ( string name, uint32_t ops, double time ) {
+   cout << setw(36) << left << name << right
+        << " ops/s=" << setw(12) << fixed << setprecision(0) << (ops / time)
+        << " us/op=" << setw(10) << setprecision(2) << ((time * 1e6) / ops) << endl;
+}
+
+int main (int argc, char **argv) {
+   const char  *varPath = "cntrlFpga(0):kpixAsic(0):DacCalibration";
+   uint32_t     count   = 2000;
+   uint32_t     clients = 4;
+   uint32_t     window  = 8;
+   uint32_t     tickets[CONTROL_CMD_RING_SLOTS];
+   uint32_t     x;
+   uint32_t     y;
+   uint32_t     z;
+   string       name;
+   char         value[20];
+   double       start;
+   pthread_t    thread;
+   pthread_t    cthread[64];
+
+   if ( argc > 1 ) count   = atoi(argv[1]);
+   if ( argc > 2 ) clients = atoi(argv[2]);
+   if ( argc > 3 ) window  = atoi(argv[3]);
+   if ( clients == 0 || clients > 64 ) clients = 4;
+   if ( window == 0 || window > CONTROL_CMD_RING_SLOTS ) window = 8;
+   count = ((count + (clients * window) - 1) / (clients * window)) * (clients * window);
+
+   try {
+      CommLink      link;
+      KpixControl   kpix(&link,"",5);
+      ControlServer cntrlServer;
+
+      link.open();
+      cntrlServer.setSystem(&kpix);
+      cntrlServer.enableSharedMemory("cmdRingBench",getpid());
+      controlCmdOpenAndMap(&cmem,"cmdRingBench",getpid());
+
+      server = &cntrlServer;
+      stop   = false;
+      pthread_create(&thread,NULL,serverRun,NULL);
+
+      cout << "KPiX tree with 5 ASICs, " << dec << count << " commands, "
+           << clients << " clients, window " << window << endl;
+
+      // Transport only with a command type the server ignores, then config writes
+      failed = 0;
+      for (z=0; z < 2; z++) {
+         cmdType = (z == 0)?0:CONTROL_CMD_TYPE_SET_CONFIG;
+         name    = (z == 0)?"no-op":"config write";
+
+         // Single command slot
+         start = now();
+         for (x=0; x < count; x++) {
+            sprintf(value,"0x%x",x & 0xFF);
+            controlCmdSetCommand(cmem,cmdType,varPath,value);
+            while ( ! controlCmdGetResult(cmem,NULL) ) usleep(1);
+         }
+         result(name + ", single slot",count,now()-start);
+
+         // Ring, one client
+         perClient = count;
+         start = now();
+         clientRun(NULL);
+         result(name + ", ring, 1 client",count,now()-start);
+
+         // Ring, several clients
+         perClient = count / clients;
+         start = now();
+         for (x=0; x < clients; x++) pthread_create(&cthread[x],NULL,clientRun,NULL);
+         for (x=0; x < clients; x++) pthread_join(cthread[x],NULL);
+         result(name + ", ring, clients",count,now()-start);
+
+         // Ring, one client with a window of commands in flight
+         start = now();
+         for (x=0; x < count; x += window) {
+            for (y=0; y < window; y++) {
+               sprintf(value,"0x%x",(x+y) & 0xFF);
+               if ( controlCmdRingSubmit(cmem,cmdType,varPath,value,&tickets[y],10000) != 1 ) failed++;
+            }
+            for (y=0; y < window; y++)
+               if ( controlCmdRingResult(cmem,tickets[y],NULL,NULL,10000) != 1 ) failed++;
+         }
+         result(name + ", ring, windowed",count,now()-start);
+      }
+
+      // Fill the ring with results nobody collects, the server frees them
+      // after CONTROL_CMD_RING_RECLAIM, reclaim at once here
+      cmdType = 0;
+      for (x=0; x < CONTROL_CMD_RING_SLOTS; x++)
+         if ( controlCmdRingSubmit(cmem,cmdType,varPath,"0",&tickets[x],10000) != 1 ) failed++;
+      start = now();
+      while ( __atomic_load_n(&(cmem->ringTail),__ATOMIC_ACQUIRE) != tickets[CONTROL_CMD_RING_SLOTS-1]+1 && (now()-start) < 10 ) usleep(100);
+      y = controlCmdRingReclaim(cmem,0);
+      if ( controlCmdRingResult(cmem,tickets[0],NULL,NULL,0) != -1 ) failed++;
+      for (x=0; x < CONTROL_CMD_RING_SLOTS; x++)
+         if ( controlCmdRingSubmit(cmem,cmdType,varPath,"0",&tickets[x],1000) != 1 ||
+              controlCmdRingResult(cmem,tickets[x],NULL,NULL,10000) != 1 ) failed++;
+      cout << "Uncollected results reclaimed: " << dec << y << " of " << CONTROL_CMD_RING_SLOTS << endl;
+      if ( y != CONTROL_CMD_RING_SLOTS ) failed++;
+
+      // A client claims a ticket and dies before publishing it. The server
+      // skips it after CONTROL_CMD_RING_PUBLISH and frees its slot with the
+      // uncollected results, reclaim at once here.
+      __atomic_fetch_add(&(cmem->ringHead),1,__ATOMIC_ACQ_REL);
+      start = now();
+      if ( controlCmdRingSubmit(cmem,cmdType,varPath,"0",&tickets[0],1000) != 1 ||
+           controlCmdRingResult(cmem,tickets[0],NULL,NULL,10000) != 1 ) failed++;
+      cout << "Unpublished ticket skipped after " << fixed << setprecision(2) << (now()-start) << " sec" << endl;
+      y = controlCmdRingReclaim(cmem,0);
+      for (x=0; x < CONTROL_CMD_RING_SLOTS; x++)
+         if ( controlCmdRingSubmit(cmem,cmdType,varPath,"0",&tickets[x],1000) != 1 ||
+              controlCmdRingResult(cmem,tickets[x],NULL,NULL,10000) != 1 ) failed++;
+      if ( y != 1 ) failed++;
+
+      if ( failed != 0 ) cout << "Failed commands: " << dec << failed << endl;
+
+      stop = true;
+      pthread_join(thread,NULL);
+
+      if ( failed != 0 ) return(1);
+
+   } catch ( string error ) {
+      cout << "Caught Error: " << endl;
+      cout << error << endl;
+      return(1);
+   }
+   return(0);
+}
@@ -0,0 +1,199 @@
+//-----------------------------------------------------------------------------
+// File          : controlBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of the binary control protocol against the xml control path on
+// a KPiX device tree. No hardware is needed, the tree is attached to the
+// generic comm link which acknowledges all register transactions.
+//
+// The xml path is timed in process, without the socket, the same way the
+// server executes it: parse the message, poll, and for reads parse the
+// returned xml. The binary path is timed over a local socket to a
+// ControlServer running in a second thread.
+//
+// Usage: controlBench [iterations] [batch]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//----------------------------------------------------------------------------
+#include <CommLink.h>
+#include <KpixControl.h>
+#include <ControlServer.h>
+#include <ControlClient.h>
+#include <XmlVariables.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+using namespace std;
+
+// Server thread
+ControlServer *server;
+bool           stop;
+
+void *serverRun ( void * ) {
+   server->receive(1000,1000000,&stop);
+   return(NULL);
+}
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Print result line
+void result ( string name, uint32_t ops, double time ) {
+   cout << setw(36) << left << name << right
+        << " ops/s=" << setw(12) << fixed << setprecision(0) << (ops / time)
+        << " us/op=" << setw(10) << setprecision(2) << ((time * 1e6) / ops) << endl;
+}
+
+int main (int argc, char **argv) {
+   const char  *varPath = "cntrlFpga(0):kpixAsic(0):DacCalibration";
+   const char  *regPath = "cntrlFpga(0):kpixAsic(0):Dac4";
+   uint32_t     iter    = 2000;
+   uint32_t     batch   = 64;
+   uint32_t     x;
+   uint32_t     y;
+   uint32_t     varId;
+   uint32_t     regId;
+   uint32_t     port;
+   double       start;
+   stringstream xml;
+   XmlVariables vars;
+   pthread_t    thread;
+
+   if ( argc > 1 ) iter  = atoi(argv[1]);
+   if ( argc > 2 ) batch = atoi(argv[2]);
+   if ( batch == 0 ) batch = 1;
+   iter = ((iter + batch - 1) / batch) * batch;
+
+   try {
+      CommLink      link;
+      KpixControl   kpix(&link,"",5);
+      ControlServer cntrlServer;
+      ControlClient client;
+
+      link.open();
+      kpix.poll(NULL);
+
+      cout << "KPiX tree with 5 ASICs, " << dec << iter << " operations, batch " << batch << endl;
+
+      // Xml config write
+      start = now();
+      for (x=0; x < iter; x++) {
+         xml.str("");
+         xml << "<system><config><cntrlFpga index=\"0\"><kpixAsic index=\"0\"><DacCalibration>0x"
+             << hex << (x & 0xFF) << "</DacCalibration></kpixAsic></cntrlFpga></config></system>";
+         kpix.parseXmlString(xml.str());
+         kpix.poll(NULL);
+      }
+      result("xml config write",iter,now()-start);
+
+      // Xml config read
+      start = now();
+      for (x=0; x < iter; x++) {
+         vars.clear();
+         vars.parse("config",kpix.configString(false,false).c_str());
+         vars.getInt(varPath);
+      }
+      result("xml config read",iter,now()-start);
+
+      // Xml register read, as ControlServer does for shared memory
+      start = now();
+      for (x=0; x < iter; x++) {
+         xml.str("");
+         xml << "<system><command>" << XmlVariables::setXml("cntrlFpga(0):kpixAsic(0):ReadRegister","Dac4") << "</command></system>";
+         kpix.parseXmlString(xml.str());
+         vars.clear();
+         vars.parse("status",kpix.statusString(true,false,true,true).c_str());
+         vars.get("cntrlFpga(0):kpixAsic(0):ReadRegisterResult");
+         kpix.poll(NULL);
+      }
+      result("xml register read",iter,now()-start);
+
+      // Start server
+      cntrlServer.setSystem(&kpix);
+      port = cntrlServer.startBinaryListen(0);
+      server = &cntrlServer;
+      stop   = false;
+      pthread_create(&thread,NULL,serverRun,NULL);
+
+      client.open("127.0.0.1",port);
+      varId = client.resolve(CONTROL_BIN_KIND_VARIABLE,varPath);
+      regId = client.resolve(CONTROL_BIN_KIND_REGISTER,regPath);
+
+      // Binary config write, one per frame
+      start = now();
+      for (x=0; x < iter; x++) {
+         client.setInt(varId,x & 0xFF);
+         client.apply();
+         client.execute();
+      }
+      result("binary config write",iter,now()-start);
+
+      // Binary config write, batched with one apply
+      start = now();
+      for (x=0; x < iter; x += batch) {
+         for (y=0; y < batch; y++) client.setInt(varId,(x+y) & 0xFF);
+         client.apply();
+         client.execute();
+      }
+      result("binary config write, batched",iter,now()-start);
+
+      // Binary config read
+      start = now();
+      for (x=0; x < iter; x++) {
+         client.getInt(varId);
+         client.execute();
+         client.resultInt(0);
+      }
+      result("binary config read",iter,now()-start);
+
+      // Binary config read, batched
+      start = now();
+      for (x=0; x < iter; x += batch) {
+         for (y=0; y < batch; y++) client.getInt(varId);
+         client.execute();
+      }
+      result("binary config read, batched",iter,now()-start);
+
+      // Binary register read
+      start = now();
+      for (x=0; x < iter; x++) {
+         client.readRegister(regId);
+         client.execute();
+         client.resultInt(0);
+      }
+      result("binary register read",iter,now()-start);
+
+      // Binary register read, batched
+      start = now();
+      for (x=0; x < iter; x += batch) {
+         for (y=0; y < batch; y++) client.readRegister(regId);
+         client.execute();
+      }
+      result("binary register read, batched",iter,now()-start);
+
+      client.close();
+      stop = true;
+      pthread_join(thread,NULL);
+
+   } catch ( string error ) {
+      cout << "Caught Error: " << endl;
+      cout << error << endl;
+      return(1);
+   }
+   return(0);
+}
+
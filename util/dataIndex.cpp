@@ -0,0 +1,74 @@
+//-----------------------------------------------------------------------------
+// File          : dataIndex.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix DAQ
+//-----------------------------------------------------------------------------
+// Description :
+// Build or update the sidecar record index of a data file and summarize it.
+// With -l each run and calibration marker is listed with its record number.
+//
+// Usage: dataIndex [-l] filename
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//----------------------------------------------------------------------------
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <Data.h>
+#include <DataIndex.h>
+using namespace std;
+
+int main (int argc, char **argv) {
+   DataIndex       index;
+   DataIndexEntry *entry;
+   uint64_t        count[8];
+   uint64_t        x;
+   uint32_t        type;
+   bool            list;
+   string          file;
+   const char     *name[8] = { "Raw data", "Config", "Status", "Run start", "Run stop", "Run time", "Cal marker", "Unknown" };
+
+   // Check args
+   list = ( argc == 3 && strcmp(argv[1],"-l") == 0 );
+   if ( argc != 2 && ! list ) {
+      cout << "Usage: dataIndex [-l] filename" << endl;
+      return(1);
+   }
+   file = argv[argc-1];
+
+   if ( ! index.load(file) ) {
+      cout << "Failed to read " << file << endl;
+      return(2);
+   }
+   if ( ! index.save() ) {
+      cout << "Failed to write " << DataIndex::fileName(file) << endl;
+      return(2);
+   }
+
+   memset(count,0,sizeof(count));
+   for (x=0; x < index.count(); x++) {
+      entry = index.entry(x);
+      type  = (entry->header >> 28) & 0xF;
+      if ( type > 7 ) type = 7;
+      count[type]++;
+
+      if ( list && (type == Data::XmlRunStart || type == Data::XmlRunStop || type == Data::CalMarker) ) {
+         cout << setw(10) << dec << x << " " << setw(10) << left << name[type] << right
+              << " offset=" << entry->offset;
+         if ( type == Data::CalMarker )
+            cout << " state=" << entry->calState << " channel=" << entry->calChannel << " dac=" << entry->calDac;
+         cout << endl;
+      }
+   }
+
+   cout << "Index " << DataIndex::fileName(file) << ", " << dec << index.count() << " records" << endl;
+   for (x=0; x < 8; x++)
+      if ( count[x] != 0 ) cout << "   " << setw(10) << left << name[x] << right << " " << count[x] << endl;
+
+   return(0);
+}
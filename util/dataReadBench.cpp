@@ -0,0 +1,178 @@
+//-----------------------------------------------------------------------------
+// File          : dataReadBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of the read(), memory mapped and read ahead DataRead backends.
+// If the file does not exist a data file of KPiX events with periodic xml
+// status records is written first and removed at the end. Each backend is run with the file dropped from
+// the page cache and again with it cached. All must return the same records.
+// Each event is summed work times to simulate processing, the read ahead
+// backend reports the time it waited for the file.
+//
+// Usage: dataReadBench [file] [size_mb] [work]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Added read ahead backend
+//----------------------------------------------------------------------------
+#include <DataRead.h>
+#include <Data.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Write a test file of size MB
+bool writeFile ( string file, uint32_t size ) {
+   uint32_t  buff[8+2*512+1];
+   uint32_t  count;
+   uint32_t  event;
+   uint32_t  x;
+   uint64_t  total;
+   FILE     *f;
+   string    xml;
+
+   if ( (f = fopen(file.c_str(),"w")) == NULL ) return(false);
+
+   total = 0;
+   event = 0;
+   while ( total < ((uint64_t)size << 20) ) {
+
+      // Status record of odd length now and then
+      if ( (event % 1000) == 0 ) {
+         stringstream tmp;
+         tmp << "<status><RunProgress>" << dec << event << "</RunProgress></status>\n";
+         xml   = tmp.str();
+         count = (Data::XmlStatus << 28) | xml.size();
+         fwrite(&count,4,1,f);
+         fwrite(xml.c_str(),xml.size(),1,f);
+         total += 4 + xml.size();
+      }
+
+      // Event with 64 to 511 samples
+      count = 64 + (event * 7919) % 448;
+      buff[0] = event;
+      for (x=1; x < 8+2*count+1; x++) buff[x] = event ^ (x * 2654435761u);
+      x = 8+2*count+1;
+      fwrite(&x,4,1,f);
+      fwrite(buff,4,x,f);
+      total += 4 + (x * 4);
+      event++;
+   }
+   fclose(f);
+   return(true);
+}
+
+// Drop file from the page cache
+void dropCache ( string file ) {
+   int32_t fd;
+
+   if ( (fd = open(file.c_str(),O_RDONLY)) < 0 ) return;
+   fdatasync(fd);
+   posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED);
+   close(fd);
+}
+
+// Read all records, returns sum of all words
+uint64_t readFile ( string file, uint32_t mode, uint32_t work, uint32_t *records, double *time ) {
+   DataRead  dataRead;
+   Data      data;
+   uint64_t  sum;
+   uint32_t *buff;
+   uint32_t  x;
+   uint32_t  y;
+   double    start;
+
+   sum      = 0;
+   *records = 0;
+   start    = now();
+
+   if ( mode == 1 ) dataRead.openMapped(file);
+   else if ( mode == 2 ) dataRead.openPrefetch(file);
+   else dataRead.open(file);
+
+   while ( dataRead.next(&data) ) {
+      buff = data.data();
+      for (x=0; x < data.size(); x++) sum += buff[x];
+      for (y=0; y < work; y++)
+         for (x=0; x < data.size(); x++) sum += (buff[x] ^ y) & 1;
+      (*records)++;
+   }
+   *time = now() - start;
+
+   if ( mode == 2 )
+      cout << "   read MB/s=" << fixed << setprecision(0) << (dataRead.prefetch()->readRate() / (1024 * 1024))
+           << " stalls=" << dec << dataRead.prefetch()->stalls()
+           << " stall sec=" << setprecision(3) << dataRead.prefetch()->stallTime() << endl;
+   dataRead.close();
+   return(sum);
+}
+
+int main (int argc, char **argv) {
+   string    file = "/tmp/dataReadBench.bin";
+   uint32_t  size = 2048;
+   uint32_t  work = 0;
+   bool      written;
+   uint32_t  records[3];
+   uint64_t  sum[3];
+   double    time;
+   double    bytes;
+   uint32_t  x;
+   uint32_t  y;
+
+   if ( argc > 1 ) file = argv[1];
+   if ( argc > 2 ) size = atoi(argv[2]);
+   if ( argc > 3 ) work = atoi(argv[3]);
+
+   written = ( access(file.c_str(),F_OK) != 0 );
+   if ( written ) {
+      cout << "Writing " << dec << size << " MB to " << file << endl;
+      if ( ! writeFile(file,size) ) {
+         cout << "Failed to write " << file << endl;
+         return(1);
+      }
+   }
+
+   // File size
+   {
+      DataRead dataRead;
+      if ( ! dataRead.open(file) ) return(1);
+      bytes = dataRead.size();
+      dataRead.close();
+   }
+
+   for (y=0; y < 2; y++) {
+      for (x=0; x < 3; x++) {
+         if ( y == 0 ) dropCache(file);
+         sum[x] = readFile(file,x,work,&records[x],&time);
+         cout << setw(9) << left << ((x == 0)?"read":((x == 1)?"mmap":"prefetch")) << setw(7) << ((y == 0)?"cold":"cached") << right
+              << " records=" << dec << records[x]
+              << " MB/s=" << setw(8) << fixed << setprecision(0) << ((bytes / (1024 * 1024)) / time)
+              << " sec=" << setprecision(2) << time << endl;
+      }
+      if ( sum[0] != sum[1] || records[0] != records[1] || sum[0] != sum[2] || records[0] != records[2] ) {
+         cout << "Backends differ" << endl;
+         return(1);
+      }
+   }
+   if ( written ) unlink(file.c_str());
+   return(0);
+}
@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+// File          : dataXmlBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of the xml records in DataRead. A data file of KPiX events with
+// a configuration record and a large status record every few events is
+// written first, with a partial status record half way between, as the
+// calibration wrote before the calibration markers. It is read without querying any variable, then querying
+// status variables after each event, which parses every status record as
+// DataRead did for all records. The variables seen must match the records
+// and the final status an immediate parse of the last record. A seek to an
+// event after the last partial record must restore the full status, replaying
+// from the last full status record only.
+//
+// Usage: dataXmlBench [events] [status_period]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Added partial status records and seek check
+// 10/17/2026: Seek must replay from the last full status record
+//----------------------------------------------------------------------------
+#include <DataRead.h>
+#include <DataIndex.h>
+#include <XmlVariables.h>
+#include <Data.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Status of four KPiX with counters of a run in progress
+string statusXml ( uint32_t event ) {
+   stringstream xml;
+   uint32_t     x;
+   uint32_t     y;
+
+   xml << "<status>\n<RunProgress>" << dec << event << "</RunProgress>\n<cntrlFpga index=\"0\">\n";
+   for (x=0; x < 4; x++) {
+      xml << "<kpixAsic index=\"" << x << "\">\n";
+      for (y=0; y < 256; y++) xml << "<Counter" << y << ">0x" << hex << (event * (y + 1)) << dec << "</Counter" << y << ">\n";
+      xml << "</kpixAsic>\n";
+   }
+   xml << "</cntrlFpga>\n</status>\n";
+   return(xml.str());
+}
+
+// Write records, status every period events
+bool writeFile ( string file, uint32_t events, uint32_t period ) {
+   uint32_t buff[8+2*256+1];
+   uint32_t header;
+   uint32_t event;
+   uint32_t x;
+   string   xml;
+   FILE    *f;
+
+   if ( (f = fopen(file.c_str(),"w")) == NULL ) return(false);
+
+   xml    = "<config>\n<RunRate>100Hz</RunRate>\n</config>\n";
+   header = (Data::XmlConfig << 28) | (xml.size() + 1);
+   fwrite(&header,4,1,f);
+   fwrite(xml.c_str(),xml.size() + 1,1,f);
+
+   for (event=0; event < events; event++) {
+      if ( (event % period) == 0 ) {
+         xml    = statusXml(event);
+         header = (Data::XmlStatus << 28) | (xml.size() + 1);
+         fwrite(&header,4,1,f);
+         fwrite(xml.c_str(),xml.size() + 1,1,f);
+      }
+      if ( (event % period) == period / 2 ) {
+         xml    = "<status>\n<CalState>Inject</CalState>\n</status>\n";
+         header = (Data::XmlStatus << 28) | (xml.size() + 1);
+         fwrite(&header,4,1,f);
+         fwrite(xml.c_str(),xml.size() + 1,1,f);
+      }
+      buff[0] = event;
+      for (x=1; x < 8+2*256+1; x++) buff[x] = event ^ (x * 2654435761u);
+      header = 8+2*256+1;
+      fwrite(&header,4,1,f);
+      fwrite(buff,4,header,f);
+   }
+   fclose(f);
+   return(true);
+}
+
+int main (int argc, char **argv) {
+   DataRead     dataRead;
+   XmlVariables vars;
+   Data         data;
+   stringstream expect;
+   string       file = "/tmp/dataXmlBench.bin";
+   uint32_t     events = 200000;
+   uint32_t     period = 100;
+   uint32_t     records[2];
+   uint32_t     errors;
+   uint32_t     event;
+   uint32_t     x;
+   uint64_t     replay;
+   double       time[3];
+   double       start;
+
+   if ( argc > 1 ) events = atoi(argv[1]);
+   if ( argc > 2 ) period = atoi(argv[2]);
+   if ( period == 0 ) period = 1;
+
+   if ( ! writeFile(file,events,period) ) {
+      cout << "Failed to write " << file << endl;
+      return(1);
+   }
+
+   // Events only, and a status query after each event
+   errors = 0;
+   for (x=0; x < 2; x++) {
+      records[x] = 0;
+      start      = now();
+      dataRead.open(file);
+      while ( dataRead.next(&data) ) {
+         if ( x == 1 ) {
+            event = data.data()[0] - (data.data()[0] % period);
+            expect.str("");
+            expect << "0x" << hex << (event * 256);
+            if ( dataRead.getStatusInt("RunProgress") != event ||
+                 dataRead.getStatus("cntrlFpga(0):kpixAsic(3):Counter255") != expect.str() ||
+                 dataRead.getStatus("CalState") != ((data.data()[0] >= period / 2)?"Inject":"") ) errors++;
+         }
+         records[x]++;
+      }
+      time[x] = now() - start;
+
+      // Status of the last record
+      event = (events - 1) - ((events - 1) % period);
+      vars.clear();
+      vars.parse("status",statusXml(event).c_str());
+      if ( dataRead.getConfig("RunRate") != "100Hz" || dataRead.getStatus("RunProgress") != vars.get("RunProgress") ||
+           dataRead.getStatus("CalState") != "Inject" || dataRead.getStatusXml().find(vars.getXml()) == string::npos ) errors++;
+      dataRead.close();
+   }
+
+   // Seek past the last partial record, the full record before it is kept
+   event = (events - 1) - ((events - 1) % period);
+   if ( event + period / 2 < events ) event += period / 2;
+   dataRead.open(file);
+   dataRead.index();
+   start = now();
+   if ( ! dataRead.seekEvent(event) || ! dataRead.next(&data) || data.data()[0] != event ) errors++;
+   time[2] = now() - start;
+   replay  = dataRead.index()->entry(dataRead.index()->findEvent(event))->status;
+   if ( replay != (uint64_t)dataRead.index()->findLast(Data::XmlStatus,dataRead.index()->findEvent(event - (event % period))) )
+      errors++;
+   expect.str("");
+   expect << "0x" << hex << ((event - (event % period)) * 256);
+   if ( dataRead.getStatusInt("RunProgress") != event - (event % period) || dataRead.getStatus("CalState") != "Inject" ||
+        dataRead.getStatus("cntrlFpga(0):kpixAsic(3):Counter255") != expect.str() ) errors++;
+   dataRead.close();
+   unlink(file.c_str());
+   unlink(DataIndex::fileName(file).c_str());
+
+   cout << "Events=" << dec << records[0] << " status every " << period << " mismatches=" << errors << endl;
+   cout << "No queries     " << fixed << setprecision(3) << time[0] << " sec" << endl;
+   cout << "Status queried " << fixed << setprecision(3) << time[1] << " sec" << endl;
+   cout << "Seek to event  " << fixed << setprecision(3) << time[2] << " sec" << endl;
+   return((errors == 0 && records[0] == records[1] && records[0] == events)?0:1);
+}
@@ -6,72 +6,92 @@
 #include <iostream>
 #include <Data.h>
 #include <DataRead.h>
+#include <DataScan.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 using namespace std;
 
-int main (int argc, char **argv) {
-   DataRead      dataRead;
-   KpixEvent     event;
-   KpixSample    *sample;
-   KpixCalibRead calibRead;
-   uint          x;
-   double        mean;
-   double        gain;
-   double        charge;
-   uint          count;
-   stringstream  tmp;
-   string        serialList[32];
-   string        serial;
-   uint          hitCount[32][1024][4];
-   uint          kpix, chan, buck;
+// Hit counts of one scan thread
+class HitMap : public DataScanProcessor {
+   public:
+      KpixEvent event;
+      uint      hitCount[32][1024][4];
 
-   // Check args
-   if ( argc != 2 ) {
-      cout << "Usage: hitMap datafile.bin" << endl;
-      return(1);
-   }
+      HitMap ( ) {
+         memset(hitCount,0,sizeof(hitCount));
+      }
 
-   // Attempt to open data file
-   if ( ! dataRead.open(argv[1]) ) {
-      cout << "Error opening file " << argv[1] << endl;
-      return(2);
-   }
+      Data *data ( ) {
+         return(&event);
+      }
 
-   for ( kpix = 0; kpix < 32; kpix++ ) {
-      for ( chan = 0; chan < 1024; chan++ ) {
-         for ( buck = 0; buck < 4; buck++ ) {
-            hitCount[kpix][chan][buck] = 0;
+      void process ( Data *data, DataRead *dataRead ) {
+         KpixSample *sample;
+         uint        x;
+
+         // Iterate through samples
+         for (x=0; x < event.count(); x++) {
+
+            // Get sample
+            sample = event.sample(x);
+
+            hitCount[sample->getKpixAddress()][sample->getKpixChannel()][sample->getKpixBucket()]++;
          }
       }
-   }
 
+      void merge ( DataScanProcessor *other ) {
+         HitMap *hm = (HitMap *)other;
+         uint    kpix, chan, buck;
 
-   // Process each event
-   count = 0;
-   while ( dataRead.next(&event) ) {
+         for ( kpix = 0; kpix < 32; kpix++ )
+            for ( chan = 0; chan < 1024; chan++ )
+               for ( buck = 0; buck < 4; buck++ )
+                  hitCount[kpix][chan][buck] += hm->hitCount[kpix][chan][buck];
+      }
+};
 
-      // Iterate through samples
-      for (x=0; x < event.count(); x++) {
+int main (int argc, char **argv) {
+   DataScan                   dataScan;
+   vector<DataScanProcessor*> procs;
+   HitMap                     *hitMap;
+   uint                       threads;
+   uint                       x;
+   uint                       kpix, chan, buck;
 
-         // Get sample
-         sample = event.sample(x);
+   // Check args
+   if ( argc != 2 && argc != 3 ) {
+      cout << "Usage: hitMap datafile.bin [threads]" << endl;
+      return(1);
+   }
+   if ( argc == 3 ) threads = atoi(argv[2]);
+   else threads = sysconf(_SC_NPROCESSORS_ONLN);
+   if ( threads < 1 ) threads = 1;
 
-         hitCount[sample->getKpixAddress()][sample->getKpixChannel()][sample->getKpixBucket()]++;
-      }
+   // One processor per thread
+   for (x=0; x < threads; x++) procs.push_back(new HitMap);
+
+   // Process each event
+   if ( dataScan.scan(argv[1],procs) < 0 ) {
+      cout << "Error opening file " << argv[1] << endl;
+      return(2);
    }
+   hitMap = (HitMap *)procs[0];
 
    for ( kpix = 0; kpix < 32; kpix++ ) {
       for ( chan = 0; chan < 1024; chan++ ) {
          for ( buck = 0; buck < 4; buck++ ) {
             cout << "Kpix=" << dec << kpix << ", Channel=" << dec << chan;
-            cout << " b0=" << dec << hitCount[kpix][chan][0];
-            cout << " b1=" << dec << hitCount[kpix][chan][1];
-            cout << " b2=" << dec << hitCount[kpix][chan][2];
-            cout << " b3=" << dec << hitCount[kpix][chan][3];
+            cout << " b0=" << dec << hitMap->hitCount[kpix][chan][0];
+            cout << " b1=" << dec << hitMap->hitCount[kpix][chan][1];
+            cout << " b2=" << dec << hitMap->hitCount[kpix][chan][2];
+            cout << " b3=" << dec << hitMap->hitCount[kpix][chan][3];
             cout << endl;
          }
       }
    }
 
+   for (x=0; x < procs.size(); x++) delete procs[x];
    return(0);
 }
 
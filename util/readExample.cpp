@@ -12,10 +12,12 @@
 //-----------------------------------------------------------------------------
 // Modification history :
 // 12/02/2011: created
+// 10/17/2026: Calibration constants from a KpixCalibTable
 //----------------------------------------------------------------------------
 #include <KpixEvent.h>
 #include <KpixSample.h>
 #include <KpixCalibRead.h>
+#include <KpixCalibTable.h>
 #include <iomanip>
 #include <fstream>
 #include <iostream>
@@ -28,6 +30,8 @@ int main (int argc, char **argv) {
    KpixEvent     event;
    KpixSample    *sample;
    KpixCalibRead calibRead;
+   KpixCalibTable calibTable;
+   vector<string> serials;
    uint          x;
    double        mean;
    double        gain;
@@ -64,6 +68,10 @@ int main (int argc, char **argv) {
             tmp << "cntrlFpga(0):kpixAsic(" << dec << x << "):SerialNumber";
             serialList[x] = dataRead.getConfig(tmp.str());
          }
+
+         // Serial numbers are resolved once
+         serials.assign(serialList,serialList+32);
+         calibTable.build(&calibRead,serials);
       }
 
       if ( dataRead.sawRunStop()  ) dataRead.dumpRunStop();
@@ -110,12 +118,12 @@ int main (int argc, char **argv) {
          if ( sample->getSampleType() == KpixSample::Data ) {
 
             // Get gain and mean for channel/bucket
-            mean = calibRead.baseMean(serial,sample->getKpixChannel(),
-                                             sample->getKpixBucket(),
-                                             sample->getSampleRange());
-            gain = calibRead.calibGain(serial,sample->getKpixChannel(),
-                                              sample->getKpixBucket(),
-                                              sample->getSampleRange());
+            mean = calibTable.baseMean(sample->getKpixAddress(),sample->getKpixChannel(),
+                                                                sample->getKpixBucket(),
+                                                                sample->getSampleRange());
+            gain = calibTable.calibGain(sample->getKpixAddress(),sample->getKpixChannel(),
+                                                                 sample->getKpixBucket(),
+                                                                 sample->getSampleRange());
 
             // compute charge value from calibration
             if ( gain != 0 ) {
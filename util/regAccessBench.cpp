@@ -0,0 +1,147 @@
+//-----------------------------------------------------------------------------
+// File          : regAccessBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of shared memory register reads and writes. The former xml path,
+// a ReadRegister command followed by a status string parsed for the result,
+// is timed in process as a reference. The shared memory commands are timed
+// through the command ring against a ControlServer in a second thread, they
+// resolve the register once and access it directly. Each write is read back.
+//
+// Usage: regAccessBench [accesses]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//----------------------------------------------------------------------------
+#include <CommLink.h>
+#include <KpixControl.h>
+#include <ControlServer.h>
+#include <ControlCmdMem.h>
+#include <XmlVariables.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+using namespace std;
+
+// Server thread
+ControlServer *server;
+bool           stop;
+
+void *serverRun ( void * ) {
+   server->receive(100,1000000,&stop);
+   return(NULL);
+}
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Print result line
+void result ( string name, uint32_t ops, double time ) {
+   cout << setw(28) << left << name << right
+        << " ops/s=" << setw(12) << fixed << setprecision(0) << (ops / time)
+        << " us/op=" << setw(10) << setprecision(2) << ((time * 1e6) / ops) << endl;
+}
+
+// Ring command, returns result or throws on error
+string ringCommand ( ControlCmdMemory *cmem, uint8_t type, const char *argA, const char *argB ) {
+   char     result[CONTROL_CMD_RESULT_SIZE];
+   char     error[CONTROL_CMD_ERROR_SIZE];
+   uint32_t ticket;
+
+   if ( controlCmdRingSubmit(cmem,type,argA,argB,&ticket,10000) != 1 ||
+        controlCmdRingResult(cmem,ticket,result,error,10000) != 1 ) throw(string("Command timeout"));
+   if ( error[0] != '\0' ) throw(string(error));
+   return(result);
+}
+
+int main (int argc, char **argv) {
+   ControlCmdMemory *cmem;
+   XmlVariables      vars;
+   const char       *devPath = "cntrlFpga(0):kpixAsic(0)";
+   uint32_t          count   = 2000;
+   uint32_t          failed;
+   uint32_t          x;
+   char              value[40];
+   string            ret;
+   double            start;
+   pthread_t         thread;
+
+   if ( argc > 1 ) count = atoi(argv[1]);
+   if ( count == 0 ) count = 1;
+
+   try {
+      CommLink      link;
+      KpixControl   kpix(&link,"",5);
+      ControlServer cntrlServer;
+
+      link.open();
+      kpix.parseXmlFile("xml/defaults.xml");
+
+      cout << "KPiX tree with 5 ASICs, " << dec << count << " accesses" << endl;
+
+      // Former path, in process without the command transport
+      start = now();
+      for (x=0; x < count; x++) {
+         kpix.parseXmlString(string("<system><command>") + vars.setXml(string(devPath) + ":ReadRegister","TimerA") + "</command></system>\n");
+         vars.clear();
+         vars.parse("status",kpix.statusString(true,false,true,true).c_str());
+         ret = vars.get(string(devPath) + ":ReadRegisterResult");
+      }
+      result("xml read, in process",count,now()-start);
+
+      cntrlServer.setSystem(&kpix);
+      cntrlServer.enableSharedMemory("regAccessBench",getpid());
+      controlCmdOpenAndMap(&cmem,"regAccessBench",getpid());
+
+      server = &cntrlServer;
+      stop   = false;
+      pthread_create(&thread,NULL,serverRun,NULL);
+
+      // Reads through the ring
+      start = now();
+      for (x=0; x < count; x++) ringCommand(cmem,CONTROL_CMD_TYPE_GET_REGISTER,devPath,"TimerA");
+      result("direct read, ring",count,now()-start);
+
+      // Writes through the ring, each read back
+      failed = 0;
+      start = now();
+      for (x=0; x < count; x++) {
+         sprintf(value,"TimerA 0x%x",x);
+         ringCommand(cmem,CONTROL_CMD_TYPE_SET_REGISTER,devPath,value);
+         sprintf(value,"0x%x",x);
+         if ( ringCommand(cmem,CONTROL_CMD_TYPE_GET_REGISTER,devPath,"TimerA") != value ) failed++;
+      }
+      result("direct write+read, ring",count,now()-start);
+
+      // Unknown register is reported as a command error
+      try {
+         ringCommand(cmem,CONTROL_CMD_TYPE_GET_REGISTER,devPath,"NoSuchRegister");
+         failed++;
+      } catch ( string error ) { }
+
+      stop = true;
+      pthread_join(thread,NULL);
+
+      cout << "Read back mismatches: " << dec << failed << endl;
+      if ( failed != 0 ) return(1);
+
+   } catch ( string error ) {
+      cout << "Caught Error: " << endl;
+      cout << error << endl;
+      return(1);
+   }
+   return(0);
+}
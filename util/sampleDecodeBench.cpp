@@ -0,0 +1,159 @@
+//-----------------------------------------------------------------------------
+// File          : sampleDecodeBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of KpixSampleBatch against the KpixSample accessors. Random
+// events are decoded both ways, with and without filters, and must match.
+//
+// Usage: sampleDecodeBench [events]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//----------------------------------------------------------------------------
+#include <KpixEvent.h>
+#include <KpixSample.h>
+#include <KpixSampleBatch.h>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Compare batch with the accessors, returns number of mismatches
+uint compare ( KpixEvent *event, KpixSampleBatch *batch, int address, int type ) {
+   KpixSample *sample;
+   uint        errors;
+   uint        flags;
+   uint        x;
+   uint        y;
+
+   errors = 0;
+   batch->decode(event,address,type);
+
+   for (x=0, y=0; x < event->count(); x++) {
+      sample = event->sample(x);
+      if ( address >= 0 && (int)sample->getKpixAddress() != address ) continue;
+      if ( type >= 0 && (int)sample->getSampleType() != type ) continue;
+
+      flags = sample->getEmpty() | (sample->getBadCount() << 1) | (sample->getTrigType() << 2);
+      if ( y >= batch->count() ||
+           batch->address()[y] != sample->getKpixAddress() ||
+           batch->channel()[y] != sample->getKpixChannel() ||
+           batch->bucket()[y]  != sample->getKpixBucket()  ||
+           batch->range()[y]   != sample->getSampleRange() ||
+           batch->time()[y]    != sample->getSampleTime()  ||
+           batch->value()[y]   != sample->getSampleValue() ||
+           batch->flags()[y]   != flags                    ||
+           batch->type()[y]    != (uint)sample->getSampleType() ) errors++;
+      y++;
+   }
+   if ( y != batch->count() ) errors++;
+   return(errors);
+}
+
+int main (int argc, char **argv) {
+   vector<KpixEvent *> events;
+   KpixSampleBatch     batch;
+   KpixSample         *sample;
+   uint                count;
+   uint                errors;
+   uint                x;
+   uint                y;
+   uint                z;
+   uint                sum;
+   uint                samples;
+   uint               *buff;
+   double              start;
+   double              timeS;
+   double              timeB;
+   double              timeD;
+
+   count = 10000;
+   if ( argc > 1 ) count = atoi(argv[1]);
+
+   // Events of 0 to 1023 samples from 4 KPiX with some temperature samples
+   srand(1);
+   samples = 0;
+   for (x=0; x < count; x++) {
+      y    = rand() % 1024;
+      buff = (uint *)calloc(8 + 2*y + 1,sizeof(uint));
+      buff[0] = x;
+      for (z=0; z < y; z++) {
+         buff[8+2*z]   = (rand() & 0xFFFF) | ((rand() % 4) << 16) | (((rand() % 8) == 0) << 28);
+         buff[8+2*z+1] = rand();
+      }
+      events.push_back(new KpixEvent);
+      events.back()->copy(buff,8+2*y+1);
+      samples += y;
+      free(buff);
+   }
+
+   // Check
+   errors = 0;
+   for (x=0; x < count; x++) {
+      errors += compare(events[x],&batch,-1,-1);
+      errors += compare(events[x],&batch,x % 4,-1);
+      errors += compare(events[x],&batch,-1,KpixSample::Data);
+      errors += compare(events[x],&batch,1,KpixSample::Temperature);
+   }
+   cout << "Events=" << dec << count << " samples=" << samples << " mismatches=" << errors << endl;
+
+   // Sum of all fields through the accessors
+   sum   = 0;
+   start = now();
+   for (x=0; x < count; x++) {
+      for (y=0; y < events[x]->count(); y++) {
+         sample = events[x]->sample(y);
+         sum += sample->getKpixAddress() + sample->getKpixChannel() + sample->getKpixBucket() +
+                sample->getSampleRange() + sample->getSampleTime() + sample->getSampleValue() +
+                sample->getEmpty() + sample->getBadCount() + sample->getTrigType() + sample->getSampleType();
+      }
+   }
+   timeS = now() - start;
+
+   // Same through the batch
+   start = now();
+   for (x=0; x < count; x++) {
+      batch.decode(events[x]);
+      const uint16_t *address = batch.address();
+      const uint16_t *channel = batch.channel();
+      const uint8_t  *bucket  = batch.bucket();
+      const uint8_t  *range   = batch.range();
+      const uint16_t *time    = batch.time();
+      const uint16_t *value   = batch.value();
+      const uint8_t  *flags   = batch.flags();
+      const uint8_t  *type    = batch.type();
+      for (y=0; y < batch.count(); y++) {
+         sum -= address[y] + channel[y] + bucket[y] + range[y] + time[y] + value[y] +
+                (flags[y] & 1) + ((flags[y] >> 1) & 1) + (flags[y] >> 2) + type[y];
+      }
+   }
+   timeB = now() - start;
+
+   // Decode alone
+   start = now();
+   for (x=0; x < count; x++) batch.decode(events[x]);
+   timeD = now() - start;
+
+   cout << "Accessors " << fixed << setprecision(2) << (timeS * 1e9 / samples) << " ns/sample" << endl;
+   cout << "Batch     " << fixed << setprecision(2) << (timeB * 1e9 / samples) << " ns/sample" << endl;
+   cout << "Decode    " << fixed << setprecision(2) << (timeD * 1e9 / samples) << " ns/sample" << endl;
+   if ( sum != 0 ) cout << "Sums differ" << endl;
+
+   for (x=0; x < count; x++) delete events[x];
+   return((errors == 0 && sum == 0)?0:1);
+}
@@ -0,0 +1,183 @@
+//-----------------------------------------------------------------------------
+// File          : snapshotBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of single variable gets from the shared memory config and status
+// snapshot against parsing the xml buffers, which is what each get cost
+// before the snapshot. A KPiX device tree is attached to the generic comm
+// link and polled into the shared memory of a ControlServer. Every snapshot
+// entry is checked against the value parsed from the xml buffers. Keys which
+// are not in the variable list must be gone after the list changes.
+//
+// Usage: snapshotBench [gets]
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Empty xml buffers are not parsed
+// 10/17/2026: Added check of keys removed from the snapshot
+//----------------------------------------------------------------------------
+#include <CommLink.h>
+#include <KpixControl.h>
+#include <ControlServer.h>
+#include <ControlCmdMem.h>
+#include <XmlVariables.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stdlib.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Parse the xml buffers holding a kind of entry. The per status buffer is
+// empty after a full status, libxml would report an empty document.
+void parseBuffers ( XmlVariables &vars, ControlCmdMemory *cmem, uint8_t kind ) {
+   const char *status;
+
+   if ( kind == CONTROL_CMD_SNAP_CONFIG ) vars.parse("config",controlCmdGetConfig(cmem));
+   else {
+      vars.parse("status",controlCmdGetStatus(cmem));
+      status = controlCmdGetPerStatus(cmem);
+      if ( status[0] != '\0' ) vars.parse("status",status);
+   }
+}
+
+// Print result line
+void result ( string name, uint32_t ops, double time ) {
+   cout << setw(28) << left << name << right
+        << " ops/s=" << setw(12) << fixed << setprecision(0) << (ops / time)
+        << " us/op=" << setw(10) << setprecision(2) << ((time * 1e6) / ops) << endl;
+}
+
+int main (int argc, char **argv) {
+   ControlCmdMemory    *cmem;
+   ControlCmdSnapEntry *entry;
+   XmlVariables         vars;
+   vector<string>       keys;
+   vector<uint8_t>      kinds;
+   char                 value[CONTROL_CMD_SNAP_VALUE_SIZE];
+   uint32_t             gets = 20000;
+   uint32_t             x;
+   uint32_t             y;
+   uint32_t             mismatch;
+   uint32_t             missing;
+   uint32_t             entries;
+   string               parsed;
+   double               start;
+
+   if ( argc > 1 ) gets = atoi(argv[1]);
+   if ( gets == 0 ) gets = 1;
+
+   try {
+      CommLink      link;
+      KpixControl   kpix(&link,"",5);
+      ControlServer cntrlServer;
+
+      link.open();
+      kpix.parseXmlFile("xml/defaults.xml");
+      cntrlServer.setSystem(&kpix);
+      cntrlServer.enableSharedMemory("snapshotBench",getpid());
+      controlCmdOpenAndMap(&cmem,"snapshotBench",getpid());
+
+      // Publish the config and full status
+      kpix.parseXmlString("<system><command><ReadStatus/></command></system>");
+      kpix.poll(cmem);
+
+      // Check each entry against the xml buffers
+      mismatch = 0;
+      missing  = 0;
+      for (x=0; x < CONTROL_CMD_SNAP_SLOTS; x++) {
+         entry = &(cmem->snapshot.entry[x]);
+         if ( entry->hash == 0 || entry->truncated ) continue;
+
+         vars.clear();
+         parseBuffers(vars,cmem,entry->kind);
+         parsed = vars.get(entry->key);
+         if ( parsed != entry->value ) {
+            if ( parsed == "" ) missing++;
+            else {
+               mismatch++;
+               cout << "Mismatch " << entry->key << ": '" << entry->value << "' != '" << parsed << "'" << endl;
+            }
+         }
+         keys.push_back(entry->key);
+         kinds.push_back(entry->kind);
+      }
+
+      cout << "KPiX tree with 5 ASICs, " << dec << cmem->snapshot.count << " snapshot entries, "
+           << mismatch << " mismatched, " << missing << " empty in xml" << endl;
+
+      // Gets by parsing the xml buffers
+      start = now();
+      for (x=0; x < gets; x++) {
+         y = x % keys.size();
+         parseBuffers(vars,cmem,kinds[y]);
+         parsed = vars.get(keys[y]);
+      }
+      result("xml parse get",gets,now()-start);
+
+      // Gets from the snapshot
+      start = now();
+      for (x=0; x < gets; x++) {
+         y = x % keys.size();
+         if ( controlCmdSnapGet(cmem,kinds[y],keys[y].c_str(),value) != 1 ) mismatch++;
+      }
+      result("snapshot get",gets,now()-start);
+
+      // Poll with and without a changed variable to publish
+      start = now();
+      for (x=0; x < 1000; x++) kpix.poll(cmem);
+      result("poll, no change",1000,now()-start);
+
+      start = now();
+      for (x=0; x < 1000; x++) {
+         kpix.getVariable("RegRxCount")->setInt(x);
+         kpix.poll(cmem);
+      }
+      result("poll, one change",1000,now()-start);
+
+      kpix.getVariable("RegRxCount")->setInt(12345);
+      kpix.poll(cmem);
+      if ( controlCmdSnapGet(cmem,CONTROL_CMD_SNAP_STATUS,"RegRxCount",value) != 1 || string(value) != "0x3039" ) {
+         cout << "Snapshot not updated: " << value << endl;
+         mismatch++;
+      }
+
+      // A key which left the variable list, then move the common values to
+      // another ASIC, which changes the list and publishes it again
+      entries = cmem->snapshot.count;
+      controlCmdSnapBegin(cmem);
+      controlCmdSnapSet(cmem,CONTROL_CMD_SNAP_STATUS,"cntrlFpga(0):Removed","1");
+      controlCmdSnapEnd(cmem);
+      kpix.parseXmlString("<system><config><cntrlFpga index=\"0\"><kpixAsic index=\"0\"><Enabled>False</Enabled>"
+                          "</kpixAsic></cntrlFpga></config></system>");
+      kpix.poll(cmem);
+      if ( controlCmdSnapGet(cmem,CONTROL_CMD_SNAP_STATUS,"cntrlFpga(0):Removed",value) != 0 ||
+           controlCmdSnapGet(cmem,CONTROL_CMD_SNAP_STATUS,"RegRxCount",value) != 1 || string(value) != "0x3039" ||
+           cmem->snapshot.count != entries ) {
+         cout << "Removed key kept, " << dec << cmem->snapshot.count << " snapshot entries" << endl;
+         mismatch++;
+      }
+
+      if ( mismatch != 0 ) return(1);
+
+   } catch ( string error ) {
+      cout << "Caught Error: " << endl;
+      cout << error << endl;
+      return(1);
+   }
+   return(0);
+}
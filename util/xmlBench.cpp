@@ -0,0 +1,123 @@
+//-----------------------------------------------------------------------------
+// File          : xmlBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of the status, config and structure xml generation on a
+// KPiX device tree. No hardware is needed, the tree is attached to an
+// unopened generic comm link. Reports time and heap allocations per call.
+//
+// Usage: xmlBench [iterations] [kpixCount] [-d]
+//    -d dumps the generated strings instead of timing them.
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+//----------------------------------------------------------------------------
+#include <CommLink.h>
+#include <KpixControl.h>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <new>
+using namespace std;
+
+// Heap allocation counters
+static unsigned long allocCount = 0;
+static unsigned long allocBytes = 0;
+
+void * operator new ( size_t size ) {
+   void *ptr;
+   __sync_fetch_and_add(&allocCount,1);
+   __sync_fetch_and_add(&allocBytes,size);
+   if ( (ptr = malloc(size==0?1:size)) == NULL ) throw bad_alloc();
+   return(ptr);
+}
+
+void operator delete ( void *ptr ) noexcept { free(ptr); }
+void operator delete ( void *ptr, size_t ) noexcept { free(ptr); }
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Generate one of the tested strings
+string gen ( KpixControl *kpix, uint32_t type ) {
+   switch ( type ) {
+      case 0  : return(kpix->statusString(true,false,false,true));
+      case 1  : return(kpix->statusString(false,false,true,true));
+      case 2  : return(kpix->configString(true,false));
+      default : return(kpix->structureString(false,false));
+   }
+}
+
+int main (int argc, char **argv) {
+   const char   *names[4] = { "statusString(full)", "statusString(compact)", "configString", "structureString" };
+   uint32_t     iter      = 1000;
+   uint32_t     count     = 5;
+   bool         dump      = false;
+   uint32_t     x;
+   uint32_t     i;
+   uint32_t     len;
+   unsigned long allocs;
+   unsigned long bytes;
+   double       start;
+   double       time;
+   string       result;
+
+   for (x=1; x < (uint32_t)argc; x++) {
+      if ( strcmp(argv[x],"-d") == 0 ) dump = true;
+      else if ( x == 1 || (x == 2 && dump) ) iter = atoi(argv[x]);
+      else count = atoi(argv[x]);
+   }
+
+   try {
+      CommLink    link;
+      KpixControl kpix(&link,"",count);
+
+      if ( dump ) {
+         for (x=0; x < 4; x++) cout << gen(&kpix,x);
+         return(0);
+      }
+
+      cout << "KPiX tree with " << dec << count << " ASICs, " << iter << " iterations" << endl;
+
+      for (x=0; x < 4; x++) {
+
+         // Warm up, lets reusable buffers reach their working size
+         len = gen(&kpix,x).size();
+
+         allocs = allocCount;
+         bytes  = allocBytes;
+         start  = now();
+
+         for (i=0; i < iter; i++) result = gen(&kpix,x);
+
+         time   = now() - start;
+         allocs = allocCount - allocs;
+         bytes  = allocBytes - bytes;
+
+         cout << setw(24) << left << names[x] << right
+              << " len="        << setw(8) << len
+              << " us/call="    << setw(10) << fixed << setprecision(2) << ((time * 1e6) / iter)
+              << " allocs/call=" << setw(8) << (allocs / iter)
+              << " bytes/call="  << setw(10) << (bytes / iter) << endl;
+      }
+
+   } catch ( string error ) {
+      cout << "Caught Error: " << endl;
+      cout << error << endl;
+      return(1);
+   }
+   return(0);
+}
+
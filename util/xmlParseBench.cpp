@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// File          : xmlParseBench.cpp
+// Author        : KPiX DAQ Group
+// Created       : 10/17/2026
+// Project       : Kpix
+//-----------------------------------------------------------------------------
+// Description :
+// Benchmark of the streaming xml parse against the document tree parse when
+// applying a configuration file to a KPiX device tree. No hardware is
+// needed, the tree is attached to the generic comm link which acknowledges
+// all register transactions. Both paths are checked to produce the same
+// configuration, and a truncated file must leave the configuration
+// unchanged. The parse is timed with the hardware write skipped, then
+// with it, which dominates.
+//
+// Usage: xmlParseBench [iterations] [file]
+//    file defaults to xml/defaults.xml
+//-----------------------------------------------------------------------------
+// Copyright (c) 2026 by SLAC. All rights reserved.
+// Proprietary and confidential to SLAC.
+//-----------------------------------------------------------------------------
+// Modification history :
+// 10/17/2026: created
+// 10/17/2026: Added parse only timing and truncated input check
+// 10/17/2026: Document tree reference parse moved here from System
+//----------------------------------------------------------------------------
+#include <CommLink.h>
+#include <KpixControl.h>
+#include <libxml/parser.h>
+#include <libxml/xmlerror.h>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+using namespace std;
+
+// Time in seconds
+double now ( ) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return(ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+// Drops libxml messages of the truncated input
+void quietError ( void *ctx, const char *msg, ... ) { }
+
+// Exposes the streaming parse and a document tree reference parse, the
+// config write can be skipped
+class BenchControl : public KpixControl {
+   public:
+      bool skipWrite;
+
+      BenchControl ( CommLink *link ) : KpixControl(link,"",5) { skipWrite = false; }
+      bool stream ( string xml ) { return(parseXml(xml,false)); }
+
+      // Reference, the whole string is parsed into a tree before it is applied
+      bool dom ( string xml ) {
+         xmlDocPtr  doc;
+         xmlNodePtr childNode;
+         const char *childName;
+         bool       configUpdate;
+
+         doc = xmlReadMemory(xml.c_str(), xml.length(), "bench", NULL, 0);
+         if ( doc == NULL ) return(false);
+
+         configUpdate = false;
+         for ( childNode = xmlDocGetRootElement(doc)->children; childNode; childNode = childNode->next ) {
+            if ( childNode->type != XML_ELEMENT_NODE ) continue;
+            childName = (const char *)childNode->name;
+
+            if ( strcmp(childName,"config") == 0 ) {
+               if ( setXmlConfig(childNode) ) {
+                  writeConfig(false);
+                  configUpdate = true;
+               }
+            }
+            else if ( strcmp(childName,"command") == 0 ) execXmlCommand(childNode);
+         }
+         xmlFreeDoc(doc);
+         return(configUpdate);
+      }
+
+      void writeConfig ( bool force ) {
+         if ( ! skipWrite ) KpixControl::writeConfig(force);
+      }
+};
+
+// Time iterations of both paths
+void timeParse ( BenchControl *kpixDom, BenchControl *kpixStream, string xml, uint32_t iter, string name ) {
+   double   start;
+   double   timeDom;
+   double   timeStream;
+   uint32_t x;
+
+   start = now();
+   for (x=0; x < iter; x++) kpixDom->dom(xml);
+   timeDom = now() - start;
+
+   start = now();
+   for (x=0; x < iter; x++) kpixStream->stream(xml);
+   timeStream = now() - start;
+
+   cout << name << endl;
+   cout << setw(8) << left << "   dom"    << right << " us/parse=" << setw(10) << fixed << setprecision(2) << ((timeDom * 1e6) / iter) << endl;
+   cout << setw(8) << left << "   stream" << right << " us/parse=" << setw(10) << fixed << setprecision(2) << ((timeStream * 1e6) / iter) << endl;
+   cout << "   Speedup: " << setprecision(2) << (timeDom / timeStream) << "x" << endl;
+}
+
+int main (int argc, char **argv) {
+   uint32_t     iter = 1000;
+   string       file = "xml/defaults.xml";
+   string       xml;
+   string       cfgDom;
+   string       cfgStream;
+   string       cfgTrunc;
+   string       trunc;
+   bool         same;
+   stringstream buffer;
+   ifstream     is;
+
+   if ( argc > 1 ) iter = atoi(argv[1]);
+   if ( argc > 2 ) file = argv[2];
+   if ( iter == 0 ) iter = 1;
+
+   is.open(file.c_str());
+   if ( ! is.is_open() ) {
+      cout << "Failed to open " << file << endl;
+      return(1);
+   }
+   buffer << is.rdbuf();
+   is.close();
+   xml = buffer.str();
+
+   try {
+      CommLink     linkDom;
+      CommLink     linkStream;
+      BenchControl kpixDom(&linkDom);
+      BenchControl kpixStream(&linkStream);
+
+      linkDom.open();
+      linkStream.open();
+
+      // Both paths must give the same configuration
+      kpixDom.dom(xml);
+      kpixStream.stream(xml);
+      cfgDom    = kpixDom.configString(false,false);
+      cfgStream = kpixStream.configString(false,false);
+
+      // Truncated input, the values before the error must not be applied
+      trunc = xml.substr(0,xml.size() / 2);
+      kpixStream.set("RunCount","7");
+      cfgTrunc = kpixStream.configString(false,false);
+      xmlSetGenericErrorFunc(NULL,quietError);
+      try { kpixStream.stream(trunc); } catch ( string error ) { }
+      xmlSetGenericErrorFunc(NULL,NULL);
+      same = (kpixStream.configString(false,false) == cfgTrunc);
+
+      cout << file << ", " << dec << xml.size() << " bytes, " << iter << " iterations" << endl;
+      cout << "Config match: " << ((cfgDom == cfgStream)?"yes":"NO") << endl;
+      cout << "Truncated input unchanged: " << (same?"yes":"NO") << endl;
+
+      kpixDom.skipWrite    = true;
+      kpixStream.skipWrite = true;
+      timeParse(&kpixDom,&kpixStream,xml,iter,"Parse only");
+
+      kpixDom.skipWrite    = false;
+      kpixStream.skipWrite = false;
+      timeParse(&kpixDom,&kpixStream,xml,iter,"Parse and config write");
+
+      if ( cfgDom != cfgStream || ! same ) return(1);
+
+   } catch ( string error ) {
+      cout << "Caught Error: " << endl;
+      cout << error << endl;
+      return(1);
+   }
+   return(0);
+}
+